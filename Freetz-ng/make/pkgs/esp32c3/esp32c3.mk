@@ -1,4 +1,4 @@
-$(call PKG_INIT_BIN, 1.1.4)
+$(call PKG_INIT_BIN, 1.1.5)
 
 $(PKG)_SOURCE :=
 $(PKG)_SITE   := none
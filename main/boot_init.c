@@ -0,0 +1,187 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Startup scheduler and boot timeline.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "boot_init.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "boot_init";
+
+typedef struct {
+    const boot_init_step_t *step;
+    uint8_t index;
+    QueueHandle_t done;
+} step_run_t;
+
+typedef struct {
+    uint8_t index;
+    esp_err_t result;
+} step_done_t;
+
+static boot_profile_t s_profile;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void add_stage(const char *name, int64_t start_us, int64_t end_us,
+                      esp_err_t result, bool on_task)
+{
+    portENTER_CRITICAL(&s_lock);
+    if (s_profile.stage_count < BOOT_INIT_MAX_STAGES) {
+        s_profile.stages[s_profile.stage_count++] = (boot_stage_t){
+            .name = name,
+            .start_us = start_us,
+            .end_us = end_us,
+            .result = result,
+            .on_task = on_task,
+        };
+    }
+    s_profile.stages_us += (uint32_t)(end_us - start_us);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void boot_init_begin(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_profile.app_main_us = esp_timer_get_time();
+    s_profile.parallel = BOOT_INIT_PARALLEL;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void boot_init_record(const char *name, int64_t started_us, esp_err_t result)
+{
+    add_stage(name, started_us, esp_timer_get_time(), result, false);
+}
+
+static esp_err_t run_step(const boot_init_step_t *step, bool on_task)
+{
+    int64_t started = esp_timer_get_time();
+    esp_err_t err = step->fn();
+    add_stage(step->name, started, esp_timer_get_time(), err, on_task);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "%s failed: %s%s", step->name, esp_err_to_name(err),
+                 step->optional ? " (optional, continuing)" : "");
+    }
+    return err;
+}
+
+static void step_task(void *arg)
+{
+    step_run_t *run = (step_run_t *)arg;
+    step_done_t done = {.index = run->index};
+    done.result = run_step(run->step, true);
+    xQueueSend(run->done, &done, portMAX_DELAY);
+    vTaskDelete(NULL);
+}
+
+esp_err_t boot_init_run(const boot_init_step_t *steps, size_t count)
+{
+    if (count > BOOT_INIT_MAX_STEPS) return ESP_ERR_INVALID_ARG;
+
+    step_run_t runs[BOOT_INIT_MAX_STEPS];
+    QueueHandle_t done_queue = NULL;
+    if (BOOT_INIT_PARALLEL) {
+        done_queue = xQueueCreate(count ? count : 1, sizeof(step_done_t));
+        if (!done_queue) return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t all = count >= 32 ? UINT32_MAX : BOOT_STEP(count) - 1;
+    uint32_t started = 0;
+    uint32_t finished = 0;
+    esp_err_t first_error = ESP_OK;
+    UBaseType_t priority = uxTaskPriorityGet(NULL);
+    int running = 0;
+
+    while (finished != all) {
+        /* Start what is ready, unless a required step has failed. */
+        bool ran_here = false;
+        for (size_t i = 0; i < count && first_error == ESP_OK; i++) {
+            uint32_t bit = BOOT_STEP(i);
+            if ((started & bit) || (steps[i].deps & finished) != steps[i].deps) {
+                continue;
+            }
+            started |= bit;
+            runs[i] = (step_run_t){.step = &steps[i], .index = (uint8_t)i,
+                                   .done = done_queue};
+            if (BOOT_INIT_PARALLEL &&
+                xTaskCreate(step_task, steps[i].name, BOOT_INIT_STACK,
+                            &runs[i], priority, NULL) == pdPASS) {
+                running++;
+                continue;
+            }
+            /* Sequential build, or no memory for a task: run it here. */
+            esp_err_t err = run_step(&steps[i], false);
+            finished |= bit;
+            if (err != ESP_OK && !steps[i].optional) first_error = err;
+            ran_here = true;
+        }
+        /* A step run here may have unblocked earlier ones. */
+        if (ran_here) continue;
+        if (running == 0) break;
+
+        step_done_t done;
+        xQueueReceive(done_queue, &done, portMAX_DELAY);
+        running--;
+        finished |= BOOT_STEP(done.index);
+        if (done.result != ESP_OK && !steps[done.index].optional &&
+            first_error == ESP_OK) {
+            first_error = done.result;
+        }
+    }
+
+    if (done_queue) vQueueDelete(done_queue);
+    portENTER_CRITICAL(&s_lock);
+    s_profile.init_done_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&s_lock);
+
+    if (first_error != ESP_OK) return first_error;
+    if (finished != all) {
+        ESP_LOGE(TAG, "Steps with unmet dependencies: 0x%lx",
+                 (unsigned long)(all & ~finished));
+        return ESP_ERR_INVALID_ARG;
+    }
+    ESP_LOGI(TAG, "Started in %lu ms, stages took %lu ms",
+             (unsigned long)((s_profile.init_done_us - s_profile.app_main_us) /
+                             1000),
+             (unsigned long)(s_profile.stages_us / 1000));
+    return ESP_OK;
+}
+
+void boot_init_milestone(boot_milestone_t milestone)
+{
+    if (milestone >= BOOT_MILESTONES) return;
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    if (s_profile.milestone_us[milestone] == 0) {
+        s_profile.milestone_us[milestone] = now;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void boot_init_get_profile(boot_profile_t *out)
+{
+    portENTER_CRITICAL(&s_lock);
+    *out = s_profile;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+const char *boot_init_milestone_name(boot_milestone_t milestone)
+{
+    switch (milestone) {
+    case BOOT_MILESTONE_SOFTAP: return "softap";
+    case BOOT_MILESTONE_PPP_UP: return "ppp_up";
+    case BOOT_MILESTONE_MQTT_VALUE: return "first_mqtt_value";
+    case BOOT_MILESTONES: break;
+    }
+    return "?";
+}
@@ -0,0 +1,147 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * SoftAP channel scoring.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "channel_select.h"
+
+#define MIN_CHANNEL 1
+#define MAX_CHANNEL 11
+
+const uint8_t channel_select_candidates[CHANNEL_SELECT_CANDIDATES] = {1, 6, 11};
+
+static uint32_t rssi_weight(int8_t rssi)
+{
+    if (rssi >= -50) return 100;
+    if (rssi >= -60) return 50;
+    if (rssi >= -70) return 20;
+    if (rssi >= -80) return 5;
+    return 1;
+}
+
+static uint32_t overlap_weight(uint8_t candidate, uint8_t primary)
+{
+    unsigned distance = candidate > primary ? candidate - primary
+                                             : primary - candidate;
+    static const uint8_t overlap[] = {100, 75, 50, 25, 10};
+    return distance < sizeof(overlap) ? overlap[distance] : 0;
+}
+
+uint32_t channel_select_beacon_score(const channel_select_ap_t *aps,
+                                     size_t count, uint8_t channel)
+{
+    uint32_t score = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (aps[i].primary < MIN_CHANNEL || aps[i].primary > MAX_CHANNEL) {
+            continue;
+        }
+        score += rssi_weight(aps[i].rssi) *
+                 overlap_weight(channel, aps[i].primary);
+    }
+    return score;
+}
+
+/* Lowest score, current on ties, then kept unless beaten by the margin. */
+static size_t pick(const uint8_t *channels, const uint32_t *scores, size_t n,
+                   uint8_t current, unsigned hysteresis_pct)
+{
+    size_t best = 0;
+    for (size_t c = 1; c < n; c++) {
+        if (scores[c] < scores[best] ||
+            (scores[c] == scores[best] && channels[c] == current)) {
+            best = c;
+        }
+    }
+
+    if (hysteresis_pct > 0) {
+        for (size_t c = 0; c < n; c++) {
+            if (channels[c] != current) continue;
+            if (scores[c] == 0 ||
+                (uint64_t)scores[best] * 100U >
+                    (uint64_t)scores[c] * (100U - hysteresis_pct)) {
+                best = c;
+            }
+            break;
+        }
+    }
+    return best;
+}
+
+uint8_t channel_select_choose(const channel_select_ap_t *aps, size_t count,
+                              uint8_t current, unsigned hysteresis_pct,
+                              uint32_t scores[CHANNEL_SELECT_CANDIDATES])
+{
+    const uint8_t *candidates = channel_select_candidates;
+    for (size_t c = 0; c < CHANNEL_SELECT_CANDIDATES; c++) {
+        scores[c] = channel_select_beacon_score(aps, count, candidates[c]);
+    }
+    return candidates[pick(candidates, scores, CHANNEL_SELECT_CANDIDATES,
+                           current, hysteresis_pct)];
+}
+
+uint8_t channel_select_choose_airtime(
+    const channel_select_ap_t *aps, size_t count,
+    const uint16_t airtime_permille[CHANNEL_SELECT_CHANNELS],
+    uint8_t current, unsigned hysteresis_pct,
+    uint32_t scores[CHANNEL_SELECT_CHANNELS])
+{
+    uint32_t load[CHANNEL_SELECT_CHANNELS] = {0};
+    uint8_t channels[CHANNEL_SELECT_CHANNELS];
+    for (size_t c = 0; c < CHANNEL_SELECT_CHANNELS; c++) {
+        channels[c] = (uint8_t)(c + 1);
+        if (airtime_permille[c] != CHANNEL_SELECT_NO_AIRTIME) {
+            load[c] = airtime_permille[c];
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (aps[i].primary < MIN_CHANNEL || aps[i].primary > MAX_CHANNEL) {
+            continue;
+        }
+        load[aps[i].primary - 1] += rssi_weight(aps[i].rssi) / 2;
+    }
+
+    for (size_t c = 0; c < CHANNEL_SELECT_CHANNELS; c++) {
+        scores[c] = 0;
+        for (size_t k = 0; k < CHANNEL_SELECT_CHANNELS; k++) {
+            scores[c] += load[k] * overlap_weight(channels[c], channels[k]);
+        }
+    }
+    return channels[pick(channels, scores, CHANNEL_SELECT_CHANNELS, current,
+                         hysteresis_pct)];
+}
+
+/* Data rate in 100 kbit/s for the wifi_phy_rate_t legacy codes; 0 = unused.
+ * 0-3 long preamble DSSS/CCK, 5-7 short preamble, 8-15 OFDM. */
+static const uint16_t legacy_rate[16] = {
+    10, 20, 55, 110, 0, 20, 55, 110, 480, 240, 120, 60, 540, 360, 180, 90,
+};
+
+/* HT MCS 0-7, 20 MHz, long guard interval, in 100 kbit/s. */
+static const uint16_t ht_rate[8] = {65, 130, 195, 260, 390, 520, 585, 650};
+
+uint32_t channel_select_frame_airtime_us(bool ht, uint8_t rate, bool ht40,
+                                         bool short_gi, uint16_t len)
+{
+    uint32_t bits = 16U + 8U * len + 6U; /* SERVICE + PSDU + tail */
+    if (!ht) {
+        uint32_t r = rate < 16 ? legacy_rate[rate] : 0;
+        if (r == 0) r = 10;
+        if (rate < 8) {
+            /* DSSS/CCK: PLCP preamble and header, then the PSDU alone. */
+            uint32_t preamble = rate < 4 ? 192 : 96;
+            return preamble + (8U * len * 10U + r - 1) / r;
+        }
+        uint32_t bits_per_symbol = r * 4 / 10;
+        return 20 + 4 * ((bits + bits_per_symbol - 1) / bits_per_symbol);
+    }
+
+    uint32_t r = ht_rate[rate & 7];
+    if (ht40) r = r * 27 / 13; /* 108 vs 52 data subcarriers */
+    uint32_t bits_per_symbol = r * 4 / 10;
+    uint32_t symbols = (bits + bits_per_symbol - 1) / bits_per_symbol;
+    /* HT-mixed preamble: legacy part, HT-SIG and one HT-LTF. */
+    return 36 + (short_gi ? (symbols * 36 + 9) / 10 : symbols * 4);
+}
@@ -11,6 +11,7 @@
 #include "client_rssi.h"
 
 #include <string.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <limits.h>
 
@@ -18,68 +19,297 @@
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 
+#include "esp_event.h"
 #include "esp_log.h"
 #include "esp_mac.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 
+#include "ap_config.h"
+
 static const char *TAG = "client_rssi";
 
 /* -------------------- Module state -------------------- */
 
-#define MAX_STA_CLIENTS 4
+/* Writers (the default event loop and the refresh task) update s_table under
+ * table_mutex and then publish it. Publishing copies the table into the
+ * buffer readers are not using and bumps s_published; readers copy the buffer
+ * selected by the counter and retry if it moved meanwhile. A writer that is
+ * preempted mid-copy never blocks a reader, unlike a classic seqlock. */
+static client_station_snapshot_t s_table;
+static client_station_snapshot_t s_published_buf[2];
+static atomic_uint s_published;
+static SemaphoreHandle_t table_mutex = NULL;
+static TaskHandle_t rssi_task_handle = NULL;
 
-typedef struct {
-    uint8_t mac[6];
-    int8_t rssi;
-} sta_rssi_entry_t;
+/* Caller holds table_mutex. */
+static void publish_table(void)
+{
+    unsigned next = atomic_load_explicit(&s_published,
+                                         memory_order_relaxed) + 1;
+    s_published_buf[next & 1] = s_table;
+    atomic_store_explicit(&s_published, next, memory_order_release);
+}
 
-static sta_rssi_entry_t sta_rssi_list[MAX_STA_CLIENTS];
-static uint8_t sta_count = 0;
-static SemaphoreHandle_t rssi_mutex = NULL;
-static TaskHandle_t rssi_task_handle = NULL;
+/* Caller holds table_mutex. */
+static int find_station(const uint8_t *mac)
+{
+    for (int i = 0; i < s_table.count; i++) {
+        if (memcmp(s_table.sta[i].mac, mac, 6) == 0) return i;
+    }
+    return -1;
+}
+
+/* Caller holds table_mutex. */
+static void remove_station(int index)
+{
+    s_table.count--;
+    if (index < s_table.count) {
+        memmove(&s_table.sta[index], &s_table.sta[index + 1],
+                (size_t)(s_table.count - index) * sizeof(s_table.sta[0]));
+    }
+    memset(&s_table.sta[s_table.count], 0, sizeof(s_table.sta[0]));
+    s_table.generation++;
+}
 
-static void clear_rssi_snapshot(void)
+/* Caller holds table_mutex. Returns the entry index, -1 if the table is full. */
+static int add_station(const uint8_t *mac, uint8_t aid, int64_t now)
 {
-    if (xSemaphoreTake(rssi_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        memset(sta_rssi_list, 0, sizeof(sta_rssi_list));
-        sta_count = 0;
-        xSemaphoreGive(rssi_mutex);
+    int i = find_station(mac);
+    if (i < 0) {
+        if (s_table.count >= CLIENT_RSSI_MAX_STATIONS) return -1;
+        i = s_table.count++;
+        memset(&s_table.sta[i], 0, sizeof(s_table.sta[i]));
+        memcpy(s_table.sta[i].mac, mac, 6);
     }
+    /* A reassociation without a disconnect event restarts the session; the
+     * cached lease stays until DHCP reports a new one. */
+    client_station_t *sta = &s_table.sta[i];
+    uint32_t ip = sta->ip;
+    memset(sta, 0, sizeof(*sta));
+    memcpy(sta->mac, mac, 6);
+    sta->aid = aid;
+    sta->ip = ip;
+    sta->rssi = INT8_MIN;
+    sta->rssi_avg = INT8_MIN;
+    sta->rssi_min = INT8_MIN;
+    sta->rssi_max = INT8_MIN;
+    sta->connected_us = now;
+    s_table.generation++;
+    return i;
 }
 
-/* -------------------- RSSI Monitoring Task -------------------- */
+static uint32_t isqrt32(uint32_t v)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1u << 30;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
 
-static void rssi_update_task(void *arg)
+/* Caller holds table_mutex. Adds a raw sample: smoothed value, window
+ * statistics and poor-signal transitions. */
+static void record_sample(client_station_t *sta, int8_t rssi)
+{
+    sta->rssi = rssi;
+
+    int16_t sample_q4 = (int16_t)(rssi * 16);
+    if (sta->history_len == 0) {
+        sta->ewma_q4 = sample_q4;
+    } else {
+        sta->ewma_q4 += (int16_t)((sample_q4 - sta->ewma_q4) >>
+                                  CLIENT_RSSI_EWMA_SHIFT);
+    }
+    sta->rssi_avg = (int8_t)((sta->ewma_q4 + (sta->ewma_q4 < 0 ? -8 : 8)) / 16);
+
+    sta->history[sta->history_head] = rssi;
+    sta->history_head = (uint8_t)((sta->history_head + 1) % CLIENT_RSSI_HISTORY);
+    if (sta->history_len < CLIENT_RSSI_HISTORY) sta->history_len++;
+
+    int32_t sum = 0;
+    int32_t sum_sq = 0;
+    int8_t lo = INT8_MAX;
+    int8_t hi = INT8_MIN;
+    int n = sta->history_len;
+    for (int k = 0; k < n; k++) {
+        int8_t v = sta->history[k];
+        sum += v;
+        sum_sq += (int32_t)v * v;
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+    }
+    sta->rssi_min = lo;
+    sta->rssi_max = hi;
+    /* Population variance in 0.01 dB^2, so the root comes out in 0.1 dB. */
+    int32_t var_n2 = n * sum_sq - sum * sum;
+    sta->rssi_stddev_ddb = (uint16_t)isqrt32((uint32_t)var_n2 * 100u /
+                                             (uint32_t)(n * n));
+
+    if (!sta->poor && rssi < CLIENT_RSSI_POOR_DBM) {
+        sta->poor = true;
+        if (sta->poor_crossings < UINT16_MAX) sta->poor_crossings++;
+    } else if (sta->poor &&
+               rssi > CLIENT_RSSI_POOR_DBM + CLIENT_RSSI_POOR_HYST_DB) {
+        sta->poor = false;
+    }
+}
+
+static void clear_table(void)
+{
+    xSemaphoreTake(table_mutex, portMAX_DELAY);
+    if (s_table.count > 0) {
+        memset(s_table.sta, 0, sizeof(s_table.sta));
+        s_table.count = 0;
+        s_table.generation++;
+        publish_table();
+    }
+    xSemaphoreGive(table_mutex);
+}
+
+/* -------------------- Wi-Fi and DHCP events -------------------- */
+
+static void station_event_handler(void *arg, esp_event_base_t event_base,
+                                  int32_t event_id, void *event_data)
 {
     (void)arg;
+    int64_t now = esp_timer_get_time();
+
+    if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_AP_STACONNECTED) {
+        wifi_event_ap_staconnected_t *e = event_data;
+        xSemaphoreTake(table_mutex, portMAX_DELAY);
+        if (add_station(e->mac, e->aid, now) < 0) {
+            ESP_LOGW(TAG, "Station table full, " MACSTR " not tracked",
+                     MAC2STR(e->mac));
+        }
+        publish_table();
+        xSemaphoreGive(table_mutex);
+        /* Fetch the new station's RSSI now instead of at the next tick. */
+        if (rssi_task_handle) xTaskNotifyGive(rssi_task_handle);
+    } else if (event_base == WIFI_EVENT &&
+               event_id == WIFI_EVENT_AP_STADISCONNECTED) {
+        wifi_event_ap_stadisconnected_t *e = event_data;
+        xSemaphoreTake(table_mutex, portMAX_DELAY);
+        int i = find_station(e->mac);
+        if (i >= 0) {
+            remove_station(i);
+            publish_table();
+        }
+        xSemaphoreGive(table_mutex);
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_AP_STOP) {
+        /* Stopping the AP drops every station without per-station events. */
+        clear_table();
+    } else if (event_base == IP_EVENT &&
+               event_id == IP_EVENT_AP_STAIPASSIGNED) {
+        ip_event_ap_staipassigned_t *e = event_data;
+        xSemaphoreTake(table_mutex, portMAX_DELAY);
+        int i = find_station(e->mac);
+        if (i >= 0 && s_table.sta[i].ip != e->ip.addr) {
+            s_table.sta[i].ip = e->ip.addr;
+            s_table.generation++;
+            publish_table();
+        }
+        xSemaphoreGive(table_mutex);
+    }
+}
 
-    while (1) {
-        vTaskDelay(pdMS_TO_TICKS(5000)); // Update every 5 seconds
+/* -------------------- RSSI Refresh Task -------------------- */
 
-        wifi_sta_list_t sta_list = {0};
-        if (esp_wifi_ap_get_sta_list(&sta_list) != ESP_OK) {
-            clear_rssi_snapshot();
-            continue;
+/* Caller holds table_mutex. Brings the table in line with the driver's list,
+ * in case an event was lost, and copies the RSSI values. */
+static void merge_driver_list(const wifi_sta_list_t *sta_list, int64_t now)
+{
+    for (int i = s_table.count - 1; i >= 0; i--) {
+        bool present = false;
+        for (int j = 0; j < sta_list->num; j++) {
+            if (memcmp(sta_list->sta[j].mac, s_table.sta[i].mac, 6) == 0) {
+                present = true;
+                break;
+            }
         }
+        if (!present) remove_station(i);
+    }
 
-        if (xSemaphoreTake(rssi_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
-            continue;
+    for (int j = 0; j < sta_list->num; j++) {
+        int i = find_station(sta_list->sta[j].mac);
+        if (i < 0) i = add_station(sta_list->sta[j].mac, 0, now);
+        if (i < 0) continue;
+        record_sample(&s_table.sta[i], sta_list->sta[j].rssi);
+
+        ESP_LOGD(TAG, "STA[%d] MAC=" MACSTR " RSSI=%d dBm",
+                 i, MAC2STR(sta_list->sta[j].mac), sta_list->sta[j].rssi);
+    }
+    s_table.rssi_updated_us = now;
+}
+
+/* Stations that joined before init, or whose lease event was missed, get
+ * their IP from the DHCP server's table. */
+static void resolve_missing_leases(void)
+{
+    esp_netif_t *ap_netif = ap_get_netif();
+    esp_netif_pair_mac_ip_t pairs[CLIENT_RSSI_MAX_STATIONS];
+    int n = 0;
+
+    xSemaphoreTake(table_mutex, portMAX_DELAY);
+    for (int i = 0; i < s_table.count; i++) {
+        if (s_table.sta[i].ip == 0) {
+            memcpy(pairs[n].mac, s_table.sta[i].mac, 6);
+            pairs[n].ip.addr = 0;
+            n++;
         }
+    }
+    xSemaphoreGive(table_mutex);
 
-        sta_count = sta_list.num;
-        if (sta_count > MAX_STA_CLIENTS) {
-            sta_count = MAX_STA_CLIENTS;
+    if (!ap_netif || n == 0 ||
+        esp_netif_dhcps_get_clients_by_mac(ap_netif, n, pairs) != ESP_OK) {
+        return;
+    }
+
+    xSemaphoreTake(table_mutex, portMAX_DELAY);
+    bool changed = false;
+    for (int k = 0; k < n; k++) {
+        int i = find_station(pairs[k].mac);
+        if (i >= 0 && pairs[k].ip.addr != 0 && s_table.sta[i].ip == 0) {
+            s_table.sta[i].ip = pairs[k].ip.addr;
+            changed = true;
         }
+    }
+    if (changed) {
+        s_table.generation++;
+        publish_table();
+    }
+    xSemaphoreGive(table_mutex);
+}
 
-        for (uint8_t i = 0; i < sta_count; i++) {
-            memcpy(sta_rssi_list[i].mac, sta_list.sta[i].mac, 6);
-            sta_rssi_list[i].rssi = sta_list.sta[i].rssi;
+static void rssi_update_task(void *arg)
+{
+    (void)arg;
 
-            ESP_LOGD(TAG, "STA[%d] MAC=" MACSTR " RSSI=%d dBm",
-                     i, MAC2STR(sta_list.sta[i].mac), sta_list.sta[i].rssi);
+    while (1) {
+        /* Every CLIENT_RSSI_REFRESH_MS, or early when a station joins. */
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CLIENT_RSSI_REFRESH_MS));
+
+        wifi_sta_list_t sta_list = {0};
+        if (esp_wifi_ap_get_sta_list(&sta_list) != ESP_OK) {
+            clear_table();
+            continue;
         }
 
-        xSemaphoreGive(rssi_mutex);
+        xSemaphoreTake(table_mutex, portMAX_DELAY);
+        merge_driver_list(&sta_list, esp_timer_get_time());
+        publish_table();
+        xSemaphoreGive(table_mutex);
+
+        resolve_missing_leases();
     }
 }
 
@@ -91,15 +321,25 @@ esp_err_t client_rssi_init(void)
         return ESP_OK;
     }
 
-    if (!rssi_mutex) {
-        rssi_mutex = xSemaphoreCreateMutex();
-        if (!rssi_mutex) {
+    if (!table_mutex) {
+        table_mutex = xSemaphoreCreateMutex();
+        if (!table_mutex) {
             return ESP_ERR_NO_MEM;
         }
     }
 
-    memset(sta_rssi_list, 0, sizeof(sta_rssi_list));
-    sta_count = 0;
+    static const int32_t wifi_events[] = {
+        WIFI_EVENT_AP_STACONNECTED, WIFI_EVENT_AP_STADISCONNECTED,
+        WIFI_EVENT_AP_STOP,
+    };
+    for (size_t i = 0; i < sizeof(wifi_events) / sizeof(wifi_events[0]); i++) {
+        esp_err_t err = esp_event_handler_register(
+            WIFI_EVENT, wifi_events[i], station_event_handler, NULL);
+        if (err != ESP_OK) return err;
+    }
+    esp_err_t err = esp_event_handler_register(
+        IP_EVENT, IP_EVENT_AP_STAIPASSIGNED, station_event_handler, NULL);
+    if (err != ESP_OK) return err;
 
     if (xTaskCreate(rssi_update_task, "rssi_update",
                     4096, NULL, 6, &rssi_task_handle) != pdPASS) {
@@ -112,57 +352,84 @@ esp_err_t client_rssi_init(void)
     return ESP_OK;
 }
 
+void client_rssi_get_snapshot(client_station_snapshot_t *out)
+{
+    if (!out) return;
+
+    for (;;) {
+        unsigned seq = atomic_load_explicit(&s_published,
+                                            memory_order_acquire);
+        *out = s_published_buf[seq & 1];
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&s_published, memory_order_relaxed) == seq) {
+            return;
+        }
+    }
+}
+
+int client_rssi_get_count(void)
+{
+    unsigned seq = atomic_load_explicit(&s_published, memory_order_acquire);
+    return s_published_buf[seq & 1].count;
+}
+
+size_t client_rssi_history(const client_station_t *sta,
+                           int8_t out[CLIENT_RSSI_HISTORY])
+{
+    if (!sta || !out) return 0;
+
+    size_t n = sta->history_len;
+    size_t start = (sta->history_head + CLIENT_RSSI_HISTORY - n) %
+                   CLIENT_RSSI_HISTORY;
+    for (size_t k = 0; k < n; k++) {
+        out[k] = sta->history[(start + k) % CLIENT_RSSI_HISTORY];
+    }
+    return n;
+}
+
 int8_t client_rssi_get_by_mac(const uint8_t *mac)
 {
     if (!mac) return INT8_MIN;
 
-    int8_t rssi = INT8_MIN;
-
-    if (xSemaphoreTake(rssi_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-        for (uint8_t i = 0; i < sta_count; i++) {
-            if (memcmp(sta_rssi_list[i].mac, mac, 6) == 0) {
-                rssi = sta_rssi_list[i].rssi;
-                break;
-            }
+    client_station_snapshot_t snap;
+    client_rssi_get_snapshot(&snap);
+    for (uint8_t i = 0; i < snap.count; i++) {
+        if (memcmp(snap.sta[i].mac, mac, 6) == 0) {
+            return snap.sta[i].rssi_avg;
         }
-        xSemaphoreGive(rssi_mutex);
     }
-
-    return rssi;
+    return INT8_MIN;
 }
 
 int8_t client_rssi_get_best(void)
 {
     int8_t best_rssi = INT8_MIN;
+    client_station_snapshot_t snap;
+    client_rssi_get_snapshot(&snap);
 
-    if (xSemaphoreTake(rssi_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-        for (uint8_t i = 0; i < sta_count; i++) {
-            if (sta_rssi_list[i].rssi > best_rssi) {
-                best_rssi = sta_rssi_list[i].rssi;
-            }
+    for (uint8_t i = 0; i < snap.count; i++) {
+        if (snap.sta[i].rssi_avg > best_rssi) {
+            best_rssi = snap.sta[i].rssi_avg;
         }
-        xSemaphoreGive(rssi_mutex);
     }
-
     return best_rssi;
 }
 
 int8_t client_rssi_get_average(void)
 {
-    int8_t avg_rssi = INT8_MIN;
-
-    if (xSemaphoreTake(rssi_mutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-        if (sta_count > 0) {
-            int32_t sum = 0;
-            for (uint8_t i = 0; i < sta_count; i++) {
-                sum += sta_rssi_list[i].rssi;
-            }
-            avg_rssi = (int8_t)(sum / sta_count);
+    client_station_snapshot_t snap;
+    client_rssi_get_snapshot(&snap);
+
+    /* Stations without a refresh yet would drag the average to INT8_MIN. */
+    int32_t sum = 0;
+    int n = 0;
+    for (uint8_t i = 0; i < snap.count; i++) {
+        if (snap.sta[i].rssi_avg != INT8_MIN) {
+            sum += snap.sta[i].rssi_avg;
+            n++;
         }
-        xSemaphoreGive(rssi_mutex);
     }
-
-    return avg_rssi;
+    return n > 0 ? (int8_t)(sum / n) : INT8_MIN;
 }
 
 uint8_t client_rssi_to_bars(int8_t rssi)
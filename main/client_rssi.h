@@ -9,6 +9,8 @@
  */
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "esp_err.h"
 
@@ -21,31 +23,99 @@ extern "C" {
  * @brief Track WiFi signal strength (RSSI) of connected SoftAP clients.
  *
  * Responsibilities:
- *  - Monitor connected clients and their RSSI values
+ *  - Keep the SoftAP station table, maintained from Wi-Fi connect/disconnect
+ *    events, with the DHCP IP cached from lease events
+ *  - Refresh RSSI values periodically (the only esp_wifi_ap_get_sta_list()
+ *    caller besides the AP self-check)
+ *  - Smooth each station's RSSI and keep link-quality statistics over a
+ *    short window of raw samples
  *  - Provide lookup of RSSI by MAC address
  *  - Expose average/best client RSSI for OLED display
+ *
+ * Readers never take a lock: the table is published under a sequence
+ * counter and client_rssi_get_snapshot() retries if a writer raced it.
  */
 
+/** Table size; matches the SoftAP max_connection (AP_MAX_CONN). */
+#define CLIENT_RSSI_MAX_STATIONS 4
+
+/** RSSI refresh period of the station table. */
+#define CLIENT_RSSI_REFRESH_MS 5000
+
+/** Recent raw samples kept per station (one minute at the refresh period). */
+#define CLIENT_RSSI_HISTORY 12
+
+/** Smoothing weight of a new sample, 1/2^CLIENT_RSSI_EWMA_SHIFT. */
+#define CLIENT_RSSI_EWMA_SHIFT 2
+
+/** A sample below this is poor; it is good again above the threshold plus
+ *  CLIENT_RSSI_POOR_HYST_DB, so noise around the edge is not counted. */
+#define CLIENT_RSSI_POOR_DBM (-75)
+#define CLIENT_RSSI_POOR_HYST_DB 3
+
+typedef struct {
+    uint8_t mac[6];
+    uint8_t aid;          /**< association id, 0 if not seen in an event */
+    int8_t rssi;          /**< latest sample in dBm, INT8_MIN before the first */
+    int8_t rssi_avg;      /**< smoothed dBm, INT8_MIN before the first sample */
+    int8_t rssi_min;      /**< over the history window */
+    int8_t rssi_max;      /**< over the history window */
+    uint16_t rssi_stddev_ddb; /**< over the history window, 0.1 dB */
+    int16_t ewma_q4;      /**< smoothing state, 1/16 dBm */
+    int8_t history[CLIENT_RSSI_HISTORY]; /**< ring of raw samples */
+    uint8_t history_len;
+    uint8_t history_head; /**< next slot to write */
+    bool poor;            /**< latest sample state, with hysteresis */
+    uint16_t poor_crossings; /**< good-to-poor transitions this session */
+    uint32_t ip;          /**< DHCP lease (network order), 0 if unknown */
+    int64_t connected_us; /**< esp_timer time of association */
+} client_station_t;
+
+typedef struct {
+    uint32_t generation;     /**< bumps on every membership or IP change */
+    int64_t rssi_updated_us; /**< last successful RSSI refresh, 0 if never */
+    uint8_t count;
+    client_station_t sta[CLIENT_RSSI_MAX_STATIONS];
+} client_station_snapshot_t;
+
 /**
  * @brief Initialize client RSSI tracking.
  */
 esp_err_t client_rssi_init(void);
 
 /**
- * @brief Get RSSI (signal strength) of a specific client by MAC address.
+ * @brief Copy a consistent snapshot of the station table without locking.
+ * @param out Destination; always filled (count 0 before init)
+ */
+void client_rssi_get_snapshot(client_station_snapshot_t *out);
+
+/**
+ * @brief Number of associated SoftAP stations, without locking.
+ */
+int client_rssi_get_count(void);
+
+/**
+ * @brief Copy a station's history window, oldest sample first.
+ * @return Number of samples written, at most CLIENT_RSSI_HISTORY
+ */
+size_t client_rssi_history(const client_station_t *sta,
+                           int8_t out[CLIENT_RSSI_HISTORY]);
+
+/**
+ * @brief Get the smoothed RSSI of a specific client by MAC address.
  * @param mac Pointer to 6-byte MAC address
  * @return RSSI in dBm (typically -40 to -100), or INT8_MIN if unknown
  */
 int8_t client_rssi_get_by_mac(const uint8_t *mac);
 
 /**
- * @brief Get the RSSI of the strongest connected client (power publisher).
+ * @brief Get the smoothed RSSI of the strongest connected client (power publisher).
  * @return RSSI in dBm, or INT8_MIN if no clients connected
  */
 int8_t client_rssi_get_best(void);
 
 /**
- * @brief Get average RSSI of all connected clients.
+ * @brief Get average smoothed RSSI of all connected clients.
  * @return RSSI in dBm, or INT8_MIN if no clients connected
  */
 int8_t client_rssi_get_average(void);
@@ -0,0 +1,257 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Per-client traffic accounting on the SoftAP and PPP interfaces.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "client_traffic.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+#include "lwip/def.h"
+#include "lwip/tcpip.h"
+
+#include "ap_config.h"
+
+static const char *TAG = "client_traffic";
+
+#define ETH_HEADER_LEN 14
+
+static traffic_table_t s_table;
+static bool s_table_ready = false;
+static uint64_t s_hook_cycles = 0;
+static uint32_t s_hook_calls = 0;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Rate state per table slot; prev_octet detects a slot handed to a new
+ * address. Only touched under s_lock. */
+static uint8_t s_prev_octet[TRAFFIC_TABLE_SLOTS];
+static uint64_t s_prev_bytes[TRAFFIC_TABLE_SLOTS][TRAFFIC_DIR_COUNT];
+static uint32_t s_rate[TRAFFIC_TABLE_SLOTS][TRAFFIC_DIR_COUNT];
+static int64_t s_rate_at_us = 0;
+
+static netif_input_fn s_ap_input = NULL;
+static netif_output_fn s_ap_output = NULL;
+static netif_output_fn s_uplink_output = NULL;
+
+/* -------------------- Hooks -------------------- */
+
+/* lwIP keeps the headers in the first pbuf, so only p->payload is read. */
+static bool read_ip4(const struct pbuf *p, uint16_t ip_offset, uint32_t *src,
+                     uint32_t *dst)
+{
+    return traffic_table_read_ip4(p->payload, p->len, ip_offset, src, dst);
+}
+
+/* Count one packet for the client at addr in dir, and in uplink_dir too
+ * unless that is TRAFFIC_DIR_COUNT. started is the hook's entry time. */
+static void account(bool ip4, uint32_t addr, uint32_t bytes,
+                    traffic_dir_t dir, traffic_dir_t uplink_dir,
+                    uint32_t started)
+{
+    portENTER_CRITICAL(&s_lock);
+    if (ip4 && s_table_ready) {
+        traffic_table_account(&s_table, dir, addr, bytes);
+        if (uplink_dir != TRAFFIC_DIR_COUNT) {
+            traffic_table_account(&s_table, uplink_dir, addr, bytes);
+        }
+    } else {
+        s_table.other_packets++;
+    }
+    s_hook_cycles += esp_cpu_get_cycle_count() - started;
+    s_hook_calls++;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static err_t ap_input_hook(struct pbuf *p, struct netif *netif)
+{
+    uint32_t started = esp_cpu_get_cycle_count();
+    uint32_t src = 0;
+    uint32_t dst = 0;
+    bool ip4 = read_ip4(p, ETH_HEADER_LEN, &src, &dst);
+    account(ip4, src, p->tot_len - ETH_HEADER_LEN, TRAFFIC_WIFI_UP,
+            TRAFFIC_DIR_COUNT, started);
+    return s_ap_input(p, netif);
+}
+
+/* lwIP's PPP delivers received packets straight to ip4_input(), bypassing
+ * netif->input, so uplink downloads are counted here: PPP is the only other
+ * interface, so a source outside the SoftAP subnet came over it. */
+static err_t ap_output_hook(struct netif *netif, struct pbuf *p,
+                            const ip4_addr_t *ipaddr)
+{
+    uint32_t started = esp_cpu_get_cycle_count();
+    uint32_t src = 0;
+    uint32_t dst = 0;
+    bool ip4 = read_ip4(p, 0, &src, &dst);
+    bool forwarded = (src & s_table.mask) != s_table.net;
+    account(ip4, dst, p->tot_len, TRAFFIC_WIFI_DOWN,
+            forwarded ? TRAFFIC_UPLINK_DOWN : TRAFFIC_DIR_COUNT, started);
+    return s_ap_output(netif, p, ipaddr);
+}
+
+static err_t uplink_output_hook(struct netif *netif, struct pbuf *p,
+                                const ip4_addr_t *ipaddr)
+{
+    uint32_t started = esp_cpu_get_cycle_count();
+    uint32_t src = 0;
+    uint32_t dst = 0;
+    bool ip4 = read_ip4(p, 0, &src, &dst);
+    account(ip4, src, p->tot_len, TRAFFIC_UPLINK_UP, TRAFFIC_DIR_COUNT,
+            started);
+    return s_uplink_output(netif, p, ipaddr);
+}
+
+/* -------------------- Rates -------------------- */
+
+/* Caller holds s_lock. */
+static void update_rates(int64_t now_us)
+{
+    int64_t elapsed_us = now_us - s_rate_at_us;
+    if (s_rate_at_us != 0 && elapsed_us < CLIENT_TRAFFIC_RATE_MS * 1000LL) {
+        return;
+    }
+
+    for (int i = 0; i < TRAFFIC_TABLE_SLOTS; i++) {
+        const traffic_slot_t *slot = &s_table.slots[i];
+        bool fresh = !slot->used || s_rate_at_us == 0 ||
+                     s_prev_octet[i] != slot->octet;
+        for (int d = 0; d < TRAFFIC_DIR_COUNT; d++) {
+            uint64_t bytes = slot->used ? slot->dir[d].bytes : 0;
+            if (fresh || bytes < s_prev_bytes[i][d]) {
+                s_rate[i][d] = 0;
+            } else {
+                uint64_t rate = (bytes - s_prev_bytes[i][d]) * 1000000ULL /
+                                (uint64_t)elapsed_us;
+                s_rate[i][d] = rate > UINT32_MAX ? UINT32_MAX : (uint32_t)rate;
+            }
+            s_prev_bytes[i][d] = bytes;
+        }
+        s_prev_octet[i] = slot->octet;
+    }
+    s_rate_at_us = now_us;
+}
+
+typedef struct {
+    struct netif *netif;
+    bool uplink;
+    SemaphoreHandle_t done;
+} hook_request_t;
+
+/* Runs on the tcpip thread, which calls netif->output, so no packet is
+ * between the old and the new output function. netif->input is also read by
+ * the Wi-Fi driver task; the original is saved first, so it sees either
+ * function. */
+static void install_hooks(void *arg)
+{
+    hook_request_t *req = (hook_request_t *)arg;
+    struct netif *netif = req->netif;
+    if (req->uplink) {
+        if (!s_uplink_output) {
+            s_uplink_output = netif->output;
+            netif->output = uplink_output_hook;
+        }
+    } else if (!s_ap_input) {
+        s_ap_input = netif->input;
+        s_ap_output = netif->output;
+        netif->input = ap_input_hook;
+        netif->output = ap_output_hook;
+    }
+    xSemaphoreGive(req->done);
+}
+
+/* Not for the tcpip thread itself: it waits for the callback. */
+static esp_err_t hook_netif(struct netif *netif, bool uplink)
+{
+    hook_request_t req = {.netif = netif, .uplink = uplink};
+    req.done = xSemaphoreCreateBinary();
+    if (!req.done) return ESP_ERR_NO_MEM;
+    esp_err_t err = ESP_FAIL;
+    if (tcpip_callback(install_hooks, &req) == ERR_OK) {
+        xSemaphoreTake(req.done, portMAX_DELAY);
+        err = ESP_OK;
+    }
+    vSemaphoreDelete(req.done);
+    return err;
+}
+
+/* -------------------- Public API -------------------- */
+
+esp_err_t client_traffic_start(void)
+{
+    esp_netif_t *ap_netif = ap_get_netif();
+    esp_netif_ip_info_t ip_info;
+    if (!ap_netif || esp_netif_get_ip_info(ap_netif, &ip_info) != ESP_OK) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    struct netif *netif = esp_netif_get_netif_impl(ap_netif);
+    if (!netif) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ip4_addr_t self = {.addr = ip_info.ip.addr};
+    ip4_addr_t mask = {.addr = ip_info.netmask.addr};
+    portENTER_CRITICAL(&s_lock);
+    traffic_table_init(&s_table, lwip_ntohl(self.addr), lwip_ntohl(mask.addr));
+    s_table_ready = true;
+    portEXIT_CRITICAL(&s_lock);
+
+    esp_err_t err = hook_netif(netif, false);
+    if (err != ESP_OK) return err;
+
+    ESP_LOGI(TAG, "Per-client traffic accounting on the SoftAP");
+    return ESP_OK;
+}
+
+void client_traffic_attach_uplink(struct netif *netif)
+{
+    if (!netif || s_uplink_output) return;
+    if (hook_netif(netif, true) != ESP_OK) {
+        ESP_LOGW(TAG, "Uplink traffic not counted");
+    }
+}
+
+bool client_traffic_get(uint32_t ip, client_traffic_t *out)
+{
+    ip4_addr_t addr = {.addr = ip};
+    bool found = false;
+    memset(out, 0, sizeof(*out));
+    if (ip == 0) return false;
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    update_rates(now);
+    const traffic_slot_t *slot = s_table_ready
+        ? traffic_table_find(&s_table, ip4_addr4(&addr)) : NULL;
+    if (slot) {
+        int i = (int)(slot - s_table.slots);
+        for (int d = 0; d < TRAFFIC_DIR_COUNT; d++) {
+            out->dir[d].bytes = slot->dir[d].bytes;
+            out->dir[d].packets = slot->dir[d].packets;
+            out->dir[d].bytes_per_s = s_rate[i][d];
+        }
+        found = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return found;
+}
+
+void client_traffic_get_stats(client_traffic_stats_t *out)
+{
+    portENTER_CRITICAL(&s_lock);
+    out->packets = s_table.clock;
+    out->other_packets = s_table.other_packets;
+    out->evictions = s_table.evictions;
+    out->hook_cycles_avg = s_hook_calls
+        ? (uint32_t)(s_hook_cycles / s_hook_calls) : 0;
+    portEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,608 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Versioned settings blob shared by all modules.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config_store.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+#include "ap_config.h"
+#include "mqtt_broker.h"
+#include "mqtt_telemetry.h"
+#include "oled.h"
+
+#define CONFIG_NVS_NAMESPACE "cfg"
+#define CONFIG_NVS_BLOB_KEY "blob"
+#define CONFIG_STORE_MAGIC 0x31474643u /* "CFG1" */
+
+/* Per-key layout used before the blob, read once for the migration. */
+#define LEGACY_AP_NAMESPACE "apcfg"
+#define LEGACY_AP_SSID_KEY "ssid"
+#define LEGACY_AP_PASS_KEY "pass"
+#define LEGACY_AP_CHANNEL_KEY "channel"
+#define LEGACY_AP_CHANNEL_AUTO_KEY "auto_chan"
+#define LEGACY_AP_LAST_AUTO_KEY "last_auto"
+#define LEGACY_AP_BUSY_SWITCHES_KEY "busy_sw"
+#define LEGACY_MQTT_NAMESPACE "mqttcfg"
+#define LEGACY_MQTT_AUTO_KEY "auto"
+#define LEGACY_MQTT_BROKER_KEY "host"
+#define LEGACY_MQTT_ROOT_KEY "root"
+#define LEGACY_MQTT_TELE_INTERVAL_KEY "tele_int"
+#define LEGACY_MQTT_TELE_DEADBAND_KEY "tele_db"
+#define LEGACY_MQTT_PROTOCOL_V5_KEY "mqtt5"
+#define LEGACY_MQTT_PERSISTENT_KEY "persist"
+#define LEGACY_MQTT_POWER_TOPIC_KEY "pwr_topic"
+#define LEGACY_MQTT_POWER_PATH_KEY "pwr_path"
+#define LEGACY_MQTT_LOCAL_BROKER_KEY "local_brk"
+#define LEGACY_MQTT_BRIDGE_FILTERS_KEY "brg_filt"
+#define LEGACY_DISPLAY_NAMESPACE "display"
+#define LEGACY_DISPLAY_ENABLED_KEY "enabled"
+#define LEGACY_DISPLAY_PAGES_KEY "pages"
+#define LEGACY_DISPLAY_ROTATE_KEY "rotate_s"
+#define LEGACY_DISPLAY_HISTORY_KEY "hist_min"
+#define LEGACY_SURVEY_NAMESPACE "survey"
+#define LEGACY_SURVEY_AIRTIME_KEY "airtime"
+
+/* Keys each section took in the per-key layout, for legacy_key_writes. */
+#define LEGACY_AP_KEYS 6
+#define LEGACY_MQTT_KEYS 11
+#define LEGACY_SURVEY_KEYS 1
+
+_Static_assert(sizeof(((config_mqtt_t *)0)->broker_host) ==
+               MQTT_BROKER_HOST_MAX_LEN + 1, "broker_host size");
+_Static_assert(sizeof(((config_mqtt_t *)0)->root_topic) ==
+               MQTT_ROOT_TOPIC_MAX_LEN + 1, "root_topic size");
+_Static_assert(sizeof(((config_mqtt_t *)0)->power_subtopic) ==
+               MQTT_POWER_SUBTOPIC_MAX_LEN + 1, "power_subtopic size");
+_Static_assert(sizeof(((config_mqtt_t *)0)->power_json_path) ==
+               MQTT_POWER_JSON_PATH_MAX_LEN + 1, "power_json_path size");
+_Static_assert(sizeof(((config_mqtt_t *)0)->bridge_filters) ==
+               MQTT_BRIDGE_FILTERS_MAX_LEN + 1, "bridge_filters size");
+
+_Static_assert(sizeof(config_store_data_t) ==
+               sizeof(config_ap_t) + sizeof(config_mqtt_t) +
+               sizeof(config_display_t) + sizeof(config_survey_t),
+               "config_store_data_t must not contain padding");
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t length; /* payload bytes after the header */
+    uint32_t crc;    /* esp_rom_crc32_le() over the payload */
+} config_header_t;
+
+typedef struct {
+    config_header_t header;
+    config_store_data_t data;
+} config_blob_t;
+
+static const char *TAG = "config_store";
+
+/* s_lock guards the settings, the pending state and the stats;
+ * s_write_lock the write buffer and the NVS write, which can take a flash
+ * erase and so runs without s_lock. */
+static SemaphoreHandle_t s_lock = NULL;
+static SemaphoreHandle_t s_write_lock = NULL;
+static TaskHandle_t s_task = NULL;
+static config_store_data_t s_data;
+static config_blob_t s_blob;
+static config_store_stats_t s_stats;
+static bool s_dirty = false;        /* s_data differs from the blob */
+static uint32_t s_generation = 0;   /* changes since boot */
+static int64_t s_dirty_since_us = 0;
+static int64_t s_due_us = 0;
+
+static void lock(void)
+{
+    if (s_lock) xSemaphoreTake(s_lock, portMAX_DELAY);
+}
+
+static void unlock(void)
+{
+    if (s_lock) xSemaphoreGive(s_lock);
+}
+
+static uint32_t payload_crc(const void *payload, size_t len)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)payload, (uint32_t)len);
+}
+
+static void set_defaults(config_store_data_t *d)
+{
+    memset(d, 0, sizeof(*d));
+    strlcpy(d->ap.ssid, AP_DEFAULT_SSID, sizeof(d->ap.ssid));
+    strlcpy(d->ap.pass, AP_DEFAULT_PASS, sizeof(d->ap.pass));
+    d->ap.manual_channel = AP_DEFAULT_CHANNEL;
+    d->ap.channel_auto = AP_DEFAULT_CHANNEL_AUTO ? 1 : 0;
+    d->ap.last_auto_channel = AP_DEFAULT_CHANNEL;
+    d->ap.busy_switch_limit = AP_DEFAULT_BUSY_SWITCHES_PER_DAY;
+
+    d->mqtt.broker_auto = 1;
+    d->mqtt.protocol_v5 = 1;
+    d->mqtt.telemetry_interval_s = MQTT_SELF_TELEMETRY_DEFAULT_INTERVAL_S;
+    d->mqtt.telemetry_deadband_pct = MQTT_SELF_TELEMETRY_DEFAULT_DEADBAND_PCT;
+    strlcpy(d->mqtt.root_topic, MQTT_DEFAULT_ROOT_TOPIC,
+            sizeof(d->mqtt.root_topic));
+    strlcpy(d->mqtt.power_subtopic, MQTT_DEFAULT_POWER_SUBTOPIC,
+            sizeof(d->mqtt.power_subtopic));
+    strlcpy(d->mqtt.bridge_filters, MQTT_BRIDGE_DEFAULT_FILTERS,
+            sizeof(d->mqtt.bridge_filters));
+
+    d->display.enabled = 1;
+    d->display.rotate_pages = OLED_ROTATE_POWER;
+    d->display.history_minutes = OLED_HISTORY_DEFAULT_MINUTES;
+}
+
+/* A blob is trusted for its CRC, but strings are terminated regardless. */
+#define TERMINATE(s) ((s)[sizeof(s) - 1] = 0)
+
+static void terminate_strings(config_store_data_t *d)
+{
+    TERMINATE(d->ap.ssid);
+    TERMINATE(d->ap.pass);
+    TERMINATE(d->mqtt.broker_host);
+    TERMINATE(d->mqtt.root_topic);
+    TERMINATE(d->mqtt.power_subtopic);
+    TERMINATE(d->mqtt.power_json_path);
+    TERMINATE(d->mqtt.bridge_filters);
+}
+
+/*
+ * Checks a blob of len bytes and loads its payload over the defaults in
+ * out. A payload from an older schema is shorter and leaves the newer
+ * fields at their defaults; one from a newer schema is cut to ours.
+ */
+static esp_err_t parse_blob(const uint8_t *buf, size_t len,
+                            config_store_data_t *out, uint16_t *version)
+{
+    config_header_t header;
+    if (len < sizeof(header)) return ESP_ERR_INVALID_SIZE;
+    memcpy(&header, buf, sizeof(header));
+    if (header.magic != CONFIG_STORE_MAGIC || header.version == 0) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (sizeof(header) + header.length != len) return ESP_ERR_INVALID_SIZE;
+    const uint8_t *payload = buf + sizeof(header);
+    if (payload_crc(payload, header.length) != header.crc) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    set_defaults(out);
+    size_t copy = header.length < sizeof(*out) ? header.length : sizeof(*out);
+    memcpy(out, payload, copy);
+    terminate_strings(out);
+    *version = header.version;
+    return ESP_OK;
+}
+
+/* Reads the blob into s_data; ESP_ERR_NVS_NOT_FOUND if there is none. */
+static esp_err_t read_blob(void)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(CONFIG_NVS_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK) return err;
+
+    int64_t started = esp_timer_get_time();
+    size_t len = sizeof(s_blob);
+    uint8_t *buf = (uint8_t *)&s_blob;
+    err = nvs_get_blob(nvs, CONFIG_NVS_BLOB_KEY, buf, &len);
+    if (err == ESP_ERR_NVS_INVALID_LENGTH) {
+        /* Written by firmware with a larger schema. */
+        buf = NULL;
+        err = nvs_get_blob(nvs, CONFIG_NVS_BLOB_KEY, NULL, &len);
+        if (err == ESP_OK) {
+            buf = malloc(len);
+            err = buf ? nvs_get_blob(nvs, CONFIG_NVS_BLOB_KEY, buf, &len)
+                      : ESP_ERR_NO_MEM;
+        }
+    }
+    s_stats.blob_read_us = (uint32_t)(esp_timer_get_time() - started);
+    nvs_close(nvs);
+
+    if (err == ESP_OK) {
+        err = parse_blob(buf, len, &s_data, &s_stats.loaded_version);
+        if (err == ESP_ERR_INVALID_CRC) s_stats.crc_errors++;
+        if (err == ESP_OK) s_stats.blob_bytes = (uint16_t)len;
+    }
+    if (buf != (uint8_t *)&s_blob) free(buf);
+    return err;
+}
+
+typedef struct {
+    nvs_handle_t nvs;
+    uint16_t reads;
+} legacy_reader_t;
+
+static bool legacy_open(legacy_reader_t *r, const char *ns)
+{
+    return nvs_open(ns, NVS_READONLY, &r->nvs) == ESP_OK;
+}
+
+static void legacy_u8(legacy_reader_t *r, const char *key, uint8_t *out)
+{
+    uint8_t v;
+    r->reads++;
+    if (nvs_get_u8(r->nvs, key, &v) == ESP_OK) *out = v;
+}
+
+static void legacy_u16(legacy_reader_t *r, const char *key, uint16_t *out)
+{
+    uint16_t v;
+    r->reads++;
+    if (nvs_get_u16(r->nvs, key, &v) == ESP_OK) *out = v;
+}
+
+static void legacy_u32(legacy_reader_t *r, const char *key, uint32_t *out)
+{
+    uint32_t v;
+    r->reads++;
+    if (nvs_get_u32(r->nvs, key, &v) == ESP_OK) *out = v;
+}
+
+/* Keeps the default unless the whole string fits. */
+static void legacy_str(legacy_reader_t *r, const char *key, char *out,
+                       size_t out_len)
+{
+    char v[128];
+    size_t len = sizeof(v) < out_len ? sizeof(v) : out_len;
+    r->reads++;
+    if (nvs_get_str(r->nvs, key, v, &len) == ESP_OK) strlcpy(out, v, out_len);
+}
+
+/* Settings of the per-key layout over the defaults in out; true if any
+ * namespace existed. */
+static bool read_legacy(config_store_data_t *out)
+{
+    legacy_reader_t r = {0};
+    bool found = false;
+    int64_t started = esp_timer_get_time();
+
+    if (legacy_open(&r, LEGACY_AP_NAMESPACE)) {
+        config_ap_t *ap = &out->ap;
+        legacy_str(&r, LEGACY_AP_SSID_KEY, ap->ssid, sizeof(ap->ssid));
+        legacy_str(&r, LEGACY_AP_PASS_KEY, ap->pass, sizeof(ap->pass));
+        legacy_u8(&r, LEGACY_AP_CHANNEL_KEY, &ap->manual_channel);
+        legacy_u8(&r, LEGACY_AP_CHANNEL_AUTO_KEY, &ap->channel_auto);
+        legacy_u8(&r, LEGACY_AP_LAST_AUTO_KEY, &ap->last_auto_channel);
+        legacy_u8(&r, LEGACY_AP_BUSY_SWITCHES_KEY, &ap->busy_switch_limit);
+        nvs_close(r.nvs);
+        found = true;
+    }
+    if (legacy_open(&r, LEGACY_MQTT_NAMESPACE)) {
+        config_mqtt_t *m = &out->mqtt;
+        legacy_u8(&r, LEGACY_MQTT_AUTO_KEY, &m->broker_auto);
+        legacy_str(&r, LEGACY_MQTT_BROKER_KEY, m->broker_host,
+                   sizeof(m->broker_host));
+        legacy_str(&r, LEGACY_MQTT_ROOT_KEY, m->root_topic,
+                   sizeof(m->root_topic));
+        legacy_u16(&r, LEGACY_MQTT_TELE_INTERVAL_KEY,
+                   &m->telemetry_interval_s);
+        legacy_u8(&r, LEGACY_MQTT_TELE_DEADBAND_KEY,
+                  &m->telemetry_deadband_pct);
+        legacy_u8(&r, LEGACY_MQTT_PROTOCOL_V5_KEY, &m->protocol_v5);
+        legacy_u8(&r, LEGACY_MQTT_PERSISTENT_KEY, &m->persistent_session);
+        legacy_str(&r, LEGACY_MQTT_POWER_TOPIC_KEY, m->power_subtopic,
+                   sizeof(m->power_subtopic));
+        legacy_str(&r, LEGACY_MQTT_POWER_PATH_KEY, m->power_json_path,
+                   sizeof(m->power_json_path));
+        legacy_u8(&r, LEGACY_MQTT_LOCAL_BROKER_KEY, &m->local_broker);
+        legacy_str(&r, LEGACY_MQTT_BRIDGE_FILTERS_KEY, m->bridge_filters,
+                   sizeof(m->bridge_filters));
+        nvs_close(r.nvs);
+        found = true;
+    }
+    if (legacy_open(&r, LEGACY_DISPLAY_NAMESPACE)) {
+        config_display_t *d = &out->display;
+        legacy_u8(&r, LEGACY_DISPLAY_ENABLED_KEY, &d->enabled);
+        legacy_u32(&r, LEGACY_DISPLAY_PAGES_KEY, &d->rotate_pages);
+        legacy_u16(&r, LEGACY_DISPLAY_ROTATE_KEY, &d->rotate_s);
+        legacy_u16(&r, LEGACY_DISPLAY_HISTORY_KEY, &d->history_minutes);
+        nvs_close(r.nvs);
+        found = true;
+    }
+    if (legacy_open(&r, LEGACY_SURVEY_NAMESPACE)) {
+        legacy_u8(&r, LEGACY_SURVEY_AIRTIME_KEY, &out->survey.airtime);
+        nvs_close(r.nvs);
+        found = true;
+    }
+
+    s_stats.legacy_read_us = (uint32_t)(esp_timer_get_time() - started);
+    s_stats.legacy_keys_read = r.reads;
+    return found;
+}
+
+/* Writes data as the new blob; caller holds s_write_lock. */
+static esp_err_t write_blob(const config_store_data_t *data)
+{
+    s_blob.header.magic = CONFIG_STORE_MAGIC;
+    s_blob.header.version = CONFIG_STORE_VERSION;
+    s_blob.header.length = sizeof(s_blob.data);
+    s_blob.data = *data;
+    s_blob.header.crc = payload_crc(&s_blob.data, sizeof(s_blob.data));
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(CONFIG_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(nvs, CONFIG_NVS_BLOB_KEY, &s_blob, sizeof(s_blob));
+        if (err == ESP_OK) err = nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Saving settings failed: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+/*
+ * Writes the pending changes, if any. The snapshot is taken under s_lock,
+ * but the flash write runs outside it, so setters never wait for flash.
+ * Changes made during the write stay pending for the next one.
+ */
+static esp_err_t flush(bool forced)
+{
+    xSemaphoreTake(s_write_lock, portMAX_DELAY);
+    lock();
+    if (!s_dirty) {
+        unlock();
+        xSemaphoreGive(s_write_lock);
+        return ESP_OK;
+    }
+    config_store_data_t snapshot = s_data;
+    uint32_t generation = s_generation;
+    unlock();
+
+    int64_t started = esp_timer_get_time();
+    esp_err_t err = write_blob(&snapshot);
+    int64_t now = esp_timer_get_time();
+
+    lock();
+    if (err == ESP_OK) {
+        if (s_generation == generation) s_dirty = false;
+        s_stats.commits++;
+        s_stats.blob_bytes = sizeof(s_blob);
+        s_stats.last_commit_us = (uint32_t)(now - started);
+        if (forced) s_stats.forced_flushes++;
+    } else {
+        s_stats.write_errors++;
+        s_due_us = now + (int64_t)CONFIG_STORE_RETRY_MS * 1000;
+    }
+    unlock();
+    xSemaphoreGive(s_write_lock);
+    return err;
+}
+
+static void flush_task(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        TickType_t wait = portMAX_DELAY;
+        lock();
+        if (s_dirty) {
+            int64_t left_us = s_due_us - esp_timer_get_time();
+            wait = left_us > 0 ? pdMS_TO_TICKS(left_us / 1000) + 1 : 0;
+        }
+        unlock();
+        if (wait) {
+            ulTaskNotifyTake(pdTRUE, wait);
+            continue;
+        }
+        flush(false);
+    }
+}
+
+static void flush_on_shutdown(void)
+{
+    config_store_flush();
+}
+
+/* Fills s_data from the blob or the old keys; true if a migration is to
+ * be written. */
+static bool load(void)
+{
+    int64_t started = esp_timer_get_time();
+    set_defaults(&s_data);
+    esp_err_t err = read_blob();
+    if (err == ESP_OK) {
+        s_stats.source = CONFIG_SOURCE_BLOB;
+        s_stats.load_us = (uint32_t)(esp_timer_get_time() - started);
+        ESP_LOGI(TAG, "Settings v%u loaded in %lu us (%u bytes)",
+                 s_stats.loaded_version, (unsigned long)s_stats.load_us,
+                 s_stats.blob_bytes);
+        return false;
+    }
+    if (err != ESP_ERR_NVS_NOT_FOUND) {
+        /* The old keys still hold the settings from before the first
+         * migration; bringing them back would revive e.g. an old AP
+         * password. The next save replaces the bad blob. */
+        s_stats.source = CONFIG_SOURCE_DEFAULTS;
+        s_stats.load_us = (uint32_t)(esp_timer_get_time() - started);
+        ESP_LOGE(TAG, "Settings blob unusable (%s), using defaults",
+                 esp_err_to_name(err));
+        return false;
+    }
+
+    config_store_data_t migrated;
+    set_defaults(&migrated);
+    if (!read_legacy(&migrated)) {
+        s_stats.source = CONFIG_SOURCE_DEFAULTS;
+        s_stats.load_us = (uint32_t)(esp_timer_get_time() - started);
+        ESP_LOGI(TAG, "No stored settings, using defaults");
+        return false;
+    }
+    s_stats.source = CONFIG_SOURCE_MIGRATED;
+    s_data = migrated;
+    s_stats.load_us = (uint32_t)(esp_timer_get_time() - started);
+    ESP_LOGI(TAG, "Migrated %u keys in %lu us to a %u byte blob",
+             s_stats.legacy_keys_read, (unsigned long)s_stats.legacy_read_us,
+             (unsigned)sizeof(s_blob));
+    return true;
+}
+
+esp_err_t config_store_init(void)
+{
+    if (s_lock) return ESP_OK;
+    s_lock = xSemaphoreCreateMutex();
+    s_write_lock = xSemaphoreCreateMutex();
+    if (!s_lock || !s_write_lock) return ESP_ERR_NO_MEM;
+
+    esp_err_t err = ESP_OK;
+    if (load()) {
+        /* Written at once, so the next boot reads the blob. */
+        s_dirty = true;
+        err = flush(false);
+    }
+    if (xTaskCreate(flush_task, "config_store", 3072, NULL, 1,
+                    &s_task) != pdPASS) {
+        s_task = NULL;
+        ESP_LOGW(TAG, "No flush task; settings are written when saved");
+    }
+    esp_register_shutdown_handler(flush_on_shutdown);
+    return err;
+}
+
+static void get_section(void *out, const void *section, size_t len)
+{
+    lock();
+    memcpy(out, section, len);
+    unlock();
+}
+
+/*
+ * Replaces one section of s_data and schedules a write within delay_ms.
+ * A change while a write is pending joins it; the earlier deadline wins.
+ */
+static esp_err_t set_section(size_t offset, const void *section, size_t len,
+                             uint32_t legacy_keys, uint32_t delay_ms)
+{
+    int64_t started = esp_timer_get_time();
+    lock();
+    if (memcmp((const uint8_t *)&s_data + offset, section, len) == 0) {
+        s_stats.unchanged++;
+        unlock();
+        return ESP_OK;
+    }
+    memcpy((uint8_t *)&s_data + offset, section, len);
+    terminate_strings(&s_data);
+    s_generation++;
+    s_stats.saves++;
+    s_stats.legacy_key_writes += legacy_keys;
+    int64_t due_us = started + (int64_t)delay_ms * 1000;
+    if (s_dirty) {
+        s_stats.coalesced++;
+        if (due_us < s_due_us) s_due_us = due_us;
+    } else {
+        s_dirty = true;
+        s_dirty_since_us = started;
+        s_due_us = due_us;
+    }
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - started);
+    if (elapsed_us > s_stats.max_save_us) s_stats.max_save_us = elapsed_us;
+    unlock();
+
+    /* Without the task, write at once as before. */
+    if (!s_task) return flush(false);
+    xTaskNotifyGive(s_task);
+    return ESP_OK;
+}
+
+void config_store_get_ap(config_ap_t *out)
+{
+    get_section(out, &s_data.ap, sizeof(*out));
+}
+
+void config_store_get_mqtt(config_mqtt_t *out)
+{
+    get_section(out, &s_data.mqtt, sizeof(*out));
+}
+
+void config_store_get_display(config_display_t *out)
+{
+    get_section(out, &s_data.display, sizeof(*out));
+}
+
+void config_store_get_survey(config_survey_t *out)
+{
+    get_section(out, &s_data.survey, sizeof(*out));
+}
+
+esp_err_t config_store_set_ap(const config_ap_t *ap)
+{
+    return set_section(offsetof(config_store_data_t, ap), ap, sizeof(*ap),
+                       LEGACY_AP_KEYS, CONFIG_STORE_DEBOUNCE_MS);
+}
+
+esp_err_t config_store_set_ap_lazy(const config_ap_t *ap)
+{
+    return set_section(offsetof(config_store_data_t, ap), ap, sizeof(*ap),
+                       LEGACY_AP_KEYS, CONFIG_STORE_LAZY_MS);
+}
+
+esp_err_t config_store_set_mqtt(const config_mqtt_t *mqtt)
+{
+    return set_section(offsetof(config_store_data_t, mqtt), mqtt,
+                       sizeof(*mqtt), LEGACY_MQTT_KEYS,
+                       CONFIG_STORE_DEBOUNCE_MS);
+}
+
+esp_err_t config_store_set_display(const config_display_t *display)
+{
+    /* The old setters wrote only the keys of the setting they changed. */
+    config_display_t old;
+    config_store_get_display(&old);
+    uint32_t keys = (old.enabled != display->enabled) +
+                    (old.history_minutes != display->history_minutes);
+    if (old.rotate_pages != display->rotate_pages ||
+        old.rotate_s != display->rotate_s) {
+        keys += 2;
+    }
+    return set_section(offsetof(config_store_data_t, display), display,
+                       sizeof(*display), keys, CONFIG_STORE_DEBOUNCE_MS);
+}
+
+esp_err_t config_store_set_survey(const config_survey_t *survey)
+{
+    return set_section(offsetof(config_store_data_t, survey), survey,
+                       sizeof(*survey), LEGACY_SURVEY_KEYS,
+                       CONFIG_STORE_DEBOUNCE_MS);
+}
+
+esp_err_t config_store_flush(void)
+{
+    if (!s_lock) return ESP_OK;
+    return flush(true);
+}
+
+void config_store_get_stats(config_store_stats_t *out)
+{
+    lock();
+    *out = s_stats;
+    out->pending = s_dirty;
+    out->pending_ms = s_dirty
+        ? (uint32_t)((esp_timer_get_time() - s_dirty_since_us) / 1000) : 0;
+    unlock();
+}
+
+const char *config_store_source_name(config_source_t source)
+{
+    switch (source) {
+    case CONFIG_SOURCE_BLOB: return "blob";
+    case CONFIG_SOURCE_MIGRATED: return "migrated";
+    case CONFIG_SOURCE_DEFAULTS: return "defaults";
+    }
+    return "?";
+}
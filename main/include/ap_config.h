@@ -15,6 +15,10 @@
 
 #include "esp_err.h"
 #include "esp_netif.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "scan_trace.h"
+#include "tx_power.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,20 +35,85 @@ extern "C" {
  *  - access ap_netif for DHCP station listing
  */
 
+/* Upper bound for the automatic channel changes allowed per day while
+ * clients are connected. */
+#define AP_MAX_BUSY_SWITCHES_PER_DAY 24
+
+/* Settings used until the user saves others. */
+#define AP_DEFAULT_SSID     "ESP32C3-PPP-AP"
+#define AP_DEFAULT_PASS     "12345678"
+#define AP_DEFAULT_CHANNEL  11
+#define AP_DEFAULT_CHANNEL_AUTO true
+#define AP_DEFAULT_BUSY_SWITCHES_PER_DAY 2
+
 typedef struct {
     bool channel_auto;
     uint8_t active_channel;
     uint8_t manual_channel;
+    uint8_t busy_switch_limit; /**< per day with clients, 0 = idle only */
     bool scan_in_progress;
     esp_err_t last_scan_result;
     int64_t last_scan_time_us;
 } ap_channel_status_t;
 
+typedef enum {
+    AP_SWITCH_CSA,     /**< Channel Switch Announcement, clients stay. */
+    AP_SWITCH_RESTART, /**< SoftAP stopped and started again. */
+    AP_SWITCH_PATHS,
+} ap_switch_path_t;
+
+/**
+ * Client outage per switch path: the time until every client that had an
+ * address before the switch sends a packet again.
+ */
+typedef struct {
+    uint32_t count;           /**< Switches or restarts via this path. */
+    uint32_t last_apply_ms;   /**< Driver time of the change itself. */
+    uint32_t max_apply_ms;
+    uint32_t measured;        /**< Of those, with clients to measure. */
+    uint32_t last_outage_ms;
+    uint32_t max_outage_ms;
+    uint64_t total_outage_ms;
+    uint32_t clients_dropped; /**< Disassociated during the switch. */
+    uint32_t clients_silent;  /**< Not heard again within the timeout. */
+} ap_switch_path_stats_t;
+
+typedef struct {
+    ap_switch_path_stats_t path[AP_SWITCH_PATHS];
+    uint32_t csa_fallbacks;    /**< CSA not taken by the driver. */
+    uint8_t busy_switches_24h; /**< Changes with clients, last 24 hours. */
+} ap_channel_switch_stats_t;
+
+/** How a saved AP configuration was applied; cheapest first. */
+typedef enum {
+    AP_RECONFIG_NONE,        /**< Only stored settings changed. */
+    AP_RECONFIG_CHANNEL,     /**< Channel only, moved with CSA. */
+    AP_RECONFIG_CREDENTIALS, /**< SSID or password set on the running AP. */
+    AP_RECONFIG_RESTART,     /**< Full stop and start, or a fallback. */
+    AP_RECONFIG_KINDS,
+} ap_reconfig_kind_t;
+
+/**
+ * Per kind, measured as for channel switches. A credential change
+ * disconnects every client, which cannot rejoin on its own; they are counted
+ * as dropped and not measured.
+ */
+typedef struct {
+    ap_switch_path_stats_t kind[AP_RECONFIG_KINDS];
+    uint32_t fallbacks;       /**< Cheaper operation failed, restarted. */
+} ap_reconfig_stats_t;
+
 /** Copy a consistent snapshot of the current AP configuration. */
 void ap_get_config_snapshot(char *ssid, size_t ssid_len,
                             char *pass, size_t pass_len,
                             ap_channel_status_t *channel_status);
 
+/**
+ * True while task holds the AP configuration lock. For watchdog restarts: a
+ * task deleted while holding it would block every AP configuration path.
+ */
+bool ap_config_held_by(TaskHandle_t task);
+
 /** AP netif handle (for DHCP client lookup). */
 esp_netif_t *ap_get_netif(void);
 
@@ -60,18 +129,44 @@ bool ap_is_running(void);
  */
 char ap_get_health_code(void);
 
+/**
+ * @brief Scan now and record the result without changing the channel.
+ *
+ * Briefly switches to APSTA mode like the automatic scan does.
+ */
+esp_err_t ap_record_scan(void);
+
+/** Copy the recorded scans (see scan_trace.h). */
+void ap_get_scan_trace(scan_trace_t *out);
+
+/** Channel switch counters and measured client outages. */
+void ap_get_channel_switch_stats(ap_channel_switch_stats_t *out);
+
+/** Counters and measured client outages of saved AP configurations. */
+void ap_get_reconfig_stats(ap_reconfig_stats_t *out);
+
+/** Adaptive SoftAP TX power: current level and savings since boot. */
+void ap_get_tx_power_stats(tx_power_stats_t *out);
+
 /**
  * @brief Apply new AP credentials, persist them, or restore the old settings.
  *
+ * Only what changed is applied: nothing for stored-only settings, a CSA for
+ * a new channel, a new config on the running AP for new credentials. The
+ * SoftAP is restarted only if that fails or the AP is not running.
+ *
  * @param ssid New SSID (validated already)
  * @param pass New password (empty allowed, or >=8 chars)
  * @param channel_auto Select the least congested channel automatically
  * @param manual_channel Manual 2.4 GHz channel, used when auto selection is off
+ * @param busy_switch_limit Automatic channel changes allowed per day while
+ *        clients are connected (0 to AP_MAX_BUSY_SWITCHES_PER_DAY)
  * @return ESP_OK on success
  */
 esp_err_t ap_set_credentials_and_restart(const char *ssid, const char *pass,
                                          bool channel_auto,
-                                         uint8_t manual_channel);
+                                         uint8_t manual_channel,
+                                         uint8_t busy_switch_limit);
 
 /**
  * @brief Restart AP using current in-memory credentials.
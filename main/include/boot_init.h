@@ -0,0 +1,102 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Startup scheduler and boot timeline.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file boot_init.h
+ * @brief Starts the modules as a dependency graph and records when each
+ * stage ran.
+ *
+ * app_main() describes its startup as steps, each with the steps it needs
+ * first. boot_init_run() starts every step whose dependencies are done on
+ * a task of its own, so a slow step (the OLED's I2C setup, the USB driver)
+ * no longer holds up unrelated ones. Set BOOT_INIT_PARALLEL to 0 to run
+ * the same steps one after another in table order, e.g. to measure the
+ * sequential baseline.
+ *
+ * The timeline keeps the start and end of every stage in esp_timer time,
+ * plus the first time the SoftAP started, PPP came up, and an MQTT power
+ * value arrived. /status/boot serves it.
+ */
+
+#ifndef BOOT_INIT_PARALLEL
+#define BOOT_INIT_PARALLEL 1
+#endif
+#define BOOT_INIT_MAX_STEPS 16
+#define BOOT_INIT_MAX_STAGES 24
+#define BOOT_INIT_STACK 4096
+
+#define BOOT_STEP(index) (1u << (index))
+
+typedef struct {
+    const char *name;
+    esp_err_t (*fn)(void);
+    uint32_t deps;  /**< BOOT_STEP() bits of the steps that must finish first. */
+    bool optional;  /**< A failure is logged and dependents still start. */
+} boot_init_step_t;
+
+typedef enum {
+    BOOT_MILESTONE_SOFTAP,     /**< WIFI_EVENT_AP_START */
+    BOOT_MILESTONE_PPP_UP,     /**< PPP link up with an address */
+    BOOT_MILESTONE_MQTT_VALUE, /**< First power value shown */
+    BOOT_MILESTONES,
+} boot_milestone_t;
+
+typedef struct {
+    const char *name;
+    int64_t start_us;
+    int64_t end_us;
+    esp_err_t result;
+    bool on_task;   /**< Ran on its own task, possibly alongside others. */
+} boot_stage_t;
+
+typedef struct {
+    int64_t app_main_us;   /**< app_main() entry. */
+    int64_t init_done_us;  /**< Every step finished; 0 while starting. */
+    int64_t milestone_us[BOOT_MILESTONES]; /**< 0 until reached. */
+    uint32_t stages_us;    /**< Sum of stage times: the length of a strictly
+                            *   sequential start. */
+    bool parallel;
+    size_t stage_count;
+    boot_stage_t stages[BOOT_INIT_MAX_STAGES];
+} boot_profile_t;
+
+/** Mark app_main() entry. Call first. */
+void boot_init_begin(void);
+
+/** Record a stage run directly by app_main(), started at started_us. */
+void boot_init_record(const char *name, int64_t started_us, esp_err_t result);
+
+/**
+ * Run the steps, each once its dependencies are done. Returns ESP_OK, or
+ * the error of the first required step that failed; steps depending on it
+ * are not started then. ESP_ERR_INVALID_ARG for a dependency that can never
+ * finish.
+ */
+esp_err_t boot_init_run(const boot_init_step_t *steps, size_t count);
+
+/** Record a milestone; only the first call per milestone counts. */
+void boot_init_milestone(boot_milestone_t milestone);
+
+void boot_init_get_profile(boot_profile_t *out);
+
+const char *boot_init_milestone_name(boot_milestone_t milestone);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,82 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * SoftAP channel scoring.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file channel_select.h
+ * @brief Picks the least congested channel from a scan.
+ *
+ * Beacon scoring looks at the non-overlapping channels 1, 6 and 11: every
+ * visible AP adds an RSSI weight times an overlap weight to each candidate,
+ * so a strong AP next to a candidate costs more than a weak one further
+ * away. Airtime scoring considers all channels 1-11. Each channel's load is
+ * its measured airtime use in permille plus half the RSSI weight of its APs,
+ * and a candidate's score is that load summed over the overlapping channels.
+ * An idle AP thus costs little, and a busy one costs what it occupies.
+ * No ESP-IDF dependencies, so tools/channel_sim.c can replay
+ * recorded scans through the same code as the firmware.
+ */
+
+#define CHANNEL_SELECT_CANDIDATES 3
+#define CHANNEL_SELECT_CHANNELS 11
+#define CHANNEL_SELECT_NO_AIRTIME 0xFFFF
+/* A candidate must score this much better before the AP is moved. */
+#define CHANNEL_SELECT_HYSTERESIS_PCT 25
+
+extern const uint8_t channel_select_candidates[CHANNEL_SELECT_CANDIDATES];
+
+/** One AP from a scan. */
+typedef struct {
+    uint8_t primary;
+    int8_t rssi;
+} channel_select_ap_t;
+
+/**
+ * Score every candidate into scores[] (lower is better) and return the
+ * channel to use. current wins ties; with hysteresis_pct > 0 it is also kept
+ * unless the best candidate scores that many percent lower.
+ */
+uint8_t channel_select_choose(const channel_select_ap_t *aps, size_t count,
+                              uint8_t current, unsigned hysteresis_pct,
+                              uint32_t scores[CHANNEL_SELECT_CANDIDATES]);
+
+/** Beacon score of any channel 1-11, as channel_select_choose() uses it. */
+uint32_t channel_select_beacon_score(const channel_select_ap_t *aps,
+                                     size_t count, uint8_t channel);
+
+/**
+ * Airtime score of every channel 1-11 into scores[] and the channel to use,
+ * with the same tie and hysteresis rules. airtime_permille[c - 1] is the
+ * measured use of channel c, CHANNEL_SELECT_NO_AIRTIME if not measured
+ * (only its beacons count then).
+ */
+uint8_t channel_select_choose_airtime(
+    const channel_select_ap_t *aps, size_t count,
+    const uint16_t airtime_permille[CHANNEL_SELECT_CHANNELS],
+    uint8_t current, unsigned hysteresis_pct,
+    uint32_t scores[CHANNEL_SELECT_CHANNELS]);
+
+/**
+ * Frame airtime in microseconds from the PHY fields of a received frame:
+ * ht false with a legacy rate code (wifi_phy_rate_t 0-15), or ht true with
+ * an MCS 0-7 index. len is the PSDU length in bytes.
+ */
+uint32_t channel_select_frame_airtime_us(bool ht, uint8_t rate, bool ht40,
+                                         bool short_gi, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,69 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Per-client traffic accounting on the SoftAP and PPP interfaces.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "lwip/netif.h"
+#include "traffic_table.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file client_traffic.h
+ * @brief Counts bytes and packets per SoftAP client.
+ *
+ * Wraps the input and output functions of the SoftAP lwIP netif and the
+ * output function of the PPP netif. Each IPv4 packet is attributed to the
+ * SoftAP address it comes from or goes to (traffic_table.h), so the uplink
+ * counters show each client's share of the USB link. The hooks run in the
+ * Wi-Fi and TCP/IP tasks and only take a short critical section.
+ */
+
+/* Rates are recomputed at most this often, when read. */
+#define CLIENT_TRAFFIC_RATE_MS 2000
+
+typedef struct {
+    uint64_t bytes;
+    uint32_t packets;
+    uint32_t bytes_per_s;
+} client_traffic_counter_t;
+
+typedef struct {
+    client_traffic_counter_t dir[TRAFFIC_DIR_COUNT]; /**< traffic_dir_t */
+} client_traffic_t;
+
+typedef struct {
+    uint32_t packets;         /**< Counted for a client; a PPP download
+                                   counts for Wi-Fi and uplink. */
+    uint32_t other_packets;   /**< Seen by a hook but not attributable. */
+    uint32_t evictions;       /**< Slots reused for a new address. */
+    uint32_t hook_cycles_avg; /**< CPU cycles per hooked packet. */
+} client_traffic_stats_t;
+
+/** Hook the SoftAP netif; call once it has its static address. */
+esp_err_t client_traffic_start(void);
+
+/** Hook the PPP netif; ppp.c calls this after creating it. */
+void client_traffic_attach_uplink(struct netif *netif);
+
+/**
+ * Counters and rates of the client at ip (network order, as in the station
+ * table). Returns false and zeroes out if nothing was counted for it.
+ */
+bool client_traffic_get(uint32_t ip, client_traffic_t *out);
+
+void client_traffic_get_stats(client_traffic_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,163 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Versioned settings blob shared by all modules.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file config_store.h
+ * @brief All persistent settings in one NVS blob.
+ *
+ * The blob is a small header (magic, schema version, payload length, CRC32)
+ * followed by config_store_data_t. It is read once at boot. A write is a
+ * single nvs_set_blob() and commit, so it is atomic: after a power cut
+ * either the old or the new settings load, never a mix.
+ *
+ * Setters only update the settings in RAM and return; the caller applies
+ * them at once. A low-priority task writes the blob CONFIG_STORE_DEBOUNCE_MS
+ * after the first unsaved change, so a form that changes several settings
+ * costs one flash write. A shutdown handler writes pending changes before
+ * esp_restart(); a crash or power cut within the window loses them.
+ *
+ * On the first boot without a blob the settings are migrated from the
+ * per-key namespaces used before ("apcfg", "mqttcfg", "display", "survey").
+ * The old keys are left in place for a rollback to older firmware, which
+ * will not see later changes.
+ *
+ * The structs below are the on-flash layout. New fields go at the end of
+ * config_store_data_t together with a CONFIG_STORE_VERSION bump; an older
+ * blob is loaded over the defaults and keeps them for what it lacks.
+ * Fields are ordered so the structs have no implicit padding; the reserved
+ * bytes keep it that way. Modules change a section by reading it with
+ * config_store_get_*(), editing fields and passing it back, and validate
+ * it when applying it, as they did per key.
+ */
+
+#define CONFIG_STORE_VERSION 1
+#define CONFIG_STORE_DEBOUNCE_MS 2000
+#define CONFIG_STORE_LAZY_MS (10 * 60 * 1000) /* for boot hints only */
+#define CONFIG_STORE_RETRY_MS 30000           /* after a failed write */
+
+typedef struct {
+    char ssid[33];
+    char pass[65];
+    uint8_t manual_channel;
+    uint8_t channel_auto;
+    uint8_t last_auto_channel;
+    uint8_t busy_switch_limit;
+    uint8_t reserved[2];
+} config_ap_t;
+
+typedef struct {
+    uint16_t telemetry_interval_s;
+    uint8_t broker_auto;
+    uint8_t protocol_v5;
+    uint8_t persistent_session;
+    uint8_t local_broker;
+    uint8_t telemetry_deadband_pct;
+    uint8_t reserved;
+    char broker_host[16];
+    char root_topic[64];
+    char power_subtopic[32];
+    char power_json_path[48];
+    char bridge_filters[128];
+} config_mqtt_t;
+
+typedef struct {
+    uint32_t rotate_pages;
+    uint16_t rotate_s;
+    uint16_t history_minutes;
+    uint8_t enabled;
+    uint8_t reserved[3];
+} config_display_t;
+
+typedef struct {
+    uint8_t airtime;
+    uint8_t reserved[3];
+} config_survey_t;
+
+typedef struct {
+    config_ap_t ap;
+    config_mqtt_t mqtt;
+    config_display_t display;
+    config_survey_t survey;
+} config_store_data_t;
+
+typedef enum {
+    CONFIG_SOURCE_DEFAULTS, /**< Nothing stored, or the blob is unusable. */
+    CONFIG_SOURCE_BLOB,     /**< Loaded from the blob. */
+    CONFIG_SOURCE_MIGRATED, /**< Read from the old per-key layout this boot. */
+} config_source_t;
+
+typedef struct {
+    config_source_t source;
+    uint16_t loaded_version;  /**< Schema of the blob read at boot, 0 if none. */
+    uint16_t blob_bytes;      /**< Header and payload as written. */
+    uint32_t load_us;         /**< Whole boot-time load, migration included. */
+    uint32_t blob_read_us;    /**< The nvs_get_blob() call alone. */
+    uint32_t legacy_read_us;  /**< Per-key reads of a migration, 0 otherwise. */
+    uint16_t legacy_keys_read;
+    uint32_t commits;         /**< Blob writes since boot. */
+    uint32_t saves;           /**< Setter calls that changed something. */
+    uint32_t coalesced;       /**< Saves joined to an already pending write. */
+    uint32_t unchanged;       /**< Saves skipped because nothing changed. */
+    uint32_t forced_flushes;  /**< Writes made early for a restart or OTA. */
+    uint32_t legacy_key_writes; /**< Keys the old layout would have written. */
+    uint32_t crc_errors;
+    uint32_t write_errors;
+    uint32_t last_commit_us;
+    uint32_t max_save_us;     /**< Longest setter call. */
+    bool pending;             /**< Changes not yet written. */
+    uint32_t pending_ms;      /**< Age of the oldest unwritten change. */
+} config_store_stats_t;
+
+/**
+ * Load the blob, or migrate the old keys and write the blob once, then
+ * start the flush task. Needs an initialised NVS; call before any module
+ * reads its settings. Without stored settings the defaults apply. An error
+ * means the migrated settings could not be written yet; they are used
+ * anyway and the write is retried.
+ */
+esp_err_t config_store_init(void);
+
+void config_store_get_ap(config_ap_t *out);
+void config_store_get_mqtt(config_mqtt_t *out);
+void config_store_get_display(config_display_t *out);
+void config_store_get_survey(config_survey_t *out);
+
+/**
+ * Replace a section in RAM and schedule the write. Unchanged sections are
+ * not written. Failed writes are counted and retried; the return value is
+ * an error only without the flush task, when the write is done in place.
+ */
+esp_err_t config_store_set_ap(const config_ap_t *ap);
+/** As config_store_set_ap(), for state that only matters at the next boot,
+ *  such as the last automatic channel: written within CONFIG_STORE_LAZY_MS
+ *  or with the next regular save. */
+esp_err_t config_store_set_ap_lazy(const config_ap_t *ap);
+esp_err_t config_store_set_mqtt(const config_mqtt_t *mqtt);
+esp_err_t config_store_set_display(const config_display_t *display);
+esp_err_t config_store_set_survey(const config_survey_t *survey);
+
+/** Write pending changes now, in the caller. Before a restart or OTA. */
+esp_err_t config_store_flush(void);
+
+void config_store_get_stats(config_store_stats_t *out);
+
+const char *config_store_source_name(config_source_t source);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,76 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Background worker for long operations started over HTTP.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file jobs.h
+ * @brief Runs slow operations (AP apply, channel scan, OTA finalize) one at
+ * a time on a dedicated task, so httpd handlers return at once with a job
+ * id instead of holding the server for seconds.
+ *
+ * The last JOBS_KEPT jobs stay queryable by id; /jobs/<id> serves them.
+ * Jobs report progress with jobs_set_progress() from inside their function.
+ */
+
+#define JOBS_KEPT 8
+#define JOBS_QUEUE_LEN 4 /* below JOBS_KEPT, so no pending job is evicted */
+#define JOBS_STEP_MAX 32
+
+typedef enum {
+    JOB_QUEUED,
+    JOB_RUNNING,
+    JOB_DONE,
+    JOB_FAILED,
+} job_state_t;
+
+/** A job; its return value becomes the job result. */
+typedef esp_err_t (*job_fn_t)(void *arg);
+
+typedef struct {
+    uint32_t id;
+    const char *kind;        /**< Static name, e.g. "ap_apply". */
+    job_state_t state;
+    uint8_t progress_pct;
+    char step[JOBS_STEP_MAX];
+    esp_err_t result;        /**< Valid once done or failed. */
+    int64_t queued_us;
+    int64_t started_us;
+    int64_t finished_us;
+} job_status_t;
+
+esp_err_t jobs_start(void);
+
+/**
+ * Queue fn(arg) and return its id in id_out. arg, if not NULL, must come
+ * from malloc() and is freed after fn returns, or here if the job is not
+ * queued: ESP_ERR_INVALID_STATE before jobs_start() or without fn,
+ * ESP_ERR_NO_MEM if the queue is full.
+ */
+esp_err_t jobs_submit(const char *kind, job_fn_t fn, void *arg,
+                      uint32_t *id_out);
+
+/** Progress of the running job; does nothing outside the job worker. */
+void jobs_set_progress(uint8_t pct, const char *step);
+
+/** Status of job id; false if unknown or no longer kept. */
+bool jobs_get(uint32_t id, job_status_t *out);
+
+const char *jobs_state_name(job_state_t state);
+
+#ifdef __cplusplus
+}
+#endif
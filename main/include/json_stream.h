@@ -0,0 +1,80 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Streaming JSON path extractor.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file json_stream.h
+ * @brief Pull scalar values out of a JSON document fed in arbitrary chunks.
+ *
+ * The extractor is a byte-at-a-time state machine. It never buffers the
+ * document, so memory use is sizeof(json_stream_t) regardless of the payload
+ * length or how MQTT_EVENT_DATA splits it. Paths are dot-separated object
+ * keys such as "ENERGY.Power"; array elements are parsed but never matched.
+ * Each configured path owns one value slot. A string value is stored without
+ * its quotes; numbers, true, false and null are stored as written. Values
+ * longer than JSON_STREAM_VALUE_MAX_LEN are truncated. The module has no
+ * ESP-IDF dependencies and also builds on the host (see tools/).
+ */
+
+#define JSON_STREAM_MAX_PATHS 4
+#define JSON_STREAM_PATH_MAX_LEN 47
+#define JSON_STREAM_MAX_DEPTH 16
+#define JSON_STREAM_VALUE_MAX_LEN 31
+
+typedef struct {
+    char paths[JSON_STREAM_MAX_PATHS][JSON_STREAM_PATH_MAX_LEN + 1];
+    uint8_t path_count;
+    /* Per document. */
+    uint8_t state;
+    uint8_t depth;
+    uint32_t array_bits;     /* bit d set: container at depth d is an array */
+    uint8_t scope[JSON_STREAM_MAX_DEPTH + 1]; /* paths matching the route to depth d */
+    uint8_t key_candidates;  /* paths still matching the key being read */
+    uint8_t key_pos;
+    uint8_t pending;         /* paths that continue below the value being read */
+    uint8_t value_paths;     /* paths that end at the value being read */
+    uint8_t capture_len;
+    uint8_t found;           /* bit per path: slot holds a complete value */
+    uint8_t seg_start[JSON_STREAM_MAX_PATHS][JSON_STREAM_MAX_DEPTH];
+    uint8_t seg_count[JSON_STREAM_MAX_PATHS];
+    char values[JSON_STREAM_MAX_PATHS][JSON_STREAM_VALUE_MAX_LEN + 1];
+} json_stream_t;
+
+/** True if path is a non-empty, dot-separated key list that fits the limits. */
+bool json_stream_valid_path(const char *path);
+
+/**
+ * Configure the paths to extract and reset for a new document.
+ * Returns false (and configures nothing) if a path is invalid or count is
+ * above JSON_STREAM_MAX_PATHS.
+ */
+bool json_stream_init(json_stream_t *js, const char *const *paths, size_t count);
+
+/** Forget the current document; the configured paths are kept. */
+void json_stream_reset(json_stream_t *js);
+
+/** Feed the next chunk of the document. Chunks may split any token. */
+void json_stream_feed(json_stream_t *js, const char *data, size_t len);
+
+/** True once the top-level value is complete and was well-formed. */
+bool json_stream_complete(const json_stream_t *js);
+
+/** Value of path index idx, or NULL if the document did not contain it. */
+const char *json_stream_value(const json_stream_t *js, size_t idx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,34 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Optional local MQTT broker on the SoftAP address.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "mqtt_broker.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Start the broker task. It follows the local_broker and bridge_filters
+ * settings of mqtt_telemetry: the broker listens on the SoftAP address while
+ * enabled, hands every PUBLISH to mqtt_telemetry_ingest_local(), and bridges
+ * matching topics upstream through mqtt_telemetry_publish_upstream().
+ */
+esp_err_t local_broker_start(void);
+
+/** True while the broker is listening. */
+bool local_broker_is_running(void);
+
+/** Copy the broker and bridge counters (zero while never started). */
+void local_broker_get_stats(mqtt_broker_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
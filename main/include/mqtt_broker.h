@@ -0,0 +1,107 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Minimal MQTT 3.1.1 broker with a coalescing upstream bridge.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file mqtt_broker.h
+ * @brief Just enough of an MQTT broker for the few devices on the SoftAP.
+ *
+ * Supported: MQTT 3.1 and 3.1.1 CONNECT, PUBLISH with QoS 0-2 from clients,
+ * SUBSCRIBE and UNSUBSCRIBE with '+' and '#' filters, retained messages, and
+ * keepalive. Delivery to subscribers is always QoS 0. Sessions are never
+ * persisted, and wills, MQTT v5 and authentication are not supported. Every
+ * PUBLISH is also passed to the deliver_local hook.
+ *
+ * Messages whose topic matches a bridge filter are held in a small table that
+ * keeps only the latest payload per topic. The table is flushed through the
+ * forward hook once per batch period, so a burst of updates to one topic costs
+ * one upstream message. A payload equal to the last one forwarded for that
+ * topic is skipped unless MQTT_BRIDGE_REFRESH_MS has passed.
+ *
+ * The module uses only BSD sockets and libc, which lwIP provides on the ESP32,
+ * so it also runs on the host (tools/mqtt_broker_host.c). It is single-threaded:
+ * all calls except mqtt_broker_get_stats() must come from the same task.
+ */
+
+#define MQTT_BROKER_PORT 1883
+#define MQTT_BROKER_MAX_CLIENTS 4
+#define MQTT_BROKER_MAX_SUBSCRIPTIONS 8
+#define MQTT_BROKER_TOPIC_MAX_LEN 95
+#define MQTT_BROKER_MAX_PACKET 1024
+#define MQTT_BROKER_MAX_RETAINED 8
+#define MQTT_BRIDGE_MAX_TOPICS 16
+#define MQTT_BRIDGE_FILTERS_MAX_LEN 127
+#define MQTT_BRIDGE_DEFAULT_FILTERS "#"
+#define MQTT_BRIDGE_DEFAULT_BATCH_MS 2000
+#define MQTT_BRIDGE_REFRESH_MS 60000
+
+typedef struct {
+    /** Address to listen on (network byte order); 0 listens on all. */
+    uint32_t bind_addr;
+    uint16_t port;
+    /** Comma-separated topic filters to forward; empty disables the bridge. */
+    const char *bridge_filters;
+    uint32_t batch_ms;
+    /** Called for every PUBLISH received from a client. */
+    void (*deliver_local)(void *ctx, const char *topic, const uint8_t *payload,
+                          size_t len, bool retain);
+    /** Send one message upstream; false keeps it queued for the next batch. */
+    bool (*forward)(void *ctx, const char *topic, const uint8_t *payload,
+                    size_t len, bool retain);
+    /** Monotonic clock in milliseconds. */
+    int64_t (*clock_ms)(void);
+    void *ctx;
+} mqtt_broker_config_t;
+
+typedef struct {
+    uint32_t clients;            /**< Currently connected. */
+    uint32_t connects;
+    uint32_t rx_publishes;
+    uint32_t tx_publishes;       /**< Deliveries to local subscribers. */
+    uint32_t bridge_forwarded;
+    uint32_t bridge_batches;     /**< Flushes that forwarded at least one message. */
+    uint32_t bridge_coalesced;   /**< Pending payloads replaced before a flush. */
+    uint32_t bridge_deduplicated;/**< Unchanged payloads not forwarded again. */
+    uint32_t bridge_dropped;     /**< Table full or payload too large. */
+    uint32_t protocol_errors;
+} mqtt_broker_stats_t;
+
+/** True if filters is a valid comma-separated list of MQTT topic filters. */
+bool mqtt_broker_valid_filters(const char *filters);
+
+/** True if topic matches the MQTT topic filter. */
+bool mqtt_broker_topic_matches(const char *filter, const char *topic);
+
+/** Allocate state and start listening. False if already running or on error. */
+bool mqtt_broker_start(const mqtt_broker_config_t *config);
+
+/**
+ * Wait up to timeout_ms for socket activity and process it, then expire
+ * idle clients and flush the bridge when its batch period has passed.
+ */
+void mqtt_broker_poll(int timeout_ms);
+
+/** Forward everything pending, disconnect all clients and free the state. */
+void mqtt_broker_stop(void);
+
+bool mqtt_broker_is_running(void);
+
+/** Copy the counters. Fields are updated individually, without a lock. */
+void mqtt_broker_get_stats(mqtt_broker_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -9,7 +9,10 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include "esp_err.h"
+#include "json_stream.h"
+#include "mqtt_broker.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,14 +22,98 @@ extern "C" {
 #define MQTT_BROKER_HOST_MAX_LEN 15
 #define MQTT_ROOT_TOPIC_MAX_LEN 63
 #define MQTT_DEFAULT_ROOT_TOPIC "OBK-681"
+#define MQTT_POWER_SUBTOPIC_MAX_LEN 31
+#define MQTT_DEFAULT_POWER_SUBTOPIC "power/get"
+#define MQTT_POWER_JSON_PATH_MAX_LEN JSON_STREAM_PATH_MAX_LEN
+/** Longest full topic: root, '/', and the longest subtopic. */
+#define MQTT_TOPIC_MAX_LEN (MQTT_ROOT_TOPIC_MAX_LEN + 1 + MQTT_POWER_SUBTOPIC_MAX_LEN)
 #define OBK_POWER_STALE_TIMEOUT_MS 30000
+#define MQTT_SELF_TELEMETRY_SUBTOPIC "esp32/state"
+#define MQTT_SELF_TELEMETRY_DEFAULT_INTERVAL_S 60
+#define MQTT_SELF_TELEMETRY_MIN_INTERVAL_S 10
+#define MQTT_SELF_TELEMETRY_MAX_INTERVAL_S 3600
+#define MQTT_SELF_TELEMETRY_DEFAULT_DEADBAND_PCT 5
+#define MQTT_SELF_TELEMETRY_MAX_DEADBAND_PCT 100
 
 typedef struct {
     bool broker_auto;
     char broker_host[MQTT_BROKER_HOST_MAX_LEN + 1];
     char root_topic[MQTT_ROOT_TOPIC_MAX_LEN + 1];
+    /** Power topic below the root, for example "power/get" or "tele/SENSOR". */
+    char power_subtopic[MQTT_POWER_SUBTOPIC_MAX_LEN + 1];
+    /**
+     * Dot-separated key path of the power value in a JSON payload, for
+     * example "ENERGY.Power". Empty means the payload is the plain value.
+     */
+    char power_json_path[MQTT_POWER_JSON_PATH_MAX_LEN + 1];
+    /** Self-telemetry sampling period in seconds; 0 disables publishing. */
+    uint16_t telemetry_interval_s;
+    /** Relative change required before a sample is published again. */
+    uint8_t telemetry_deadband_pct;
+    /** Connect with MQTT v5 (topic aliases, subscription identifiers). */
+    bool protocol_v5;
+    /**
+     * Keep the broker session across reconnects (stable client id, QoS 1
+     * subscriptions) and show the last known power value while waiting for
+     * a fresh one.
+     */
+    bool persistent_session;
+    /**
+     * Run the local broker on the SoftAP and take power and connection state
+     * from it instead of subscribing upstream.
+     */
+    bool local_broker;
+    /** Comma-separated filters of local topics bridged upstream. */
+    char bridge_filters[MQTT_BRIDGE_FILTERS_MAX_LEN + 1];
 } mqtt_telemetry_config_t;
 
+/** Last known power value with its freshness. */
+typedef struct {
+    char value[64];
+    bool valid;     /**< A value is available, fresh or cached. */
+    bool stale;     /**< Cached value: broker down or no update within the timeout. */
+    bool retained;  /**< Last delivery was a retained copy from the broker. */
+    int32_t age_s;  /**< Seconds since the last live update, -1 if unknown. */
+} mqtt_power_reading_t;
+
+/** Broker connect to first power value shown, over all reconnects. */
+typedef struct {
+    uint32_t last_ms;
+    uint32_t best_ms;
+    uint32_t worst_ms;
+    uint32_t samples;
+    bool last_from_retained; /**< The last first value was a retained copy. */
+    bool pending;            /**< Connected, still waiting for a value. */
+} mqtt_first_display_stats_t;
+
+typedef struct {
+    uint32_t published;  /**< Self-telemetry payloads handed to ESP-MQTT. */
+    uint32_t suppressed; /**< Samples skipped because they were inside the deadband. */
+    uint32_t failed;     /**< Samples that ESP-MQTT refused to publish. */
+    int64_t last_published_us;
+} mqtt_self_telemetry_stats_t;
+
+/**
+ * Cost counters of the current client session, used to compare the v5 and
+ * v3.1.1 paths. tx_wire_bytes is the encoded PUBLISH size (fixed header,
+ * topic, properties, payload). Dispatch cycles cover mapping an incoming
+ * PUBLISH to its metric.
+ */
+typedef struct {
+    bool protocol_v5;
+    uint32_t tx_messages;
+    uint64_t tx_wire_bytes;
+    uint32_t tx_alias_hits;   /**< PUBLISHes sent with an empty, aliased topic. */
+    uint32_t rx_messages;
+    uint32_t dispatch_by_id;
+    uint32_t dispatch_by_topic;
+    uint64_t dispatch_id_cycles;
+    uint64_t dispatch_topic_cycles;
+} mqtt_link_stats_t;
+
+/** Called after the displayed power value or connection state changed. */
+typedef void (*mqtt_telemetry_update_cb_t)(void);
+
 /** Load persistent settings and start the MQTT client task. */
 esp_err_t mqtt_telemetry_start(void);
 
@@ -43,18 +130,62 @@ bool mqtt_telemetry_get_effective_broker_host(char *out, size_t out_len);
  * Persist new settings and reconnect the client.
  * In automatic mode the PPP peer is used and broker_host may be empty. In
  * manual mode broker_host must be an IPv4 address. root_topic must be an exact
- * topic root without '/', whitespace, '+' or '#'.
+ * topic root without '/', whitespace, '+' or '#'. power_subtopic may contain
+ * '/' between levels but no wildcards; power_json_path must be empty or a
+ * valid json_stream path. The self-telemetry interval must be 0 or between
+ * the MIN and MAX limits above. bridge_filters must be empty or pass
+ * mqtt_broker_valid_filters().
  */
-esp_err_t mqtt_telemetry_set_config(bool broker_auto, const char *broker_host,
-                                    const char *root_topic);
+esp_err_t mqtt_telemetry_set_config(const mqtt_telemetry_config_t *config);
+
+/** Copy the self-telemetry publisher counters. */
+void mqtt_telemetry_get_self_stats(mqtt_self_telemetry_stats_t *out);
+
+/** Copy the wire-size and dispatch-cost counters of the current session. */
+void mqtt_telemetry_get_link_stats(mqtt_link_stats_t *out);
 
 /** Copy the latest fresh power payload, or "N/A" when unavailable/stale. */
 void mqtt_telemetry_get_power(char *out, size_t out_len);
 
+/**
+ * Fill the latest power value. With a persistent session a stale value is
+ * still returned, marked stale, so the display need not fall back to "N/A".
+ * Returns out->valid.
+ */
+bool mqtt_telemetry_get_power_reading(mqtt_power_reading_t *out);
+
+/** Copy the time-to-first-display measurements. */
+void mqtt_telemetry_get_first_display_stats(mqtt_first_display_stats_t *out);
+
+/**
+ * Feed a PUBLISH received by the local broker. Topics equal to the configured
+ * power and connected topics update the same state as upstream deliveries.
+ * Called from the local broker task only.
+ */
+void mqtt_telemetry_ingest_local(const char *topic, const uint8_t *payload,
+                                 size_t len, bool retain);
+
+/**
+ * Queue a bridged message on the upstream client (QoS 0). Returns false while
+ * the broker is not connected, so the bridge keeps the message for later.
+ */
+bool mqtt_telemetry_publish_upstream(const char *topic, const uint8_t *payload,
+                                     size_t len, bool retain);
+
+/** Report whether the local broker is up; it is the value source meanwhile. */
+void mqtt_telemetry_set_local_source(bool up);
+
+/**
+ * Register one callback for value changes, so a display can sleep until
+ * something changes. It runs on the MQTT or local broker task and must not
+ * block; NULL unregisters.
+ */
+void mqtt_telemetry_set_update_callback(mqtt_telemetry_update_cb_t callback);
+
 /**
  * Return the OBK connection state.
  *  1 = online, 0 = offline, -1 = no retained state yet,
- * -2 = configured MQTT broker is not connected.
+ * -2 = the value source (upstream or local broker) is not connected.
  */
 int mqtt_telemetry_get_obk_connected_state(void);
 
@@ -12,6 +12,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "esp_err.h"
 
 #ifdef __cplusplus
@@ -24,10 +25,51 @@ extern "C" {
  *
  * Responsibilities:
  *  - Initialize u8g2 + I2C HAL for SSD1306 OLED.
- *  - Refresh screen periodically.
+ *  - Redraw the current page when its inputs change or it is due.
+ *  - Rotate through the configured pages.
  *  - Display latest MQTT OBK power payload.
  */
 
+/** Cost of the frames sent to the panel, and OLED task wakeups, since boot. */
+typedef struct {
+    uint32_t frames;
+    uint32_t full_frames;      /**< First frame and periodic full refreshes. */
+    uint32_t unchanged_frames; /**< Frames identical to the previous one. */
+    uint64_t tiles_sent;       /**< 8x8 tiles, 128 per full frame. */
+    uint64_t i2c_bytes;        /**< Wire bytes including commands and addresses. */
+    uint64_t i2c_us;
+    uint32_t last_bytes;
+    uint32_t last_us;
+    uint32_t task_wakeups;     /**< Returns from the OLED task's wait. */
+    uint64_t render_us;        /**< Drawing into the buffer, before transfer. */
+    uint32_t over_budget_frames;
+    uint32_t skipped_renders;  /**< Wakeups whose changes the page ignores. */
+    const char *page;          /**< Page shown, NULL before the first frame. */
+    uint32_t history_columns;  /**< Graph columns closed since the span was set. */
+    uint32_t history_rescales; /**< Full height recomputations. */
+} oled_frame_stats_t;
+
+/* Pages that can take part in the rotation. */
+#define OLED_ROTATE_POWER (1u << 0)
+#define OLED_ROTATE_DEBUG (1u << 1)
+#define OLED_ROTATE_HISTORY (1u << 2)
+#define OLED_ROTATE_CLIENTS (1u << 3)
+#define OLED_ROTATE_ALL \
+    (OLED_ROTATE_POWER | OLED_ROTATE_DEBUG | OLED_ROTATE_HISTORY | \
+     OLED_ROTATE_CLIENTS)
+#define OLED_ROTATE_MIN_S 3
+#define OLED_ROTATE_MAX_S 3600
+
+/* Span of the power graph page. */
+#define OLED_HISTORY_MIN_MINUTES 10
+#define OLED_HISTORY_MAX_MINUTES 1440
+#define OLED_HISTORY_DEFAULT_MINUTES 60
+
+typedef struct {
+    uint32_t pages;      /**< OLED_ROTATE_* bits; none shows the power page. */
+    uint16_t interval_s; /**< Seconds per page; 0 keeps the first page. */
+} oled_rotation_t;
+
 esp_err_t oled_start(void);
 void oled_blank_and_reset_screensaver(void);
 /** Persistently enable or power-save the OLED. */
@@ -37,6 +79,18 @@ bool oled_is_enabled(void);
 
 /** Request the same debug-page toggle as a BOOT-button press. */
 void oled_request_debug_toggle(void);
+/** Copy the page rotation setting. */
+void oled_get_rotation(oled_rotation_t *out);
+/** Validate, persist and apply the page rotation; ESP_ERR_INVALID_ARG if
+ *  a bit or the interval is out of range. */
+esp_err_t oled_set_rotation(const oled_rotation_t *rotation);
+/** Span of the power graph in minutes. */
+uint16_t oled_get_history_minutes(void);
+/** Persist a new graph span; the history restarts empty.
+ *  ESP_ERR_INVALID_ARG outside OLED_HISTORY_MIN/MAX_MINUTES. */
+esp_err_t oled_set_history_minutes(uint16_t minutes);
+/** Copy the frame transfer counters. */
+void oled_get_frame_stats(oled_frame_stats_t *out);
 
 #ifdef __cplusplus
 }
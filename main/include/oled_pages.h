@@ -0,0 +1,126 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * OLED page renderers.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "u8g2.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file oled_pages.h
+ * @brief Draws each OLED page into the u8g2 buffer from plain data.
+ *
+ * The renderers only clear and draw the buffer; oled.c gathers the data and
+ * sends the frame. They depend on u8g2 alone, so tools/oled_render.c runs
+ * them on the host for golden-image snapshots and frame timing.
+ */
+
+#define OLED_WIDTH 128
+#define OLED_HEIGHT 64
+/* Top-left corner and width of the area visible on the 0.42" panel. */
+#define OLED_CONTENT_X_OFFSET 28
+#define OLED_CONTENT_Y_OFFSET 18
+#define OLED_CONTENT_WIDTH 72
+#define OLED_DEBUG_LINE_COUNT 4
+#define OLED_DEBUG_LINE_LEN 15
+#define OLED_CREDENTIAL_LINE_CHARS 25
+#define OLED_CREDENTIAL_LINE_COUNT 5
+
+typedef struct {
+    const char *label;  /**< "Power (W)" or a stale label. */
+    const char *value;
+    int clients;
+    int8_t rssi;        /**< Best client RSSI, INT8_MIN if unknown. */
+    char marker;        /**< 'X', '+', '-', or 0 to show the RSSI bar. */
+    int jitter_x;       /**< Burn-in shift: -1, 0 or 1 pixel. */
+} oled_power_page_t;
+
+typedef struct {
+    const char *label;      /**< Min/avg/max line above the graph. */
+    const uint8_t *heights; /**< Bar heights oldest first, 0 = no data. */
+    size_t count;           /**< Number of heights, newest at the right. */
+    uint8_t max_height;
+    int jitter_x;
+} oled_history_page_t;
+
+/** One SoftAP station on the clients page. */
+typedef struct {
+    uint8_t index;          /**< 0-based position among count stations. */
+    uint8_t count;          /**< 0 shows "No clients". */
+    uint8_t mac_tail[2];    /**< Last two MAC bytes. */
+    int8_t rssi_avg;        /**< Smoothed dBm, INT8_MIN before the first sample. */
+    int8_t rssi_min;
+    int8_t rssi_max;
+    uint16_t stddev_ddb;    /**< 0.1 dB. */
+    uint16_t poor_crossings;
+    uint32_t connected_s;
+} oled_client_page_t;
+
+/** Position and direction of the bouncing screensaver text. */
+typedef struct {
+    int x;
+    int y;
+    int dx;
+    int dy;
+} oled_screensaver_t;
+
+/** "Power (W)", or "Old (W) <age>" for a stale value (age_s < 0: unknown). */
+void oled_pages_format_power_label(char *out, size_t out_len, bool stale,
+                                   int32_t age_s);
+
+/** Horizontal RSSI bar, one pixel per dBm from -100 to -45 dBm. */
+void oled_pages_draw_signal_bar(u8g2_t *u8g2, int x, int y, int8_t rssi);
+
+void oled_pages_draw_power(u8g2_t *u8g2, const oled_power_page_t *page);
+
+/** Pixel width of value in large digits, -1 if a character has no glyph. */
+int oled_pages_big_value_width(const char *value);
+
+/**
+ * Blit value from the build-time digit atlas (0-9, '.', '-', ' ') with its
+ * top-left corner at x, y, writing the u8g2 buffer directly (U8G2_R0 only).
+ * Returns false without drawing if a character has no glyph.
+ */
+bool oled_pages_draw_big_value(u8g2_t *u8g2, int x, int y, const char *value);
+
+/** "H<max> A<avg> L<min>" in whole watts, "No data" if !valid. */
+void oled_pages_format_history_label(char *out, size_t out_len, bool valid,
+                                     int32_t min_dw, int32_t max_dw,
+                                     int32_t avg_dw);
+
+/** Summary line and a bar per column, bottom-aligned, one pixel wide. */
+void oled_pages_draw_history(u8g2_t *u8g2, const oled_history_page_t *page);
+
+/** Debug-page lines for one station: position and MAC, smoothed RSSI and
+ *  deviation, window range and poor-signal count, time connected. */
+void oled_pages_format_client(char lines[OLED_DEBUG_LINE_COUNT]
+                                        [OLED_DEBUG_LINE_LEN + 1],
+                              const oled_client_page_t *client);
+
+void oled_pages_draw_debug(u8g2_t *u8g2,
+                           const char lines[OLED_DEBUG_LINE_COUNT]
+                                           [OLED_DEBUG_LINE_LEN + 1]);
+
+/** SSID and password, wrapped and centred; an empty password shows <OPEN>. */
+void oled_pages_draw_credentials(u8g2_t *u8g2, const char *ssid,
+                                 const char *password);
+
+void oled_pages_screensaver_reset(oled_screensaver_t *ss);
+
+/** Move text one pixel along its bounce path and draw it. */
+void oled_pages_draw_screensaver(u8g2_t *u8g2, oled_screensaver_t *ss,
+                                 const char *text);
+
+#ifdef __cplusplus
+}
+#endif
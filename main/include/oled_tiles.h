@@ -0,0 +1,56 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Dirty-tile diff for incremental OLED updates.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file oled_tiles.h
+ * @brief Finds the 8x8 tiles that changed since the last frame sent.
+ *
+ * Buffers use the u8g2 full-buffer layout of the SSD1306: tile_rows pages of
+ * tile_cols * 8 bytes, where each byte is one column of eight pixels, so a
+ * tile is eight consecutive bytes. Changed tiles in a page are grouped into
+ * runs, and each run is passed to a send callback that transfers it, for
+ * example with u8g2_UpdateDisplayArea(). No ESP-IDF or u8g2 dependency, so
+ * tools/oled_tiles_check.c can verify it on the host.
+ */
+
+#define OLED_TILE_BYTES 8
+/* Clean tiles between two dirty runs that are sent anyway to join them;
+ * one tile of data costs about as much as addressing a new run. */
+#define OLED_TILES_MERGE_GAP 1
+
+/** Transfer tw tiles of page ty starting at tile column tx. */
+typedef void (*oled_tiles_send_fn)(void *ctx, uint8_t tx, uint8_t ty,
+                                   uint8_t tw);
+
+typedef struct {
+    uint16_t tiles; /**< Tiles sent, including merged clean tiles. */
+    uint16_t runs;  /**< Send callbacks. */
+} oled_tiles_result_t;
+
+/**
+ * Send the runs of frame that differ from shadow, then copy them into shadow
+ * so it again mirrors the panel. With full set every tile is sent, which
+ * also (re)initialises shadow.
+ */
+oled_tiles_result_t oled_tiles_flush(const uint8_t *frame, uint8_t *shadow,
+                                     uint8_t tile_cols, uint8_t tile_rows,
+                                     bool full, oled_tiles_send_fn send,
+                                     void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,101 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Power history for the OLED graph page.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file power_history.h
+ * @brief Fixed-width power history with cached bar heights.
+ *
+ * The span is split into POWER_HISTORY_COLUMNS columns of equal duration.
+ * Power is sample-and-hold: a value counts until the next one or until it
+ * is marked unknown, so a constant reading still fills columns. Each column
+ * stores the time-weighted average and the min/max in deciwatts.
+ *
+ * A column's bar height is computed once, in Q24 fixed point, when the
+ * column closes. Only the open column is recomputed on each read. All heights
+ * are recomputed only when the vertical scale changes, which happens when a
+ * value leaves the scale or the window falls below a quarter of it. Scales
+ * are 1/2/5 steps, so a rescale is rare.
+ *
+ * No ESP-IDF dependencies; also used by tools/oled_render.c.
+ */
+
+#define POWER_HISTORY_COLUMNS 70
+/** Bar height in pixels for the scale maximum. */
+#define POWER_HISTORY_HEIGHT 30
+/** Height value for a column without data. */
+#define POWER_HISTORY_NO_DATA 0
+
+typedef struct {
+    int32_t avg_dw;
+    int32_t min_dw;
+    int32_t max_dw;
+    uint8_t height;
+    bool valid;
+} power_history_column_t;
+
+typedef struct {
+    power_history_column_t columns[POWER_HISTORY_COLUMNS]; /**< Closed, ring. */
+    uint8_t head;            /**< Oldest closed column. */
+    uint8_t count;
+    uint32_t column_ms;
+    int64_t column_start_ms; /**< Start of the open column. */
+    int64_t open_sum;        /**< Deciwatt-milliseconds. */
+    int64_t open_weight_ms;
+    int32_t open_min_dw;
+    int32_t open_max_dw;
+    int32_t hold_dw;
+    bool hold_valid;
+    int64_t hold_since_ms;
+    int32_t scale_lo_dw;
+    int32_t scale_hi_dw;
+    uint32_t scale_q24;      /**< (POWER_HISTORY_HEIGHT - 1) / range, Q24. */
+    uint32_t columns_closed;
+    uint32_t rescales;
+} power_history_t;
+
+typedef struct {
+    int32_t min_dw;
+    int32_t max_dw;
+    int32_t avg_dw;
+    bool valid;
+} power_history_summary_t;
+
+/** Empty history with columns of column_ms, the first opening at now_ms. */
+void power_history_init(power_history_t *h, uint32_t column_ms, int64_t now_ms);
+
+/** New reading at now_ms; valid=false marks the power unknown from now on. */
+void power_history_set(power_history_t *h, int64_t now_ms, bool valid,
+                       int32_t value_dw);
+
+/** Account the held value up to now_ms, closing columns that ended. */
+void power_history_advance(power_history_t *h, int64_t now_ms);
+
+/**
+ * Bar heights oldest first, the open column last. POWER_HISTORY_NO_DATA
+ * marks a column without data. Returns the number written, at most
+ * POWER_HISTORY_COLUMNS.
+ */
+size_t power_history_heights(const power_history_t *h,
+                             uint8_t out[POWER_HISTORY_COLUMNS]);
+
+/** Min, max and average over the columns in the window. */
+void power_history_get_summary(const power_history_t *h,
+                               power_history_summary_t *out);
+
+#ifdef __cplusplus
+}
+#endif
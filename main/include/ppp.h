@@ -10,6 +10,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "esp_err.h"
 #include "lwip/ip4_addr.h"
 
@@ -44,6 +45,15 @@ void ppp_get_ip_info(ip4_addr_t *ip, ip4_addr_t *gw, ip4_addr_t *nm);
  */
 ip4_addr_t ppp_get_ip(void);
 
+typedef struct {
+    uint64_t rx_bytes;     /**< Serial bytes fed into lwIP PPP since boot. */
+    uint64_t tx_bytes;     /**< Serial bytes written to the USB host since boot. */
+    uint32_t link_up_count; /**< Completed PPP negotiations since boot. */
+} ppp_stats_t;
+
+/** Copy the cumulative PPP link counters. */
+void ppp_get_stats(ppp_stats_t *out);
+
 #ifdef __cplusplus
 }
 #endif
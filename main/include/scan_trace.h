@@ -0,0 +1,109 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Recorded channel scans.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file scan_trace.h
+ * @brief Ring of the last channel scans and their CSV text form.
+ *
+ * The firmware keeps the fields of each wifi_ap_record_t that channel
+ * selection can use and serves them on /debug/scans. tools/channel_sim.c
+ * parses the same text, so a trace from the device can be replayed on a PC.
+ * No ESP-IDF dependencies.
+ *
+ * Text form, one record per line:
+ *   S,<seq>,<uptime_s>,<ap_channel>,<aps_seen>
+ *   U,<channel>,<airtime_permille>
+ *   A,<bssid>,<primary>,<second>,<rssi>
+ * An S line starts a scan; the U and A lines after it are its measured
+ * airtime per channel (only for measured channels) and its APs. second is
+ * the wifi_second_chan_t value. Lines starting with '#' are comments.
+ */
+
+#define SCAN_TRACE_SCANS 8
+#define SCAN_TRACE_APS 32 /* strongest kept per scan */
+#define SCAN_TRACE_LINE_MAX 48
+#define SCAN_TRACE_CHANNELS 11
+#define SCAN_TRACE_NO_AIRTIME 0xFFFF /* same as CHANNEL_SELECT_NO_AIRTIME */
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t primary;
+    uint8_t second;
+    int8_t rssi;
+} scan_trace_ap_t;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t uptime_s;
+    uint8_t ap_channel; /**< SoftAP channel while scanning. */
+    uint16_t seen;      /**< APs reported by the driver. */
+    uint8_t count;      /**< APs kept. */
+    uint16_t airtime_permille[SCAN_TRACE_CHANNELS]; /**< From the survey. */
+    scan_trace_ap_t ap[SCAN_TRACE_APS];
+} scan_trace_scan_t;
+
+typedef struct {
+    uint32_t next_seq;
+    uint8_t count;
+    uint8_t head; /**< Next slot to write. */
+    scan_trace_scan_t scans[SCAN_TRACE_SCANS];
+} scan_trace_t;
+
+void scan_trace_init(scan_trace_t *t);
+
+/** Empty scan taken at uptime_s on ap_channel. */
+void scan_trace_scan_init(scan_trace_scan_t *scan, uint32_t uptime_s,
+                          uint8_t ap_channel);
+
+/** Add one AP; a full scan keeps the strongest. */
+void scan_trace_scan_add(scan_trace_scan_t *scan, const scan_trace_ap_t *ap);
+
+/** Store scan as the newest, dropping the oldest if full; sets its seq. */
+void scan_trace_push(scan_trace_t *t, scan_trace_scan_t *scan);
+
+/** i-th stored scan, oldest first, or NULL. */
+const scan_trace_scan_t *scan_trace_get(const scan_trace_t *t, size_t i);
+
+/** The S line of scan, newline included; returns its length. */
+int scan_trace_format_scan(char *buf, size_t len,
+                           const scan_trace_scan_t *scan);
+
+/** The U line of channel in scan, newline included; returns its length,
+ * 0 if the channel has no airtime. */
+int scan_trace_format_airtime(char *buf, size_t len,
+                              const scan_trace_scan_t *scan, uint8_t channel);
+
+/** The A line of ap, newline included; returns its length. */
+int scan_trace_format_ap(char *buf, size_t len, const scan_trace_ap_t *ap);
+
+typedef enum {
+    SCAN_TRACE_LINE_SKIP, /**< Blank or comment. */
+    SCAN_TRACE_LINE_SCAN, /**< Header fields filled in, count zeroed. */
+    SCAN_TRACE_LINE_AIRTIME, /**< One entry of scan->airtime_permille. */
+    SCAN_TRACE_LINE_AP,
+    SCAN_TRACE_LINE_ERROR,
+} scan_trace_line_t;
+
+/** Parse one line into scan (S, U) or ap (A). A U line only sets its entry,
+ * so keep passing the same scan after its S line. */
+scan_trace_line_t scan_trace_parse_line(const char *line,
+                                        scan_trace_scan_t *scan,
+                                        scan_trace_ap_t *ap);
+
+#ifdef __cplusplus
+}
+#endif
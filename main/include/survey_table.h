@@ -0,0 +1,104 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Per-channel occupancy from the background survey.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "channel_select.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file survey_table.h
+ * @brief What the incremental survey has seen on channels 1-11.
+ *
+ * Each dwell on one channel updates that channel's counters and the APs
+ * heard, keyed by BSSID. An AP on the channel that was not heard for
+ * SURVEY_AP_TTL_DWELLS dwells in a row is dropped, so the table follows the
+ * neighbourhood without one missed beacon removing an AP. Airtime windows,
+ * when measured, update the channel's smoothed share of time occupied by
+ * frames. No ESP-IDF dependencies.
+ */
+
+#define SURVEY_CHANNELS 11
+#define SURVEY_MAX_APS 48
+#define SURVEY_AP_TTL_DWELLS 3
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t primary;
+    int8_t rssi;       /**< Smoothed, dBm. */
+    uint8_t missed;    /**< Dwells on its channel without it, in a row. */
+} survey_ap_t;
+
+typedef struct {
+    uint32_t dwells;
+    uint32_t last_dwell_s; /**< Uptime of the latest dwell, 0 if none. */
+    uint32_t dwell_ms;     /**< Total time spent listening. */
+    uint16_t aps;          /**< APs with this primary in the table. */
+    uint16_t aps_avg_q4;   /**< APs heard per dwell, smoothed, 1/16. */
+    int8_t strongest;      /**< Strongest AP in the table, INT8_MIN if none. */
+    uint16_t airtime_permille; /**< Smoothed, CHANNEL_SELECT_NO_AIRTIME
+                                    until the first window. */
+    uint32_t airtime_windows;
+    uint32_t airtime_frames;   /**< Frames heard in the latest window. */
+} survey_channel_t;
+
+typedef struct {
+    uint32_t sweeps;       /**< Times every channel has been visited. */
+    uint32_t dwells;
+    uint16_t visited;      /**< Bit per channel visited in this sweep. */
+    uint32_t dropped_aps;  /**< Not stored because the table was full. */
+    survey_channel_t ch[SURVEY_CHANNELS];
+    uint8_t ap_count;
+    survey_ap_t ap[SURVEY_MAX_APS];
+} survey_table_t;
+
+void survey_table_init(survey_table_t *t);
+
+/** One AP as reported by a dwell. */
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t primary;
+    int8_t rssi;
+} survey_seen_t;
+
+/** Record a dwell of dwell_ms on channel at uptime now_s. */
+void survey_table_record(survey_table_t *t, uint8_t channel,
+                         const survey_seen_t *seen, size_t count,
+                         uint32_t now_s, uint32_t dwell_ms);
+
+/** Record an airtime window of window_us with busy_us of frames heard. */
+void survey_table_record_airtime(survey_table_t *t, uint8_t channel,
+                                 uint32_t busy_us, uint32_t window_us,
+                                 uint32_t frames);
+
+/**
+ * Smoothed airtime per channel in the form channel_select_choose_airtime()
+ * takes; true if every channel has been measured.
+ */
+bool survey_table_airtime(const survey_table_t *t,
+                          uint16_t out[SURVEY_CHANNELS]);
+
+/** True once every channel has been visited at least once. */
+static inline bool survey_table_complete(const survey_table_t *t)
+{
+    return t->sweeps > 0;
+}
+
+/** The stored APs in the form channel_select_choose() takes. */
+size_t survey_table_export(const survey_table_t *t, channel_select_ap_t *out,
+                           size_t max);
+
+#ifdef __cplusplus
+}
+#endif
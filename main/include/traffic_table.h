@@ -0,0 +1,91 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Per-client traffic counters for the SoftAP subnet.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file traffic_table.h
+ * @brief Byte and packet counters per SoftAP client, keyed by the last
+ * octet of its IPv4 address (the SoftAP subnet is a /24).
+ *
+ * A 256-byte index maps the octet to one of TRAFFIC_TABLE_SLOTS slots, so a
+ * packet costs a subnet compare, one index load and two adds. A new address
+ * takes a free slot or the one idle the longest. Addresses outside the
+ * subnet, the network, broadcast and the router's own address are not
+ * counted. No ESP-IDF or lwIP dependency, so tools/traffic_bench.c can
+ * measure it on the host; client_traffic.c feeds it from the netif hooks and
+ * serialises access.
+ */
+
+/* Leases outlive associations, so keep more slots than AP_MAX_CONN. */
+#define TRAFFIC_TABLE_SLOTS 8
+#define TRAFFIC_TABLE_NONE 0xFF
+
+typedef enum {
+    TRAFFIC_WIFI_UP,    /**< From the client, received on the SoftAP. */
+    TRAFFIC_WIFI_DOWN,  /**< To the client, sent on the SoftAP. */
+    TRAFFIC_UPLINK_UP,  /**< From the client, forwarded to PPP. */
+    TRAFFIC_UPLINK_DOWN, /**< To the client, received from PPP. */
+    TRAFFIC_DIR_COUNT,
+} traffic_dir_t;
+
+typedef struct {
+    uint64_t bytes;
+    uint32_t packets;
+} traffic_counter_t;
+
+typedef struct {
+    bool used;
+    uint8_t octet;
+    uint32_t last_seen; /**< Table clock at the last packet, for eviction. */
+    traffic_counter_t dir[TRAFFIC_DIR_COUNT];
+} traffic_slot_t;
+
+typedef struct {
+    uint32_t net;  /**< Host order. */
+    uint32_t mask; /**< Host order. */
+    uint8_t self_octet;
+    uint32_t clock;       /**< Counted packets. */
+    uint32_t evictions;
+    uint32_t other_packets; /**< Not attributable to a client. */
+    uint8_t slot_by_octet[256];
+    traffic_slot_t slots[TRAFFIC_TABLE_SLOTS];
+} traffic_table_t;
+
+/** Empty table for the subnet of self (host order, e.g. 192.168.4.1/24). */
+void traffic_table_init(traffic_table_t *t, uint32_t self, uint32_t mask);
+
+/**
+ * Count one packet of bytes for the client at addr (host order). Returns
+ * false if addr is not a client address in the subnet.
+ */
+bool traffic_table_account(traffic_table_t *t, traffic_dir_t dir,
+                           uint32_t addr, uint32_t bytes);
+
+/**
+ * Source and destination (host order) of the IPv4 packet whose header starts
+ * at ip_offset of data: 0 for an IP packet, 14 for an Ethernet frame, whose
+ * EtherType must then be IPv4. Returns false for anything else.
+ */
+bool traffic_table_read_ip4(const uint8_t *data, size_t len, size_t ip_offset,
+                            uint32_t *src, uint32_t *dst);
+
+/** Counters of the client with this last octet, NULL if it has no slot. */
+const traffic_slot_t *traffic_table_find(const traffic_table_t *t,
+                                         uint8_t octet);
+
+#ifdef __cplusplus
+}
+#endif
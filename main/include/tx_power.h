@@ -0,0 +1,91 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Adaptive SoftAP transmit power.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file tx_power.h
+ * @brief Lowers SoftAP TX power while every client keeps a margin.
+ *
+ * The AP only measures each client's uplink RSSI, which does not change with
+ * the AP's own power. The path is symmetric, so the client is assumed to
+ * receive the AP about as strongly at full power, less every dB the power
+ * has been lowered. The weakest client decides:
+ *
+ *  - below TX_POWER_TARGET_DBM, power rises at once by as much as needed to
+ *    get TX_POWER_HYST_DB above it;
+ *  - with at least a step to spare above target + hysteresis for
+ *    TX_POWER_DOWN_HOLD updates in a row, power drops one step;
+ *  - no clients, a client without a sample, or a poor link: full power, so
+ *    joining stations always see the AP at its full range.
+ *
+ * Powers are in the 0.25 dBm units of esp_wifi_set_max_tx_power(). No
+ * ESP-IDF dependencies.
+ */
+
+#define TX_POWER_STEP_QDBM 8      /* 2 dB */
+#define TX_POWER_TARGET_DBM (-67) /* estimated RSSI at the weakest client */
+#define TX_POWER_HYST_DB 4
+#define TX_POWER_DOWN_HOLD 6      /* updates, 30 s at the RSSI refresh */
+
+typedef enum {
+    TX_POWER_HOLD,     /**< No change. */
+    TX_POWER_DOWN,     /**< One step down, margin kept. */
+    TX_POWER_DEGRADED, /**< Raised for a client below target. */
+    TX_POWER_FULL,     /**< Back to full: no clients, unknown or poor link. */
+} tx_power_change_t;
+
+typedef struct {
+    int8_t power_qdbm;
+    int8_t max_qdbm;
+    int8_t lowest_qdbm;     /**< Lowest power used. */
+    uint32_t steps_down;
+    uint32_t degraded_raises;
+    uint32_t full_raises;
+    uint64_t reduced_ms;    /**< Time below full power. */
+    uint64_t total_ms;
+    uint8_t energy_saving_pct; /**< Radiated power saved against full power. */
+} tx_power_stats_t;
+
+typedef struct {
+    int8_t min_qdbm;
+    int8_t max_qdbm;
+    int8_t power_qdbm;
+    uint8_t hold;
+    int64_t last_ms;
+    double energy_mw_ms;    /**< Integral of the radiated power. */
+    tx_power_stats_t stats;
+} tx_power_ctrl_t;
+
+void tx_power_init(tx_power_ctrl_t *c, int8_t min_qdbm, int8_t max_qdbm,
+                   int64_t now_ms);
+
+/**
+ * Feed the current clients and return what changed; c->power_qdbm is the
+ * power to apply. weakest_dbm is the lowest smoothed RSSI, INT8_MIN if a
+ * client has no sample yet; poor is true if any link is poor.
+ */
+tx_power_change_t tx_power_update(tx_power_ctrl_t *c, int64_t now_ms,
+                                  int clients, int8_t weakest_dbm, bool poor);
+
+/** Full power at once, e.g. when a station joins or the AP restarts. */
+tx_power_change_t tx_power_force_full(tx_power_ctrl_t *c, int64_t now_ms);
+
+/** Statistics up to now_ms. */
+void tx_power_get_stats(tx_power_ctrl_t *c, int64_t now_ms,
+                        tx_power_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -31,14 +31,52 @@
  *   - Include this header in your main application or modules.
  *   - In app_main(), call watchdog_start().
  *   - The watchdog_task will regularly feed TWDT; if the task is not scheduled, MCU resets.
+ *   - Critical tasks call watchdog_register() once and watchdog_checkin() every
+ *     loop. The TWDT is fed only while every registered task has checked in
+ *     within WATCHDOG_MISSED_BEATS of its period. A stalled task is first
+ *     restarted through its restart callback; if that is not possible, or the
+ *     new task stalls too, feeding stops and the TWDT resets the chip.
  *   - You may call watchdog_deinit() to remove the feed loop and disable the watchdog.
  */
 
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "esp_err.h"
 
+#define WATCHDOG_MAX_TASKS 8
+#define WATCHDOG_MISSED_BEATS 3  /* Periods without a check-in before a task stalls. */
+#define WATCHDOG_MAX_RESTARTS 3  /* Targeted restarts per task before a reset. */
+
+/**
+ * @brief Replaces a stalled task. Runs on the watchdog task.
+ *
+ * Deletes the old task and starts a new one, which registers again. Returns
+ * an error when the task cannot be replaced safely, e.g. because it holds a
+ * mutex; the watchdog then lets the TWDT reset the chip.
+ */
+typedef esp_err_t (*watchdog_restart_fn)(void);
+
+typedef struct {
+    const char *name;
+    uint32_t period_ms;
+    uint32_t last_seen_ms;  /**< Age of the last check-in. */
+    uint32_t checkins;
+    uint8_t restarts;
+    bool healthy;
+} watchdog_task_status_t;
+
+typedef struct {
+    bool running;
+    bool feeding;          /**< False once a stall is final; reset follows. */
+    uint32_t feeds;
+    uint32_t skipped_feeds;
+    uint32_t restarts;
+    uint8_t task_count;
+    watchdog_task_status_t tasks[WATCHDOG_MAX_TASKS];
+} watchdog_status_t;
+
 /**
  * @brief Start watchdog timer with feed loop in background task.
  *
@@ -51,3 +89,28 @@ esp_err_t watchdog_start(uint32_t timeout_seconds, uint32_t period_ms);
  * @brief Stop and deinitialize watchdog feed loop.
  */
 void watchdog_deinit(void);
+
+/**
+ * @brief Register a task for liveness monitoring.
+ *
+ * May be called before watchdog_start(). Registering a name again, as a
+ * restarted task does, reuses its entry; it does not count as a check-in,
+ * so a restarted task must reach its loop within the stall window.
+ *
+ * @param name Static task name, shown in /status/all.
+ * @param period_ms Longest regular interval between check-ins.
+ * @param restart Replaces the task after a stall, or NULL to reset instead.
+ * @return Entry id for watchdog_checkin(), or -1 if the registry is full.
+ */
+int watchdog_register(const char *name, uint32_t period_ms,
+                      watchdog_restart_fn restart);
+
+/**
+ * @brief Heartbeat of a registered task. Cheap; call once per loop.
+ */
+void watchdog_checkin(int id);
+
+/**
+ * @brief Snapshot of the feed loop and the registered tasks.
+ */
+void watchdog_get_status(watchdog_status_t *out);
@@ -0,0 +1,78 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Incremental background channel survey.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "survey_table.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file wifi_survey.h
+ * @brief Scans one channel every WIFI_SURVEY_STEP_MS with a short active
+ * dwell, so a full sweep of channels 1-11 is spread over minutes and the
+ * SoftAP never leaves its channel for more than one dwell.
+ *
+ * Results are published like the client station table: the survey task is
+ * the only writer and readers copy a snapshot without taking a lock, so
+ * channel selection and /wifi/survey never wait for a scan.
+ *
+ * Optionally each step also listens in promiscuous mode for
+ * WIFI_SURVEY_AIRTIME_MS and adds up the airtime of every frame heard, which
+ * measures how busy the channel really is rather than how many APs beacon
+ * on it. The radio has to follow the SoftAP there, and the driver only
+ * allows that with no station associated, so windows are taken only while
+ * the AP is idle.
+ *
+ * The driver has one scanner. Anyone else who scans, or stops Wi-Fi, takes
+ * it with wifi_survey_take_scanner() first; the survey holds it only for the
+ * duration of one dwell.
+ */
+
+#define WIFI_SURVEY_STEP_MS 15000
+#define WIFI_SURVEY_DWELL_MIN_MS 20
+#define WIFI_SURVEY_DWELL_MAX_MS 40
+#define WIFI_SURVEY_AIRTIME_MS 100
+
+typedef struct {
+    uint32_t dwell_failures;
+    uint32_t skipped_steps; /**< AP down, OTA running or scanner busy. */
+    uint32_t last_dwell_us; /**< Off-channel time of the latest dwell. */
+    uint32_t airtime_windows;
+    uint32_t airtime_failures;
+    uint32_t airtime_busy_skips; /**< Steps without a window: clients. */
+    uint64_t airtime_off_channel_ms; /**< Beacons sent off the home channel. */
+    uint32_t rx_frames;          /**< Frames counted by the rx callback. */
+    uint32_t rx_cycles_avg;      /**< CPU cycles per rx callback. */
+} wifi_survey_stats_t;
+
+/** Start the survey task; call after the SoftAP and STA netif exist. */
+esp_err_t wifi_survey_start(void);
+
+/** Lock-free copy of the survey results. */
+void wifi_survey_get(survey_table_t *out);
+
+void wifi_survey_get_stats(wifi_survey_stats_t *out);
+
+/** Whether idle steps measure airtime; stored in NVS, off by default. */
+bool wifi_survey_get_airtime_enabled(void);
+esp_err_t wifi_survey_set_airtime_enabled(bool enabled);
+
+/** Exclusive use of the driver's scanner; see the file comment. */
+bool wifi_survey_take_scanner(TickType_t wait);
+void wifi_survey_give_scanner(void);
+
+#ifdef __cplusplus
+}
+#endif
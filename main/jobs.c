@@ -0,0 +1,167 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Background worker for long operations started over HTTP.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "jobs.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "jobs";
+
+typedef struct {
+    uint32_t id;
+    job_fn_t fn;
+    void *arg;
+} job_request_t;
+
+static QueueHandle_t s_queue = NULL;
+static TaskHandle_t s_worker = NULL;
+static job_status_t s_jobs[JOBS_KEPT];
+static uint32_t s_next_id = 1;
+static uint32_t s_running_id = 0;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Caller holds s_lock. */
+static job_status_t *slot_of(uint32_t id)
+{
+    return &s_jobs[id % JOBS_KEPT];
+}
+
+static void finish_job(uint32_t id, esp_err_t result)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_running_id = 0;
+    job_status_t *job = slot_of(id);
+    if (job->id == id) {
+        job->state = result == ESP_OK ? JOB_DONE : JOB_FAILED;
+        job->result = result;
+        job->finished_us = esp_timer_get_time();
+        if (result == ESP_OK) job->progress_pct = 100;
+        strlcpy(job->step, result == ESP_OK ? "Done" : "Failed",
+                sizeof(job->step));
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static void jobs_task(void *arg)
+{
+    (void)arg;
+    job_request_t request;
+    for (;;) {
+        if (xQueueReceive(s_queue, &request, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        const char *kind = "?";
+        portENTER_CRITICAL(&s_lock);
+        job_status_t *job = slot_of(request.id);
+        if (job->id == request.id) {
+            job->state = JOB_RUNNING;
+            job->started_us = esp_timer_get_time();
+            kind = job->kind;
+        }
+        s_running_id = request.id;
+        portEXIT_CRITICAL(&s_lock);
+
+        esp_err_t result = request.fn(request.arg);
+        free(request.arg);
+        finish_job(request.id, result);
+        if (result == ESP_OK) {
+            ESP_LOGI(TAG, "Job %lu (%s) done", (unsigned long)request.id, kind);
+        } else {
+            ESP_LOGW(TAG, "Job %lu (%s) failed: %s",
+                     (unsigned long)request.id, kind, esp_err_to_name(result));
+        }
+    }
+}
+
+esp_err_t jobs_start(void)
+{
+    if (s_worker) return ESP_OK;
+    s_queue = xQueueCreate(JOBS_QUEUE_LEN, sizeof(job_request_t));
+    if (!s_queue) return ESP_ERR_NO_MEM;
+    /* The AP apply path scans and restarts Wi-Fi, like channel_rescan. */
+    if (xTaskCreate(jobs_task, "jobs", 4096, NULL, 4, &s_worker) != pdPASS) {
+        vQueueDelete(s_queue);
+        s_queue = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t jobs_submit(const char *kind, job_fn_t fn, void *arg,
+                      uint32_t *id_out)
+{
+    if (!s_queue || !fn) {
+        free(arg);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    uint32_t id = s_next_id++;
+    job_status_t *job = slot_of(id);
+    memset(job, 0, sizeof(*job));
+    job->id = id;
+    job->kind = kind;
+    job->state = JOB_QUEUED;
+    job->queued_us = esp_timer_get_time();
+    strlcpy(job->step, "Queued", sizeof(job->step));
+    portEXIT_CRITICAL(&s_lock);
+
+    job_request_t request = {.id = id, .fn = fn, .arg = arg};
+    if (xQueueSend(s_queue, &request, 0) != pdTRUE) {
+        portENTER_CRITICAL(&s_lock);
+        if (job->id == id) job->id = 0;
+        portEXIT_CRITICAL(&s_lock);
+        free(arg);
+        return ESP_ERR_NO_MEM;
+    }
+    if (id_out) *id_out = id;
+    return ESP_OK;
+}
+
+void jobs_set_progress(uint8_t pct, const char *step)
+{
+    if (!s_worker || xTaskGetCurrentTaskHandle() != s_worker) return;
+    portENTER_CRITICAL(&s_lock);
+    job_status_t *job = slot_of(s_running_id);
+    if (s_running_id != 0 && job->id == s_running_id) {
+        job->progress_pct = pct > 100 ? 100 : pct;
+        if (step) strlcpy(job->step, step, sizeof(job->step));
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+bool jobs_get(uint32_t id, job_status_t *out)
+{
+    bool found = false;
+    portENTER_CRITICAL(&s_lock);
+    if (id != 0 && slot_of(id)->id == id) {
+        *out = *slot_of(id);
+        found = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return found;
+}
+
+const char *jobs_state_name(job_state_t state)
+{
+    switch (state) {
+    case JOB_QUEUED: return "queued";
+    case JOB_RUNNING: return "running";
+    case JOB_DONE: return "done";
+    case JOB_FAILED: return "failed";
+    }
+    return "unknown";
+}
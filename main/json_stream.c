@@ -0,0 +1,339 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Streaming JSON path extractor.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "json_stream.h"
+
+#include <ctype.h>
+#include <string.h>
+
+enum {
+    ST_VALUE,       /* expecting any value */
+    ST_OBJ_START,   /* after '{': key or '}' */
+    ST_KEY_START,   /* after ',' in an object: key */
+    ST_KEY,
+    ST_KEY_ESC,
+    ST_COLON,
+    ST_ARR_START,   /* after '[': value or ']' */
+    ST_STRING,
+    ST_STRING_ESC,
+    ST_LITERAL,     /* number, true, false, null */
+    ST_AFTER_VALUE,
+    ST_DONE,
+    ST_ERROR,
+};
+
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool is_literal_char(char c)
+{
+    return isalnum((unsigned char)c) || c == '-' || c == '+' || c == '.';
+}
+
+bool json_stream_valid_path(const char *path)
+{
+    if (!path || !*path) return false;
+    size_t len = strlen(path);
+    if (len > JSON_STREAM_PATH_MAX_LEN) return false;
+    unsigned segments = 1;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)path[i];
+        if (c == '.') {
+            if (i == 0 || i + 1 == len || path[i + 1] == '.') return false;
+            segments++;
+        } else if (!(isalnum(c) || c == '_' || c == '-')) {
+            return false;
+        }
+    }
+    return segments <= JSON_STREAM_MAX_DEPTH;
+}
+
+void json_stream_reset(json_stream_t *js)
+{
+    if (!js) return;
+    js->state = ST_VALUE;
+    js->depth = 0;
+    js->array_bits = 0;
+    js->key_candidates = 0;
+    js->key_pos = 0;
+    js->pending = (uint8_t)((1u << js->path_count) - 1);
+    js->value_paths = 0;
+    js->capture_len = 0;
+    js->found = 0;
+    memset(js->scope, 0, sizeof(js->scope));
+    memset(js->values, 0, sizeof(js->values));
+}
+
+bool json_stream_init(json_stream_t *js, const char *const *paths, size_t count)
+{
+    if (!js || count > JSON_STREAM_MAX_PATHS || (count > 0 && !paths)) {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!json_stream_valid_path(paths[i])) return false;
+    }
+    memset(js, 0, sizeof(*js));
+    js->path_count = (uint8_t)count;
+    for (size_t i = 0; i < count; i++) {
+        strncpy(js->paths[i], paths[i], JSON_STREAM_PATH_MAX_LEN);
+        uint8_t segments = 0;
+        js->seg_start[i][segments++] = 0;
+        for (size_t pos = 0; js->paths[i][pos]; pos++) {
+            if (js->paths[i][pos] == '.') {
+                js->seg_start[i][segments++] = (uint8_t)(pos + 1);
+            }
+        }
+        js->seg_count[i] = segments;
+    }
+    json_stream_reset(js);
+    return true;
+}
+
+/* Split the surviving key candidates into paths ending here and paths that
+ * continue into a nested object. */
+static void finish_key(json_stream_t *js)
+{
+    uint8_t level = (uint8_t)(js->depth - 1);
+    js->value_paths = 0;
+    js->pending = 0;
+    for (uint8_t i = 0; i < js->path_count; i++) {
+        uint8_t bit = (uint8_t)(1u << i);
+        if (!(js->key_candidates & bit)) continue;
+        char next = js->paths[i][js->seg_start[i][level] + js->key_pos];
+        if (next != '.' && next != 0) continue;
+        if (js->seg_count[i] == js->depth) {
+            js->value_paths |= bit;
+        } else {
+            js->pending |= bit;
+        }
+    }
+}
+
+static void match_key_char(json_stream_t *js, char c)
+{
+    if (!js->key_candidates) return;
+    if (js->key_pos >= JSON_STREAM_PATH_MAX_LEN) {
+        js->key_candidates = 0;
+        return;
+    }
+    uint8_t level = (uint8_t)(js->depth - 1);
+    for (uint8_t i = 0; i < js->path_count; i++) {
+        uint8_t bit = (uint8_t)(1u << i);
+        if (!(js->key_candidates & bit)) continue;
+        char expected = js->paths[i][js->seg_start[i][level] + js->key_pos];
+        if (expected == '.' || expected == 0 || expected != c) {
+            js->key_candidates &= (uint8_t)~bit;
+        }
+    }
+    js->key_pos++;
+}
+
+static void capture_char(json_stream_t *js, char c)
+{
+    if (!js->value_paths || js->capture_len >= JSON_STREAM_VALUE_MAX_LEN) {
+        return;
+    }
+    for (uint8_t i = 0; i < js->path_count; i++) {
+        if (js->value_paths & (1u << i)) {
+            js->values[i][js->capture_len] = c;
+            js->values[i][js->capture_len + 1] = 0;
+        }
+    }
+    js->capture_len++;
+}
+
+static void begin_capture(json_stream_t *js)
+{
+    js->capture_len = 0;
+    for (uint8_t i = 0; i < js->path_count; i++) {
+        if (js->value_paths & (1u << i)) js->values[i][0] = 0;
+    }
+}
+
+static void end_value(json_stream_t *js)
+{
+    js->found |= js->value_paths;
+    js->value_paths = 0;
+    js->state = js->depth == 0 ? ST_DONE : ST_AFTER_VALUE;
+}
+
+static void open_container(json_stream_t *js, bool array)
+{
+    if (js->depth >= JSON_STREAM_MAX_DEPTH) {
+        js->state = ST_ERROR;
+        return;
+    }
+    js->depth++;
+    js->scope[js->depth] = array ? 0 : js->pending;
+    if (array) {
+        js->array_bits |= 1u << js->depth;
+    } else {
+        js->array_bits &= ~(1u << js->depth);
+    }
+    js->value_paths = 0;
+    js->state = array ? ST_ARR_START : ST_OBJ_START;
+}
+
+static void close_container(json_stream_t *js, bool array)
+{
+    bool is_array = (js->array_bits & (1u << js->depth)) != 0;
+    if (js->depth == 0 || is_array != array) {
+        js->state = ST_ERROR;
+        return;
+    }
+    js->depth--;
+    js->state = js->depth == 0 ? ST_DONE : ST_AFTER_VALUE;
+}
+
+static void begin_key(json_stream_t *js)
+{
+    js->key_candidates = js->scope[js->depth];
+    js->key_pos = 0;
+    js->state = ST_KEY;
+}
+
+/* Elements of an array are never matched. */
+static void begin_array_element(json_stream_t *js)
+{
+    js->pending = 0;
+    js->value_paths = 0;
+    js->state = ST_VALUE;
+}
+
+/* Returns false when c must be processed again in the new state. */
+static bool step(json_stream_t *js, char c)
+{
+    switch (js->state) {
+        case ST_VALUE:
+            if (is_space(c)) return true;
+            if (c == '{') {
+                open_container(js, false);
+            } else if (c == '[') {
+                open_container(js, true);
+            } else if (c == '"') {
+                begin_capture(js);
+                js->state = ST_STRING;
+            } else if (is_literal_char(c)) {
+                begin_capture(js);
+                js->state = ST_LITERAL;
+                return false;
+            } else {
+                js->state = ST_ERROR;
+            }
+            return true;
+        case ST_OBJ_START:
+            if (is_space(c)) return true;
+            if (c == '}') {
+                close_container(js, false);
+            } else if (c == '"') {
+                begin_key(js);
+            } else {
+                js->state = ST_ERROR;
+            }
+            return true;
+        case ST_KEY_START:
+            if (is_space(c)) return true;
+            if (c == '"') {
+                begin_key(js);
+            } else {
+                js->state = ST_ERROR;
+            }
+            return true;
+        case ST_KEY:
+            if (c == '"') {
+                finish_key(js);
+                js->state = ST_COLON;
+            } else if (c == '\\') {
+                js->state = ST_KEY_ESC;
+            } else {
+                match_key_char(js, c);
+            }
+            return true;
+        case ST_KEY_ESC:
+            match_key_char(js, c);
+            js->state = ST_KEY;
+            return true;
+        case ST_COLON:
+            if (is_space(c)) return true;
+            js->state = c == ':' ? ST_VALUE : ST_ERROR;
+            return true;
+        case ST_ARR_START:
+            if (is_space(c)) return true;
+            if (c == ']') {
+                close_container(js, true);
+                return true;
+            }
+            begin_array_element(js);
+            return false;
+        case ST_STRING:
+            if (c == '"') {
+                end_value(js);
+            } else if (c == '\\') {
+                js->state = ST_STRING_ESC;
+            } else if ((unsigned char)c < 0x20) {
+                js->state = ST_ERROR;
+            } else {
+                capture_char(js, c);
+            }
+            return true;
+        case ST_STRING_ESC:
+            capture_char(js, c == 'n' ? '\n' : c == 't' ? '\t' : c);
+            js->state = ST_STRING;
+            return true;
+        case ST_LITERAL:
+            if (is_literal_char(c)) {
+                capture_char(js, c);
+                return true;
+            }
+            end_value(js);
+            return false;
+        case ST_AFTER_VALUE:
+            if (is_space(c)) return true;
+            if (c == ',') {
+                if (js->array_bits & (1u << js->depth)) {
+                    begin_array_element(js);
+                } else {
+                    js->state = ST_KEY_START;
+                }
+            } else if (c == '}' || c == ']') {
+                close_container(js, c == ']');
+            } else {
+                js->state = ST_ERROR;
+            }
+            return true;
+        case ST_DONE:
+            if (!is_space(c)) js->state = ST_ERROR;
+            return true;
+        default:
+            return true;
+    }
+}
+
+void json_stream_feed(json_stream_t *js, const char *data, size_t len)
+{
+    if (!js || !data) return;
+    size_t i = 0;
+    while (i < len && js->state != ST_ERROR) {
+        if (step(js, data[i])) i++;
+    }
+}
+
+bool json_stream_complete(const json_stream_t *js)
+{
+    /* A top-level literal is only terminated by the end of the document. */
+    return js && (js->state == ST_DONE ||
+                  (js->state == ST_LITERAL && js->depth == 0));
+}
+
+const char *json_stream_value(const json_stream_t *js, size_t idx)
+{
+    if (!js || idx >= js->path_count) return NULL;
+    return (js->found & (1u << idx)) ? js->values[idx] : NULL;
+}
@@ -0,0 +1,134 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Runs the minimal MQTT broker from mqtt_broker.c on the SoftAP so that
+ * devices publishing there are consumed without crossing the PPP link.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "local_broker.h"
+#include "ap_config.h"
+#include "mqtt_telemetry.h"
+
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_log.h"
+#include "esp_netif.h"
+#include "esp_timer.h"
+
+/* How often a stopped broker re-reads its settings. */
+#define LOCAL_BROKER_IDLE_MS 2000
+/* Longest wait for socket activity; also bounds settings-change latency. */
+#define LOCAL_BROKER_POLL_MS 1000
+
+static const char *TAG = "local_broker";
+
+static TaskHandle_t s_task;
+static bool s_running;
+/* Settings the running broker was started with. */
+static char s_active_filters[MQTT_BRIDGE_FILTERS_MAX_LEN + 1];
+static uint32_t s_active_addr;
+
+static int64_t clock_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static void deliver_local(void *ctx, const char *topic, const uint8_t *payload,
+                          size_t len, bool retain)
+{
+    (void)ctx;
+    mqtt_telemetry_ingest_local(topic, payload, len, retain);
+}
+
+static bool forward(void *ctx, const char *topic, const uint8_t *payload,
+                    size_t len, bool retain)
+{
+    (void)ctx;
+    return mqtt_telemetry_publish_upstream(topic, payload, len, retain);
+}
+
+static uint32_t softap_addr(void)
+{
+    esp_netif_ip_info_t ip_info = {0};
+    esp_netif_t *netif = ap_get_netif();
+    if (!netif || esp_netif_get_ip_info(netif, &ip_info) != ESP_OK) return 0;
+    return ip_info.ip.addr;
+}
+
+static void stop_broker(void)
+{
+    if (!s_running) return;
+    mqtt_telemetry_set_local_source(false);
+    mqtt_broker_stop();
+    s_running = false;
+    ESP_LOGI(TAG, "Stopped");
+}
+
+static void start_broker(const char *filters, uint32_t addr)
+{
+    mqtt_broker_config_t config = {
+        .bind_addr = addr,
+        .port = MQTT_BROKER_PORT,
+        .bridge_filters = filters,
+        .batch_ms = MQTT_BRIDGE_DEFAULT_BATCH_MS,
+        .deliver_local = deliver_local,
+        .forward = forward,
+        .clock_ms = clock_ms,
+    };
+    if (!mqtt_broker_start(&config)) {
+        ESP_LOGW(TAG, "Unable to listen on port %d", MQTT_BROKER_PORT);
+        return;
+    }
+    strlcpy(s_active_filters, filters, sizeof(s_active_filters));
+    s_active_addr = addr;
+    s_running = true;
+    mqtt_telemetry_set_local_source(true);
+    ESP_LOGI(TAG, "Listening on port %d, bridging \"%s\"", MQTT_BROKER_PORT,
+             filters);
+}
+
+static void local_broker_task(void *arg)
+{
+    (void)arg;
+    mqtt_telemetry_config_t config;
+    for (;;) {
+        mqtt_telemetry_get_config(&config);
+        uint32_t addr = config.local_broker ? softap_addr() : 0;
+        if (s_running && (addr != s_active_addr ||
+                          strcmp(config.bridge_filters, s_active_filters) != 0)) {
+            stop_broker();
+        }
+        if (!s_running && addr != 0) start_broker(config.bridge_filters, addr);
+        if (s_running) {
+            mqtt_broker_poll(LOCAL_BROKER_POLL_MS);
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(LOCAL_BROKER_IDLE_MS));
+        }
+    }
+}
+
+esp_err_t local_broker_start(void)
+{
+    if (s_task) return ESP_OK;
+    if (xTaskCreate(local_broker_task, "local_broker", 4096, NULL, 6,
+                    &s_task) != pdPASS) {
+        s_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+bool local_broker_is_running(void)
+{
+    return mqtt_broker_is_running();
+}
+
+void local_broker_get_stats(mqtt_broker_stats_t *out)
+{
+    mqtt_broker_get_stats(out);
+}
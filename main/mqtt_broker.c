@@ -0,0 +1,840 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Minimal MQTT 3.1.1 broker with a coalescing upstream bridge.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "mqtt_broker.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#else
+#define ESP_LOGI(tag, fmt, ...) fprintf(stderr, "I (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) do { } while (0)
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/* A client must send CONNECT within this time after the TCP accept. */
+#define CONNECT_TIMEOUT_MS 10000
+/* Largest fixed header: type byte plus a four-byte remaining length. */
+#define FIXED_HEADER_MAX 5
+#define SUBACK_MAX_FILTERS 32
+
+enum {
+    PKT_CONNECT = 1,
+    PKT_CONNACK = 2,
+    PKT_PUBLISH = 3,
+    PKT_PUBACK = 4,
+    PKT_PUBREC = 5,
+    PKT_PUBREL = 6,
+    PKT_PUBCOMP = 7,
+    PKT_SUBSCRIBE = 8,
+    PKT_SUBACK = 9,
+    PKT_UNSUBSCRIBE = 10,
+    PKT_UNSUBACK = 11,
+    PKT_PINGREQ = 12,
+    PKT_PINGRESP = 13,
+    PKT_DISCONNECT = 14,
+};
+
+typedef struct {
+    int fd;                 /* -1 when the slot is free */
+    bool connected;         /* CONNECT accepted */
+    bool closing;
+    uint16_t keepalive_s;
+    int64_t last_rx_ms;
+    size_t rx_len;
+    uint8_t rx[FIXED_HEADER_MAX + MQTT_BROKER_MAX_PACKET];
+    char subs[MQTT_BROKER_MAX_SUBSCRIPTIONS][MQTT_BROKER_TOPIC_MAX_LEN + 1];
+} client_t;
+
+typedef struct {
+    char topic[MQTT_BROKER_TOPIC_MAX_LEN + 1];
+    uint8_t *payload;
+    size_t len;
+} retained_t;
+
+typedef struct {
+    char topic[MQTT_BROKER_TOPIC_MAX_LEN + 1];
+    bool forwarded;
+    bool last_retain;
+    uint32_t last_hash;
+    size_t last_len;
+    int64_t last_forward_ms;
+    int64_t last_used_ms;
+    uint8_t *pending;       /* latest payload not yet forwarded, or NULL */
+    size_t pending_len;
+    bool pending_retain;
+} bridge_entry_t;
+
+typedef struct {
+    mqtt_broker_config_t config;
+    char filters[MQTT_BRIDGE_FILTERS_MAX_LEN + 1];
+    int listen_fd;
+    int64_t now_ms;
+    int64_t next_flush_ms;
+    unsigned retained_next;
+    client_t clients[MQTT_BROKER_MAX_CLIENTS];
+    retained_t retained[MQTT_BROKER_MAX_RETAINED];
+    bridge_entry_t bridge[MQTT_BRIDGE_MAX_TOPICS];
+    uint8_t tx[FIXED_HEADER_MAX + MQTT_BROKER_MAX_PACKET];
+} broker_t;
+
+static const char *TAG = "mqtt_broker";
+
+static broker_t *s_broker;
+static mqtt_broker_stats_t s_stats;
+
+/* ---------------- Topics and filters ---------------- */
+
+static bool valid_topic_name(const char *topic, size_t len)
+{
+    if (len == 0 || len > MQTT_BROKER_TOPIC_MAX_LEN) return false;
+    for (size_t i = 0; i < len; i++) {
+        if (topic[i] == '+' || topic[i] == '#' || topic[i] == 0) return false;
+    }
+    return true;
+}
+
+static bool valid_filter(const char *filter, size_t len)
+{
+    if (len == 0 || len > MQTT_BROKER_TOPIC_MAX_LEN) return false;
+    for (size_t i = 0; i < len; i++) {
+        char c = filter[i];
+        bool level_start = i == 0 || filter[i - 1] == '/';
+        bool level_end = i + 1 == len || filter[i + 1] == '/';
+        if (c == 0) return false;
+        if (c == '+' && !(level_start && level_end)) return false;
+        if (c == '#' && !(level_start && i + 1 == len)) return false;
+    }
+    return true;
+}
+
+bool mqtt_broker_topic_matches(const char *filter, const char *topic)
+{
+    if (!filter || !topic) return false;
+    for (;;) {
+        const char *f_end = strchr(filter, '/');
+        const char *t_end = strchr(topic, '/');
+        if (!f_end) f_end = filter + strlen(filter);
+        if (!t_end) t_end = topic + strlen(topic);
+        size_t f_len = (size_t)(f_end - filter);
+        size_t t_len = (size_t)(t_end - topic);
+
+        if (f_len == 1 && filter[0] == '#') return true;
+        if (!(f_len == 1 && filter[0] == '+') &&
+            (f_len != t_len || memcmp(filter, topic, f_len) != 0)) {
+            return false;
+        }
+        if (!*f_end || !*t_end) {
+            /* "a/#" also matches the parent level "a". */
+            return (!*f_end && !*t_end) ||
+                   (!*t_end && strcmp(f_end, "/#") == 0);
+        }
+        filter = f_end + 1;
+        topic = t_end + 1;
+    }
+}
+
+/* Iterate the comma-separated filter list; spaces around items are ignored. */
+static const char *next_filter(const char *list, char *out, size_t out_size,
+                               bool *ok)
+{
+    while (*list == ' ' || *list == ',') list++;
+    if (!*list) return NULL;
+    const char *end = strchr(list, ',');
+    if (!end) end = list + strlen(list);
+    const char *last = end;
+    while (last > list && last[-1] == ' ') last--;
+    size_t len = (size_t)(last - list);
+    *ok = len < out_size && valid_filter(list, len);
+    if (*ok) {
+        memcpy(out, list, len);
+        out[len] = 0;
+    }
+    return end;
+}
+
+bool mqtt_broker_valid_filters(const char *filters)
+{
+    if (!filters) return false;
+    if (strlen(filters) > MQTT_BRIDGE_FILTERS_MAX_LEN) return false;
+    char filter[MQTT_BROKER_TOPIC_MAX_LEN + 1];
+    bool ok = true;
+    const char *pos = filters;
+    while ((pos = next_filter(pos, filter, sizeof(filter), &ok)) != NULL) {
+        if (!ok) return false;
+    }
+    return true;
+}
+
+static bool bridge_wants(const broker_t *b, const char *topic)
+{
+    char filter[MQTT_BROKER_TOPIC_MAX_LEN + 1];
+    bool ok = true;
+    const char *pos = b->filters;
+    while ((pos = next_filter(pos, filter, sizeof(filter), &ok)) != NULL) {
+        if (ok && mqtt_broker_topic_matches(filter, topic)) return true;
+    }
+    return false;
+}
+
+/* ---------------- Encoding ---------------- */
+
+static size_t encode_remaining_length(uint8_t *out, size_t value)
+{
+    size_t n = 0;
+    do {
+        uint8_t digit = value % 128;
+        value /= 128;
+        if (value > 0) digit |= 0x80;
+        out[n++] = digit;
+    } while (value > 0 && n < 4);
+    return n;
+}
+
+static void send_packet(client_t *c, const uint8_t *data, size_t len)
+{
+    if (c->fd < 0 || c->closing) return;
+    ssize_t sent = send(c->fd, data, len, MSG_NOSIGNAL);
+    /* Sockets are non-blocking; a partial write would corrupt the stream,
+     * so a client that cannot keep up is disconnected. */
+    if (sent != (ssize_t)len) {
+        ESP_LOGW(TAG, "Dropping slow or closed client (fd %d)", c->fd);
+        c->closing = true;
+    }
+}
+
+static void send_ack(client_t *c, uint8_t type_flags, uint16_t packet_id)
+{
+    uint8_t ack[4] = {type_flags, 2, (uint8_t)(packet_id >> 8),
+                      (uint8_t)packet_id};
+    send_packet(c, ack, sizeof(ack));
+}
+
+static void send_publish(broker_t *b, client_t *c, const char *topic,
+                         const uint8_t *payload, size_t len, bool retain)
+{
+    size_t topic_len = strlen(topic);
+    size_t remaining = 2 + topic_len + len;
+    if (remaining > MQTT_BROKER_MAX_PACKET) return;
+    size_t pos = 0;
+    b->tx[pos++] = (uint8_t)((PKT_PUBLISH << 4) | (retain ? 1 : 0));
+    pos += encode_remaining_length(b->tx + pos, remaining);
+    b->tx[pos++] = (uint8_t)(topic_len >> 8);
+    b->tx[pos++] = (uint8_t)topic_len;
+    memcpy(b->tx + pos, topic, topic_len);
+    pos += topic_len;
+    if (len > 0) memcpy(b->tx + pos, payload, len);
+    pos += len;
+    send_packet(c, b->tx, pos);
+    if (!c->closing) s_stats.tx_publishes++;
+}
+
+/* ---------------- Retained messages ---------------- */
+
+static void store_retained(broker_t *b, const char *topic,
+                           const uint8_t *payload, size_t len)
+{
+    retained_t *slot = NULL;
+    for (unsigned i = 0; i < MQTT_BROKER_MAX_RETAINED; i++) {
+        if (b->retained[i].topic[0] && strcmp(b->retained[i].topic, topic) == 0) {
+            slot = &b->retained[i];
+            break;
+        }
+    }
+    if (len == 0) {
+        /* An empty retained payload deletes the retained message. */
+        if (slot) {
+            free(slot->payload);
+            memset(slot, 0, sizeof(*slot));
+        }
+        return;
+    }
+    uint8_t *copy = malloc(len);
+    if (!copy) return;
+    memcpy(copy, payload, len);
+    if (!slot) {
+        for (unsigned i = 0; i < MQTT_BROKER_MAX_RETAINED && !slot; i++) {
+            if (!b->retained[i].topic[0]) slot = &b->retained[i];
+        }
+    }
+    if (!slot) {
+        /* Table full: replace entries round-robin. */
+        slot = &b->retained[b->retained_next];
+        b->retained_next = (b->retained_next + 1) % MQTT_BROKER_MAX_RETAINED;
+    }
+    free(slot->payload);
+    snprintf(slot->topic, sizeof(slot->topic), "%s", topic);
+    slot->payload = copy;
+    slot->len = len;
+}
+
+static void send_retained(broker_t *b, client_t *c, const char *filter)
+{
+    for (unsigned i = 0; i < MQTT_BROKER_MAX_RETAINED; i++) {
+        retained_t *r = &b->retained[i];
+        if (r->topic[0] && mqtt_broker_topic_matches(filter, r->topic)) {
+            send_publish(b, c, r->topic, r->payload, r->len, true);
+        }
+    }
+}
+
+/* ---------------- Bridge ---------------- */
+
+static uint32_t fnv1a(const uint8_t *data, size_t len)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bridge_entry_t *bridge_entry(broker_t *b, const char *topic)
+{
+    bridge_entry_t *free_slot = NULL;
+    bridge_entry_t *oldest = NULL;
+    for (unsigned i = 0; i < MQTT_BRIDGE_MAX_TOPICS; i++) {
+        bridge_entry_t *e = &b->bridge[i];
+        if (!e->topic[0]) {
+            if (!free_slot) free_slot = e;
+            continue;
+        }
+        if (strcmp(e->topic, topic) == 0) return e;
+        if (!e->pending && (!oldest || e->last_used_ms < oldest->last_used_ms)) {
+            oldest = e;
+        }
+    }
+    /* Evicting an idle topic only loses its deduplication history. */
+    bridge_entry_t *e = free_slot ? free_slot : oldest;
+    if (!e) return NULL;
+    memset(e, 0, sizeof(*e));
+    snprintf(e->topic, sizeof(e->topic), "%s", topic);
+    return e;
+}
+
+static void bridge_offer(broker_t *b, const char *topic,
+                         const uint8_t *payload, size_t len, bool retain)
+{
+    if (!b->config.forward || !bridge_wants(b, topic)) return;
+    bridge_entry_t *e = bridge_entry(b, topic);
+    if (!e) {
+        s_stats.bridge_dropped++;
+        return;
+    }
+    e->last_used_ms = b->now_ms;
+    uint32_t hash = fnv1a(payload, len);
+    if (e->forwarded && e->last_hash == hash && e->last_len == len &&
+        e->last_retain == retain &&
+        b->now_ms - e->last_forward_ms < MQTT_BRIDGE_REFRESH_MS) {
+        if (e->pending) {
+            /* The topic went back to the value upstream already has. */
+            free(e->pending);
+            e->pending = NULL;
+            s_stats.bridge_coalesced++;
+        }
+        s_stats.bridge_deduplicated++;
+        return;
+    }
+    uint8_t *copy = malloc(len > 0 ? len : 1);
+    if (!copy) {
+        s_stats.bridge_dropped++;
+        return;
+    }
+    memcpy(copy, payload, len);
+    if (e->pending) {
+        free(e->pending);
+        s_stats.bridge_coalesced++;
+    }
+    e->pending = copy;
+    e->pending_len = len;
+    e->pending_retain = retain;
+}
+
+static void bridge_flush(broker_t *b)
+{
+    uint32_t sent = 0;
+    for (unsigned i = 0; i < MQTT_BRIDGE_MAX_TOPICS; i++) {
+        bridge_entry_t *e = &b->bridge[i];
+        if (!e->pending) continue;
+        if (!b->config.forward(b->config.ctx, e->topic, e->pending,
+                               e->pending_len, e->pending_retain)) {
+            /* Upstream unavailable: keep the latest values for later. */
+            break;
+        }
+        e->forwarded = true;
+        e->last_hash = fnv1a(e->pending, e->pending_len);
+        e->last_len = e->pending_len;
+        e->last_retain = e->pending_retain;
+        e->last_forward_ms = b->now_ms;
+        free(e->pending);
+        e->pending = NULL;
+        sent++;
+    }
+    if (sent > 0) {
+        s_stats.bridge_forwarded += sent;
+        s_stats.bridge_batches++;
+    }
+    b->next_flush_ms = b->now_ms + b->config.batch_ms;
+}
+
+/* ---------------- Packet handling ---------------- */
+
+static bool read_u16(const uint8_t *body, size_t len, size_t *pos,
+                     uint16_t *out)
+{
+    if (*pos + 2 > len) return false;
+    *out = (uint16_t)((body[*pos] << 8) | body[*pos + 1]);
+    *pos += 2;
+    return true;
+}
+
+/* Read a length-prefixed string. str may be NULL to skip it. */
+static bool read_string(const uint8_t *body, size_t len, size_t *pos,
+                        const char **str, size_t *str_len)
+{
+    uint16_t n;
+    if (!read_u16(body, len, pos, &n) || *pos + n > len) return false;
+    if (str) *str = (const char *)body + *pos;
+    if (str_len) *str_len = n;
+    *pos += n;
+    return true;
+}
+
+static void route_publish(broker_t *b, const char *topic,
+                          const uint8_t *payload, size_t len, bool retain)
+{
+    s_stats.rx_publishes++;
+    if (b->config.deliver_local) {
+        b->config.deliver_local(b->config.ctx, topic, payload, len, retain);
+    }
+    if (retain) store_retained(b, topic, payload, len);
+    for (unsigned i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++) {
+        client_t *c = &b->clients[i];
+        if (c->fd < 0 || !c->connected || c->closing) continue;
+        for (unsigned s = 0; s < MQTT_BROKER_MAX_SUBSCRIPTIONS; s++) {
+            if (c->subs[s][0] && mqtt_broker_topic_matches(c->subs[s], topic)) {
+                /* Live deliveries never carry the retain flag. */
+                send_publish(b, c, topic, payload, len, false);
+                break;
+            }
+        }
+    }
+    bridge_offer(b, topic, payload, len, retain);
+}
+
+static bool handle_connect(client_t *c, const uint8_t *body, size_t len)
+{
+    size_t pos = 0;
+    uint16_t keepalive;
+    if (!read_string(body, len, &pos, NULL, NULL) || pos + 2 > len) {
+        return false;
+    }
+    uint8_t level = body[pos++];
+    uint8_t flags = body[pos++];
+    if (!read_u16(body, len, &pos, &keepalive) ||
+        !read_string(body, len, &pos, NULL, NULL)) {
+        return false;
+    }
+    if ((flags & 0x04) && (!read_string(body, len, &pos, NULL, NULL) ||
+                           !read_string(body, len, &pos, NULL, NULL))) {
+        return false;
+    }
+    if ((flags & 0x80) && !read_string(body, len, &pos, NULL, NULL)) {
+        return false;
+    }
+    if ((flags & 0x40) && !read_string(body, len, &pos, NULL, NULL)) {
+        return false;
+    }
+    if (level != 3 && level != 4) {
+        /* 0x01: unacceptable protocol level (MQTT v5 clients land here). */
+        uint8_t refuse[4] = {PKT_CONNACK << 4, 2, 0, 1};
+        send_packet(c, refuse, sizeof(refuse));
+        return false;
+    }
+    uint8_t connack[4] = {PKT_CONNACK << 4, 2, 0, 0};
+    send_packet(c, connack, sizeof(connack));
+    c->connected = true;
+    c->keepalive_s = keepalive;
+    s_stats.connects++;
+    s_stats.clients++;
+    return true;
+}
+
+static bool handle_publish(broker_t *b, client_t *c, uint8_t flags,
+                           const uint8_t *body, size_t len)
+{
+    uint8_t qos = (flags >> 1) & 3;
+    bool retain = (flags & 1) != 0;
+    size_t pos = 0;
+    const char *topic_raw;
+    size_t topic_len;
+    uint16_t packet_id = 0;
+    char topic[MQTT_BROKER_TOPIC_MAX_LEN + 1];
+
+    if (qos == 3 || !read_string(body, len, &pos, &topic_raw, &topic_len) ||
+        !valid_topic_name(topic_raw, topic_len)) {
+        return false;
+    }
+    if (qos > 0 && !read_u16(body, len, &pos, &packet_id)) return false;
+    memcpy(topic, topic_raw, topic_len);
+    topic[topic_len] = 0;
+
+    if (qos == 1) send_ack(c, PKT_PUBACK << 4, packet_id);
+    if (qos == 2) send_ack(c, PKT_PUBREC << 4, packet_id);
+    route_publish(b, topic, body + pos, len - pos, retain);
+    return true;
+}
+
+static bool handle_subscribe(broker_t *b, client_t *c, const uint8_t *body,
+                             size_t len)
+{
+    size_t pos = 0;
+    uint16_t packet_id;
+    uint8_t suback[FIXED_HEADER_MAX + 2 + SUBACK_MAX_FILTERS];
+    uint8_t codes[SUBACK_MAX_FILTERS];
+    char filter_copy[MQTT_BROKER_TOPIC_MAX_LEN + 1];
+    size_t count = 0;
+
+    if (!read_u16(body, len, &pos, &packet_id) || pos >= len) return false;
+    while (pos < len) {
+        const char *filter;
+        size_t filter_len;
+        if (count == SUBACK_MAX_FILTERS ||
+            !read_string(body, len, &pos, &filter, &filter_len) ||
+            pos >= len) {
+            return false;
+        }
+        pos++; /* requested QoS; everything is delivered at QoS 0 */
+        uint8_t code = 0x80;
+        if (valid_filter(filter, filter_len)) {
+            int slot = -1;
+            for (int s = 0; s < MQTT_BROKER_MAX_SUBSCRIPTIONS; s++) {
+                if (strlen(c->subs[s]) == filter_len &&
+                    memcmp(c->subs[s], filter, filter_len) == 0) {
+                    slot = s;
+                    break;
+                }
+                if (slot < 0 && !c->subs[s][0]) slot = s;
+            }
+            if (slot >= 0) {
+                memcpy(c->subs[slot], filter, filter_len);
+                c->subs[slot][filter_len] = 0;
+                code = 0;
+            }
+        }
+        codes[count++] = code;
+    }
+
+    size_t out = 0;
+    suback[out++] = PKT_SUBACK << 4;
+    out += encode_remaining_length(suback + out, 2 + count);
+    suback[out++] = (uint8_t)(packet_id >> 8);
+    suback[out++] = (uint8_t)packet_id;
+    memcpy(suback + out, codes, count);
+    send_packet(c, suback, out + count);
+
+    /* Retained messages follow the SUBACK, once per granted filter. */
+    pos = 2;
+    for (size_t i = 0; i < count; i++) {
+        const char *filter = NULL;
+        size_t filter_len = 0;
+        if (!read_string(body, len, &pos, &filter, &filter_len)) break;
+        pos++;
+        if (codes[i] != 0) continue;
+        memcpy(filter_copy, filter, filter_len);
+        filter_copy[filter_len] = 0;
+        send_retained(b, c, filter_copy);
+    }
+    return true;
+}
+
+static bool handle_unsubscribe(client_t *c, const uint8_t *body, size_t len)
+{
+    size_t pos = 0;
+    uint16_t packet_id;
+    if (!read_u16(body, len, &pos, &packet_id)) return false;
+    while (pos < len) {
+        const char *filter;
+        size_t filter_len;
+        if (!read_string(body, len, &pos, &filter, &filter_len)) return false;
+        for (int s = 0; s < MQTT_BROKER_MAX_SUBSCRIPTIONS; s++) {
+            if (strlen(c->subs[s]) == filter_len &&
+                memcmp(c->subs[s], filter, filter_len) == 0) {
+                c->subs[s][0] = 0;
+            }
+        }
+    }
+    send_ack(c, PKT_UNSUBACK << 4, packet_id);
+    return true;
+}
+
+/* Returns false when the connection must be closed. */
+static bool handle_packet(broker_t *b, client_t *c, uint8_t header,
+                          const uint8_t *body, size_t len)
+{
+    uint8_t type = header >> 4;
+    uint8_t flags = header & 0x0F;
+    uint16_t packet_id;
+    size_t pos = 0;
+
+    if (!c->connected) return type == PKT_CONNECT && handle_connect(c, body, len);
+    switch (type) {
+        case PKT_PUBLISH:
+            return handle_publish(b, c, flags, body, len);
+        case PKT_PUBREL:
+            if (!read_u16(body, len, &pos, &packet_id)) return false;
+            send_ack(c, PKT_PUBCOMP << 4, packet_id);
+            return true;
+        case PKT_SUBSCRIBE:
+            return flags == 2 && handle_subscribe(b, c, body, len);
+        case PKT_UNSUBSCRIBE:
+            return flags == 2 && handle_unsubscribe(c, body, len);
+        case PKT_PINGREQ: {
+            uint8_t pong[2] = {PKT_PINGRESP << 4, 0};
+            send_packet(c, pong, sizeof(pong));
+            return true;
+        }
+        case PKT_DISCONNECT:
+            c->closing = true;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Decode complete packets from the receive buffer. */
+static bool process_rx(broker_t *b, client_t *c)
+{
+    while (c->rx_len >= 2 && !c->closing) {
+        size_t remaining = 0;
+        size_t multiplier = 1;
+        size_t header_len = 1;
+        for (;;) {
+            if (header_len >= c->rx_len) return true; /* need more bytes */
+            uint8_t digit = c->rx[header_len++];
+            remaining += (size_t)(digit & 0x7F) * multiplier;
+            if (!(digit & 0x80)) break;
+            multiplier *= 128;
+            if (header_len > 4) return false;
+        }
+        if (header_len + remaining > sizeof(c->rx)) {
+            ESP_LOGW(TAG, "Packet of %u bytes exceeds the %u byte limit",
+                     (unsigned)(header_len + remaining),
+                     (unsigned)sizeof(c->rx));
+            return false;
+        }
+        if (c->rx_len < header_len + remaining) return true;
+        if (!handle_packet(b, c, c->rx[0], c->rx + header_len, remaining)) {
+            return false;
+        }
+        size_t used = header_len + remaining;
+        memmove(c->rx, c->rx + used, c->rx_len - used);
+        c->rx_len -= used;
+    }
+    return true;
+}
+
+static void close_client(client_t *c)
+{
+    if (c->fd >= 0) close(c->fd);
+    if (c->connected && s_stats.clients > 0) s_stats.clients--;
+    c->fd = -1;
+    c->connected = false;
+    c->closing = false;
+    c->rx_len = 0;
+    memset(c->subs, 0, sizeof(c->subs));
+}
+
+static void accept_client(broker_t *b)
+{
+    int fd = accept(b->listen_fd, NULL, NULL);
+    if (fd < 0) return;
+    client_t *slot = NULL;
+    for (unsigned i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++) {
+        if (b->clients[i].fd < 0) {
+            slot = &b->clients[i];
+            break;
+        }
+    }
+    if (!slot) {
+        ESP_LOGW(TAG, "Refusing client: all %d slots in use",
+                 MQTT_BROKER_MAX_CLIENTS);
+        close(fd);
+        return;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    slot->fd = fd;
+    slot->connected = false;
+    slot->closing = false;
+    slot->rx_len = 0;
+    slot->keepalive_s = 0;
+    slot->last_rx_ms = b->now_ms;
+}
+
+static void read_client(broker_t *b, client_t *c)
+{
+    ssize_t n = recv(c->fd, c->rx + c->rx_len, sizeof(c->rx) - c->rx_len, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        c->closing = true;
+        return;
+    }
+    if (n < 0) return;
+    c->rx_len += (size_t)n;
+    c->last_rx_ms = b->now_ms;
+    if (!process_rx(b, c)) {
+        if (c->connected) s_stats.protocol_errors++;
+        c->closing = true;
+    }
+}
+
+/* ---------------- Public API ---------------- */
+
+bool mqtt_broker_start(const mqtt_broker_config_t *config)
+{
+    if (s_broker || !config || !config->clock_ms ||
+        (config->bridge_filters &&
+         !mqtt_broker_valid_filters(config->bridge_filters))) {
+        return false;
+    }
+    broker_t *b = calloc(1, sizeof(*b));
+    if (!b) return false;
+    b->config = *config;
+    if (b->config.batch_ms == 0) b->config.batch_ms = MQTT_BRIDGE_DEFAULT_BATCH_MS;
+    if (config->bridge_filters) {
+        snprintf(b->filters, sizeof(b->filters), "%s", config->bridge_filters);
+    }
+    b->config.bridge_filters = b->filters;
+    for (unsigned i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++) b->clients[i].fd = -1;
+
+    b->listen_fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (b->listen_fd < 0) {
+        free(b);
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(b->listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(config->port ? config->port : MQTT_BROKER_PORT),
+        .sin_addr.s_addr = config->bind_addr,
+    };
+    if (bind(b->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(b->listen_fd, 2) != 0) {
+        ESP_LOGW(TAG, "Unable to listen on port %u (errno %d)",
+                 (unsigned)ntohs(addr.sin_port), errno);
+        close(b->listen_fd);
+        free(b);
+        return false;
+    }
+    b->now_ms = config->clock_ms();
+    b->next_flush_ms = b->now_ms + b->config.batch_ms;
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_broker = b;
+    ESP_LOGI(TAG, "Listening on port %u; bridge filters \"%s\", batch %u ms",
+             (unsigned)ntohs(addr.sin_port), b->filters,
+             (unsigned)b->config.batch_ms);
+    return true;
+}
+
+void mqtt_broker_poll(int timeout_ms)
+{
+    broker_t *b = s_broker;
+    if (!b) return;
+
+    fd_set rfds;
+    FD_ZERO(&rfds);
+    FD_SET(b->listen_fd, &rfds);
+    int max_fd = b->listen_fd;
+    for (unsigned i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++) {
+        if (b->clients[i].fd >= 0) {
+            FD_SET(b->clients[i].fd, &rfds);
+            if (b->clients[i].fd > max_fd) max_fd = b->clients[i].fd;
+        }
+    }
+    /* Never sleep past the next bridge flush. */
+    int64_t until_flush = b->next_flush_ms - b->config.clock_ms();
+    if (until_flush < 0) until_flush = 0;
+    if (timeout_ms > until_flush) timeout_ms = (int)until_flush;
+    struct timeval tv = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    int ready = select(max_fd + 1, &rfds, NULL, NULL, &tv);
+    b->now_ms = b->config.clock_ms();
+
+    if (ready > 0) {
+        if (FD_ISSET(b->listen_fd, &rfds)) accept_client(b);
+        for (unsigned i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++) {
+            client_t *c = &b->clients[i];
+            if (c->fd >= 0 && !c->closing && FD_ISSET(c->fd, &rfds)) {
+                read_client(b, c);
+            }
+        }
+    }
+
+    for (unsigned i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++) {
+        client_t *c = &b->clients[i];
+        if (c->fd < 0) continue;
+        int64_t idle = b->now_ms - c->last_rx_ms;
+        /* The spec allows one and a half keepalive periods of silence. */
+        if ((!c->connected && idle > CONNECT_TIMEOUT_MS) ||
+            (c->connected && c->keepalive_s > 0 &&
+             idle > (int64_t)c->keepalive_s * 1500)) {
+            c->closing = true;
+        }
+        if (c->closing) close_client(c);
+    }
+
+    if (b->now_ms >= b->next_flush_ms) bridge_flush(b);
+}
+
+void mqtt_broker_stop(void)
+{
+    broker_t *b = s_broker;
+    if (!b) return;
+    b->now_ms = b->config.clock_ms();
+    if (b->config.forward) bridge_flush(b);
+    for (unsigned i = 0; i < MQTT_BROKER_MAX_CLIENTS; i++) {
+        if (b->clients[i].fd >= 0) close_client(&b->clients[i]);
+    }
+    for (unsigned i = 0; i < MQTT_BROKER_MAX_RETAINED; i++) {
+        free(b->retained[i].payload);
+    }
+    for (unsigned i = 0; i < MQTT_BRIDGE_MAX_TOPICS; i++) {
+        free(b->bridge[i].pending);
+    }
+    close(b->listen_fd);
+    s_broker = NULL;
+    free(b);
+    s_stats.clients = 0;
+}
+
+bool mqtt_broker_is_running(void)
+{
+    return s_broker != NULL;
+}
+
+void mqtt_broker_get_stats(mqtt_broker_stats_t *out)
+{
+    if (out) *out = s_stats;
+}
@@ -1,17 +1,27 @@
 /*
  * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
  *
- * MQTT telemetry subscriber for the broker running on the FRITZ!Box.
+ * MQTT telemetry subscriber for the broker running on the FRITZ!Box, plus a
+ * rate-limited publisher for the router's own health metrics.
  *
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
 #include "mqtt_telemetry.h"
+#include "ap_config.h"
+#include "boot_init.h"
+#include "client_rssi.h"
+#include "config_store.h"
+#include "json_stream.h"
 #include "ppp.h"
+#include "watchdog.h"
 
 #include <ctype.h>
+#include <inttypes.h>
+#include <limits.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <strings.h>
 
@@ -19,41 +29,124 @@
 #include "freertos/semphr.h"
 #include "freertos/task.h"
 
+#include "esp_cpu.h"
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_system.h"
 #include "esp_timer.h"
+#include "esp_wifi.h"
 #include "lwip/ip4_addr.h"
 #include "mqtt_client.h"
-#include "nvs.h"
 
-#define MQTT_NVS_NAMESPACE "mqttcfg"
-#define MQTT_NVS_AUTO_KEY "auto"
-#define MQTT_NVS_BROKER_KEY "host"
-#define MQTT_NVS_ROOT_KEY "root"
-#define MQTT_TOPIC_MAX_LEN (MQTT_ROOT_TOPIC_MAX_LEN + 16)
+/* Publish an unchanged sample at least once per this many intervals. */
+#define SELF_TELEMETRY_HEARTBEAT_INTERVALS 10
+/* Absolute changes below these floors never leave the deadband. */
+#define SELF_TELEMETRY_HEAP_FLOOR_BYTES 512
+#define SELF_TELEMETRY_RATE_FLOOR_BPS 64
+#define SELF_TELEMETRY_RSSI_DEADBAND_DB 3
+/* Aliases the broker may use towards us, and the alias used for our topic. */
+#define MQTT_RX_TOPIC_ALIAS_MAX 4
+#define SELF_TELEMETRY_TOPIC_ALIAS 1
+/* How long the broker keeps a persistent v5 session after we disconnect. */
+#define MQTT_SESSION_EXPIRY_S 3600
+/* mqtt_task loops every 0.5-2 s; stopping a client can block for seconds. */
+#define MQTT_TASK_HEARTBEAT_MS 10000
+
+/* Subscribed metrics. With MQTT v5 the value doubles as the subscription
+ * identifier, so incoming PUBLISH packets are routed without a topic compare. */
+typedef enum {
+    MQTT_METRIC_NONE = 0,
+    MQTT_METRIC_POWER = 1,
+    MQTT_METRIC_CONNECTED = 2,
+    MQTT_METRIC_COUNT,
+} mqtt_metric_id_t;
+
+typedef struct {
+    int64_t uptime_s;
+    uint32_t free_heap;
+    uint32_t min_free_heap;
+    bool ppp_up;
+    uint32_t ppp_rx_bps;
+    uint32_t ppp_tx_bps;
+    uint64_t ppp_rx_bytes;
+    uint64_t ppp_tx_bytes;
+    uint32_t ppp_connects;
+    uint32_t mqtt_connects;
+    int clients;
+    int8_t best_rssi;
+    uint8_t channel;
+} self_sample_t;
 
 static const char *TAG = "mqtt_telemetry";
 
 static SemaphoreHandle_t s_mutex;
 static TaskHandle_t s_task;
 static esp_mqtt_client_handle_t s_client;
+/* Serialises publishes from other tasks and property+publish sequences
+ * against destroy_client(). */
+static SemaphoreHandle_t s_client_lock;
 static mqtt_telemetry_config_t s_config = {
     .broker_auto = true,
     .broker_host = "",
     .root_topic = MQTT_DEFAULT_ROOT_TOPIC,
+    .power_subtopic = MQTT_DEFAULT_POWER_SUBTOPIC,
+    .power_json_path = "",
+    .telemetry_interval_s = MQTT_SELF_TELEMETRY_DEFAULT_INTERVAL_S,
+    .telemetry_deadband_pct = MQTT_SELF_TELEMETRY_DEFAULT_DEADBAND_PCT,
+    .protocol_v5 = true,
+    .persistent_session = false,
+    .local_broker = false,
+    .bridge_filters = MQTT_BRIDGE_DEFAULT_FILTERS,
 };
 static bool s_reconfigure_requested;
+static volatile mqtt_telemetry_update_cb_t s_update_cb;
 static bool s_broker_connected;
 static char s_power_topic[MQTT_TOPIC_MAX_LEN];
 static char s_connected_topic[MQTT_TOPIC_MAX_LEN];
+static char s_self_topic[MQTT_TOPIC_MAX_LEN];
 static char s_broker_uri[64];
+static char s_client_id[24];
 static char s_active_broker_host[MQTT_BROKER_HOST_MAX_LEN + 1];
 static char s_power[64] = "N/A";
+/* Last live (non-retained) power delivery; 0 when the age is unknown. */
 static int64_t s_power_updated_us;
+static bool s_power_valid;
+static bool s_power_retained;
+static int64_t s_connected_us;
+static bool s_first_display_pending;
+static mqtt_first_display_stats_t s_first_display;
 static int8_t s_obk_connected_state = -1;
-static char s_in_topic[MQTT_TOPIC_MAX_LEN];
+static mqtt_metric_id_t s_in_metric;
+static bool s_in_retained;
 static char s_in_payload[64];
 static size_t s_in_len;
+/* Power payloads are JSON when a path is configured; only the MQTT event
+ * task touches the extractor after create_client() set it up. */
+static json_stream_t s_power_json;
+static bool s_power_json_active;
+/* Same for payloads from the local broker; only its task touches this. */
+static json_stream_t s_local_power_json;
+static bool s_local_source_up;
+static uint32_t s_mqtt_connect_count;
+static mqtt_self_telemetry_stats_t s_self_stats;
+static mqtt_link_stats_t s_link_stats;
+static portMUX_TYPE s_link_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+/* Options of the running client; written before esp_mqtt_client_start(). */
+static bool s_active_protocol_v5;
+static bool s_active_persistent;
+static bool s_active_local_broker;
+/* 0 = alias not yet announced this session, 1 = announced, -1 = not
+ * allowed by the broker's Topic Alias Maximum. */
+static int s_self_alias_state;
+
+/* Self-telemetry sampler state; touched only by mqtt_task. */
+static self_sample_t s_self_last_published;
+static bool s_self_have_published;
+static bool s_self_was_connected;
+static int64_t s_self_next_sample_us;
+static int64_t s_self_prev_sample_us;
+static ppp_stats_t s_self_prev_ppp;
 
 static void trim_whitespace(char *value)
 {
@@ -90,69 +183,290 @@ static bool valid_root_topic(const char *root)
     return true;
 }
 
-static void load_config_from_nvs(void)
+static bool valid_power_subtopic(const char *subtopic)
 {
-    nvs_handle_t nvs;
-    if (nvs_open(MQTT_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) return;
+    size_t len;
+    if (!subtopic) return false;
+    len = strlen(subtopic);
+    if (len == 0 || len > MQTT_POWER_SUBTOPIC_MAX_LEN) return false;
+    if (subtopic[0] == '/' || subtopic[len - 1] == '/') return false;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)subtopic[i];
+        if (c == '/' && subtopic[i + 1] == '/') return false;
+        if (!(isalnum(c) || c == '-' || c == '_' || c == '.' || c == '/')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool valid_telemetry_interval(uint16_t interval_s)
+{
+    return interval_s == 0 ||
+           (interval_s >= MQTT_SELF_TELEMETRY_MIN_INTERVAL_S &&
+            interval_s <= MQTT_SELF_TELEMETRY_MAX_INTERVAL_S);
+}
 
-    uint8_t auto_mode = 1;
-    char host[sizeof(s_config.broker_host)] = "";
-    char root[sizeof(s_config.root_topic)] = MQTT_DEFAULT_ROOT_TOPIC;
-    size_t host_len = sizeof(host);
-    size_t root_len = sizeof(root);
-    if (nvs_get_u8(nvs, MQTT_NVS_AUTO_KEY, &auto_mode) != ESP_OK) {
-        auto_mode = 1;
+static void load_config(void)
+{
+    config_mqtt_t stored;
+    config_store_get_mqtt(&stored);
+
+    if (!valid_telemetry_interval(stored.telemetry_interval_s)) {
+        stored.telemetry_interval_s = MQTT_SELF_TELEMETRY_DEFAULT_INTERVAL_S;
+    }
+    if (stored.telemetry_deadband_pct > MQTT_SELF_TELEMETRY_MAX_DEADBAND_PCT) {
+        stored.telemetry_deadband_pct = MQTT_SELF_TELEMETRY_DEFAULT_DEADBAND_PCT;
+    }
+    if (stored.bridge_filters[0] &&
+        !mqtt_broker_valid_filters(stored.bridge_filters)) {
+        strlcpy(stored.bridge_filters, MQTT_BRIDGE_DEFAULT_FILTERS,
+                sizeof(stored.bridge_filters));
     }
-    if (nvs_get_str(nvs, MQTT_NVS_BROKER_KEY, host, &host_len) != ESP_OK ||
-        (host[0] && !valid_broker_host(host))) {
-        host[0] = 0;
+    if (stored.broker_host[0] && !valid_broker_host(stored.broker_host)) {
+        stored.broker_host[0] = 0;
     }
-    if (nvs_get_str(nvs, MQTT_NVS_ROOT_KEY, root, &root_len) != ESP_OK ||
-        !valid_root_topic(root)) {
-        strlcpy(root, MQTT_DEFAULT_ROOT_TOPIC, sizeof(root));
+    if (!valid_root_topic(stored.root_topic)) {
+        strlcpy(stored.root_topic, MQTT_DEFAULT_ROOT_TOPIC,
+                sizeof(stored.root_topic));
     }
-    nvs_close(nvs);
-    s_config.broker_auto = auto_mode != 0 || !valid_broker_host(host);
-    strlcpy(s_config.broker_host, host, sizeof(s_config.broker_host));
-    strlcpy(s_config.root_topic, root, sizeof(s_config.root_topic));
+    if (!valid_power_subtopic(stored.power_subtopic)) {
+        strlcpy(stored.power_subtopic, MQTT_DEFAULT_POWER_SUBTOPIC,
+                sizeof(stored.power_subtopic));
+    }
+    if (stored.power_json_path[0] &&
+        !json_stream_valid_path(stored.power_json_path)) {
+        stored.power_json_path[0] = 0;
+    }
+    s_config.broker_auto = stored.broker_auto != 0 ||
+                           !valid_broker_host(stored.broker_host);
+    strlcpy(s_config.broker_host, stored.broker_host,
+            sizeof(s_config.broker_host));
+    strlcpy(s_config.root_topic, stored.root_topic,
+            sizeof(s_config.root_topic));
+    strlcpy(s_config.power_subtopic, stored.power_subtopic,
+            sizeof(s_config.power_subtopic));
+    strlcpy(s_config.power_json_path, stored.power_json_path,
+            sizeof(s_config.power_json_path));
+    s_config.telemetry_interval_s = stored.telemetry_interval_s;
+    s_config.telemetry_deadband_pct = stored.telemetry_deadband_pct;
+    s_config.protocol_v5 = stored.protocol_v5 != 0;
+    s_config.persistent_session = stored.persistent_session != 0;
+    s_config.local_broker = stored.local_broker != 0;
+    strlcpy(s_config.bridge_filters, stored.bridge_filters,
+            sizeof(s_config.bridge_filters));
 }
 
-static esp_err_t save_config_to_nvs(bool auto_mode, const char *host,
-                                    const char *root)
+static esp_err_t save_config(const mqtt_telemetry_config_t *config)
 {
-    nvs_handle_t nvs;
-    esp_err_t err = nvs_open(MQTT_NVS_NAMESPACE, NVS_READWRITE, &nvs);
-    if (err != ESP_OK) return err;
-    err = nvs_set_u8(nvs, MQTT_NVS_AUTO_KEY, auto_mode ? 1 : 0);
-    if (err == ESP_OK) err = nvs_set_str(nvs, MQTT_NVS_BROKER_KEY, host);
-    if (err == ESP_OK) err = nvs_set_str(nvs, MQTT_NVS_ROOT_KEY, root);
-    if (err == ESP_OK) err = nvs_commit(nvs);
-    nvs_close(nvs);
-    return err;
+    config_mqtt_t stored;
+    config_store_get_mqtt(&stored);
+    stored.broker_auto = config->broker_auto ? 1 : 0;
+    strlcpy(stored.broker_host, config->broker_host,
+            sizeof(stored.broker_host));
+    strlcpy(stored.root_topic, config->root_topic, sizeof(stored.root_topic));
+    strlcpy(stored.power_subtopic, config->power_subtopic,
+            sizeof(stored.power_subtopic));
+    strlcpy(stored.power_json_path, config->power_json_path,
+            sizeof(stored.power_json_path));
+    stored.telemetry_interval_s = config->telemetry_interval_s;
+    stored.telemetry_deadband_pct = config->telemetry_deadband_pct;
+    stored.protocol_v5 = config->protocol_v5 ? 1 : 0;
+    stored.persistent_session = config->persistent_session ? 1 : 0;
+    stored.local_broker = config->local_broker ? 1 : 0;
+    strlcpy(stored.bridge_filters, config->bridge_filters,
+            sizeof(stored.bridge_filters));
+    return config_store_set_mqtt(&stored);
+}
+
+static void notify_update(void)
+{
+    mqtt_telemetry_update_cb_t callback = s_update_cb;
+    if (callback) callback();
 }
 
 static void set_broker_connected(bool connected)
 {
+    bool changed = false;
     if (!s_mutex) return;
     if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(20)) == pdTRUE) {
+        /* In local mode the upstream link only carries bridged traffic. */
+        if (connected && !s_broker_connected && !s_config.local_broker) {
+            s_connected_us = esp_timer_get_time();
+            s_first_display_pending = true;
+            /* A persistent session keeps the cached state until the retained
+             * copy replaces it; a clean session starts from unknown. */
+            if (!s_active_persistent) s_obk_connected_state = -1;
+        }
+        changed = s_broker_connected != connected;
         s_broker_connected = connected;
-        if (connected) s_obk_connected_state = -1;
+        if (connected) s_mqtt_connect_count++;
         xSemaphoreGive(s_mutex);
     }
+    if (changed) notify_update();
 }
 
-static void handle_message(const char *topic, const char *data, int len)
+static bool topic_equals(const char *topic, int topic_len, const char *expected)
 {
-    if (!topic || !data || len <= 0 || !s_mutex) return;
+    size_t expected_len = strlen(expected);
+    return topic && topic_len >= 0 && (size_t)topic_len == expected_len &&
+           memcmp(topic, expected, expected_len) == 0;
+}
+
+/* Size of an MQTT "remaining length" variable byte integer. */
+static unsigned varint_size(uint32_t value)
+{
+    unsigned size = 1;
+    while (value >= 128) {
+        value /= 128;
+        size++;
+    }
+    return size;
+}
+
+static void record_published(size_t topic_len, int payload_len, bool aliased)
+{
+    uint32_t remaining = 2 + (uint32_t)topic_len + (uint32_t)payload_len;
+    if (s_active_protocol_v5) {
+        uint32_t properties = aliased ? 3 : 0;
+        remaining += varint_size(properties) + properties;
+    }
+    portENTER_CRITICAL(&s_link_stats_lock);
+    s_link_stats.tx_messages++;
+    s_link_stats.tx_wire_bytes += 1 + varint_size(remaining) + remaining;
+    if (aliased && topic_len == 0) s_link_stats.tx_alias_hits++;
+    portEXIT_CRITICAL(&s_link_stats_lock);
+}
+
+/*
+ * Map an incoming PUBLISH to a metric. v5 brokers echo the subscription
+ * identifier, which makes routing a bounds check; v3.1.1 needs topic compares.
+ * Both paths are timed in CPU cycles for /status/all.
+ */
+static mqtt_metric_id_t route_message(esp_mqtt_event_handle_t event)
+{
+    uint32_t started = esp_cpu_get_cycle_count();
+    mqtt_metric_id_t metric = MQTT_METRIC_NONE;
+    bool by_id = false;
+
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    if (event->protocol_ver == MQTT_PROTOCOL_V_5 && event->property &&
+        event->property->subscribe_id > MQTT_METRIC_NONE &&
+        event->property->subscribe_id < MQTT_METRIC_COUNT) {
+        metric = (mqtt_metric_id_t)event->property->subscribe_id;
+        by_id = true;
+    }
+#endif
+    if (!by_id) {
+        if (topic_equals(event->topic, event->topic_len, s_power_topic)) {
+            metric = MQTT_METRIC_POWER;
+        } else if (topic_equals(event->topic, event->topic_len,
+                                s_connected_topic)) {
+            metric = MQTT_METRIC_CONNECTED;
+        }
+    }
+
+    uint32_t cycles = esp_cpu_get_cycle_count() - started;
+    portENTER_CRITICAL(&s_link_stats_lock);
+    s_link_stats.rx_messages++;
+    if (by_id) {
+        s_link_stats.dispatch_by_id++;
+        s_link_stats.dispatch_id_cycles += cycles;
+    } else {
+        s_link_stats.dispatch_by_topic++;
+        s_link_stats.dispatch_topic_cycles += cycles;
+    }
+    portEXIT_CRITICAL(&s_link_stats_lock);
+    return metric;
+}
+
+static void subscribe_metric(esp_mqtt_client_handle_t client,
+                             const char *topic, mqtt_metric_id_t metric)
+{
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    if (s_active_protocol_v5) {
+        esp_mqtt5_subscribe_property_config_t property = {
+            .subscribe_id = metric,
+        };
+        esp_mqtt5_client_set_subscribe_property(client, &property);
+    }
+#else
+    (void)metric;
+#endif
+    esp_mqtt_client_subscribe(client, topic,
+                              s_active_persistent ? 1 : 0);
+}
+
+/* Whether the source of power and connection state is reachable. Caller
+ * holds s_mutex. */
+static bool source_connected(void)
+{
+    return s_config.local_broker ? s_local_source_up : s_broker_connected;
+}
+
+static bool power_is_fresh(int64_t now_us)
+{
+    return s_power_valid && s_power_updated_us != 0 &&
+           now_us - s_power_updated_us <=
+               (int64_t)OBK_POWER_STALE_TIMEOUT_MS * 1000;
+}
+
+/*
+ * A retained delivery says nothing about when the value was produced. If it
+ * repeats the cached value the stored timestamp still applies; a different
+ * value is shown at once but with an unknown age until a live update arrives.
+ */
+static void store_power(const char *data, int len, bool retained,
+                        int64_t now_us)
+{
+    char value[sizeof(s_power)];
+    int copy = len;
+    if (copy >= (int)sizeof(value)) copy = sizeof(value) - 1;
+    memcpy(value, data, (size_t)copy);
+    value[copy] = 0;
+
+    if (!retained) {
+        s_power_updated_us = now_us;
+    } else if (!s_power_valid || strcmp(value, s_power) != 0) {
+        s_power_updated_us = 0;
+    }
+    strlcpy(s_power, value, sizeof(s_power));
+    s_power_valid = true;
+    s_power_retained = retained;
+
+    if (s_first_display_pending) {
+        s_first_display_pending = false;
+        boot_init_milestone(BOOT_MILESTONE_MQTT_VALUE);
+        uint32_t elapsed_ms = (uint32_t)((now_us - s_connected_us) / 1000);
+        s_first_display.last_ms = elapsed_ms;
+        if (s_first_display.samples == 0 ||
+            elapsed_ms < s_first_display.best_ms) {
+            s_first_display.best_ms = elapsed_ms;
+        }
+        if (elapsed_ms > s_first_display.worst_ms) {
+            s_first_display.worst_ms = elapsed_ms;
+        }
+        s_first_display.samples++;
+        s_first_display.last_from_retained = retained;
+    }
+}
+
+static void handle_message(mqtt_metric_id_t metric, const char *data, int len,
+                           bool retained)
+{
+    bool changed = false;
+    if (metric == MQTT_METRIC_NONE || !data || len <= 0 || !s_mutex) return;
     if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(20)) != pdTRUE) return;
 
-    if (strcmp(topic, s_power_topic) == 0) {
-        int copy = len;
-        if (copy >= (int)sizeof(s_power)) copy = sizeof(s_power) - 1;
-        memcpy(s_power, data, (size_t)copy);
-        s_power[copy] = 0;
-        s_power_updated_us = esp_timer_get_time();
-    } else if (strcmp(topic, s_connected_topic) == 0) {
+    if (metric == MQTT_METRIC_POWER) {
+        int64_t now = esp_timer_get_time();
+        char previous[sizeof(s_power)];
+        bool was_fresh = power_is_fresh(now);
+        strlcpy(previous, s_power, sizeof(previous));
+        store_power(data, len, retained, now);
+        changed = !was_fresh || strcmp(previous, s_power) != 0;
+    } else if (metric == MQTT_METRIC_CONNECTED) {
+        int8_t previous = s_obk_connected_state;
         char state[16];
         int copy = len;
         if (copy >= (int)sizeof(state)) copy = sizeof(state) - 1;
@@ -161,8 +475,10 @@ static void handle_message(const char *topic, const char *data, int len)
         trim_whitespace(state);
         if (strcasecmp(state, "online") == 0) s_obk_connected_state = 1;
         else if (strcasecmp(state, "offline") == 0) s_obk_connected_state = 0;
+        changed = previous != s_obk_connected_state;
     }
     xSemaphoreGive(s_mutex);
+    if (changed) notify_update();
 }
 
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
@@ -176,9 +492,16 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
     switch (event_id) {
         case MQTT_EVENT_CONNECTED:
             set_broker_connected(true);
-            esp_mqtt_client_subscribe(event->client, s_power_topic, 0);
-            esp_mqtt_client_subscribe(event->client, s_connected_topic, 0);
-            ESP_LOGI(TAG, "Connected; subscribed to %s and %s",
+            if (s_active_local_broker) {
+                ESP_LOGI(TAG, "Connected (MQTT %s); values come from the "
+                         "local broker", s_active_protocol_v5 ? "5" : "3.1.1");
+                break;
+            }
+            subscribe_metric(event->client, s_power_topic, MQTT_METRIC_POWER);
+            subscribe_metric(event->client, s_connected_topic,
+                             MQTT_METRIC_CONNECTED);
+            ESP_LOGI(TAG, "Connected (MQTT %s); subscribed to %s and %s",
+                     s_active_protocol_v5 ? "5" : "3.1.1",
                      s_power_topic, s_connected_topic);
             break;
         case MQTT_EVENT_DISCONNECTED:
@@ -187,24 +510,45 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
             break;
         case MQTT_EVENT_DATA: {
             if (event->current_data_offset == 0) {
-                size_t topic_len = event->topic_len < (int)(sizeof(s_in_topic) - 1)
-                    ? (size_t)event->topic_len : sizeof(s_in_topic) - 1;
-                memcpy(s_in_topic, event->topic, topic_len);
-                s_in_topic[topic_len] = 0;
+                s_in_metric = route_message(event);
+                s_in_retained = event->retain;
                 s_in_len = 0;
+                if (s_in_metric == MQTT_METRIC_POWER && s_power_json_active) {
+                    json_stream_reset(&s_power_json);
+                }
             }
-            size_t copy = (size_t)event->data_len;
-            if (s_in_len + copy >= sizeof(s_in_payload)) {
-                copy = s_in_len < sizeof(s_in_payload) - 1
-                    ? sizeof(s_in_payload) - 1 - s_in_len : 0;
+            bool json = s_in_metric == MQTT_METRIC_POWER && s_power_json_active;
+            if (json) {
+                /* Stream through the extractor; nothing is buffered. */
+                json_stream_feed(&s_power_json, event->data,
+                                 (size_t)event->data_len);
+            } else {
+                size_t copy = (size_t)event->data_len;
+                if (s_in_len + copy >= sizeof(s_in_payload)) {
+                    copy = s_in_len < sizeof(s_in_payload) - 1
+                        ? sizeof(s_in_payload) - 1 - s_in_len : 0;
+                }
+                if (copy > 0) {
+                    memcpy(s_in_payload + s_in_len, event->data, copy);
+                    s_in_len += copy;
+                }
             }
-            if (copy > 0) {
-                memcpy(s_in_payload + s_in_len, event->data, copy);
-                s_in_len += copy;
+            if (event->current_data_offset + event->data_len < event->total_data_len) {
+                break;
             }
-            if (event->current_data_offset + event->data_len >= event->total_data_len) {
+            if (json) {
+                const char *value = json_stream_value(&s_power_json, 0);
+                if (json_stream_complete(&s_power_json) && value && *value) {
+                    handle_message(s_in_metric, value, (int)strlen(value),
+                                   s_in_retained);
+                } else {
+                    ESP_LOGD(TAG, "Power payload has no %s",
+                             s_power_json.paths[0]);
+                }
+            } else {
                 s_in_payload[s_in_len] = 0;
-                handle_message(s_in_topic, s_in_payload, (int)s_in_len);
+                handle_message(s_in_metric, s_in_payload, (int)s_in_len,
+                               s_in_retained);
             }
             break;
         }
@@ -213,12 +557,217 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
     }
 }
 
+/* ---------------- Self-telemetry publisher ---------------- */
+
+static uint32_t bytes_per_second(uint64_t now_bytes, uint64_t prev_bytes,
+                                 int64_t elapsed_us)
+{
+    if (elapsed_us <= 0 || now_bytes < prev_bytes) return 0;
+    uint64_t rate = (now_bytes - prev_bytes) * 1000000ULL / (uint64_t)elapsed_us;
+    return rate > UINT32_MAX ? UINT32_MAX : (uint32_t)rate;
+}
+
+static void sample_self_telemetry(self_sample_t *out, int64_t now_us)
+{
+    ppp_stats_t ppp_stats;
+    ap_channel_status_t channel_status;
+
+    ppp_get_stats(&ppp_stats);
+    ap_get_config_snapshot(NULL, 0, NULL, 0, &channel_status);
+    memset(out, 0, sizeof(*out));
+    out->uptime_s = now_us / 1000000;
+    out->free_heap = esp_get_free_heap_size();
+    out->min_free_heap = esp_get_minimum_free_heap_size();
+    out->ppp_up = ppp_is_up();
+    out->ppp_rx_bytes = ppp_stats.rx_bytes;
+    out->ppp_tx_bytes = ppp_stats.tx_bytes;
+    out->ppp_connects = ppp_stats.link_up_count;
+    if (s_self_prev_sample_us != 0) {
+        int64_t elapsed_us = now_us - s_self_prev_sample_us;
+        out->ppp_rx_bps = bytes_per_second(ppp_stats.rx_bytes,
+                                           s_self_prev_ppp.rx_bytes, elapsed_us);
+        out->ppp_tx_bps = bytes_per_second(ppp_stats.tx_bytes,
+                                           s_self_prev_ppp.tx_bytes, elapsed_us);
+    }
+    s_self_prev_ppp = ppp_stats;
+    s_self_prev_sample_us = now_us;
+    out->clients = client_rssi_get_count();
+    out->best_rssi = client_rssi_get_best();
+    out->channel = channel_status.active_channel;
+    if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(20)) == pdTRUE) {
+        out->mqtt_connects = s_mqtt_connect_count;
+        xSemaphoreGive(s_mutex);
+    }
+}
+
+static bool outside_deadband(uint64_t previous, uint64_t current,
+                             uint8_t deadband_pct, uint64_t floor)
+{
+    uint64_t delta = current > previous ? current - previous : previous - current;
+    if (delta <= floor) return false;
+    return delta * 100U > previous * deadband_pct;
+}
+
+static bool self_sample_changed(const self_sample_t *prev,
+                                const self_sample_t *cur, uint8_t deadband_pct)
+{
+    if (deadband_pct == 0) return true;
+    if (prev->ppp_up != cur->ppp_up || prev->clients != cur->clients ||
+        prev->channel != cur->channel ||
+        prev->ppp_connects != cur->ppp_connects ||
+        prev->mqtt_connects != cur->mqtt_connects ||
+        (prev->best_rssi == INT8_MIN) != (cur->best_rssi == INT8_MIN)) {
+        return true;
+    }
+    if (cur->best_rssi != INT8_MIN &&
+        abs(cur->best_rssi - prev->best_rssi) >= SELF_TELEMETRY_RSSI_DEADBAND_DB) {
+        return true;
+    }
+    return outside_deadband(prev->free_heap, cur->free_heap, deadband_pct,
+                            SELF_TELEMETRY_HEAP_FLOOR_BYTES) ||
+           outside_deadband(prev->ppp_rx_bps, cur->ppp_rx_bps, deadband_pct,
+                            SELF_TELEMETRY_RATE_FLOOR_BPS) ||
+           outside_deadband(prev->ppp_tx_bps, cur->ppp_tx_bps, deadband_pct,
+                            SELF_TELEMETRY_RATE_FLOOR_BPS);
+}
+
+static int format_self_sample(const self_sample_t *sample, char *out,
+                              size_t out_len)
+{
+    char rssi[8] = "null";
+    if (sample->best_rssi != INT8_MIN) {
+        snprintf(rssi, sizeof(rssi), "%d", sample->best_rssi);
+    }
+    return snprintf(out, out_len,
+                    "{\"uptime_s\":%lld,\"heap\":%" PRIu32
+                    ",\"heap_min\":%" PRIu32 ",\"ppp_up\":%s"
+                    ",\"ppp_rx_bps\":%" PRIu32 ",\"ppp_tx_bps\":%" PRIu32
+                    ",\"ppp_rx\":%" PRIu64 ",\"ppp_tx\":%" PRIu64
+                    ",\"ppp_connects\":%" PRIu32 ",\"mqtt_connects\":%" PRIu32
+                    ",\"clients\":%d,\"rssi\":%s,\"channel\":%u}",
+                    (long long)sample->uptime_s, sample->free_heap,
+                    sample->min_free_heap, sample->ppp_up ? "true" : "false",
+                    sample->ppp_rx_bps, sample->ppp_tx_bps,
+                    sample->ppp_rx_bytes, sample->ppp_tx_bytes,
+                    sample->ppp_connects, sample->mqtt_connects,
+                    sample->clients, rssi, sample->channel);
+}
+
+/*
+ * With MQTT v5 the first record of a session carries the topic and binds it
+ * to an alias; later records send an empty topic plus the 2-byte alias. If
+ * the broker's Topic Alias Maximum is too low, setting the alias property
+ * fails, s_self_alias_state becomes -1, and the session publishes full
+ * topics from then on.
+ */
+static int publish_self_payload(const char *payload, int len)
+{
+    const char *topic = s_self_topic;
+    bool aliased = false;
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    esp_mqtt5_publish_property_config_t property = {0};
+    if (s_active_protocol_v5) {
+        if (s_self_alias_state >= 0) {
+            /* ESP-MQTT rejects an alias above the broker's Topic Alias
+             * Maximum here; the publish itself would still succeed. */
+            property.topic_alias = SELF_TELEMETRY_TOPIC_ALIAS;
+            if (esp_mqtt5_client_set_publish_property(s_client, &property) ==
+                ESP_OK) {
+                aliased = true;
+                if (s_self_alias_state > 0) topic = "";
+            } else {
+                ESP_LOGW(TAG, "Broker allows no topic alias %d; using full topics",
+                         SELF_TELEMETRY_TOPIC_ALIAS);
+                s_self_alias_state = -1;
+                property.topic_alias = 0;
+            }
+        }
+        if (!aliased) esp_mqtt5_client_set_publish_property(s_client, &property);
+    }
+#endif
+    int msg_id = esp_mqtt_client_publish(s_client, topic, payload, len, 0, 0);
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    /* The broker maps the alias once it received the full topic with it. */
+    if (aliased && msg_id >= 0) s_self_alias_state = 1;
+#endif
+    if (msg_id >= 0) record_published(strlen(topic), len, aliased);
+    return msg_id;
+}
+
+/*
+ * Sample once per configured interval and publish a single JSON document.
+ * Samples inside the deadband are dropped so an idle router adds almost no
+ * traffic to the PPP link; a heartbeat still goes out every few intervals.
+ */
+static void run_self_telemetry(int64_t now_us)
+{
+    mqtt_telemetry_config_t config;
+    bool connected = s_client && mqtt_telemetry_is_broker_connected();
+    mqtt_telemetry_get_config(&config);
+
+    if (!connected || config.telemetry_interval_s == 0) {
+        s_self_was_connected = connected;
+        return;
+    }
+    if (!s_self_was_connected) {
+        /* Give every new broker session a fresh baseline sample. */
+        s_self_was_connected = true;
+        s_self_have_published = false;
+        s_self_alias_state = 0;
+        s_self_next_sample_us = now_us;
+    }
+    if (now_us < s_self_next_sample_us) return;
+
+    int64_t interval_us = (int64_t)config.telemetry_interval_s * 1000000;
+    s_self_next_sample_us = now_us + interval_us;
+
+    self_sample_t sample;
+    sample_self_telemetry(&sample, now_us);
+    bool heartbeat_due = !s_self_have_published ||
+        now_us - s_self_stats.last_published_us >=
+            interval_us * SELF_TELEMETRY_HEARTBEAT_INTERVALS;
+    if (!heartbeat_due &&
+        !self_sample_changed(&s_self_last_published, &sample,
+                             config.telemetry_deadband_pct)) {
+        if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(20)) == pdTRUE) {
+            s_self_stats.suppressed++;
+            xSemaphoreGive(s_mutex);
+        }
+        return;
+    }
+
+    char payload[320];
+    int len = format_self_sample(&sample, payload, sizeof(payload));
+    if (len <= 0 || len >= (int)sizeof(payload)) return;
+    int msg_id = -1;
+    if (xSemaphoreTake(s_client_lock, pdMS_TO_TICKS(100)) == pdTRUE) {
+        if (s_client) msg_id = publish_self_payload(payload, len);
+        xSemaphoreGive(s_client_lock);
+    }
+    if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(20)) == pdTRUE) {
+        if (msg_id < 0) {
+            s_self_stats.failed++;
+        } else {
+            s_self_stats.published++;
+            s_self_stats.last_published_us = now_us;
+        }
+        xSemaphoreGive(s_mutex);
+    }
+    if (msg_id >= 0) {
+        s_self_last_published = sample;
+        s_self_have_published = true;
+        ESP_LOGD(TAG, "Self-telemetry %s: %s", s_self_topic, payload);
+    }
+}
+
 static void destroy_client(void)
 {
     if (!s_client) return;
     esp_mqtt_client_stop(s_client);
+    xSemaphoreTake(s_client_lock, portMAX_DELAY);
     esp_mqtt_client_destroy(s_client);
     s_client = NULL;
+    xSemaphoreGive(s_client_lock);
     s_active_broker_host[0] = 0;
     set_broker_connected(false);
 }
@@ -229,34 +778,84 @@ static esp_err_t create_client(const char *broker_host)
     mqtt_telemetry_get_config(&config);
     snprintf(s_broker_uri, sizeof(s_broker_uri), "mqtt://%s:%d",
              broker_host, MQTT_TELEMETRY_PORT);
-    snprintf(s_power_topic, sizeof(s_power_topic), "%s/power/get",
-             config.root_topic);
+    snprintf(s_power_topic, sizeof(s_power_topic), "%s/%s",
+             config.root_topic, config.power_subtopic);
+    const char *power_path = config.power_json_path;
+    s_power_json_active = power_path[0] &&
+                          json_stream_init(&s_power_json, &power_path, 1);
     snprintf(s_connected_topic, sizeof(s_connected_topic), "%s/connected",
              config.root_topic);
+    snprintf(s_self_topic, sizeof(s_self_topic), "%s/%s",
+             config.root_topic, MQTT_SELF_TELEMETRY_SUBTOPIC);
 
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    s_active_protocol_v5 = config.protocol_v5;
+#else
+    s_active_protocol_v5 = false;
+#endif
+    s_active_persistent = config.persistent_session;
+    s_active_local_broker = config.local_broker;
+    /* The broker finds a persistent session by client id, so it must not
+     * change across reboots. */
+    uint8_t mac[6] = {0};
+    esp_read_mac(mac, ESP_MAC_WIFI_SOFTAP);
+    snprintf(s_client_id, sizeof(s_client_id), "esp32c3-%02x%02x%02x",
+             mac[3], mac[4], mac[5]);
     esp_mqtt_client_config_t mqtt_config = {
         .broker.address.uri = s_broker_uri,
+        .credentials.client_id = s_client_id,
+        .session.protocol_ver = s_active_protocol_v5 ? MQTT_PROTOCOL_V_5
+                                                     : MQTT_PROTOCOL_V_3_1_1,
+        .session.disable_clean_session = config.persistent_session,
     };
     s_client = esp_mqtt_client_init(&mqtt_config);
     if (!s_client) return ESP_ERR_NO_MEM;
-    esp_err_t err = esp_mqtt_client_register_event(
-        s_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
+    esp_err_t err = ESP_OK;
+#ifdef CONFIG_MQTT_PROTOCOL_5
+    if (s_active_protocol_v5) {
+        esp_mqtt5_connection_property_config_t connect_property = {
+            .topic_alias_maximum = MQTT_RX_TOPIC_ALIAS_MAX,
+            .request_problem_info = true,
+            .session_expiry_interval =
+                config.persistent_session ? MQTT_SESSION_EXPIRY_S : 0,
+        };
+        err = esp_mqtt5_client_set_connect_property(s_client,
+                                                    &connect_property);
+    }
+#endif
+    portENTER_CRITICAL(&s_link_stats_lock);
+    memset(&s_link_stats, 0, sizeof(s_link_stats));
+    s_link_stats.protocol_v5 = s_active_protocol_v5;
+    portEXIT_CRITICAL(&s_link_stats_lock);
+    if (err == ESP_OK) {
+        err = esp_mqtt_client_register_event(
+            s_client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
+    }
     if (err == ESP_OK) err = esp_mqtt_client_start(s_client);
     if (err != ESP_OK) {
+        xSemaphoreTake(s_client_lock, portMAX_DELAY);
         esp_mqtt_client_destroy(s_client);
         s_client = NULL;
+        xSemaphoreGive(s_client_lock);
         return err;
     }
     strlcpy(s_active_broker_host, broker_host,
             sizeof(s_active_broker_host));
-    ESP_LOGI(TAG, "MQTT client started for %s", s_broker_uri);
+    ESP_LOGI(TAG, "MQTT %s client %s started for %s (%s session)",
+             s_active_protocol_v5 ? "v5" : "v3.1.1", s_client_id, s_broker_uri,
+             config.persistent_session ? "persistent" : "clean");
     return ESP_OK;
 }
 
+static esp_err_t restart_task(void);
+
 static void mqtt_task(void *arg)
 {
     (void)arg;
+    int watch_id = watchdog_register("mqtt_task", MQTT_TASK_HEARTBEAT_MS,
+                                     restart_task);
     for (;;) {
+        watchdog_checkin(watch_id);
         bool reconfigure = false;
         char desired_host[MQTT_BROKER_HOST_MAX_LEN + 1];
         if (xSemaphoreTake(s_mutex, portMAX_DELAY) == pdTRUE) {
@@ -278,10 +877,33 @@ static void mqtt_task(void *arg)
                          esp_err_to_name(err));
             }
         }
+        run_self_telemetry(esp_timer_get_time());
         vTaskDelay(pdMS_TO_TICKS(s_client ? 500 : 2000));
     }
 }
 
+/*
+ * Called by the watchdog when mqtt_task stopped checking in. A task stuck
+ * holding one of the module's locks cannot be replaced; the watchdog resets
+ * the chip instead. If it is stuck inside the MQTT client, the new task
+ * stalls in the same place and the reset follows one period later.
+ */
+static esp_err_t restart_task(void)
+{
+    TaskHandle_t stuck = s_task;
+    if (xSemaphoreGetMutexHolder(s_mutex) == stuck ||
+        xSemaphoreGetMutexHolder(s_client_lock) == stuck) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_task = NULL;
+    vTaskDelete(stuck);
+    if (xTaskCreate(mqtt_task, "mqtt_telemetry", 6144, NULL, 7, &s_task) != pdPASS) {
+        s_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
 esp_err_t mqtt_telemetry_start(void)
 {
     if (s_task) return ESP_OK;
@@ -289,7 +911,11 @@ esp_err_t mqtt_telemetry_start(void)
         s_mutex = xSemaphoreCreateMutex();
         if (!s_mutex) return ESP_ERR_NO_MEM;
     }
-    load_config_from_nvs();
+    if (!s_client_lock) {
+        s_client_lock = xSemaphoreCreateMutex();
+        if (!s_client_lock) return ESP_ERR_NO_MEM;
+    }
+    load_config();
     if (xTaskCreate(mqtt_task, "mqtt_telemetry", 6144, NULL, 7, &s_task) != pdPASS) {
         s_task = NULL;
         return ESP_ERR_NO_MEM;
@@ -335,26 +961,40 @@ bool mqtt_telemetry_get_effective_broker_host(char *out, size_t out_len)
     return ip4addr_ntoa_r(&gateway, out, (int)out_len) != NULL;
 }
 
-esp_err_t mqtt_telemetry_set_config(bool broker_auto, const char *broker_host,
-                                    const char *root_topic)
+esp_err_t mqtt_telemetry_set_config(const mqtt_telemetry_config_t *config)
 {
-    if (!broker_host || (!broker_auto && !valid_broker_host(broker_host)) ||
-        (broker_host[0] && !valid_broker_host(broker_host)) ||
-        !valid_root_topic(root_topic)) {
+    if (!config ||
+        (!config->broker_auto && !valid_broker_host(config->broker_host)) ||
+        (config->broker_host[0] && !valid_broker_host(config->broker_host)) ||
+        !valid_root_topic(config->root_topic) ||
+        !valid_power_subtopic(config->power_subtopic) ||
+        (config->power_json_path[0] &&
+         !json_stream_valid_path(config->power_json_path)) ||
+        !valid_telemetry_interval(config->telemetry_interval_s) ||
+        config->telemetry_deadband_pct > MQTT_SELF_TELEMETRY_MAX_DEADBAND_PCT ||
+        (config->bridge_filters[0] &&
+         !mqtt_broker_valid_filters(config->bridge_filters))) {
         return ESP_ERR_INVALID_ARG;
     }
-    esp_err_t err = save_config_to_nvs(broker_auto, broker_host, root_topic);
+    esp_err_t err = save_config(config);
     if (err != ESP_OK) return err;
     if (xSemaphoreTake(s_mutex, portMAX_DELAY) != pdTRUE) return ESP_ERR_TIMEOUT;
-    s_config.broker_auto = broker_auto;
-    strlcpy(s_config.broker_host, broker_host, sizeof(s_config.broker_host));
-    strlcpy(s_config.root_topic, root_topic, sizeof(s_config.root_topic));
-    strlcpy(s_power, "N/A", sizeof(s_power));
-    s_power_updated_us = 0;
-    s_obk_connected_state = -1;
+    /* Cached values belong to the old topics only when the source changes. */
+    if (strcmp(s_config.root_topic, config->root_topic) != 0 ||
+        strcmp(s_config.power_subtopic, config->power_subtopic) != 0 ||
+        strcmp(s_config.power_json_path, config->power_json_path) != 0 ||
+        s_config.local_broker != config->local_broker) {
+        strlcpy(s_power, "N/A", sizeof(s_power));
+        s_power_updated_us = 0;
+        s_power_valid = false;
+        s_power_retained = false;
+        s_obk_connected_state = -1;
+    }
+    s_config = *config;
     s_broker_connected = false;
     s_reconfigure_requested = true;
     xSemaphoreGive(s_mutex);
+    notify_update();
     return ESP_OK;
 }
 
@@ -363,22 +1003,162 @@ void mqtt_telemetry_get_power(char *out, size_t out_len)
     if (!out || out_len == 0) return;
     strlcpy(out, "N/A", out_len);
     if (s_mutex && xSemaphoreTake(s_mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        int64_t age = s_power_updated_us == 0
-            ? INT64_MAX : esp_timer_get_time() - s_power_updated_us;
-        if (s_broker_connected &&
-            age <= (int64_t)OBK_POWER_STALE_TIMEOUT_MS * 1000) {
+        if (source_connected() && power_is_fresh(esp_timer_get_time())) {
             strlcpy(out, s_power, out_len);
         }
         xSemaphoreGive(s_mutex);
     }
 }
 
+bool mqtt_telemetry_get_power_reading(mqtt_power_reading_t *out)
+{
+    if (!out) return false;
+    memset(out, 0, sizeof(*out));
+    strlcpy(out->value, "N/A", sizeof(out->value));
+    out->age_s = -1;
+    if (!s_mutex || xSemaphoreTake(s_mutex, pdMS_TO_TICKS(5)) != pdTRUE) {
+        return false;
+    }
+    int64_t now = esp_timer_get_time();
+    bool fresh = source_connected() && power_is_fresh(now);
+    if (fresh || (s_config.persistent_session && s_power_valid)) {
+        strlcpy(out->value, s_power, sizeof(out->value));
+        out->valid = true;
+        out->stale = !fresh;
+        out->retained = s_power_retained;
+        if (s_power_updated_us != 0) {
+            out->age_s = (int32_t)((now - s_power_updated_us) / 1000000);
+        }
+    }
+    xSemaphoreGive(s_mutex);
+    return out->valid;
+}
+
+void mqtt_telemetry_get_first_display_stats(mqtt_first_display_stats_t *out)
+{
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (s_mutex && xSemaphoreTake(s_mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
+        *out = s_first_display;
+        out->pending = source_connected() && s_first_display_pending;
+        xSemaphoreGive(s_mutex);
+    }
+}
+
 int mqtt_telemetry_get_obk_connected_state(void)
 {
     int state = -2;
     if (s_mutex && xSemaphoreTake(s_mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-        state = s_broker_connected ? s_obk_connected_state : -2;
+        state = source_connected() ? s_obk_connected_state : -2;
         xSemaphoreGive(s_mutex);
     }
     return state;
 }
+
+/* True if topic is exactly "<root>/<subtopic>". */
+static bool topic_is(const char *topic, const char *root, const char *subtopic)
+{
+    size_t root_len = strlen(root);
+    return strncmp(topic, root, root_len) == 0 && topic[root_len] == '/' &&
+           strcmp(topic + root_len + 1, subtopic) == 0;
+}
+
+void mqtt_telemetry_ingest_local(const char *topic, const uint8_t *payload,
+                                 size_t len, bool retain)
+{
+    mqtt_metric_id_t metric = MQTT_METRIC_NONE;
+    char path[MQTT_POWER_JSON_PATH_MAX_LEN + 1] = "";
+    if (!topic || !payload || !s_mutex) return;
+    if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(20)) != pdTRUE) return;
+    if (s_config.local_broker) {
+        if (topic_is(topic, s_config.root_topic, s_config.power_subtopic)) {
+            metric = MQTT_METRIC_POWER;
+            strlcpy(path, s_config.power_json_path, sizeof(path));
+        } else if (topic_is(topic, s_config.root_topic, "connected")) {
+            metric = MQTT_METRIC_CONNECTED;
+        }
+    }
+    xSemaphoreGive(s_mutex);
+    if (metric == MQTT_METRIC_NONE || len > INT_MAX) return;
+
+    if (metric == MQTT_METRIC_POWER && path[0]) {
+        const char *power_path = path;
+        if (!json_stream_init(&s_local_power_json, &power_path, 1)) return;
+        json_stream_feed(&s_local_power_json, (const char *)payload, len);
+        const char *value = json_stream_value(&s_local_power_json, 0);
+        if (json_stream_complete(&s_local_power_json) && value && *value) {
+            handle_message(metric, value, (int)strlen(value), retain);
+        } else {
+            ESP_LOGD(TAG, "Local power payload has no %s", path);
+        }
+        return;
+    }
+    handle_message(metric, (const char *)payload, (int)len, retain);
+}
+
+bool mqtt_telemetry_publish_upstream(const char *topic, const uint8_t *payload,
+                                     size_t len, bool retain)
+{
+    int msg_id = -1;
+    if (!topic || !s_client_lock || len > INT_MAX ||
+        !mqtt_telemetry_is_broker_connected()) {
+        return false;
+    }
+    if (xSemaphoreTake(s_client_lock, pdMS_TO_TICKS(20)) != pdTRUE) return false;
+    if (s_client) {
+#ifdef CONFIG_MQTT_PROTOCOL_5
+        if (s_active_protocol_v5) {
+            /* Drop the alias property left behind by the self-telemetry
+             * publisher; bridged topics always go out in full. */
+            esp_mqtt5_publish_property_config_t property = {0};
+            esp_mqtt5_client_set_publish_property(s_client, &property);
+        }
+#endif
+        /* Enqueue rather than publish: this runs on the local broker task
+         * and must not block on the PPP link. */
+        msg_id = esp_mqtt_client_enqueue(s_client, topic, (const char *)payload,
+                                         (int)len, 0, retain ? 1 : 0, true);
+    }
+    xSemaphoreGive(s_client_lock);
+    if (msg_id < 0) return false;
+    record_published(strlen(topic), (int)len, false);
+    return true;
+}
+
+void mqtt_telemetry_set_local_source(bool up)
+{
+    if (!s_mutex || xSemaphoreTake(s_mutex, portMAX_DELAY) != pdTRUE) return;
+    if (up && !s_local_source_up) {
+        /* Time to first display now runs from the broker coming up. */
+        s_connected_us = esp_timer_get_time();
+        s_first_display_pending = true;
+        s_obk_connected_state = -1;
+    }
+    bool changed = s_local_source_up != up;
+    s_local_source_up = up;
+    xSemaphoreGive(s_mutex);
+    if (changed) notify_update();
+}
+
+void mqtt_telemetry_set_update_callback(mqtt_telemetry_update_cb_t callback)
+{
+    s_update_cb = callback;
+}
+
+void mqtt_telemetry_get_self_stats(mqtt_self_telemetry_stats_t *out)
+{
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (s_mutex && xSemaphoreTake(s_mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
+        *out = s_self_stats;
+        xSemaphoreGive(s_mutex);
+    }
+}
+
+void mqtt_telemetry_get_link_stats(mqtt_link_stats_t *out)
+{
+    if (!out) return;
+    portENTER_CRITICAL(&s_link_stats_lock);
+    *out = s_link_stats;
+    portEXIT_CRITICAL(&s_link_stats_lock);
+}
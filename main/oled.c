@@ -9,22 +9,30 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 #include "oled.h"
+#include "oled_pages.h"
+#include "oled_tiles.h"
+#include "power_history.h"
 #include "ap_config.h"
 #include "mqtt_telemetry.h"
 #include "web_server.h"
 #include "client_rssi.h"
+#include "config_store.h"
+#include "watchdog.h"
 
 #include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/timers.h"
 
 #include "driver/gpio.h"
+#include "esp_event.h"
 #include "esp_log.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
-#include "nvs.h"
 
 #include "u8g2.h"
 #include "u8g2_esp32_hal.h"
@@ -34,18 +42,58 @@
 #define OLED_SCL GPIO_NUM_6
 #define OLED_RST U8G2_ESP32_HAL_UNDEFINED
 #define OLED_DEBUG_BUTTON GPIO_NUM_9
-#define BUTTON_DEBOUNCE_SAMPLES 2
+#define BUTTON_DEBOUNCE_MS 30
 #define BUTTON_LONG_PRESS_MS 1200
 #define BUTTON_SEQUENCE_GAP_MS 2000
 #define AUTH_TOGGLE_PRESS_COUNT 6
-#define OLED_WIDTH 128
-#define OLED_HEIGHT 64
-#define CONTENT_X_OFFSET 28
-#define CONTENT_Y_OFFSET 18
-#define CREDENTIAL_LINE_CHARS 25
-#define CREDENTIAL_LINE_COUNT 5
-#define OLED_NVS_NAMESPACE "display"
-#define OLED_NVS_ENABLED_KEY "enabled"
+/* Resend the whole frame this often in case the panel missed a transfer. */
+#define OLED_FULL_REFRESH_FRAMES 300
+/* Debug page and screensaver animation. */
+#define OLED_REFRESH_MS 1000
+/* Normal page without new telemetry: client count, RSSI bar, stale age. */
+#define OLED_IDLE_REFRESH_MS 5000
+/* Bursts of telemetry updates are drawn at most this often. */
+#define OLED_MIN_FRAME_MS 200
+/* Render plus transfer time one frame may take. A slower frame stretches the
+ * gap before the next one in proportion, so a slow bus cannot starve other
+ * tasks. */
+#define OLED_FRAME_BUDGET_US 20000
+/* Longest sleep, so the liveness watchdog hears from a disabled display. */
+#define OLED_HEARTBEAT_MS 10000
+/* oled_task notification bits. */
+#define OLED_EVT_BUTTON (1u << 0)
+#define OLED_EVT_TOGGLE (1u << 1)
+#define OLED_EVT_POWER (1u << 2)
+#define OLED_EVT_SETTINGS (1u << 3)
+#define OLED_EVT_CLIENTS (1u << 4)
+#define OLED_EVT_BLANK (1u << 5)
+/* Page inputs. Values that are only polled (RSSI, web health, age of a stale
+ * reading) are covered by the page's refresh interval instead. */
+#define OLED_DEP_POWER (1u << 0)    /* power value, OBK and broker state */
+#define OLED_DEP_CLIENTS (1u << 1)  /* SoftAP connects and disconnects */
+#define OLED_DEP_SETTINGS (1u << 2) /* display, AP and auth settings */
+
+typedef enum {
+    OLED_PAGE_POWER,
+    OLED_PAGE_DEBUG,
+    OLED_PAGE_HISTORY,
+    OLED_PAGE_CLIENTS,
+    OLED_PAGE_CREDENTIALS,
+    OLED_PAGE_SCREENSAVER,
+    OLED_PAGE_BLANK,
+    OLED_PAGE_COUNT,
+} oled_page_id_t;
+
+/* One screen: what it draws, which inputs it depends on, and how often it
+ * must be redrawn when none of them changes (0: never). */
+typedef struct {
+    const char *name;
+    uint32_t deps;
+    uint32_t refresh_ms;
+    bool dim;
+    uint32_t rotation_bit; /* OLED_ROTATE_*, 0 for pages chosen by state */
+    void (*render)(int64_t now_us);
+} oled_page_t;
 
 static const uint8_t I2C_ADDR_8BIT = (0x3C << 1);
 
@@ -54,13 +102,23 @@ static u8g2_t u8g2; // OLED driver handle
 
 // statics (oben in der Datei, dort wo width/height/xOffset/yOffset sind)
 static bool screensaver = false;
-static int idle_seconds = 0;
+/* Since when the power has been zero; 0 while it is positive. */
+static int64_t idle_since_us = 0;
 static const int SCREENSAVER_DELAY = 60; // s
 static const uint8_t CONTRAST = 125;   // 0..255 (für kleines Display niedrig halten)
 static const uint8_t DIM_CONTRAST = 12;   // 0..255 (für kleines Display niedrig halten)
-static int ss_x, ss_y, ss_dx = 1, ss_dy = 1;
-static int normal_jitter_phase = 0;
-static int blank_seconds = 0;
+static oled_screensaver_t ss;
+/* Screensaver and blanking state above: touched only by oled_task. */
+static int64_t blank_until_us = 0;
+/* Start of the current rotation cycle, 0 outside the rotating pages. */
+static int64_t rotation_started_us = 0;
+static oled_rotation_t rotation = {.pages = OLED_ROTATE_POWER, .interval_s = 0};
+static uint16_t history_minutes = OLED_HISTORY_DEFAULT_MINUTES;
+/* Guards rotation and history_minutes. */
+static portMUX_TYPE rotation_lock = portMUX_INITIALIZER_UNLOCKED;
+/* Power samples for the graph page; touched only by oled_task. */
+static power_history_t history;
+static uint16_t history_span_minutes = 0;
 static int64_t last_web_check_us = 0;
 static int last_web_status = 0;
 static esp_err_t last_web_err = ESP_OK;
@@ -69,29 +127,129 @@ static bool debug_toggle_requested = false;
 static portMUX_TYPE debug_toggle_lock = portMUX_INITIALIZER_UNLOCKED;
 static bool display_enabled = true;
 static portMUX_TYPE display_enabled_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t oled_task_handle = NULL;
+static TimerHandle_t button_timer = NULL;
+/* Pending long press, 0 when none; set and read by oled_task only. */
+static int64_t button_long_press_at_us = 0;
+static unsigned button_short_presses = 0;
+/* Copy of what the panel shows, for sending only the tiles that changed.
+ * Touched only by oled_task after oled_start(). */
+static uint8_t frame_shadow[OLED_WIDTH * OLED_HEIGHT / 8];
+static bool frame_shadow_valid = false;
+static int frames_since_full = 0;
+static uint32_t i2c_bytes = 0;
+/* Set by oled_task between START and END of an I2C transfer; read by the
+ * watchdog. */
+static volatile bool i2c_in_transfer = false;
+static oled_frame_stats_t frame_stats;
+static portMUX_TYPE frame_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool rotation_valid(const oled_rotation_t *r)
+{
+    return (r->pages & ~OLED_ROTATE_ALL) == 0 &&
+           (r->interval_s == 0 || (r->interval_s >= OLED_ROTATE_MIN_S &&
+                                   r->interval_s <= OLED_ROTATE_MAX_S));
+}
 
 static void load_display_setting(void)
 {
-    nvs_handle_t nvs;
-    uint8_t enabled = 1;
-    if (nvs_open(OLED_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
-        if (nvs_get_u8(nvs, OLED_NVS_ENABLED_KEY, &enabled) != ESP_OK) {
-            enabled = 1;
-        }
-        nvs_close(nvs);
+    config_display_t stored;
+    config_store_get_display(&stored);
+    oled_rotation_t loaded = {.pages = stored.rotate_pages,
+                              .interval_s = stored.rotate_s};
+    if (!rotation_valid(&loaded)) {
+        loaded = (oled_rotation_t){.pages = OLED_ROTATE_POWER, .interval_s = 0};
+    }
+    uint16_t minutes = stored.history_minutes;
+    if (minutes < OLED_HISTORY_MIN_MINUTES ||
+        minutes > OLED_HISTORY_MAX_MINUTES) {
+        minutes = OLED_HISTORY_DEFAULT_MINUTES;
     }
     portENTER_CRITICAL(&display_enabled_lock);
-    display_enabled = enabled != 0;
+    display_enabled = stored.enabled != 0;
     portEXIT_CRITICAL(&display_enabled_lock);
+    portENTER_CRITICAL(&rotation_lock);
+    rotation = loaded;
+    history_minutes = minutes;
+    portEXIT_CRITICAL(&rotation_lock);
 }
 
-static int get_connected_client_count(void)
+/* Counts bytes on the wire, including the address byte of each transfer,
+ * and marks the transfers for the watchdog. */
+static uint8_t oled_i2c_byte_cb(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int,
+                                void *arg_ptr)
 {
-    wifi_sta_list_t sta_list = {0};
-    if (esp_wifi_ap_get_sta_list(&sta_list) != ESP_OK) {
-        return 0;
+    if (msg == U8X8_MSG_BYTE_SEND) {
+        i2c_bytes += arg_int;
+    } else if (msg == U8X8_MSG_BYTE_START_TRANSFER) {
+        i2c_bytes++;
+        i2c_in_transfer = true;
     }
-    return sta_list.num;
+    uint8_t result = u8g2_esp32_i2c_byte_cb(u8x8, msg, arg_int, arg_ptr);
+    if (msg == U8X8_MSG_BYTE_END_TRANSFER) i2c_in_transfer = false;
+    return result;
+}
+
+static void send_tiles(void *ctx, uint8_t tx, uint8_t ty, uint8_t tw)
+{
+    u8g2_UpdateDisplayArea((u8g2_t *)ctx, tx, ty, tw, 1);
+}
+
+/* Replacement for u8g2_SendBuffer(): transfers only the 8x8 tiles that
+ * differ from the previous frame. */
+static void send_frame(void)
+{
+    bool full = !frame_shadow_valid ||
+                ++frames_since_full >= OLED_FULL_REFRESH_FRAMES;
+    uint32_t bytes_before = i2c_bytes;
+    int64_t started = esp_timer_get_time();
+    oled_tiles_result_t sent = oled_tiles_flush(
+        u8g2_GetBufferPtr(&u8g2), frame_shadow,
+        u8g2_GetBufferTileWidth(&u8g2), u8g2_GetBufferTileHeight(&u8g2),
+        full, send_tiles, &u8g2);
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - started);
+    uint32_t bytes = i2c_bytes - bytes_before;
+    if (full) {
+        frame_shadow_valid = true;
+        frames_since_full = 0;
+    }
+
+    portENTER_CRITICAL(&frame_stats_lock);
+    frame_stats.frames++;
+    if (full) frame_stats.full_frames++;
+    if (sent.tiles == 0) frame_stats.unchanged_frames++;
+    frame_stats.tiles_sent += sent.tiles;
+    frame_stats.i2c_bytes += bytes;
+    frame_stats.i2c_us += elapsed_us;
+    frame_stats.last_bytes = bytes;
+    frame_stats.last_us = elapsed_us;
+    portEXIT_CRITICAL(&frame_stats_lock);
+}
+
+static void notify_oled_task(uint32_t events)
+{
+    TaskHandle_t task = oled_task_handle;
+    if (task) xTaskNotify(task, events, eSetBits);
+}
+
+static void on_telemetry_update(void)
+{
+    notify_oled_task(OLED_EVT_POWER);
+}
+
+static void on_wifi_client_event(void *arg, esp_event_base_t base,
+                                 int32_t event_id, void *event_data)
+{
+    (void)arg;
+    (void)base;
+    (void)event_id;
+    (void)event_data;
+    notify_oled_task(OLED_EVT_CLIENTS);
+}
+
+static int get_connected_client_count(void)
+{
+    return client_rssi_get_count();
 }
 
 static char get_obk_connected_marker(void)
@@ -109,42 +267,9 @@ static int8_t get_best_client_rssi(void)
     return client_rssi_get_best();
 }
 
-/* Draw a horizontal RSSI bar with one pixel per dBm over the configured range. */
-static void draw_signal_bar(u8g2_t *u8g2, int x, int y, int8_t rssi)
+static void render_screensaver_page(int64_t now_us)
 {
-    enum {
-        BAR_W = 58,
-        BAR_H = 6,
-        RSSI_MIN_DBM = -100,
-        RSSI_MAX_DBM = -45,
-    };
-
-    u8g2_DrawFrame(u8g2, x, y, BAR_W, BAR_H);
-
-    if (rssi == INT8_MIN) {
-        return;
-    }
-
-    if (rssi < RSSI_MIN_DBM) {
-        rssi = RSSI_MIN_DBM;
-    } else if (rssi > RSSI_MAX_DBM) {
-        rssi = RSSI_MAX_DBM;
-    }
-
-    uint8_t fill_w = 1 + (uint16_t)(rssi - RSSI_MIN_DBM) * (BAR_W - 3) /
-                         (RSSI_MAX_DBM - RSSI_MIN_DBM);
-
-    u8g2_DrawBox(u8g2, x + 1, y + 1, fill_w, BAR_H - 2);
-}
-
-// Hilfsfunktion: sichere Grenzen für die Animation berechnen
-static void ss_init_bounds(void) {
-    ss_x = OLED_WIDTH / 2;
-    ss_y = OLED_HEIGHT / 2;
-    ss_dx = 1; ss_dy = 1;
-}
-
-static void draw_screensaver(u8g2_t *u8g2) {
+    (void)now_us;
     char buf[16];
     char marker = get_obk_connected_marker();
     if (marker) {
@@ -152,32 +277,12 @@ static void draw_screensaver(u8g2_t *u8g2) {
     } else {
         snprintf(buf, sizeof(buf), "%d", get_connected_client_count());
     }
+    oled_pages_draw_screensaver(&u8g2, &ss, buf);
+}
 
-    u8g2_SetFont(u8g2, u8g2_font_6x10_tr);
-    int text_w = u8g2_GetStrWidth(u8g2, buf);
-    int text_h = 10; // baseline height for 6x10 font
-
-    int min_x = 1;
-    int min_y = text_h + 1;
-    int max_x = OLED_WIDTH - text_w - 1;
-    int max_y = OLED_HEIGHT - 1;
-    if (max_x < min_x) {
-        min_x = max_x = 1;
-    }
-    if (max_y < min_y) {
-        min_y = max_y = text_h + 1;
-    }
-
-    ss_x += ss_dx;
-    ss_y += ss_dy;
-    if (ss_x < min_x) { ss_x = min_x; ss_dx = -ss_dx; }
-    if (ss_x > max_x) { ss_x = max_x; ss_dx = -ss_dx; }
-    if (ss_y < min_y) { ss_y = min_y; ss_dy = -ss_dy; }
-    if (ss_y > max_y) { ss_y = max_y; ss_dy = -ss_dy; }
-
-    u8g2_ClearBuffer(u8g2);
-    u8g2_DrawStr(u8g2, ss_x, ss_y, buf);
-    u8g2_SendBuffer(u8g2);
+static int64_t ms_to_us(int64_t ms)
+{
+    return ms * 1000;
 }
 
 static float parse_power(const char *s) {
@@ -185,92 +290,94 @@ static float parse_power(const char *s) {
     return strtof(s, NULL);
 }
 
-static void oled_button_init(void)
+/* Every edge, bounces included, restarts the debounce timer; the level is
+ * read once it has been quiet for BUTTON_DEBOUNCE_MS. */
+static void IRAM_ATTR button_isr(void *arg)
+{
+    (void)arg;
+    BaseType_t woken = pdFALSE;
+    xTimerResetFromISR(button_timer, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void button_debounced(TimerHandle_t timer)
+{
+    (void)timer;
+    notify_oled_task(OLED_EVT_BUTTON);
+}
+
+static esp_err_t oled_button_init(void)
 {
     gpio_config_t cfg = {
         .pin_bit_mask = 1ULL << OLED_DEBUG_BUTTON,
         .mode = GPIO_MODE_INPUT,
         .pull_up_en = GPIO_PULLUP_ENABLE,
         .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE
+        .intr_type = GPIO_INTR_ANYEDGE
     };
-    gpio_config(&cfg);
+    button_timer = xTimerCreate("oled_button", pdMS_TO_TICKS(BUTTON_DEBOUNCE_MS),
+                                pdFALSE, NULL, button_debounced);
+    if (!button_timer) return ESP_ERR_NO_MEM;
+    esp_err_t err = gpio_config(&cfg);
+    if (err != ESP_OK) return err;
+    err = gpio_install_isr_service(0);
+    /* Another module may already have installed the shared service. */
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return err;
+    return gpio_isr_handler_add(OLED_DEBUG_BUTTON, button_isr, NULL);
 }
 
 static void toggle_debug_page(void)
 {
     debug_mode = !debug_mode;
     screensaver = false;
-    idle_seconds = 0;
-    blank_seconds = 0;
-    normal_jitter_phase = 0;
+    idle_since_us = 0;
+    blank_until_us = 0;
 }
 
-static void poll_debug_button(void)
+/* Long press of BOOT: due once the button has been held long enough. */
+static bool check_long_press(int64_t now_us)
 {
-    static int sampled_level = 1;
-    static int stable_level = 1;
-    static unsigned same_sample_count = 0;
-    static TickType_t press_started_at = 0;
-    static TickType_t last_short_release_at = 0;
-    static unsigned short_press_count = 0;
-    static bool long_press_handled = false;
-    TickType_t now = xTaskGetTickCount();
-    int level = gpio_get_level(OLED_DEBUG_BUTTON);
-
-    if (stable_level == 1 && short_press_count > 0 &&
-        (now - last_short_release_at) > pdMS_TO_TICKS(BUTTON_SEQUENCE_GAP_MS)) {
-        short_press_count = 0;
-    }
-
-    if (level == sampled_level) {
-        if (same_sample_count < BUTTON_DEBOUNCE_SAMPLES) {
-            same_sample_count++;
-        }
-    } else {
-        sampled_level = level;
-        same_sample_count = 1;
+    if (button_long_press_at_us == 0 || now_us < button_long_press_at_us) {
+        return false;
     }
+    button_long_press_at_us = 0;
+    button_short_presses = 0;
+    toggle_debug_page();
+    ESP_LOGI(TAG, "BOOT long press toggled OLED debug page");
+    return true;
+}
 
-    if (stable_level == 0 && !long_press_handled &&
-        (now - press_started_at) >= pdMS_TO_TICKS(BUTTON_LONG_PRESS_MS)) {
-        toggle_debug_page();
-        long_press_handled = true;
-        short_press_count = 0;
-        ESP_LOGI(TAG, "BOOT long press toggled OLED debug page");
-    }
+/* Debounced BOOT level changes drive the short- and six-press gestures. */
+static void handle_button_level(int level, int64_t now_us)
+{
+    static int stable_level = 1;
+    static int64_t last_short_release_us = 0;
 
-    if (same_sample_count < BUTTON_DEBOUNCE_SAMPLES ||
-        sampled_level == stable_level) {
+    if (level == stable_level) return;
+    stable_level = level;
+    if (level == 0) {
+        button_long_press_at_us = now_us + ms_to_us(BUTTON_LONG_PRESS_MS);
         return;
     }
+    /* Released; a cleared deadline means the long press already fired. */
+    if (button_long_press_at_us == 0) return;
+    button_long_press_at_us = 0;
 
-    stable_level = sampled_level;
-    if (stable_level == 0) {
-        press_started_at = now;
-        long_press_handled = false;
-        return;
+    if (button_short_presses > 0 &&
+        now_us - last_short_release_us > ms_to_us(BUTTON_SEQUENCE_GAP_MS)) {
+        button_short_presses = 0;
     }
+    last_short_release_us = now_us;
+    button_short_presses++;
 
-    if (!long_press_handled) {
-        if (short_press_count > 0 &&
-            (now - last_short_release_at) > pdMS_TO_TICKS(BUTTON_SEQUENCE_GAP_MS)) {
-            short_press_count = 0;
-        }
-        last_short_release_at = now;
-        short_press_count++;
-
-        if (short_press_count >= AUTH_TOGGLE_PRESS_COUNT) {
-            bool auth_enabled = web_server_toggle_authentication();
-            short_press_count = 0;
-            screensaver = false;
-            idle_seconds = 0;
-            blank_seconds = 0;
-            u8g2_SetPowerSave(&u8g2, 0);
-            u8g2_SetContrast(&u8g2, CONTRAST);
-            ESP_LOGW(TAG, "Six BOOT presses set web authentication to %s",
-                     auth_enabled ? "ON" : "OFF");
-        }
+    if (button_short_presses >= AUTH_TOGGLE_PRESS_COUNT) {
+        bool auth_enabled = web_server_toggle_authentication();
+        button_short_presses = 0;
+        screensaver = false;
+        idle_since_us = 0;
+        blank_until_us = 0;
+        ESP_LOGW(TAG, "Six BOOT presses set web authentication to %s",
+                 auth_enabled ? "ON" : "OFF");
     }
 }
 
@@ -294,11 +401,30 @@ static void update_cached_web_health(void)
                                  &last_web_check_us);
 }
 
-static void draw_debug_page(void)
+/* Time from broker connect to the first power value; R = retained copy. */
+static void format_first_display(char *out, size_t out_len)
+{
+    mqtt_first_display_stats_t stats;
+    mqtt_telemetry_get_first_display_stats(&stats);
+    if (stats.pending) {
+        snprintf(out, out_len, "FD:wait");
+    } else if (stats.samples == 0) {
+        snprintf(out, out_len, "FD:--");
+    } else if (stats.last_ms < 10000) {
+        snprintf(out, out_len, "FD:%lums%s", (unsigned long)stats.last_ms,
+                 stats.last_from_retained ? " R" : "");
+    } else {
+        snprintf(out, out_len, "FD:%lus%s",
+                 (unsigned long)(stats.last_ms / 1000),
+                 stats.last_from_retained ? " R" : "");
+    }
+}
+
+static void render_debug_page(int64_t now_us)
 {
-    char line1[16];
-    char line2[16];
-    char line3[16];
+    char lines[OLED_DEBUG_LINE_COUNT][OLED_DEBUG_LINE_LEN + 1];
+    (void)now_us;
+    update_cached_web_health();
     char web_state = web_server_is_running() ? 'R' : 'S';
     char health[8] = "H:--";
     int ota_pct = web_server_get_ota_progress();
@@ -317,232 +443,484 @@ static void draw_debug_page(void)
         }
     }
 
-    snprintf(line1, sizeof(line1), "W:%c %s", web_state, health);
+    snprintf(lines[0], sizeof(lines[0]), "W:%c %s", web_state, health);
     if (web_server_is_ota_in_progress()) {
         if (ota_pct >= 0) {
-            snprintf(line2, sizeof(line2), "OTA:%d%%", ota_pct);
+            snprintf(lines[1], sizeof(lines[1]), "OTA:%d%%", ota_pct);
         } else {
-            snprintf(line2, sizeof(line2), "OTA:--");
+            snprintf(lines[1], sizeof(lines[1]), "OTA:--");
         }
     } else if (last_web_check_us == 0) {
-        snprintf(line2, sizeof(line2), "E:--");
+        snprintf(lines[1], sizeof(lines[1]), "E:--");
     } else if (last_web_err == ESP_OK) {
-        snprintf(line2, sizeof(line2), "E:OK");
+        snprintf(lines[1], sizeof(lines[1]), "E:OK");
     } else {
-        snprintf(line2, sizeof(line2), "E:%04X", (unsigned)last_web_err & 0xFFFF);
+        snprintf(lines[1], sizeof(lines[1]), "E:%04X", (unsigned)last_web_err & 0xFFFF);
     }
-    snprintf(line3, sizeof(line3), "AP:%c C:%d M:%c",
+    snprintf(lines[2], sizeof(lines[2]), "AP:%c C:%d M:%c",
              ap_get_health_code(),
              get_connected_client_count(),
              mqtt_telemetry_is_broker_connected() ? 'R' : 'S');
+    format_first_display(lines[3], sizeof(lines[3]));
 
-    u8g2_ClearBuffer(&u8g2);
-    u8g2_SetFont(&u8g2, u8g2_font_6x10_tr);
-    u8g2_DrawStr(&u8g2, CONTENT_X_OFFSET, CONTENT_Y_OFFSET + 14, line1);
-    u8g2_DrawStr(&u8g2, CONTENT_X_OFFSET, CONTENT_Y_OFFSET + 26, line2);
-    u8g2_DrawStr(&u8g2, CONTENT_X_OFFSET, CONTENT_Y_OFFSET + 38, line3);
-    u8g2_SendBuffer(&u8g2);
-}
-
-static unsigned append_credential_lines(
-    char lines[CREDENTIAL_LINE_COUNT][CREDENTIAL_LINE_CHARS + 1],
-    unsigned line_count, const char *label, const char *value)
-{
-    size_t value_len = strlen(value);
-    size_t value_pos = 0;
-    bool first_line = true;
-
-    while ((value_pos < value_len || first_line) &&
-           line_count < CREDENTIAL_LINE_COUNT) {
-        char *line = lines[line_count++];
-        size_t prefix_len = first_line ? strlen(label) : 0;
-        size_t available = CREDENTIAL_LINE_CHARS - prefix_len;
-        size_t remaining = value_len - value_pos;
-        size_t copy_len = remaining < available ? remaining : available;
-
-        if (first_line) {
-            memcpy(line, label, prefix_len);
-        }
-        memcpy(line + prefix_len, value + value_pos, copy_len);
-        line[prefix_len + copy_len] = 0;
-        value_pos += copy_len;
-        first_line = false;
-    }
-    return line_count;
+    oled_pages_draw_debug(&u8g2, (const char (*)[OLED_DEBUG_LINE_LEN + 1])lines);
 }
 
-static void draw_credentials_page(void)
+static void render_credentials_page(int64_t now_us)
 {
     char ssid[33];
     char password[65];
-    char lines[CREDENTIAL_LINE_COUNT][CREDENTIAL_LINE_CHARS + 1] = {0};
 
+    (void)now_us;
     ap_get_config_snapshot(ssid, sizeof(ssid), password, sizeof(password), NULL);
-    const char *display_password = password[0] ? password : "<OPEN>";
-    unsigned line_count = append_credential_lines(lines, 0, "S:", ssid);
-    line_count = append_credential_lines(lines, line_count, "P:",
-                                         display_password);
+    oled_pages_draw_credentials(&u8g2, ssid, password);
+}
 
-    u8g2_SetPowerSave(&u8g2, 0);
-    u8g2_SetContrast(&u8g2, CONTRAST);
-    u8g2_ClearBuffer(&u8g2);
-    u8g2_SetFont(&u8g2, u8g2_font_5x7_tr);
-    const char *heading = "WEB AUTH:OFF";
-    int heading_x = (OLED_WIDTH - u8g2_GetStrWidth(&u8g2, heading)) / 2;
-    u8g2_DrawStr(&u8g2, heading_x, 8, heading);
-
-    int first_baseline = 19 +
-        (int)(CREDENTIAL_LINE_COUNT - line_count) * 5;
-    for (unsigned i = 0; i < line_count; i++) {
-        int line_x = (OLED_WIDTH - u8g2_GetStrWidth(&u8g2, lines[i])) / 2;
-        u8g2_DrawStr(&u8g2, line_x, first_baseline + (int)i * 9, lines[i]);
+/* Next multiple of period_ms after now_us, so periodic redraws line up with
+ * the jitter windows below. */
+static int64_t next_boundary_us(int64_t now_us, int64_t period_ms)
+{
+    int64_t period_us = ms_to_us(period_ms);
+    return (now_us / period_us + 1) * period_us;
+}
+
+// Normale Anzeige mit gelegentlichem, kleinem Jitter: je 5 s pro Minute 1 px
+static int jitter_offset(int64_t now_us)
+{
+    int jitter_phase = (int)((now_us / 1000000) % 60);
+    if (jitter_phase < 5) return 1;
+    if (jitter_phase >= 30 && jitter_phase < 35) return -1;
+    return 0;
+}
+
+/* Solar power value with client count and WiFi signal strength. */
+static void render_power_page(int64_t now_us)
+{
+    mqtt_power_reading_t power;
+    mqtt_telemetry_get_power_reading(&power);
+
+    char label[16];
+    oled_pages_format_power_label(label, sizeof(label), power.stale,
+                                  power.age_s);
+    oled_power_page_t page = {
+        .label = label,
+        .value = power.value,
+        .clients = get_connected_client_count(),
+        .rssi = get_best_client_rssi(),
+        .marker = get_obk_connected_marker(),
+        .jitter_x = jitter_offset(now_us),
+    };
+    oled_pages_draw_power(&u8g2, &page);
+}
+
+/* Feed the current reading into the history; stale or unparsable values
+ * leave a gap in the graph. */
+static void record_power_sample(int64_t now_us)
+{
+    mqtt_power_reading_t power;
+    mqtt_telemetry_get_power_reading(&power);
+    char *end = NULL;
+    float watts = strtof(power.value, &end);
+    bool valid = !power.stale && end != power.value;
+    int32_t dw = 0;
+    if (valid) {
+        float scaled = watts * 10.0f;
+        if (scaled > (float)(INT32_MAX / 2)) scaled = (float)(INT32_MAX / 2);
+        if (scaled < (float)(INT32_MIN / 2)) scaled = (float)(INT32_MIN / 2);
+        dw = (int32_t)(scaled >= 0 ? scaled + 0.5f : scaled - 0.5f);
     }
-    u8g2_SendBuffer(&u8g2);
+    power_history_set(&history, now_us / 1000, valid, dw);
 }
 
-/**
- * @brief Renders OLED UI: solar power value with WiFi signal strength.
- */
+/* (Re)start the history when its span setting changed. */
+static void apply_history_span(int64_t now_us)
+{
+    portENTER_CRITICAL(&rotation_lock);
+    uint16_t minutes = history_minutes;
+    portEXIT_CRITICAL(&rotation_lock);
+    if (minutes == history_span_minutes) return;
+
+    history_span_minutes = minutes;
+    power_history_init(&history,
+                       (uint32_t)minutes * 60000u / POWER_HISTORY_COLUMNS,
+                       now_us / 1000);
+    record_power_sample(now_us);
+}
 
-static void handle_oled(void)
+/* Power over the configured span: one bar per column, newest at the right. */
+static void render_history_page(int64_t now_us)
 {
-    char power_copy[30];
-    mqtt_telemetry_get_power(power_copy, sizeof(power_copy));
-    float p = parse_power(power_copy);
+    uint8_t heights[POWER_HISTORY_COLUMNS];
+    power_history_summary_t summary;
+    char label[24];
+
+    power_history_advance(&history, now_us / 1000);
+    size_t count = power_history_heights(&history, heights);
+    power_history_get_summary(&history, &summary);
+    oled_pages_format_history_label(label, sizeof(label), summary.valid,
+                                    summary.min_dw, summary.max_dw,
+                                    summary.avg_dw);
+    oled_history_page_t page = {
+        .label = label,
+        .heights = heights,
+        .count = count,
+        .max_height = POWER_HISTORY_HEIGHT,
+        .jitter_x = jitter_offset(now_us),
+    };
+    oled_pages_draw_history(&u8g2, &page);
 
-    if (!web_server_is_auth_enabled()) {
-        screensaver = false;
-        idle_seconds = 0;
-        blank_seconds = 0;
-        draw_credentials_page();
-        return;
+    portENTER_CRITICAL(&frame_stats_lock);
+    frame_stats.history_columns = history.columns_closed;
+    frame_stats.history_rescales = history.rescales;
+    portEXIT_CRITICAL(&frame_stats_lock);
+}
+
+/* Link quality of one SoftAP station; the page steps to the next station at
+ * every RSSI refresh. */
+static void render_clients_page(int64_t now_us)
+{
+    char lines[OLED_DEBUG_LINE_COUNT][OLED_DEBUG_LINE_LEN + 1];
+    client_station_snapshot_t stations;
+    oled_client_page_t client = {0};
+
+    client_rssi_get_snapshot(&stations);
+    client.count = stations.count;
+    if (stations.count > 0) {
+        client.index = (uint8_t)((now_us / ms_to_us(CLIENT_RSSI_REFRESH_MS)) %
+                                 stations.count);
+        const client_station_t *sta = &stations.sta[client.index];
+        client.mac_tail[0] = sta->mac[4];
+        client.mac_tail[1] = sta->mac[5];
+        client.rssi_avg = sta->rssi_avg;
+        client.rssi_min = sta->rssi_min;
+        client.rssi_max = sta->rssi_max;
+        client.stddev_ddb = sta->rssi_stddev_ddb;
+        client.poor_crossings = sta->poor_crossings;
+        client.connected_s = (uint32_t)((now_us - sta->connected_us) / 1000000);
+    }
+    oled_pages_format_client(lines, &client);
+    oled_pages_draw_debug(&u8g2, (const char (*)[OLED_DEBUG_LINE_LEN + 1])lines);
+}
+
+static void render_blank_page(int64_t now_us)
+{
+    (void)now_us;
+    u8g2_ClearBuffer(&u8g2);
+}
+
+static const oled_page_t pages[OLED_PAGE_COUNT] = {
+    [OLED_PAGE_POWER] = {
+        .name = "power",
+        .deps = OLED_DEP_POWER | OLED_DEP_CLIENTS,
+        .refresh_ms = OLED_IDLE_REFRESH_MS,
+        .rotation_bit = OLED_ROTATE_POWER,
+        .render = render_power_page,
+    },
+    [OLED_PAGE_DEBUG] = {
+        .name = "debug",
+        .deps = OLED_DEP_POWER | OLED_DEP_CLIENTS | OLED_DEP_SETTINGS,
+        .refresh_ms = OLED_REFRESH_MS,
+        .rotation_bit = OLED_ROTATE_DEBUG,
+        .render = render_debug_page,
+    },
+    [OLED_PAGE_HISTORY] = {
+        .name = "history",
+        .deps = OLED_DEP_POWER,
+        .refresh_ms = OLED_IDLE_REFRESH_MS,
+        .rotation_bit = OLED_ROTATE_HISTORY,
+        .render = render_history_page,
+    },
+    [OLED_PAGE_CLIENTS] = {
+        .name = "clients",
+        .deps = OLED_DEP_CLIENTS,
+        .refresh_ms = CLIENT_RSSI_REFRESH_MS,
+        .rotation_bit = OLED_ROTATE_CLIENTS,
+        .render = render_clients_page,
+    },
+    [OLED_PAGE_CREDENTIALS] = {
+        .name = "credentials",
+        .deps = OLED_DEP_SETTINGS,
+        .refresh_ms = OLED_IDLE_REFRESH_MS,
+        .render = render_credentials_page,
+    },
+    [OLED_PAGE_SCREENSAVER] = {
+        .name = "screensaver",
+        .deps = OLED_DEP_POWER | OLED_DEP_CLIENTS,
+        .refresh_ms = OLED_REFRESH_MS,
+        .dim = true,
+        .render = render_screensaver_page,
+    },
+    [OLED_PAGE_BLANK] = {
+        .name = "blank",
+        .render = render_blank_page,
+    },
+};
+
+/* Next page of the configured rotation; lowers *switch_at_us to the time the
+ * rotation moves on. */
+static oled_page_id_t select_rotation_page(int64_t now_us,
+                                           int64_t *switch_at_us)
+{
+    oled_rotation_t current;
+    oled_get_rotation(&current);
+
+    oled_page_id_t ids[OLED_PAGE_COUNT];
+    int count = 0;
+    for (int i = 0; i < OLED_PAGE_COUNT; i++) {
+        if (pages[i].rotation_bit & current.pages) ids[count++] = i;
     }
+    if (count == 0) return OLED_PAGE_POWER;
+    if (count == 1 || current.interval_s == 0) return ids[0];
+
+    if (rotation_started_us == 0) rotation_started_us = now_us;
+    int64_t period_us = ms_to_us((int64_t)current.interval_s * 1000);
+    int64_t slot = (now_us - rotation_started_us) / period_us;
+    int64_t next_us = rotation_started_us + (slot + 1) * period_us;
+    if (next_us < *switch_at_us) *switch_at_us = next_us;
+    return ids[slot % count];
+}
+
+/*
+ * The page to show now, by priority: credentials while web auth is off, the
+ * debug page, a blank frame after settings changes, the screensaver after a
+ * minute without power, then the rotation. *switch_at_us is set to when the
+ * choice changes without any new event.
+ */
+static oled_page_id_t select_page(int64_t now_us, int64_t *switch_at_us)
+{
+    *switch_at_us = INT64_MAX;
 
-    if (debug_mode) {
+    if (!web_server_is_auth_enabled() || debug_mode) {
         screensaver = false;
-        idle_seconds = 0;
-        blank_seconds = 0;
-        draw_debug_page();
-        return;
+        idle_since_us = 0;
+        blank_until_us = 0;
+        rotation_started_us = 0;
+        return debug_mode && web_server_is_auth_enabled()
+            ? OLED_PAGE_DEBUG : OLED_PAGE_CREDENTIALS;
     }
 
-    if (blank_seconds > 0) {
-        blank_seconds--;
-        u8g2_SetPowerSave(&u8g2, 0);
-        u8g2_SetContrast(&u8g2, CONTRAST);
-        u8g2_ClearBuffer(&u8g2);
-        u8g2_SendBuffer(&u8g2);
-        return;
+    if (now_us < blank_until_us) {
+        *switch_at_us = blank_until_us;
+        rotation_started_us = 0;
+        return OLED_PAGE_BLANK;
     }
 
+    mqtt_power_reading_t power;
+    mqtt_telemetry_get_power_reading(&power);
+    /* A cached value must not keep the screensaver away forever. */
+    float p = power.stale ? 0.0f : parse_power(power.value);
     if (p <= 0.0001f) {
-        idle_seconds++;
+        if (idle_since_us == 0) idle_since_us = now_us;
     } else {
-        idle_seconds = 0;
-        if (screensaver) {
-            screensaver = false;
-            u8g2_SetPowerSave(&u8g2, 0);
-            u8g2_SetContrast(&u8g2, CONTRAST);
-        }
+        idle_since_us = 0;
+        screensaver = false;
     }
 
-    if (!screensaver && idle_seconds >= SCREENSAVER_DELAY) {
+    int64_t screensaver_at_us = idle_since_us == 0 ? INT64_MAX
+        : idle_since_us + ms_to_us((int64_t)SCREENSAVER_DELAY * 1000);
+    if (!screensaver && now_us >= screensaver_at_us) {
         screensaver = true;
-        // wähle Option: komplett aus ODER dim + animate
-        // Option komplett aus:
-        // u8g2_SetPowerSave(&u8g2, 1);
-        // Option dim + animate:
-        u8g2_SetPowerSave(&u8g2, 0);
-        u8g2_SetContrast(&u8g2, DIM_CONTRAST);
-        ss_init_bounds();
+        oled_pages_screensaver_reset(&ss);
     }
-
     if (screensaver) {
-        draw_screensaver(&u8g2);
-        return;
+        rotation_started_us = 0;
+        return OLED_PAGE_SCREENSAVER;
     }
 
-    // Normale Anzeige mit gelegentlichem, kleinem Jitter (alle Aufrufe cycles)
-    normal_jitter_phase = (normal_jitter_phase + 1) % 60; // z.B. 1 px Veränderung pro Minute
-    int xoff = CONTENT_X_OFFSET;
-    int yoff = CONTENT_Y_OFFSET;
-    if (normal_jitter_phase == 0) xoff += 1;
-    else if (normal_jitter_phase == 30) xoff -= 1;
+    *switch_at_us = screensaver_at_us;
+    return select_rotation_page(now_us, switch_at_us);
+}
 
-    u8g2_ClearBuffer(&u8g2);
-    u8g2_SetFont(&u8g2, u8g2_font_6x10_tr);
-    u8g2_DrawStr(&u8g2, xoff + 0, yoff + 14, "Power (W)");
-
-    u8g2_SetFont(&u8g2, u8g2_font_9x15_tr);
-    char buffer[32];
-    snprintf(buffer, sizeof(buffer), "%s", power_copy);
-    u8g2_DrawStr(&u8g2, xoff + 0, yoff + 32, buffer);
-
-    u8g2_SetFont(&u8g2, u8g2_font_6x10_tr);
-    
-    /* Display client count with WiFi signal strength indicator */
-    int client_count = get_connected_client_count();
-    int8_t client_rssi = get_best_client_rssi();
-    
-    /* Draw client count number */
-    char count_str[4];
-    snprintf(count_str, sizeof(count_str), "%d", client_count);
-    u8g2_DrawStr(&u8g2, xoff + 0, yoff + 44, count_str);
-    
-    /* MQTT/OBK state: X=broker unavailable, +=online, -=offline. */
-    char marker = get_obk_connected_marker();
-    if (marker) {
-        char marker_str[2] = {marker, 0};
-        u8g2_DrawStr(&u8g2, xoff + 12, yoff + 44, marker_str);
-    } else if (client_count > 0) {
-        draw_signal_bar(&u8g2, xoff + 12, yoff + 38, client_rssi);
+/* Page on the panel, OLED_PAGE_COUNT when none (start-up, display off). */
+static oled_page_id_t current_page = OLED_PAGE_COUNT;
+/* When the current page is due for its periodic refresh. */
+static int64_t page_due_us = 0;
+/* Earliest start of the next frame, from OLED_MIN_FRAME_MS and the budget. */
+static int64_t next_frame_allowed_us = 0;
+
+static void render_page(oled_page_id_t id, int64_t now_us)
+{
+    const oled_page_t *page = &pages[id];
+    if (id != current_page) {
+        // wähle Option: komplett aus ODER dim + animate
+        // Option komplett aus:
+        // u8g2_SetPowerSave(&u8g2, 1);
+        // Option dim + animate:
+        u8g2_SetPowerSave(&u8g2, 0);
+        u8g2_SetContrast(&u8g2, page->dim ? DIM_CONTRAST : CONTRAST);
+        current_page = id;
     }
 
-    u8g2_SendBuffer(&u8g2);
+    int64_t started = esp_timer_get_time();
+    page->render(now_us);
+    int64_t rendered = esp_timer_get_time();
+    send_frame();
+    uint32_t render_us = (uint32_t)(rendered - started);
+    uint32_t frame_us = (uint32_t)(esp_timer_get_time() - started);
+
+    int64_t gap_us = ms_to_us(OLED_MIN_FRAME_MS);
+    bool over_budget = frame_us > OLED_FRAME_BUDGET_US;
+    if (over_budget) gap_us = gap_us * frame_us / OLED_FRAME_BUDGET_US;
+    next_frame_allowed_us = now_us + gap_us;
+    /* Periodic redraws line up with the jitter windows of the power page. */
+    page_due_us = page->refresh_ms
+        ? next_boundary_us(now_us, page->refresh_ms) : INT64_MAX;
+
+    portENTER_CRITICAL(&frame_stats_lock);
+    frame_stats.render_us += render_us;
+    if (over_budget) frame_stats.over_budget_frames++;
+    frame_stats.page = page->name;
+    portEXIT_CRITICAL(&frame_stats_lock);
 }
 
 /**
- * @brief Task that periodically refreshes the OLED display.
+ * @brief Task that refreshes the OLED display.
+ *
+ * Sleeps until a button, telemetry, client or settings event arrives or the
+ * current page is due for its periodic redraw. Events mark page inputs as
+ * changed; the page is redrawn only if it depends on one of them, and never
+ * sooner than the frame budget allows.
  */
+static esp_err_t restart_oled_task(void);
+
 static void oled_task(void *arg)
 {
     (void)arg;
-    int tick = 0;
+    int watch_id = watchdog_register("oled_task", OLED_HEARTBEAT_MS,
+                                     restart_oled_task);
     bool display_was_enabled = oled_is_enabled();
+    uint32_t changed = 0;
+    int64_t switch_at_us = 0;
+    bool render_blocked = false;
+    apply_history_span(esp_timer_get_time());
     while (1) {
-        poll_debug_button();
-        process_requested_debug_toggle();
+        watchdog_checkin(watch_id);
+        int64_t now = esp_timer_get_time();
+        int64_t deadline = INT64_MAX;
+        if (display_was_enabled) {
+            deadline = render_blocked ? next_frame_allowed_us
+                     : page_due_us < switch_at_us ? page_due_us : switch_at_us;
+        }
+        if (button_long_press_at_us != 0 && button_long_press_at_us < deadline) {
+            deadline = button_long_press_at_us;
+        }
+        int64_t wait_ms = OLED_HEARTBEAT_MS;
+        if (deadline != INT64_MAX) {
+            int64_t due_ms = deadline > now ? (deadline - now + 999) / 1000 : 0;
+            if (due_ms < wait_ms) wait_ms = due_ms;
+        }
+        TickType_t wait = pdMS_TO_TICKS(wait_ms);
+
+        uint32_t events = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &events, wait);
+        now = esp_timer_get_time();
+        portENTER_CRITICAL(&frame_stats_lock);
+        frame_stats.task_wakeups++;
+        portEXIT_CRITICAL(&frame_stats_lock);
+
+        if (check_long_press(now)) changed |= OLED_DEP_SETTINGS;
+        if (events & OLED_EVT_BUTTON) {
+            handle_button_level(gpio_get_level(OLED_DEBUG_BUTTON), now);
+            changed |= OLED_DEP_SETTINGS;
+        }
+        if (events & OLED_EVT_TOGGLE) {
+            process_requested_debug_toggle();
+            changed |= OLED_DEP_SETTINGS;
+        }
+        if (events & OLED_EVT_POWER) {
+            record_power_sample(now);
+            changed |= OLED_DEP_POWER;
+        }
+        if (events & OLED_EVT_CLIENTS) changed |= OLED_DEP_CLIENTS;
+        if (events & OLED_EVT_SETTINGS) {
+            /* A new rotation starts from its first page. */
+            rotation_started_us = 0;
+            apply_history_span(now);
+            changed |= OLED_DEP_SETTINGS;
+        }
+        if (events & OLED_EVT_BLANK) {
+            screensaver = false;
+            idle_since_us = 0;
+            blank_until_us = now + ms_to_us(2 * OLED_REFRESH_MS);
+            changed |= OLED_DEP_SETTINGS;
+        }
+
         bool enabled = oled_is_enabled();
         if (!enabled) {
             if (display_was_enabled) {
                 u8g2_ClearBuffer(&u8g2);
-                u8g2_SendBuffer(&u8g2);
+                send_frame();
                 u8g2_SetPowerSave(&u8g2, 1);
                 display_was_enabled = false;
+                current_page = OLED_PAGE_COUNT;
             }
-        } else {
-            if (!display_was_enabled) {
-                screensaver = false;
-                idle_seconds = 0;
-                blank_seconds = 0;
-                u8g2_SetPowerSave(&u8g2, 0);
-                u8g2_SetContrast(&u8g2, CONTRAST);
-                display_was_enabled = true;
+            changed = 0;
+            render_blocked = false;
+            continue;
+        }
+        if (!display_was_enabled) {
+            screensaver = false;
+            idle_since_us = 0;
+            blank_until_us = 0;
+            display_was_enabled = true;
+            next_frame_allowed_us = 0;
+        }
+
+        oled_page_id_t id = select_page(now, &switch_at_us);
+        bool due = id != current_page || now >= page_due_us ||
+                   (changed & pages[id].deps);
+        if (!due) {
+            /* Inputs of pages not on screen changed; nothing to draw. */
+            if (changed) {
+                portENTER_CRITICAL(&frame_stats_lock);
+                frame_stats.skipped_renders++;
+                portEXIT_CRITICAL(&frame_stats_lock);
             }
-            update_cached_web_health();
+            changed = 0;
+            continue;
         }
-        if (enabled && (tick % 20) == 0) {
-            handle_oled();
+        if (now < next_frame_allowed_us) {
+            /* Keep the changes; the wait above ends when a frame is allowed. */
+            render_blocked = true;
+            continue;
         }
-        tick = (tick + 1) % 1000;
-        vTaskDelay(pdMS_TO_TICKS(50));
+        render_page(id, now);
+        changed = 0;
+        render_blocked = false;
+    }
+}
+
+/* Called by the watchdog when oled_task stopped checking in. The pages take
+ * the AP config lock for their snapshots, and a task stuck in an I2C
+ * transfer leaves the bus driver mid-transaction; in both cases the task is
+ * not replaced and the watchdog resets the chip instead. */
+static esp_err_t restart_oled_task(void)
+{
+    TaskHandle_t stuck = oled_task_handle;
+    if (i2c_in_transfer || ap_config_held_by(stuck)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    oled_task_handle = NULL;
+    if (stuck) vTaskDelete(stuck);
+    /* Panel state is unknown after a stall; resend the whole frame. */
+    frame_shadow_valid = false;
+    current_page = OLED_PAGE_COUNT;
+    if (xTaskCreate(oled_task, "oled_task", 4096, NULL, 5,
+                    &oled_task_handle) != pdPASS) {
+        oled_task_handle = NULL;
+        return ESP_ERR_NO_MEM;
     }
+    return ESP_OK;
 }
 
 esp_err_t oled_start(void)
 {
     load_display_setting();
-    oled_button_init();
+    esp_err_t err = oled_button_init();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "BOOT button setup failed: %s", esp_err_to_name(err));
+        return err;
+    }
     u8g2_esp32_hal_t hal = U8G2_ESP32_HAL_DEFAULT;
     hal.bus.i2c.sda = OLED_SDA;
     hal.bus.i2c.scl = OLED_SCL;
@@ -554,31 +932,94 @@ esp_err_t oled_start(void)
     u8g2_Setup_ssd1306_i2c_128x64_noname_f(
         &u8g2,
         U8G2_R0,
-        u8g2_esp32_i2c_byte_cb,
+        oled_i2c_byte_cb,
         u8g2_esp32_gpio_and_delay_cb
     );
 
     u8g2_SetI2CAddress(&u8g2, I2C_ADDR_8BIT);
     u8g2_InitDisplay(&u8g2);
+    /* Panel RAM is undefined after init; the first frame is sent in full. */
+    frame_shadow_valid = false;
     u8g2_SetPowerSave(&u8g2, oled_is_enabled() ? 0 : 1);
     if (oled_is_enabled()) u8g2_SetContrast(&u8g2, CONTRAST);
 
     ESP_LOGI(TAG, "OLED init OK. Display %dx%d, content offset (%d,%d)",
-             OLED_WIDTH, OLED_HEIGHT, CONTENT_X_OFFSET, CONTENT_Y_OFFSET);
+             OLED_WIDTH, OLED_HEIGHT, OLED_CONTENT_X_OFFSET,
+             OLED_CONTENT_Y_OFFSET);
 
-    if (xTaskCreate(oled_task, "oled_task", 4096, NULL, 5, NULL) != pdPASS) {
+    if (xTaskCreate(oled_task, "oled_task", 4096, NULL, 5,
+                    &oled_task_handle) != pdPASS) {
         ESP_LOGE(TAG, "Failed to create OLED task");
         return ESP_ERR_NO_MEM;
     }
+    mqtt_telemetry_set_update_callback(on_telemetry_update);
+    esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_AP_STACONNECTED,
+                               on_wifi_client_event, NULL);
+    esp_event_handler_register(WIFI_EVENT, WIFI_EVENT_AP_STADISCONNECTED,
+                               on_wifi_client_event, NULL);
+    return ESP_OK;
+}
+
+void oled_get_rotation(oled_rotation_t *out)
+{
+    portENTER_CRITICAL(&rotation_lock);
+    *out = rotation;
+    portEXIT_CRITICAL(&rotation_lock);
+}
+
+esp_err_t oled_set_rotation(const oled_rotation_t *new_rotation)
+{
+    if (!new_rotation || !rotation_valid(new_rotation)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    config_display_t stored;
+    config_store_get_display(&stored);
+    stored.rotate_pages = new_rotation->pages;
+    stored.rotate_s = new_rotation->interval_s;
+    esp_err_t err = config_store_set_display(&stored);
+    if (err != ESP_OK) return err;
+
+    portENTER_CRITICAL(&rotation_lock);
+    rotation = *new_rotation;
+    portEXIT_CRITICAL(&rotation_lock);
+    notify_oled_task(OLED_EVT_SETTINGS);
+    return ESP_OK;
+}
+
+uint16_t oled_get_history_minutes(void)
+{
+    portENTER_CRITICAL(&rotation_lock);
+    uint16_t minutes = history_minutes;
+    portEXIT_CRITICAL(&rotation_lock);
+    return minutes;
+}
+
+esp_err_t oled_set_history_minutes(uint16_t minutes)
+{
+    if (minutes < OLED_HISTORY_MIN_MINUTES ||
+        minutes > OLED_HISTORY_MAX_MINUTES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (minutes == oled_get_history_minutes()) return ESP_OK;
+
+    config_display_t stored;
+    config_store_get_display(&stored);
+    stored.history_minutes = minutes;
+    esp_err_t err = config_store_set_display(&stored);
+    if (err != ESP_OK) return err;
+
+    portENTER_CRITICAL(&rotation_lock);
+    history_minutes = minutes;
+    portEXIT_CRITICAL(&rotation_lock);
+    notify_oled_task(OLED_EVT_SETTINGS);
     return ESP_OK;
 }
 
+/* The screensaver state belongs to oled_task; it applies the request. */
 void oled_blank_and_reset_screensaver(void)
 {
-    screensaver = false;
-    idle_seconds = 0;
-    normal_jitter_phase = 0;
-    blank_seconds = 2;
+    notify_oled_task(OLED_EVT_SETTINGS | OLED_EVT_BLANK);
 }
 
 void oled_request_debug_toggle(void)
@@ -586,6 +1027,15 @@ void oled_request_debug_toggle(void)
     portENTER_CRITICAL(&debug_toggle_lock);
     debug_toggle_requested = true;
     portEXIT_CRITICAL(&debug_toggle_lock);
+    notify_oled_task(OLED_EVT_TOGGLE);
+}
+
+void oled_get_frame_stats(oled_frame_stats_t *out)
+{
+    if (!out) return;
+    portENTER_CRITICAL(&frame_stats_lock);
+    *out = frame_stats;
+    portEXIT_CRITICAL(&frame_stats_lock);
 }
 
 bool oled_is_enabled(void)
@@ -599,16 +1049,15 @@ bool oled_is_enabled(void)
 
 esp_err_t oled_set_enabled(bool enabled)
 {
-    nvs_handle_t nvs;
-    esp_err_t err = nvs_open(OLED_NVS_NAMESPACE, NVS_READWRITE, &nvs);
-    if (err != ESP_OK) return err;
-    err = nvs_set_u8(nvs, OLED_NVS_ENABLED_KEY, enabled ? 1 : 0);
-    if (err == ESP_OK) err = nvs_commit(nvs);
-    nvs_close(nvs);
+    config_display_t stored;
+    config_store_get_display(&stored);
+    stored.enabled = enabled ? 1 : 0;
+    esp_err_t err = config_store_set_display(&stored);
     if (err != ESP_OK) return err;
 
     portENTER_CRITICAL(&display_enabled_lock);
     display_enabled = enabled;
     portEXIT_CRITICAL(&display_enabled_lock);
+    notify_oled_task(OLED_EVT_SETTINGS);
     return ESP_OK;
 }
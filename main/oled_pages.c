@@ -0,0 +1,317 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * OLED page renderers, free of ESP-IDF dependencies.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "oled_pages.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "digit_atlas.h"
+
+void oled_pages_format_power_label(char *out, size_t out_len, bool stale,
+                                   int32_t age_s)
+{
+    if (!stale) {
+        snprintf(out, out_len, "Power (W)");
+    } else if (age_s < 0) {
+        snprintf(out, out_len, "Old (W) ?");
+    } else if (age_s < 60) {
+        snprintf(out, out_len, "Old (W) %lds", (long)age_s);
+    } else if (age_s < 3600) {
+        snprintf(out, out_len, "Old (W) %ldm", (long)(age_s / 60));
+    } else {
+        snprintf(out, out_len, "Old (W) %ldh", (long)(age_s / 3600));
+    }
+}
+
+void oled_pages_draw_signal_bar(u8g2_t *u8g2, int x, int y, int8_t rssi)
+{
+    enum {
+        BAR_W = 58,
+        BAR_H = 6,
+        RSSI_MIN_DBM = -100,
+        RSSI_MAX_DBM = -45,
+    };
+
+    u8g2_DrawFrame(u8g2, x, y, BAR_W, BAR_H);
+
+    if (rssi == INT8_MIN) {
+        return;
+    }
+
+    if (rssi < RSSI_MIN_DBM) {
+        rssi = RSSI_MIN_DBM;
+    } else if (rssi > RSSI_MAX_DBM) {
+        rssi = RSSI_MAX_DBM;
+    }
+
+    uint8_t fill_w = 1 + (uint16_t)(rssi - RSSI_MIN_DBM) * (BAR_W - 3) /
+                         (RSSI_MAX_DBM - RSSI_MIN_DBM);
+
+    u8g2_DrawBox(u8g2, x + 1, y + 1, fill_w, BAR_H - 2);
+}
+
+static const digit_atlas_glyph_t *atlas_glyph(char ch)
+{
+    if (ch < DIGIT_ATLAS_FIRST || ch > DIGIT_ATLAS_LAST) return NULL;
+    uint8_t index = digit_atlas_index[ch - DIGIT_ATLAS_FIRST];
+    return index == DIGIT_ATLAS_NONE ? NULL : &digit_atlas_glyphs[index];
+}
+
+int oled_pages_big_value_width(const char *value)
+{
+    int width = 0;
+    for (const char *p = value; *p; p++) {
+        const digit_atlas_glyph_t *glyph = atlas_glyph(*p);
+        if (!glyph) return -1;
+        width += glyph->width + (p[1] ? DIGIT_ATLAS_SPACING : 0);
+    }
+    return width;
+}
+
+bool oled_pages_draw_big_value(u8g2_t *u8g2, int x, int y, const char *value)
+{
+    if (oled_pages_big_value_width(value) < 0) return false;
+
+    /* Full-buffer layout as in oled_tiles.h: page-major, one byte per column
+     * and 8-pixel page, LSB on top. */
+    uint8_t *buf = u8g2_GetBufferPtr(u8g2);
+    int width = u8g2_GetBufferTileWidth(u8g2) * 8;
+    int pages = u8g2_GetBufferTileHeight(u8g2);
+    int shift = ((y % 8) + 8) % 8;
+    int first_page = (y - shift) / 8;
+
+    for (const char *p = value; *p; p++) {
+        const digit_atlas_glyph_t *glyph = atlas_glyph(*p);
+        const uint8_t *bits = &digit_atlas_bits[glyph->offset];
+        for (int col = 0; col < glyph->width; col++, x++) {
+            if (x < 0 || x >= width) continue;
+            uint32_t column = 0;
+            for (int i = 0; i < DIGIT_ATLAS_PAGES; i++) {
+                column |= (uint32_t)bits[col * DIGIT_ATLAS_PAGES + i] << (8 * i);
+            }
+            column <<= shift;
+            for (int i = 0; i <= DIGIT_ATLAS_PAGES; i++) {
+                int page = first_page + i;
+                if (page >= 0 && page < pages) {
+                    buf[page * width + x] |= (uint8_t)(column >> (8 * i));
+                }
+            }
+        }
+        x += DIGIT_ATLAS_SPACING;
+    }
+    return true;
+}
+
+void oled_pages_draw_power(u8g2_t *u8g2, const oled_power_page_t *page)
+{
+    int xoff = OLED_CONTENT_X_OFFSET + page->jitter_x;
+    int yoff = OLED_CONTENT_Y_OFFSET;
+
+    u8g2_ClearBuffer(u8g2);
+    u8g2_SetFont(u8g2, u8g2_font_6x10_tr);
+    u8g2_DrawStr(u8g2, xoff + 0, yoff + 14, page->label);
+
+    /* Values the atlas cannot show, such as "N/A", or that would run past
+     * the visible area, such as "-1234.5", use the 9x15 font. */
+    int big_width = oled_pages_big_value_width(page->value);
+    if (big_width < 0 || page->jitter_x + big_width > OLED_CONTENT_WIDTH ||
+        !oled_pages_draw_big_value(u8g2, xoff + 0, yoff + 16, page->value)) {
+        u8g2_SetFont(u8g2, u8g2_font_9x15_tr);
+        u8g2_DrawStr(u8g2, xoff + 0, yoff + 32, page->value);
+    }
+
+    u8g2_SetFont(u8g2, u8g2_font_6x10_tr);
+
+    /* Client count, then the connection marker or the RSSI bar. */
+    char count_str[4];
+    snprintf(count_str, sizeof(count_str), "%d", page->clients);
+    u8g2_DrawStr(u8g2, xoff + 0, yoff + 44, count_str);
+
+    /* MQTT/OBK state: X=broker unavailable, +=online, -=offline. */
+    if (page->marker) {
+        char marker_str[2] = {page->marker, 0};
+        u8g2_DrawStr(u8g2, xoff + 12, yoff + 44, marker_str);
+    } else if (page->clients > 0) {
+        oled_pages_draw_signal_bar(u8g2, xoff + 12, yoff + 38, page->rssi);
+    }
+}
+
+/* Deciwatts to whole watts, rounded half away from zero. */
+static long dw_to_w(int32_t dw)
+{
+    return dw >= 0 ? (long)((dw + 5) / 10) : -(long)((-(int64_t)dw + 5) / 10);
+}
+
+void oled_pages_format_history_label(char *out, size_t out_len, bool valid,
+                                     int32_t min_dw, int32_t max_dw,
+                                     int32_t avg_dw)
+{
+    if (!valid) {
+        snprintf(out, out_len, "No data");
+        return;
+    }
+    snprintf(out, out_len, "H%ld A%ld L%ld", dw_to_w(max_dw), dw_to_w(avg_dw),
+             dw_to_w(min_dw));
+}
+
+void oled_pages_draw_history(u8g2_t *u8g2, const oled_history_page_t *page)
+{
+    /* One pixel of margin on each side leaves room for the jitter. */
+    int xoff = OLED_CONTENT_X_OFFSET + page->jitter_x;
+    int yoff = OLED_CONTENT_Y_OFFSET;
+    int bottom = yoff + 39;
+    int right = xoff + OLED_CONTENT_WIDTH - 1;
+
+    u8g2_ClearBuffer(u8g2);
+    u8g2_SetFont(u8g2, u8g2_font_4x6_tr);
+    u8g2_DrawStr(u8g2, xoff + 1, yoff + 6, page->label);
+
+    /* The newest column is at the right edge; each one is a single line. */
+    for (size_t i = 0; i < page->count; i++) {
+        uint8_t h = page->heights[i];
+        if (h == 0) continue;
+        if (h > page->max_height) h = page->max_height;
+        int x = right - (int)(page->count - i);
+        u8g2_DrawVLine(u8g2, x, bottom - h + 1, h);
+    }
+}
+
+void oled_pages_format_client(char lines[OLED_DEBUG_LINE_COUNT]
+                                        [OLED_DEBUG_LINE_LEN + 1],
+                              const oled_client_page_t *client)
+{
+    const size_t len = OLED_DEBUG_LINE_LEN + 1;
+    for (int i = 0; i < OLED_DEBUG_LINE_COUNT; i++) lines[i][0] = 0;
+
+    if (client->count == 0) {
+        snprintf(lines[0], len, "No clients");
+        return;
+    }
+    snprintf(lines[0], len, "%u/%u ..%02X:%02X", client->index + 1u,
+             client->count, client->mac_tail[0], client->mac_tail[1]);
+    if (client->rssi_avg == INT8_MIN) {
+        snprintf(lines[1], len, "RSSI --");
+        return;
+    }
+    snprintf(lines[1], len, "%ddBm ~%u.%u", client->rssi_avg,
+             client->stddev_ddb / 10, client->stddev_ddb % 10);
+    snprintf(lines[2], len, "%d..%d P%u", client->rssi_min, client->rssi_max,
+             client->poor_crossings > 99 ? 99u : client->poor_crossings);
+
+    uint32_t s = client->connected_s;
+    if (s < 3600) {
+        snprintf(lines[3], len, "Up %lum%02lus", (unsigned long)(s / 60),
+                 (unsigned long)(s % 60));
+    } else if (s < 86400) {
+        snprintf(lines[3], len, "Up %luh%02lum", (unsigned long)(s / 3600),
+                 (unsigned long)(s / 60 % 60));
+    } else {
+        snprintf(lines[3], len, "Up %lud%02luh", (unsigned long)(s / 86400),
+                 (unsigned long)(s / 3600 % 24));
+    }
+}
+
+void oled_pages_draw_debug(u8g2_t *u8g2,
+                           const char lines[OLED_DEBUG_LINE_COUNT]
+                                           [OLED_DEBUG_LINE_LEN + 1])
+{
+    u8g2_ClearBuffer(u8g2);
+    u8g2_SetFont(u8g2, u8g2_font_6x10_tr);
+    for (int i = 0; i < OLED_DEBUG_LINE_COUNT; i++) {
+        u8g2_DrawStr(u8g2, OLED_CONTENT_X_OFFSET,
+                     OLED_CONTENT_Y_OFFSET + 9 + i * 10, lines[i]);
+    }
+}
+
+static unsigned append_credential_lines(
+    char lines[OLED_CREDENTIAL_LINE_COUNT][OLED_CREDENTIAL_LINE_CHARS + 1],
+    unsigned line_count, const char *label, const char *value)
+{
+    size_t value_len = strlen(value);
+    size_t value_pos = 0;
+    bool first_line = true;
+
+    while ((value_pos < value_len || first_line) &&
+           line_count < OLED_CREDENTIAL_LINE_COUNT) {
+        char *line = lines[line_count++];
+        size_t prefix_len = first_line ? strlen(label) : 0;
+        size_t available = OLED_CREDENTIAL_LINE_CHARS - prefix_len;
+        size_t remaining = value_len - value_pos;
+        size_t copy_len = remaining < available ? remaining : available;
+
+        if (first_line) {
+            memcpy(line, label, prefix_len);
+        }
+        memcpy(line + prefix_len, value + value_pos, copy_len);
+        line[prefix_len + copy_len] = 0;
+        value_pos += copy_len;
+        first_line = false;
+    }
+    return line_count;
+}
+
+void oled_pages_draw_credentials(u8g2_t *u8g2, const char *ssid,
+                                 const char *password)
+{
+    char lines[OLED_CREDENTIAL_LINE_COUNT][OLED_CREDENTIAL_LINE_CHARS + 1] = {0};
+    const char *display_password = password[0] ? password : "<OPEN>";
+    unsigned line_count = append_credential_lines(lines, 0, "S:", ssid);
+    line_count = append_credential_lines(lines, line_count, "P:",
+                                         display_password);
+
+    u8g2_ClearBuffer(u8g2);
+    u8g2_SetFont(u8g2, u8g2_font_5x7_tr);
+    const char *heading = "WEB AUTH:OFF";
+    int heading_x = (OLED_WIDTH - u8g2_GetStrWidth(u8g2, heading)) / 2;
+    u8g2_DrawStr(u8g2, heading_x, 8, heading);
+
+    int first_baseline = 19 +
+        (int)(OLED_CREDENTIAL_LINE_COUNT - line_count) * 5;
+    for (unsigned i = 0; i < line_count; i++) {
+        int line_x = (OLED_WIDTH - u8g2_GetStrWidth(u8g2, lines[i])) / 2;
+        u8g2_DrawStr(u8g2, line_x, first_baseline + (int)i * 9, lines[i]);
+    }
+}
+
+void oled_pages_screensaver_reset(oled_screensaver_t *ss)
+{
+    ss->x = OLED_WIDTH / 2;
+    ss->y = OLED_HEIGHT / 2;
+    ss->dx = 1;
+    ss->dy = 1;
+}
+
+void oled_pages_draw_screensaver(u8g2_t *u8g2, oled_screensaver_t *ss,
+                                 const char *text)
+{
+    u8g2_SetFont(u8g2, u8g2_font_6x10_tr);
+    int text_w = u8g2_GetStrWidth(u8g2, text);
+    int text_h = 10; // baseline height for 6x10 font
+
+    int min_x = 1;
+    int min_y = text_h + 1;
+    int max_x = OLED_WIDTH - text_w - 1;
+    int max_y = OLED_HEIGHT - 1;
+    if (max_x < min_x) {
+        min_x = max_x = 1;
+    }
+    if (max_y < min_y) {
+        min_y = max_y = text_h + 1;
+    }
+
+    ss->x += ss->dx;
+    ss->y += ss->dy;
+    if (ss->x < min_x) { ss->x = min_x; ss->dx = -ss->dx; }
+    if (ss->x > max_x) { ss->x = max_x; ss->dx = -ss->dx; }
+    if (ss->y < min_y) { ss->y = min_y; ss->dy = -ss->dy; }
+    if (ss->y > max_y) { ss->y = max_y; ss->dy = -ss->dy; }
+
+    u8g2_ClearBuffer(u8g2);
+    u8g2_DrawStr(u8g2, ss->x, ss->y, text);
+}
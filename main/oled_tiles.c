@@ -0,0 +1,68 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Dirty-tile diff for incremental OLED updates.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "oled_tiles.h"
+
+#include <string.h>
+
+static void send_run(const uint8_t *frame, uint8_t *shadow, size_t page_offset,
+                     uint8_t start, uint8_t end, uint8_t ty,
+                     oled_tiles_send_fn send, void *ctx,
+                     oled_tiles_result_t *result)
+{
+    size_t offset = page_offset + (size_t)start * OLED_TILE_BYTES;
+    size_t len = (size_t)(end - start) * OLED_TILE_BYTES;
+    send(ctx, start, ty, (uint8_t)(end - start));
+    memcpy(shadow + offset, frame + offset, len);
+    result->tiles += (uint16_t)(end - start);
+    result->runs++;
+}
+
+oled_tiles_result_t oled_tiles_flush(const uint8_t *frame, uint8_t *shadow,
+                                     uint8_t tile_cols, uint8_t tile_rows,
+                                     bool full, oled_tiles_send_fn send,
+                                     void *ctx)
+{
+    oled_tiles_result_t result = {0};
+    if (!frame || !shadow || !send) return result;
+    size_t page_len = (size_t)tile_cols * OLED_TILE_BYTES;
+
+    for (uint8_t ty = 0; ty < tile_rows; ty++) {
+        size_t page_offset = (size_t)ty * page_len;
+        if (full) {
+            send_run(frame, shadow, page_offset, 0, tile_cols, ty, send, ctx,
+                     &result);
+            continue;
+        }
+        if (memcmp(frame + page_offset, shadow + page_offset, page_len) == 0) {
+            continue;
+        }
+        /* [run_start, run_end) is the pending run; run_end is one past its
+         * last dirty tile. */
+        int run_start = -1;
+        int run_end = 0;
+        for (uint8_t tx = 0; tx < tile_cols; tx++) {
+            size_t offset = page_offset + (size_t)tx * OLED_TILE_BYTES;
+            if (memcmp(frame + offset, shadow + offset, OLED_TILE_BYTES) == 0) {
+                continue;
+            }
+            if (run_start >= 0 && tx - run_end > OLED_TILES_MERGE_GAP) {
+                send_run(frame, shadow, page_offset, (uint8_t)run_start,
+                         (uint8_t)run_end, ty, send, ctx, &result);
+                run_start = -1;
+            }
+            if (run_start < 0) run_start = tx;
+            run_end = tx + 1;
+        }
+        if (run_start >= 0) {
+            send_run(frame, shadow, page_offset, (uint8_t)run_start,
+                     (uint8_t)run_end, ty, send, ctx, &result);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,201 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Power history for the OLED graph page.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "power_history.h"
+
+#include <string.h>
+
+/* Smallest 1/2/5 x 10^n deciwatts that is at least value (minimum 1 W). */
+static int32_t nice_ceil(int32_t value)
+{
+    int32_t decade = 10;
+    while (1) {
+        if (value <= decade) return decade;
+        if (value <= 2 * decade) return 2 * decade;
+        if (value <= 5 * decade) return 5 * decade;
+        if (decade > INT32_MAX / 100) return INT32_MAX;
+        decade *= 10;
+    }
+}
+
+static uint8_t height_for(const power_history_t *h, int32_t value_dw)
+{
+    if (value_dw <= h->scale_lo_dw) return 1;
+    if (value_dw >= h->scale_hi_dw) return POWER_HISTORY_HEIGHT;
+    int64_t offset = (int64_t)value_dw - h->scale_lo_dw;
+    return (uint8_t)(1 + ((offset * h->scale_q24) >> 24));
+}
+
+static void set_scale(power_history_t *h, int32_t lo_dw, int32_t hi_dw)
+{
+    h->scale_lo_dw = lo_dw;
+    h->scale_hi_dw = hi_dw;
+    h->scale_q24 = (uint32_t)(((uint64_t)(POWER_HISTORY_HEIGHT - 1) << 24) /
+                              (uint64_t)((int64_t)hi_dw - lo_dw));
+}
+
+static power_history_column_t *column_at(power_history_t *h, size_t i)
+{
+    return &h->columns[(h->head + i) % POWER_HISTORY_COLUMNS];
+}
+
+/* Pick the scale for the closed columns; recompute every height only if it
+ * differs from the current one. */
+static void update_scale(power_history_t *h)
+{
+    power_history_summary_t s;
+    power_history_get_summary(h, &s);
+    if (!s.valid) return;
+
+    bool fits = s.min_dw >= h->scale_lo_dw && s.max_dw <= h->scale_hi_dw;
+    bool too_coarse =
+        (h->scale_hi_dw > 10 && s.max_dw < h->scale_hi_dw / 4) ||
+        (h->scale_lo_dw < 0 && s.min_dw > h->scale_lo_dw / 4);
+    if (fits && !too_coarse) return;
+
+    int32_t lo = s.min_dw >= 0 ? 0 : -nice_ceil(-s.min_dw);
+    int32_t hi = s.max_dw <= 0 ? 10 : nice_ceil(s.max_dw);
+    if (lo == h->scale_lo_dw && hi == h->scale_hi_dw) return;
+    set_scale(h, lo, hi);
+    for (size_t i = 0; i < h->count; i++) {
+        power_history_column_t *c = column_at(h, i);
+        c->height = c->valid ? height_for(h, c->avg_dw) : POWER_HISTORY_NO_DATA;
+    }
+    h->rescales++;
+}
+
+static void reset_open(power_history_t *h)
+{
+    h->open_sum = 0;
+    h->open_weight_ms = 0;
+    h->open_min_dw = INT32_MAX;
+    h->open_max_dw = INT32_MIN;
+}
+
+static void close_column(power_history_t *h)
+{
+    power_history_column_t c = {0};
+    if (h->open_weight_ms > 0) {
+        c.valid = true;
+        c.avg_dw = (int32_t)(h->open_sum / h->open_weight_ms);
+        c.min_dw = h->open_min_dw;
+        c.max_dw = h->open_max_dw;
+    }
+
+    if (h->count == POWER_HISTORY_COLUMNS) {
+        h->head = (uint8_t)((h->head + 1) % POWER_HISTORY_COLUMNS);
+        h->count--;
+    }
+    c.height = c.valid ? height_for(h, c.avg_dw) : POWER_HISTORY_NO_DATA;
+    *column_at(h, h->count) = c;
+    h->count++;
+    h->columns_closed++;
+    h->column_start_ms += h->column_ms;
+    reset_open(h);
+
+    /* Only the new column is scaled, unless the scale has to change. */
+    update_scale(h);
+}
+
+void power_history_init(power_history_t *h, uint32_t column_ms, int64_t now_ms)
+{
+    memset(h, 0, sizeof(*h));
+    h->column_ms = column_ms ? column_ms : 1;
+    h->column_start_ms = now_ms;
+    h->hold_since_ms = now_ms;
+    reset_open(h);
+    set_scale(h, 0, 10);
+}
+
+void power_history_advance(power_history_t *h, int64_t now_ms)
+{
+    /* After a long gap only the last window matters. */
+    int64_t behind = (now_ms - h->column_start_ms) / h->column_ms;
+    if (behind > POWER_HISTORY_COLUMNS) {
+        h->column_start_ms += (behind - POWER_HISTORY_COLUMNS) * h->column_ms;
+        if (h->hold_since_ms < h->column_start_ms) {
+            h->hold_since_ms = h->column_start_ms;
+        }
+    }
+
+    while (1) {
+        int64_t column_end = h->column_start_ms + h->column_ms;
+        int64_t until = now_ms < column_end ? now_ms : column_end;
+        if (until > h->hold_since_ms) {
+            if (h->hold_valid) {
+                int64_t duration = until - h->hold_since_ms;
+                h->open_sum += (int64_t)h->hold_dw * duration;
+                h->open_weight_ms += duration;
+                if (h->hold_dw < h->open_min_dw) h->open_min_dw = h->hold_dw;
+                if (h->hold_dw > h->open_max_dw) h->open_max_dw = h->hold_dw;
+            }
+            h->hold_since_ms = until;
+        }
+        if (now_ms < column_end) break;
+        close_column(h);
+    }
+}
+
+void power_history_set(power_history_t *h, int64_t now_ms, bool valid,
+                       int32_t value_dw)
+{
+    power_history_advance(h, now_ms);
+    h->hold_valid = valid;
+    h->hold_dw = value_dw;
+    h->hold_since_ms = now_ms;
+}
+
+size_t power_history_heights(const power_history_t *h,
+                             uint8_t out[POWER_HISTORY_COLUMNS])
+{
+    size_t n = 0;
+    /* The open column takes the last slot, dropping the oldest closed one. */
+    size_t skip = h->count == POWER_HISTORY_COLUMNS ? 1 : 0;
+    for (size_t i = skip; i < h->count; i++) {
+        out[n++] = h->columns[(h->head + i) % POWER_HISTORY_COLUMNS].height;
+    }
+    if (h->open_weight_ms > 0) {
+        out[n++] = height_for(h, (int32_t)(h->open_sum / h->open_weight_ms));
+    } else {
+        out[n++] = h->hold_valid ? height_for(h, h->hold_dw)
+                                 : POWER_HISTORY_NO_DATA;
+    }
+    return n;
+}
+
+void power_history_get_summary(const power_history_t *h,
+                               power_history_summary_t *out)
+{
+    int64_t sum = 0;
+    int32_t n = 0;
+    out->min_dw = INT32_MAX;
+    out->max_dw = INT32_MIN;
+    /* Same window as power_history_heights(). */
+    size_t skip = h->count == POWER_HISTORY_COLUMNS ? 1 : 0;
+    for (size_t i = skip; i < h->count; i++) {
+        const power_history_column_t *c =
+            &h->columns[(h->head + i) % POWER_HISTORY_COLUMNS];
+        if (!c->valid) continue;
+        if (c->min_dw < out->min_dw) out->min_dw = c->min_dw;
+        if (c->max_dw > out->max_dw) out->max_dw = c->max_dw;
+        sum += c->avg_dw;
+        n++;
+    }
+    if (h->open_weight_ms > 0) {
+        if (h->open_min_dw < out->min_dw) out->min_dw = h->open_min_dw;
+        if (h->open_max_dw > out->max_dw) out->max_dw = h->open_max_dw;
+        sum += h->open_sum / h->open_weight_ms;
+        n++;
+    }
+    out->valid = n > 0;
+    out->avg_dw = n > 0 ? (int32_t)(sum / n) : 0;
+    if (!out->valid) {
+        out->min_dw = 0;
+        out->max_dw = 0;
+    }
+}
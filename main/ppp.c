@@ -8,6 +8,9 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 #include "ppp.h"
+#include "client_traffic.h"
+#include "boot_init.h"
+#include "watchdog.h"
 
 #include <string.h>
 
@@ -37,18 +40,22 @@ static const char *TAG = "ppp";
 /* PPP state */
 static ppp_pcb *ppp = NULL;
 static struct netif ppp_netif;
+static TaskHandle_t s_rx_task;
 
 static EventGroupHandle_t s_event_group;
 #define PPP_CONNECTED_BIT BIT0
 #define PPP_DISCONN_BIT   BIT1
 #define PPP_RECONNECT_DELAY_MS 2000
 #define PPP_USB_POLL_MS 250
+/* The RX loop passes at least every PPP_USB_POLL_MS; allow for a busy CPU. */
+#define PPP_RX_HEARTBEAT_MS 1000
 #define PPP_USB_TX_WAIT_MS 10
 
 static bool s_ppp_up = false;
 static ip4_addr_t s_ppp_ip = {0};
 static ip4_addr_t s_ppp_gw = {0};
 static ip4_addr_t s_ppp_nm = {0};
+static ppp_stats_t s_ppp_stats;
 static portMUX_TYPE s_ppp_state_lock = portMUX_INITIALIZER_UNLOCKED;
 
 static void set_ppp_state(bool up, const ip4_addr_t *ip,
@@ -59,9 +66,12 @@ static void set_ppp_state(bool up, const ip4_addr_t *ip,
     s_ppp_ip.addr = ip ? ip->addr : 0;
     s_ppp_gw.addr = gw ? gw->addr : 0;
     s_ppp_nm.addr = nm ? nm->addr : 0;
+    if (up) s_ppp_stats.link_up_count++;
     portEXIT_CRITICAL(&s_ppp_state_lock);
 }
 
+static esp_err_t restart_rx_task(void);
+
 /**
  * @brief PPP RX task: reads bytes from USB Serial/JTAG and feeds to PPP stack.
  */
@@ -69,8 +79,11 @@ static void ppp_usb_rx_task(void *arg)
 {
     (void)arg;
     uint8_t buf[256];
+    int watch_id = watchdog_register("ppp_usb_rx", PPP_RX_HEARTBEAT_MS,
+                                     restart_rx_task);
 
     while (1) {
+        watchdog_checkin(watch_id);
         if (!usb_serial_jtag_is_connected()) {
             vTaskDelay(pdMS_TO_TICKS(PPP_USB_POLL_MS));
             continue;
@@ -79,11 +92,31 @@ static void ppp_usb_rx_task(void *arg)
         int n = usb_serial_jtag_read_bytes(buf, sizeof(buf), pdMS_TO_TICKS(100));
         if (n > 0 && ppp) {
             pppos_input_tcpip(ppp, buf, n);
+            portENTER_CRITICAL(&s_ppp_state_lock);
+            s_ppp_stats.rx_bytes += (uint64_t)n;
+            portEXIT_CRITICAL(&s_ppp_state_lock);
         }
         vTaskDelay(pdMS_TO_TICKS(10));
     }
 }
 
+/**
+ * @brief Replace an RX task that stopped checking in. Runs on the watchdog
+ * task; the RX task holds no locks, and the PPP session stays up.
+ */
+static esp_err_t restart_rx_task(void)
+{
+    TaskHandle_t stuck = s_rx_task;
+    s_rx_task = NULL;
+    if (stuck) vTaskDelete(stuck);
+    if (xTaskCreate(ppp_usb_rx_task, "ppp_usb_rx", 4096, NULL, 10,
+                    &s_rx_task) != pdPASS) {
+        s_rx_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
 /**
  * @brief PPP Output callback: Called by lwIP when PPP needs to transmit data.
  */
@@ -102,6 +135,9 @@ static u32_t ppp_output_cb(ppp_pcb *pcb, const void *data, u32_t len, void *ctx)
                  (unsigned long)len);
         return 0;
     }
+    portENTER_CRITICAL(&s_ppp_state_lock);
+    s_ppp_stats.tx_bytes += (uint64_t)written;
+    portEXIT_CRITICAL(&s_ppp_state_lock);
     return (u32_t)written;
 }
 
@@ -117,6 +153,7 @@ static void ppp_status_cb(ppp_pcb *pcb, int err_code, void *ctx)
     switch (err_code) {
         case PPPERR_NONE: {
             ESP_LOGI(TAG, "PPP connected");
+            boot_init_milestone(BOOT_MILESTONE_PPP_UP);
             ip4_addr_t ip = pcb->netif->ip_addr.u_addr.ip4;
             ip4_addr_t gw = pcb->netif->gw.u_addr.ip4;
             ip4_addr_t nm = pcb->netif->netmask.u_addr.ip4;
@@ -223,6 +260,9 @@ esp_err_t ppp_usb_start(void)
     ppp_recv_config(ppp, PPP_MRU_MTU, 0xFFFFFFFF, 0, 0);
     ppp->netif->mtu = PPP_MRU_MTU;
 
+    /* Count each SoftAP client's share of the uplink */
+    client_traffic_attach_uplink(ppp->netif);
+
     /* No authentication; peer provides DNS */
     ppp_set_auth(ppp, PPPAUTHTYPE_NONE, NULL, NULL);
     ppp_set_usepeerdns(ppp, true);
@@ -230,7 +270,8 @@ esp_err_t ppp_usb_start(void)
     /* Make PPP default route in lwIP */
     pppapi_set_default(ppp);
 
-    if (xTaskCreate(ppp_usb_rx_task, "ppp_usb_rx", 4096, NULL, 10, NULL) != pdPASS ||
+    if (xTaskCreate(ppp_usb_rx_task, "ppp_usb_rx", 4096, NULL, 10,
+                    &s_rx_task) != pdPASS ||
         xTaskCreate(ppp_reconnect_task, "ppp_reconn", 4096, NULL, 9, NULL) != pdPASS) {
         return ESP_ERR_NO_MEM;
     }
@@ -265,3 +306,11 @@ ip4_addr_t ppp_get_ip(void)
     portEXIT_CRITICAL(&s_ppp_state_lock);
     return ip;
 }
+
+void ppp_get_stats(ppp_stats_t *out)
+{
+    if (!out) return;
+    portENTER_CRITICAL(&s_ppp_state_lock);
+    *out = s_ppp_stats;
+    portEXIT_CRITICAL(&s_ppp_state_lock);
+}
@@ -4,7 +4,7 @@
  * App glue / startup file after modular refactor.
  *
  * Keeps:
- *  - NVS storage for AP creds
+ *  - Persistent AP settings (config_store "ap" section)
  *  - WiFi SoftAP setup + static IP config
  *  - Exposed AP interface for web server
  *  - Starts modules (PPP, web server, MQTT telemetry, OLED)
@@ -27,25 +27,29 @@
 #include "esp_netif.h"
 #include "esp_system.h"
 #include "nvs_flash.h"
-#include "nvs.h"
 
 #include "esp_wifi.h"
 #include "esp_mac.h"
 #include "lwip/ip4_addr.h"
 
 #include "ap_config.h"
+#include "config_store.h"
 #include "ppp.h"
 #include "web_server.h"
 #include "mqtt_telemetry.h"
+#include "local_broker.h"
 #include "oled.h"
 #include "watchdog.h"
 #include "client_rssi.h"
+#include "client_traffic.h"
+#include "tx_power.h"
+#include "channel_select.h"
+#include "scan_trace.h"
+#include "wifi_survey.h"
+#include "jobs.h"
+#include "boot_init.h"
 
 /* ------------------------- AP defaults ------------------------- */
-#define DEFAULT_AP_SSID     "ESP32C3-PPP-AP"
-#define DEFAULT_AP_PASS     "12345678"
-#define DEFAULT_AP_CHANNEL  11
-#define DEFAULT_CHANNEL_AUTO true
 #define AP_MAX_CONN         4
 #define AP_MIN_CHANNEL      1
 #define AP_MAX_CHANNEL      11
@@ -53,32 +57,31 @@
 #define AP_COUNTRY_SCHAN    1
 #define AP_COUNTRY_NCHAN    11
 #define AP_MAX_TX_POWER_QDBM 80
+#define AP_MIN_TX_POWER_QDBM 40 /* 10 dBm floor for the adaptive controller */
 #define AUTO_SCAN_INTERVAL_US (6LL * 60LL * 60LL * 1000000LL)
 #define AUTO_SCAN_IDLE_US     (5LL * 60LL * 1000000LL)
 #define AUTO_INITIAL_SCAN_IDLE_US (60LL * 1000000LL)
 #define AUTO_SCAN_POLL_MS     (60 * 1000)
+#define AP_BEACON_INTERVAL_TU 100
+#define AP_CSA_COUNT          5   /* beacons announcing a channel switch */
+#define SWITCH_OUTAGE_TIMEOUT_MS 30000
+#define SWITCH_OUTAGE_POLL_MS    100
 
 #define AP_IP_ADDR     "192.168.4.1"
 #define AP_GATEWAY     "192.168.4.1"
 #define AP_NETMASK     "255.255.255.0"
 
-/* NVS keys/namespace */
-#define NVS_NS   "apcfg"
-#define NVS_KEY_SSID "ssid"
-#define NVS_KEY_PASS "pass"
-#define NVS_KEY_CHANNEL "channel"
-#define NVS_KEY_CHANNEL_AUTO "auto_chan"
-#define NVS_KEY_LAST_AUTO_CHANNEL "last_auto"
 
 /* ------------------------- module state ------------------------- */
 static const char *TAG = "ppp_usb_ap_web";
 
-static char g_ap_ssid[33] = DEFAULT_AP_SSID;
-static char g_ap_pass[65] = DEFAULT_AP_PASS;
-static uint8_t g_ap_channel = DEFAULT_AP_CHANNEL;
-static uint8_t g_manual_channel = DEFAULT_AP_CHANNEL;
-static uint8_t g_last_auto_channel = DEFAULT_AP_CHANNEL;
-static bool g_channel_auto = DEFAULT_CHANNEL_AUTO;
+static char g_ap_ssid[33] = AP_DEFAULT_SSID;
+static char g_ap_pass[65] = AP_DEFAULT_PASS;
+static uint8_t g_ap_channel = AP_DEFAULT_CHANNEL;
+static uint8_t g_manual_channel = AP_DEFAULT_CHANNEL;
+static uint8_t g_last_auto_channel = AP_DEFAULT_CHANNEL;
+static bool g_channel_auto = AP_DEFAULT_CHANNEL_AUTO;
+static uint8_t g_busy_switch_limit = AP_DEFAULT_BUSY_SWITCHES_PER_DAY;
 static bool g_scan_in_progress = false;
 static esp_err_t g_last_scan_result = ESP_ERR_INVALID_STATE;
 static int64_t g_last_scan_time_us = 0;
@@ -87,67 +90,53 @@ static esp_netif_t *ap_netif = NULL;
 static esp_netif_t *sta_netif = NULL;
 static bool ap_started = false;
 static SemaphoreHandle_t ap_config_mutex = NULL;
+static TaskHandle_t channel_rescan_handle = NULL;
+static TaskHandle_t tx_power_task_handle = NULL;
 static portMUX_TYPE ap_state_lock = portMUX_INITIALIZER_UNLOCKED;
-
-static esp_err_t save_ap_config_to_nvs(const char *ssid, const char *pass,
-                                       bool channel_auto,
-                                       uint8_t manual_channel,
-                                       uint8_t active_channel);
+/* Held across the controller update and the driver call, so a join forcing
+ * full power cannot be overwritten by a step computed just before it. */
+static SemaphoreHandle_t tx_power_mutex = NULL;
+static tx_power_ctrl_t g_tx_power;
+static scan_trace_t g_scan_trace;
+static portMUX_TYPE scan_trace_lock = portMUX_INITIALIZER_UNLOCKED;
+/* Under ap_state_lock: times of the last busy switches, and outage stats. */
+static int64_t g_busy_switch_us[AP_MAX_BUSY_SWITCHES_PER_DAY];
+static uint8_t g_busy_switch_head = 0;
+static ap_channel_switch_stats_t g_switch_stats;
+static ap_reconfig_stats_t g_reconfig_stats;
+
+static esp_err_t save_ap_config(const char *ssid, const char *pass,
+                                bool channel_auto, uint8_t manual_channel,
+                                uint8_t active_channel,
+                                uint8_t busy_switch_limit);
 
 static uint8_t sanitize_ap_channel(uint8_t channel)
 {
     if (channel < AP_MIN_CHANNEL || channel > AP_MAX_CHANNEL) {
-        return DEFAULT_AP_CHANNEL;
+        return AP_DEFAULT_CHANNEL;
     }
     return channel;
 }
 
 /* =========================================================================
- * NVS Flash Storage - Load & Save AP config
+ * Persistent AP config (config_store "ap" section)
  * ========================================================================= */
 
-static void load_ap_config_from_nvs(void)
+static void load_ap_config(void)
 {
-    nvs_handle_t nvs;
-    esp_err_t err = nvs_open(NVS_NS, NVS_READONLY, &nvs);
-    if (err != ESP_OK) {
-        ESP_LOGW(TAG, "No NVS namespace yet, using defaults");
-        return;
-    }
-
-    size_t ssid_len = sizeof(g_ap_ssid);
-    size_t pass_len = sizeof(g_ap_pass);
-
-    err = nvs_get_str(nvs, NVS_KEY_SSID, g_ap_ssid, &ssid_len);
-    if (err != ESP_OK) {
-        strncpy(g_ap_ssid, DEFAULT_AP_SSID, sizeof(g_ap_ssid));
-    }
-
-    err = nvs_get_str(nvs, NVS_KEY_PASS, g_ap_pass, &pass_len);
-    if (err != ESP_OK) {
-        strncpy(g_ap_pass, DEFAULT_AP_PASS, sizeof(g_ap_pass));
-    }
-
-    uint8_t channel = DEFAULT_AP_CHANNEL;
-    err = nvs_get_u8(nvs, NVS_KEY_CHANNEL, &channel);
-    if (err == ESP_OK) {
-        g_manual_channel = sanitize_ap_channel(channel);
-    }
-
-    uint8_t channel_auto = DEFAULT_CHANNEL_AUTO ? 1 : 0;
-    if (nvs_get_u8(nvs, NVS_KEY_CHANNEL_AUTO, &channel_auto) == ESP_OK) {
-        g_channel_auto = channel_auto != 0;
-    }
-
-    uint8_t last_auto_channel = DEFAULT_AP_CHANNEL;
-    if (nvs_get_u8(nvs, NVS_KEY_LAST_AUTO_CHANNEL,
-                   &last_auto_channel) == ESP_OK) {
-        last_auto_channel = sanitize_ap_channel(last_auto_channel);
-    }
-    g_last_auto_channel = last_auto_channel;
+    config_ap_t ap;
+    config_store_get_ap(&ap);
+
+    strlcpy(g_ap_ssid, ap.ssid, sizeof(g_ap_ssid));
+    if (!g_ap_ssid[0]) strlcpy(g_ap_ssid, AP_DEFAULT_SSID, sizeof(g_ap_ssid));
+    strlcpy(g_ap_pass, ap.pass, sizeof(g_ap_pass));
+    g_manual_channel = sanitize_ap_channel(ap.manual_channel);
+    g_channel_auto = ap.channel_auto != 0;
+    g_last_auto_channel = sanitize_ap_channel(ap.last_auto_channel);
     g_ap_channel = g_channel_auto ? g_last_auto_channel : g_manual_channel;
-
-    nvs_close(nvs);
+    if (ap.busy_switch_limit <= AP_MAX_BUSY_SWITCHES_PER_DAY) {
+        g_busy_switch_limit = ap.busy_switch_limit;
+    }
 
     ESP_LOGI(TAG, "Loaded AP config: SSID='%s' PASS len=%d mode=%s CH=%u manual=%u",
              g_ap_ssid, (int)strlen(g_ap_pass),
@@ -155,104 +144,142 @@ static void load_ap_config_from_nvs(void)
              g_manual_channel);
 }
 
-static esp_err_t save_ap_config_to_nvs(const char *ssid, const char *pass,
-                                       bool channel_auto,
-                                       uint8_t manual_channel,
-                                       uint8_t active_channel)
+static esp_err_t save_ap_config(const char *ssid, const char *pass,
+                                bool channel_auto, uint8_t manual_channel,
+                                uint8_t active_channel,
+                                uint8_t busy_switch_limit)
 {
-    nvs_handle_t nvs;
-    manual_channel = sanitize_ap_channel(manual_channel);
+    config_ap_t ap;
+    config_store_get_ap(&ap);
     active_channel = sanitize_ap_channel(active_channel);
-    esp_err_t err = nvs_open(NVS_NS, NVS_READWRITE, &nvs);
-    if (err != ESP_OK) return err;
-
-    err = nvs_set_str(nvs, NVS_KEY_SSID, ssid);
-    if (err != ESP_OK) { nvs_close(nvs); return err; }
-
-    err = nvs_set_str(nvs, NVS_KEY_PASS, pass);
-    if (err != ESP_OK) { nvs_close(nvs); return err; }
-
-    err = nvs_set_u8(nvs, NVS_KEY_CHANNEL, manual_channel);
-    if (err != ESP_OK) { nvs_close(nvs); return err; }
-
-    err = nvs_set_u8(nvs, NVS_KEY_CHANNEL_AUTO, channel_auto ? 1 : 0);
-    if (err != ESP_OK) { nvs_close(nvs); return err; }
-
-    err = nvs_set_u8(nvs, NVS_KEY_LAST_AUTO_CHANNEL,
-                     channel_auto ? active_channel : g_last_auto_channel);
-    if (err != ESP_OK) { nvs_close(nvs); return err; }
-
-    err = nvs_commit(nvs);
-    nvs_close(nvs);
+    strlcpy(ap.ssid, ssid, sizeof(ap.ssid));
+    strlcpy(ap.pass, pass, sizeof(ap.pass));
+    ap.manual_channel = sanitize_ap_channel(manual_channel);
+    ap.channel_auto = channel_auto ? 1 : 0;
+    ap.last_auto_channel = channel_auto ? active_channel : g_last_auto_channel;
+    ap.busy_switch_limit = busy_switch_limit;
+
+    esp_err_t err = config_store_set_ap(&ap);
     if (err == ESP_OK && channel_auto) {
         g_last_auto_channel = active_channel;
     }
     return err;
 }
 
-static uint32_t rssi_weight(int8_t rssi)
+/* The last automatic channel only picks the start channel of the next
+ * boot, so a switch is written lazily rather than on every change. */
+static esp_err_t save_last_auto_channel(uint8_t channel)
 {
-    if (rssi >= -50) return 100;
-    if (rssi >= -60) return 50;
-    if (rssi >= -70) return 20;
-    if (rssi >= -80) return 5;
-    return 1;
+    config_ap_t ap;
+    config_store_get_ap(&ap);
+    ap.last_auto_channel = sanitize_ap_channel(channel);
+    esp_err_t err = config_store_set_ap_lazy(&ap);
+    if (err == ESP_OK) g_last_auto_channel = ap.last_auto_channel;
+    return err;
 }
 
-static uint32_t overlap_weight(uint8_t candidate, uint8_t primary)
+static uint8_t choose_best_channel(const channel_select_ap_t *aps,
+                                   size_t count, bool use_hysteresis)
 {
-    unsigned distance = candidate > primary ? candidate - primary
-                                             : primary - candidate;
-    static const uint8_t overlap[] = {100, 75, 50, 25, 10};
-    return distance < sizeof(overlap) ? overlap[distance] : 0;
+    uint32_t scores[CHANNEL_SELECT_CANDIDATES];
+    uint8_t best = channel_select_choose(
+        aps, count, g_ap_channel,
+        use_hysteresis ? CHANNEL_SELECT_HYSTERESIS_PCT : 0, scores);
+
+    ESP_LOGI(TAG, "Channel scores: 1=%lu 6=%lu 11=%lu; selected %u",
+             (unsigned long)scores[0], (unsigned long)scores[1],
+             (unsigned long)scores[2], best);
+    return best;
 }
 
-static uint8_t choose_best_channel(const wifi_ap_record_t *records,
-                                   uint16_t record_count,
-                                   bool use_hysteresis)
+static uint8_t choose_channel_by_airtime(const channel_select_ap_t *aps,
+                                         size_t count,
+                                         const uint16_t *airtime,
+                                         bool use_hysteresis)
 {
-    static const uint8_t candidates[] = {1, 6, 11};
-    uint32_t scores[sizeof(candidates)] = {0};
-
-    for (uint16_t i = 0; i < record_count; i++) {
-        if (records[i].primary < AP_MIN_CHANNEL ||
-            records[i].primary > AP_MAX_CHANNEL) {
-            continue;
-        }
-        uint32_t signal = rssi_weight(records[i].rssi);
-        for (size_t c = 0; c < sizeof(candidates); c++) {
-            scores[c] += signal * overlap_weight(candidates[c],
-                                                  records[i].primary);
-        }
+    uint32_t scores[CHANNEL_SELECT_CHANNELS];
+    uint8_t best = channel_select_choose_airtime(
+        aps, count, airtime, g_ap_channel,
+        use_hysteresis ? CHANNEL_SELECT_HYSTERESIS_PCT : 0, scores);
+
+    char line[CHANNEL_SELECT_CHANNELS * 12];
+    size_t used = 0;
+    for (size_t c = 0; c < CHANNEL_SELECT_CHANNELS && used < sizeof(line); c++) {
+        used += (size_t)snprintf(line + used, sizeof(line) - used, " %u=%lu",
+                                 (unsigned)(c + 1), (unsigned long)scores[c]);
     }
+    ESP_LOGI(TAG, "Airtime scores:%s; selected %u", line, best);
+    return best;
+}
 
-    size_t best = 0;
-    for (size_t c = 1; c < sizeof(candidates); c++) {
-        if (scores[c] < scores[best] ||
-            (scores[c] == scores[best] && candidates[c] == g_ap_channel)) {
-            best = c;
-        }
+/* Picks a channel from the background survey without scanning. Returns
+ * ESP_ERR_INVALID_STATE until the survey has visited every channel.
+ * Caller serializes this with ap_config_mutex. */
+static esp_err_t select_channel_from_survey(bool use_hysteresis)
+{
+    survey_table_t *survey = malloc(sizeof(*survey));
+    channel_select_ap_t *aps = malloc(SURVEY_MAX_APS * sizeof(*aps));
+    if (!survey || !aps) {
+        free(survey);
+        free(aps);
+        return ESP_ERR_NO_MEM;
     }
-
-    if (use_hysteresis) {
-        for (size_t c = 0; c < sizeof(candidates); c++) {
-            if (candidates[c] != g_ap_channel) continue;
-            /* Require a score at least 25 percent better before disrupting AP. */
-            if (scores[c] == 0 || scores[best] * 4U > scores[c] * 3U) {
-                best = c;
-            }
-            break;
+    wifi_survey_get(survey);
+    esp_err_t err = ESP_ERR_INVALID_STATE;
+    if (survey_table_complete(survey)) {
+        size_t count = survey_table_export(survey, aps, SURVEY_MAX_APS);
+        uint16_t airtime[SURVEY_CHANNELS];
+        /* Until every channel has an airtime window, beacons decide. */
+        if (wifi_survey_get_airtime_enabled() &&
+            survey_table_airtime(survey, airtime)) {
+            g_ap_channel = choose_channel_by_airtime(aps, count, airtime,
+                                                     use_hysteresis);
+        } else {
+            g_ap_channel = choose_best_channel(aps, count, use_hysteresis);
         }
+        g_last_scan_result = ESP_OK;
+        g_last_scan_time_us = esp_timer_get_time();
+        err = ESP_OK;
     }
+    free(survey);
+    free(aps);
+    return err;
+}
 
-    ESP_LOGI(TAG, "Channel scores: 1=%lu 6=%lu 11=%lu; selected %u",
-             (unsigned long)scores[0], (unsigned long)scores[1],
-             (unsigned long)scores[2], candidates[best]);
-    return candidates[best];
+/* Keeps the scan for /debug/scans; the ring is copied out under the lock. */
+static void record_scan(const wifi_ap_record_t *records, uint16_t count,
+                        uint8_t ap_channel)
+{
+    scan_trace_scan_t *scan = malloc(sizeof(*scan));
+    if (!scan) return;
+    scan_trace_scan_init(scan, (uint32_t)(esp_timer_get_time() / 1000000),
+                         ap_channel);
+    survey_table_t *survey = malloc(sizeof(*survey));
+    if (survey) {
+        wifi_survey_get(survey);
+        uint16_t airtime[SURVEY_CHANNELS];
+        survey_table_airtime(survey, airtime);
+        memcpy(scan->airtime_permille, airtime, sizeof(airtime));
+        free(survey);
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        scan_trace_ap_t ap = {
+            .primary = records[i].primary,
+            .second = (uint8_t)records[i].second,
+            .rssi = records[i].rssi,
+        };
+        memcpy(ap.bssid, records[i].bssid, sizeof(ap.bssid));
+        scan_trace_scan_add(scan, &ap);
+    }
+    portENTER_CRITICAL(&scan_trace_lock);
+    scan_trace_push(&g_scan_trace, scan);
+    portEXIT_CRITICAL(&scan_trace_lock);
+    free(scan);
 }
 
-/* Caller serializes this with ap_config_mutex. Wi-Fi must already be started. */
-static esp_err_t scan_and_select_channel(bool use_hysteresis)
+/* Caller serializes this with ap_config_mutex. Wi-Fi must already be started.
+ * With select false the scan is only recorded and the channel is kept. */
+static esp_err_t scan_and_select_channel(bool select, bool use_hysteresis)
 {
     uint8_t original_channel = g_ap_channel;
     if (!sta_netif) {
@@ -260,9 +287,14 @@ static esp_err_t scan_and_select_channel(bool use_hysteresis)
         g_last_scan_time_us = esp_timer_get_time();
         return g_last_scan_result;
     }
+    /* Waits for at most one survey dwell. */
+    wifi_survey_take_scanner(portMAX_DELAY);
     wifi_mode_t original_mode;
     esp_err_t err = esp_wifi_get_mode(&original_mode);
-    if (err != ESP_OK) return err;
+    if (err != ESP_OK) {
+        wifi_survey_give_scanner();
+        return err;
+    }
 
     g_scan_in_progress = true;
     wifi_mode_t scan_mode = original_mode == WIFI_MODE_AP
@@ -282,23 +314,36 @@ static esp_err_t scan_and_select_channel(bool use_hysteresis)
     if (err != ESP_OK) goto clear_scan;
 
     wifi_ap_record_t *records = NULL;
+    channel_select_ap_t *aps = NULL;
+    uint16_t fetched = 0;
     if (ap_count > 0) {
         records = calloc(ap_count, sizeof(*records));
-        if (!records) {
+        aps = calloc(ap_count, sizeof(*aps));
+        if (!records || !aps) {
+            free(records);
+            free(aps);
             err = ESP_ERR_NO_MEM;
             goto clear_scan;
         }
-        uint16_t fetched = ap_count;
+        fetched = ap_count;
         err = esp_wifi_scan_get_ap_records(&fetched, records);
-        if (err == ESP_OK) {
-            g_ap_channel = choose_best_channel(records, fetched,
-                                                use_hysteresis);
+        if (err != ESP_OK) fetched = 0;
+        for (uint16_t i = 0; i < fetched; i++) {
+            aps[i] = (channel_select_ap_t) {
+                .primary = records[i].primary,
+                .rssi = records[i].rssi,
+            };
         }
-        free(records);
-    } else {
+    }
+    if (err == ESP_OK) {
+        record_scan(records, fetched, g_ap_channel);
         /* With no visible APs, keep an already non-overlapping channel. */
-        g_ap_channel = choose_best_channel(NULL, 0, use_hysteresis);
+        if (select) {
+            g_ap_channel = choose_best_channel(aps, fetched, use_hysteresis);
+        }
     }
+    free(records);
+    free(aps);
     goto restore_mode;
 
 clear_scan:
@@ -309,14 +354,18 @@ restore_mode:
         if (err == ESP_OK) err = restore_err;
     }
 done:
+    wifi_survey_give_scanner();
     if (err != ESP_OK) {
         g_ap_channel = original_channel;
     }
-    g_last_scan_result = err;
-    g_last_scan_time_us = esp_timer_get_time();
+    /* A recording-only scan does not count as a selection. */
+    if (select) {
+        g_last_scan_result = err;
+        g_last_scan_time_us = esp_timer_get_time();
+    }
     g_scan_in_progress = false;
     if (err != ESP_OK) {
-        ESP_LOGW(TAG, "Automatic channel scan failed: %s",
+        ESP_LOGW(TAG, "Channel scan failed: %s",
                  esp_err_to_name(err));
     }
     return err;
@@ -345,7 +394,89 @@ static esp_err_t apply_softap_runtime_settings(void)
     if (err != ESP_OK) {
         return err;
     }
-    return esp_wifi_set_max_tx_power(AP_MAX_TX_POWER_QDBM);
+
+    /* A restarted AP starts at full power; the controller lowers it again
+     * once the clients are back and measured. */
+    xSemaphoreTake(tx_power_mutex, portMAX_DELAY);
+    tx_power_force_full(&g_tx_power, esp_timer_get_time() / 1000);
+    err = esp_wifi_set_max_tx_power(AP_MAX_TX_POWER_QDBM);
+    xSemaphoreGive(tx_power_mutex);
+    return err;
+}
+
+/* =========================================================================
+ * Adaptive TX power
+ * ========================================================================= */
+
+/* Runs on the TX power task, woken by WIFI_EVENT_AP_STACONNECTED. */
+static void tx_power_raise_for_join(void)
+{
+    xSemaphoreTake(tx_power_mutex, portMAX_DELAY);
+    int8_t before = g_tx_power.power_qdbm;
+    if (tx_power_force_full(&g_tx_power, esp_timer_get_time() / 1000) ==
+        TX_POWER_FULL) {
+        esp_err_t err = esp_wifi_set_max_tx_power(AP_MAX_TX_POWER_QDBM);
+        ESP_LOGI(TAG, "TX power %d.%02d -> %d dBm for joining station: %s",
+                 before / 4, (before % 4) * 25, AP_MAX_TX_POWER_QDBM / 4,
+                 esp_err_to_name(err));
+    }
+    xSemaphoreGive(tx_power_mutex);
+}
+
+static void tx_power_task(void *arg)
+{
+    (void)arg;
+    const TickType_t period = pdMS_TO_TICKS(CLIENT_RSSI_REFRESH_MS);
+    TickType_t last_update = xTaskGetTickCount();
+    for (;;) {
+        TickType_t elapsed = xTaskGetTickCount() - last_update;
+        if (ulTaskNotifyTake(pdTRUE, elapsed < period ? period - elapsed : 0)) {
+            tx_power_raise_for_join();
+            continue;
+        }
+        last_update = xTaskGetTickCount();
+        if (!ap_is_running()) {
+            continue;
+        }
+
+        client_station_snapshot_t stations;
+        client_rssi_get_snapshot(&stations);
+        int8_t weakest = INT8_MAX;
+        bool poor = false;
+        for (int i = 0; i < stations.count; i++) {
+            const client_station_t *sta = &stations.sta[i];
+            if (sta->rssi_avg < weakest) weakest = sta->rssi_avg;
+            poor = poor || sta->poor;
+        }
+
+        xSemaphoreTake(tx_power_mutex, portMAX_DELAY);
+        int8_t before = g_tx_power.power_qdbm;
+        tx_power_change_t change = tx_power_update(
+            &g_tx_power, esp_timer_get_time() / 1000, stations.count,
+            weakest, poor);
+        int8_t after = g_tx_power.power_qdbm;
+        esp_err_t err = change == TX_POWER_HOLD
+            ? ESP_OK : esp_wifi_set_max_tx_power(after);
+        xSemaphoreGive(tx_power_mutex);
+
+        if (change == TX_POWER_HOLD) {
+            continue;
+        }
+        const char *why = change == TX_POWER_DOWN ? "margin kept" :
+                          change == TX_POWER_DEGRADED ? "client degraded" :
+                          stations.count == 0 ? "no clients" :
+                          poor ? "poor link" : "unmeasured client";
+        if (change == TX_POWER_DOWN) {
+            ESP_LOGI(TAG, "TX power %d.%02d -> %d.%02d dBm (%s, weakest "
+                     "%d dBm): %s", before / 4, (before % 4) * 25, after / 4,
+                     (after % 4) * 25, why, weakest, esp_err_to_name(err));
+        } else {
+            ESP_LOGW(TAG, "TX power %d.%02d -> %d.%02d dBm (%s, %d clients): "
+                     "%s", before / 4, (before % 4) * 25, after / 4,
+                     (after % 4) * 25, why, stations.count,
+                     esp_err_to_name(err));
+        }
+    }
 }
 
 /* =========================================================================
@@ -366,6 +497,7 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
             portENTER_CRITICAL(&ap_state_lock);
             ap_started = true;
             portEXIT_CRITICAL(&ap_state_lock);
+            boot_init_milestone(BOOT_MILESTONE_SOFTAP);
             ESP_LOGI(TAG, "WiFi SoftAP driver started");
             break;
 
@@ -384,6 +516,10 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
             portENTER_CRITICAL(&ap_state_lock);
             g_last_client_activity_us = esp_timer_get_time();
             portEXIT_CRITICAL(&ap_state_lock);
+            /* Association and the first frames happen at full range. The
+             * TX power task raises it: it may hold tx_power_mutex, and the
+             * event loop must not wait for it. */
+            if (tx_power_task_handle) xTaskNotifyGive(tx_power_task_handle);
             break;
         }
 
@@ -413,7 +549,8 @@ static void fill_softap_config(wifi_config_t *wifi_config)
                                    ? WIFI_AUTH_OPEN
                                    : WIFI_AUTH_WPA2_PSK;
     wifi_config->ap.pmf_cfg.required = false;
-    wifi_config->ap.beacon_interval = 100;
+    wifi_config->ap.beacon_interval = AP_BEACON_INTERVAL_TU;
+    wifi_config->ap.csa_count = AP_CSA_COUNT;
     wifi_config->ap.dtim_period = 1;
 
     wifi_config->ap.ssid_len = strlen(g_ap_ssid);
@@ -422,7 +559,8 @@ static void fill_softap_config(wifi_config_t *wifi_config)
     memcpy(wifi_config->ap.password, g_ap_pass, strlen(g_ap_pass));
 }
 
-static esp_err_t apply_ap_config_and_restart(void)
+/* Caller holds the scanner, so no survey dwell is cut off by the stop. */
+static esp_err_t restart_softap(void)
 {
     wifi_config_t wifi_config;
     fill_softap_config(&wifi_config);
@@ -438,7 +576,8 @@ static esp_err_t apply_ap_config_and_restart(void)
 
     vTaskDelay(pdMS_TO_TICKS(250));
 
-    err = esp_wifi_set_mode(WIFI_MODE_AP);
+    /* Keep the STA interface the survey scans with. */
+    err = esp_wifi_set_mode(sta_netif ? WIFI_MODE_APSTA : WIFI_MODE_AP);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "esp_wifi_set_mode failed: %s", esp_err_to_name(err));
         return err;
@@ -467,6 +606,287 @@ static esp_err_t apply_ap_config_and_restart(void)
     return ESP_OK;
 }
 
+static esp_err_t apply_ap_config_and_restart(void)
+{
+    wifi_survey_take_scanner(portMAX_DELAY);
+    esp_err_t err = restart_softap();
+    wifi_survey_give_scanner();
+    return err;
+}
+
+/* =========================================================================
+ * Channel switching and client outage measurement
+ * ========================================================================= */
+
+typedef struct {
+    ap_switch_path_stats_t *stats; /* in g_switch_stats or g_reconfig_stats */
+    const char *what;
+    int64_t started_us;
+    uint8_t count;
+    struct {
+        uint8_t mac[6];
+        uint32_t ip;
+        int64_t connected_us;
+        uint32_t packets; /* received from the client before the switch */
+    } sta[CLIENT_RSSI_MAX_STATIONS];
+} switch_baseline_t;
+
+/* Clients with an address, and how much each has sent so far. */
+static switch_baseline_t *take_switch_baseline(ap_switch_path_stats_t *stats,
+                                               const char *what)
+{
+    switch_baseline_t *b = calloc(1, sizeof(*b));
+    if (!b) return NULL;
+    client_station_snapshot_t stations;
+    client_rssi_get_snapshot(&stations);
+    b->stats = stats;
+    b->what = what;
+    b->started_us = esp_timer_get_time();
+    for (int i = 0; i < stations.count; i++) {
+        if (stations.sta[i].ip == 0) continue;
+        client_traffic_t traffic;
+        memcpy(b->sta[b->count].mac, stations.sta[i].mac, 6);
+        b->sta[b->count].ip = stations.sta[i].ip;
+        b->sta[b->count].connected_us = stations.sta[i].connected_us;
+        b->sta[b->count].packets = client_traffic_get(stations.sta[i].ip, &traffic)
+            ? traffic.dir[TRAFFIC_WIFI_UP].packets : 0;
+        b->count++;
+    }
+    return b;
+}
+
+/* Waits until every client has sent a packet after the switch, then records
+ * the longest wait. Runs in its own task so no lock is held meanwhile. */
+static void switch_outage_task(void *arg)
+{
+    switch_baseline_t *b = (switch_baseline_t *)arg;
+    bool heard[CLIENT_RSSI_MAX_STATIONS] = {0};
+    bool dropped[CLIENT_RSSI_MAX_STATIONS] = {0};
+    uint8_t heard_count = 0;
+    uint8_t dropped_count = 0;
+    uint32_t outage_ms = 0;
+    uint32_t elapsed_ms = 0;
+
+    while (heard_count < b->count && elapsed_ms < SWITCH_OUTAGE_TIMEOUT_MS) {
+        vTaskDelay(pdMS_TO_TICKS(SWITCH_OUTAGE_POLL_MS));
+        elapsed_ms = (uint32_t)((esp_timer_get_time() - b->started_us) / 1000);
+
+        client_station_snapshot_t stations;
+        client_rssi_get_snapshot(&stations);
+        for (uint8_t i = 0; i < b->count; i++) {
+            if (heard[i]) continue;
+            const client_station_t *sta = NULL;
+            for (int s = 0; s < stations.count; s++) {
+                if (memcmp(stations.sta[s].mac, b->sta[i].mac, 6) == 0) {
+                    sta = &stations.sta[s];
+                }
+            }
+            if (!dropped[i] &&
+                (!sta || sta->connected_us != b->sta[i].connected_us)) {
+                dropped[i] = true;
+                dropped_count++;
+            }
+            client_traffic_t traffic;
+            if (client_traffic_get(b->sta[i].ip, &traffic) &&
+                traffic.dir[TRAFFIC_WIFI_UP].packets != b->sta[i].packets) {
+                heard[i] = true;
+                heard_count++;
+                outage_ms = elapsed_ms;
+            }
+        }
+    }
+
+    uint8_t silent = b->count - heard_count;
+    if (silent > 0) outage_ms = elapsed_ms;
+    portENTER_CRITICAL(&ap_state_lock);
+    ap_switch_path_stats_t *stats = b->stats;
+    stats->measured++;
+    stats->last_outage_ms = outage_ms;
+    if (outage_ms > stats->max_outage_ms) stats->max_outage_ms = outage_ms;
+    stats->total_outage_ms += outage_ms;
+    stats->clients_dropped += dropped_count;
+    stats->clients_silent += silent;
+    portEXIT_CRITICAL(&ap_state_lock);
+
+    ESP_LOGI(TAG, "%s outage: %lu ms for %u clients (%u dropped, %u silent)",
+             b->what, (unsigned long)outage_ms, b->count, dropped_count, silent);
+    free(b);
+    vTaskDelete(NULL);
+}
+
+/* started_us is when the driver operation began. */
+static void count_switch(ap_switch_path_stats_t *stats, int64_t started_us,
+                         switch_baseline_t *baseline)
+{
+    uint32_t apply_ms = (uint32_t)((esp_timer_get_time() - started_us) / 1000);
+    portENTER_CRITICAL(&ap_state_lock);
+    stats->count++;
+    stats->last_apply_ms = apply_ms;
+    if (apply_ms > stats->max_apply_ms) stats->max_apply_ms = apply_ms;
+    portEXIT_CRITICAL(&ap_state_lock);
+
+    if (!baseline) return;
+    if (baseline->count == 0 ||
+        xTaskCreate(switch_outage_task, "switch_outage", 3072, baseline, 2,
+                    NULL) != pdPASS) {
+        free(baseline);
+    }
+}
+
+/* Moves the running SoftAP to g_ap_channel by announcing the switch in
+ * AP_CSA_COUNT beacons; associated stations follow without reconnecting.
+ * Returns ESP_ERR_NOT_SUPPORTED if the driver did not move in time. The
+ * scanner stays taken through the countdown: an off-channel survey scan
+ * during it would break the switch. */
+static esp_err_t switch_channel_with_csa(void)
+{
+    wifi_config_t wifi_config;
+    fill_softap_config(&wifi_config);
+    wifi_survey_take_scanner(portMAX_DELAY);
+    esp_err_t err = esp_wifi_set_config(WIFI_IF_AP, &wifi_config);
+    if (err != ESP_OK) {
+        wifi_survey_give_scanner();
+        return err;
+    }
+
+    err = ESP_ERR_NOT_SUPPORTED;
+    int64_t deadline = esp_timer_get_time() +
+        (int64_t)(AP_CSA_COUNT + 3) * AP_BEACON_INTERVAL_TU * 1024;
+    while (esp_timer_get_time() < deadline) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        uint8_t channel;
+        wifi_second_chan_t second;
+        if (esp_wifi_get_channel(&channel, &second) == ESP_OK &&
+            channel == g_ap_channel) {
+            err = ESP_OK;
+            break;
+        }
+    }
+    wifi_survey_give_scanner();
+    return err;
+}
+
+/* Caller holds ap_config_mutex and has set g_ap_channel. With clients
+ * connected CSA is tried first; the restart path is the fallback. */
+static esp_err_t switch_ap_channel(bool clients)
+{
+    ap_switch_path_stats_t *csa = &g_switch_stats.path[AP_SWITCH_CSA];
+    ap_switch_path_stats_t *restart = &g_switch_stats.path[AP_SWITCH_RESTART];
+    if (clients) {
+        int64_t started = esp_timer_get_time();
+        esp_err_t err = switch_channel_with_csa();
+        if (err == ESP_OK) {
+            /* Measured from the moment the driver is on the new channel. */
+            count_switch(csa, started, take_switch_baseline(csa, "CSA switch"));
+            return ESP_OK;
+        }
+        ESP_LOGW(TAG, "CSA channel switch not taken (%s), restarting SoftAP",
+                 esp_err_to_name(err));
+        portENTER_CRITICAL(&ap_state_lock);
+        g_switch_stats.csa_fallbacks++;
+        portEXIT_CRITICAL(&ap_state_lock);
+    }
+
+    switch_baseline_t *baseline = clients
+        ? take_switch_baseline(restart, "SoftAP restart") : NULL;
+    int64_t started = esp_timer_get_time();
+    esp_err_t err = apply_ap_config_and_restart();
+    if (err != ESP_OK) {
+        free(baseline);
+        return err;
+    }
+    count_switch(restart, started, baseline);
+    return ESP_OK;
+}
+
+static const char *const reconfig_names[AP_RECONFIG_KINDS] = {
+    "Settings-only change", "Channel change", "Credential change",
+    "Restart for new settings",
+};
+
+/* Applies the new g_ap_* with the cheapest driver operation for what
+ * changed, falling back to a restart. Caller holds ap_config_mutex. */
+static esp_err_t apply_ap_config_changes(bool credentials_changed,
+                                         bool channel_changed)
+{
+    ap_reconfig_kind_t kind = AP_RECONFIG_RESTART;
+    if (ap_is_running()) {
+        kind = credentials_changed ? AP_RECONFIG_CREDENTIALS
+             : channel_changed ? AP_RECONFIG_CHANNEL : AP_RECONFIG_NONE;
+    }
+    int clients = client_rssi_get_count();
+    int64_t started = esp_timer_get_time();
+    esp_err_t err = ESP_OK;
+
+    if (kind == AP_RECONFIG_CHANNEL) {
+        err = switch_channel_with_csa();
+    } else if (kind == AP_RECONFIG_CREDENTIALS) {
+        /* The driver restarts the BSS itself; Wi-Fi, the STA interface and
+         * the runtime settings stay as they are. */
+        wifi_config_t wifi_config;
+        fill_softap_config(&wifi_config);
+        wifi_survey_take_scanner(portMAX_DELAY);
+        err = esp_wifi_set_config(WIFI_IF_AP, &wifi_config);
+        wifi_survey_give_scanner();
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "%s not applied in place (%s), restarting SoftAP",
+                 reconfig_names[kind], esp_err_to_name(err));
+        portENTER_CRITICAL(&ap_state_lock);
+        g_reconfig_stats.fallbacks++;
+        portEXIT_CRITICAL(&ap_state_lock);
+        kind = AP_RECONFIG_RESTART;
+    }
+
+    ap_switch_path_stats_t *stats = &g_reconfig_stats.kind[kind];
+    switch_baseline_t *baseline = NULL;
+    if (kind == AP_RECONFIG_RESTART) {
+        baseline = credentials_changed
+            ? NULL : take_switch_baseline(stats, reconfig_names[kind]);
+        started = esp_timer_get_time();
+        err = apply_ap_config_and_restart();
+        if (err != ESP_OK) {
+            free(baseline);
+            return err;
+        }
+    } else if (kind == AP_RECONFIG_CHANNEL) {
+        /* As for automatic switches, from the moment of the move. */
+        baseline = take_switch_baseline(stats, reconfig_names[kind]);
+    }
+    if (credentials_changed && clients > 0) {
+        portENTER_CRITICAL(&ap_state_lock);
+        stats->clients_dropped += (uint32_t)clients;
+        portEXIT_CRITICAL(&ap_state_lock);
+    }
+    ESP_LOGI(TAG, "%s applied in %lu ms", reconfig_names[kind],
+             (unsigned long)((esp_timer_get_time() - started) / 1000));
+    count_switch(stats, started, baseline);
+    return ESP_OK;
+}
+
+/* Automatic changes with clients connected in the last 24 hours. */
+static uint8_t busy_switches_last_day(int64_t now)
+{
+    uint8_t count = 0;
+    portENTER_CRITICAL(&ap_state_lock);
+    for (size_t i = 0; i < AP_MAX_BUSY_SWITCHES_PER_DAY; i++) {
+        if (g_busy_switch_us[i] != 0 &&
+            now - g_busy_switch_us[i] < 24LL * 60LL * 60LL * 1000000LL) {
+            count++;
+        }
+    }
+    portEXIT_CRITICAL(&ap_state_lock);
+    return count;
+}
+
+static void record_busy_switch(int64_t now)
+{
+    portENTER_CRITICAL(&ap_state_lock);
+    g_busy_switch_us[g_busy_switch_head] = now;
+    g_busy_switch_head = (g_busy_switch_head + 1) % AP_MAX_BUSY_SWITCHES_PER_DAY;
+    portEXIT_CRITICAL(&ap_state_lock);
+}
+
 static void wifi_init_softap(void)
 {
     ESP_LOGI(TAG, "Initializing WiFi SoftAP...");
@@ -537,6 +957,7 @@ void ap_get_config_snapshot(char *ssid, size_t ssid_len,
             .channel_auto = g_channel_auto,
             .active_channel = actual_channel,
             .manual_channel = g_manual_channel,
+            .busy_switch_limit = g_busy_switch_limit,
             .scan_in_progress = g_scan_in_progress,
             .last_scan_result = g_last_scan_result,
             .last_scan_time_us = g_last_scan_time_us,
@@ -547,6 +968,11 @@ void ap_get_config_snapshot(char *ssid, size_t ssid_len,
     }
 }
 esp_netif_t *ap_get_netif(void) { return ap_netif; }
+bool ap_config_held_by(TaskHandle_t task)
+{
+    return task && ap_config_mutex &&
+           xSemaphoreGetMutexHolder(ap_config_mutex) == task;
+}
 bool ap_is_running(void)
 {
     bool started;
@@ -556,6 +982,47 @@ bool ap_is_running(void)
     return started;
 }
 
+esp_err_t ap_record_scan(void)
+{
+    if (web_server_is_ota_in_progress()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(ap_config_mutex, portMAX_DELAY);
+    esp_err_t err = scan_and_select_channel(false, false);
+    xSemaphoreGive(ap_config_mutex);
+    return err;
+}
+
+void ap_get_scan_trace(scan_trace_t *out)
+{
+    portENTER_CRITICAL(&scan_trace_lock);
+    *out = g_scan_trace;
+    portEXIT_CRITICAL(&scan_trace_lock);
+}
+
+void ap_get_channel_switch_stats(ap_channel_switch_stats_t *out)
+{
+    uint8_t busy = busy_switches_last_day(esp_timer_get_time());
+    portENTER_CRITICAL(&ap_state_lock);
+    *out = g_switch_stats;
+    portEXIT_CRITICAL(&ap_state_lock);
+    out->busy_switches_24h = busy;
+}
+
+void ap_get_reconfig_stats(ap_reconfig_stats_t *out)
+{
+    portENTER_CRITICAL(&ap_state_lock);
+    *out = g_reconfig_stats;
+    portEXIT_CRITICAL(&ap_state_lock);
+}
+
+void ap_get_tx_power_stats(tx_power_stats_t *out)
+{
+    xSemaphoreTake(tx_power_mutex, portMAX_DELAY);
+    tx_power_get_stats(&g_tx_power, esp_timer_get_time() / 1000, out);
+    xSemaphoreGive(tx_power_mutex);
+}
+
 char ap_get_health_code(void)
 {
     if (!ap_is_running()) {
@@ -601,10 +1068,12 @@ char ap_get_health_code(void)
 
 esp_err_t ap_set_credentials_and_restart(const char *ssid, const char *pass,
                                          bool channel_auto,
-                                         uint8_t manual_channel)
+                                         uint8_t manual_channel,
+                                         uint8_t busy_switch_limit)
 {
     if (!ssid || !pass || ssid[0] == 0 || strlen(ssid) > 32 ||
-        manual_channel < AP_MIN_CHANNEL || manual_channel > AP_MAX_CHANNEL) {
+        manual_channel < AP_MIN_CHANNEL || manual_channel > AP_MAX_CHANNEL ||
+        busy_switch_limit > AP_MAX_BUSY_SWITCHES_PER_DAY) {
         return ESP_ERR_INVALID_ARG;
     }
     size_t pass_len = strlen(pass);
@@ -626,26 +1095,34 @@ esp_err_t ap_set_credentials_and_restart(const char *ssid, const char *pass,
     uint8_t old_channel = g_ap_channel;
     uint8_t old_manual_channel = g_manual_channel;
     bool old_channel_auto = g_channel_auto;
+    uint8_t old_busy_switch_limit = g_busy_switch_limit;
     strlcpy(old_ssid, g_ap_ssid, sizeof(old_ssid));
     strlcpy(old_pass, g_ap_pass, sizeof(old_pass));
+    bool credentials_changed = strcmp(ssid, g_ap_ssid) != 0 ||
+                               strcmp(pass, g_ap_pass) != 0;
 
     strlcpy(g_ap_ssid, ssid, sizeof(g_ap_ssid));
     strlcpy(g_ap_pass, pass, sizeof(g_ap_pass));
     g_channel_auto = channel_auto;
     g_manual_channel = manual_channel;
-    if (g_channel_auto) {
-        scan_and_select_channel(false);
-    } else {
+    g_busy_switch_limit = busy_switch_limit;
+    if (g_channel_auto &&
+        select_channel_from_survey(false) == ESP_ERR_INVALID_STATE) {
+        /* Survey not complete yet, e.g. right after boot. */
+        jobs_set_progress(20, "Scanning channels");
+        scan_and_select_channel(true, false);
+    } else if (!g_channel_auto) {
         g_ap_channel = g_manual_channel;
     }
 
-    bool save_attempted = false;
-    esp_err_t err = apply_ap_config_and_restart();
+    jobs_set_progress(50, "Applying to the SoftAP");
+    esp_err_t err = apply_ap_config_changes(credentials_changed,
+                                            g_ap_channel != old_channel);
     if (err == ESP_OK) {
-        save_attempted = true;
-        err = save_ap_config_to_nvs(g_ap_ssid, g_ap_pass,
-                                    g_channel_auto, g_manual_channel,
-                                    g_ap_channel);
+        jobs_set_progress(90, "Saving");
+        err = save_ap_config(g_ap_ssid, g_ap_pass, g_channel_auto,
+                             g_manual_channel, g_ap_channel,
+                             g_busy_switch_limit);
     }
     if (err == ESP_OK) {
         xSemaphoreGive(ap_config_mutex);
@@ -654,25 +1131,20 @@ esp_err_t ap_set_credentials_and_restart(const char *ssid, const char *pass,
 
     ESP_LOGE(TAG, "AP configuration update failed, restoring previous settings: %s",
              esp_err_to_name(err));
+    jobs_set_progress(95, "Restoring previous settings");
     strlcpy(g_ap_ssid, old_ssid, sizeof(g_ap_ssid));
     strlcpy(g_ap_pass, old_pass, sizeof(g_ap_pass));
     g_ap_channel = old_channel;
     g_manual_channel = old_manual_channel;
     g_channel_auto = old_channel_auto;
+    g_busy_switch_limit = old_busy_switch_limit;
     esp_err_t rollback_err = apply_ap_config_and_restart();
     if (rollback_err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to restore previous AP settings: %s",
                  esp_err_to_name(rollback_err));
     }
-    if (save_attempted) {
-        esp_err_t restore_nvs_err = save_ap_config_to_nvs(
-            old_ssid, old_pass, old_channel_auto, old_manual_channel,
-            old_channel);
-        if (restore_nvs_err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to restore previous AP settings in NVS: %s",
-                     esp_err_to_name(restore_nvs_err));
-        }
-    }
+    /* A failed save leaves the stored settings untouched, so there is
+     * nothing to write back. */
     xSemaphoreGive(ap_config_mutex);
     return err;
 }
@@ -685,20 +1157,24 @@ esp_err_t ap_restart(void)
     return err;
 }
 
+static esp_err_t restart_channel_task(void);
+
 static void channel_rescan_task(void *arg)
 {
     (void)arg;
+    /* One pass per poll; a selection and switch adds seconds at most. */
+    int watch_id = watchdog_register("channel_rescan", AUTO_SCAN_POLL_MS,
+                                     restart_channel_task);
     for (;;) {
         vTaskDelay(pdMS_TO_TICKS(AUTO_SCAN_POLL_MS));
+        watchdog_checkin(watch_id);
 
-        wifi_sta_list_t stations = {0};
         int64_t now = esp_timer_get_time();
-        if (esp_wifi_ap_get_sta_list(&stations) != ESP_OK) continue;
-        if (stations.num > 0) {
+        bool busy = client_rssi_get_count() > 0;
+        if (busy) {
             portENTER_CRITICAL(&ap_state_lock);
             g_last_client_activity_us = now;
             portEXIT_CRITICAL(&ap_state_lock);
-            continue;
         }
 
         int64_t last_client_activity;
@@ -712,33 +1188,42 @@ static void channel_rescan_task(void *arg)
         bool periodic_scan_due = g_last_scan_time_us > 0 &&
             now - g_last_scan_time_us >= AUTO_SCAN_INTERVAL_US &&
             now - last_client_activity >= AUTO_SCAN_IDLE_US;
+        /* With clients connected, the channel may move by CSA only a few
+         * times a day, and never before the regular rescan interval. */
+        bool busy_scan_due = busy &&
+            now - g_last_scan_time_us >= AUTO_SCAN_INTERVAL_US &&
+            busy_switches_last_day(now) < g_busy_switch_limit;
         bool due = g_channel_auto && !g_scan_in_progress &&
-                   (initial_scan_due || periodic_scan_due);
+                   (busy ? busy_scan_due
+                         : initial_scan_due || periodic_scan_due);
         if (!due || web_server_is_ota_in_progress()) {
             xSemaphoreGive(ap_config_mutex);
             continue;
         }
 
-        /* Close the race with a client joining while the mutex was acquired. */
-        memset(&stations, 0, sizeof(stations));
-        if (esp_wifi_ap_get_sta_list(&stations) != ESP_OK || stations.num > 0) {
-            xSemaphoreGive(ap_config_mutex);
-            continue;
-        }
-
+        /* The survey has the data; nothing here waits for a scan. */
         uint8_t old_channel = g_ap_channel;
-        esp_err_t err = scan_and_select_channel(g_last_scan_time_us != 0);
+        esp_err_t err = select_channel_from_survey(g_last_scan_time_us != 0);
         if (err == ESP_OK && g_ap_channel != old_channel) {
-            ESP_LOGW(TAG, "Idle automatic channel change %u -> %u",
-                     old_channel, g_ap_channel);
-            err = apply_ap_config_and_restart();
+            /* Re-read: a client may have joined during the scan. */
+            bool clients = client_rssi_get_count() > 0;
+            if (clients && !busy &&
+                busy_switches_last_day(now) >= g_busy_switch_limit) {
+                ESP_LOGI(TAG, "Client joined during the scan, keeping channel %u",
+                         old_channel);
+                g_ap_channel = old_channel;
+                xSemaphoreGive(ap_config_mutex);
+                continue;
+            }
+            ESP_LOGW(TAG, "%s automatic channel change %u -> %u",
+                     clients ? "Busy" : "Idle", old_channel, g_ap_channel);
+            err = switch_ap_channel(clients);
             if (err != ESP_OK) {
                 g_ap_channel = old_channel;
                 apply_ap_config_and_restart();
             } else {
-                esp_err_t save_err = save_ap_config_to_nvs(
-                    g_ap_ssid, g_ap_pass, g_channel_auto,
-                    g_manual_channel, g_ap_channel);
+                if (clients) record_busy_switch(esp_timer_get_time());
+                esp_err_t save_err = save_last_auto_channel(g_ap_channel);
                 if (save_err != ESP_OK) {
                     ESP_LOGW(TAG, "Failed to save selected channel: %s",
                              esp_err_to_name(save_err));
@@ -753,8 +1238,94 @@ static void channel_rescan_task(void *arg)
  * Main entry point
  * ========================================================================= */
 
+/* Startup steps after the prelude in app_main(), in the order a sequential
+ * start (BOOT_INIT_PARALLEL 0) runs them. */
+enum {
+    STEP_SOFTAP,
+    STEP_TRAFFIC,
+    STEP_SURVEY,
+    STEP_CHANNEL_TASK,
+    STEP_TX_POWER_TASK,
+    STEP_JOBS,
+    STEP_WEB,
+    STEP_MQTT,
+    STEP_LOCAL_BROKER,
+    STEP_OLED,
+    STEP_PPP,
+    STEP_WATCHDOG,
+};
+
+static esp_err_t start_softap(void)
+{
+    wifi_init_softap();
+    return ESP_OK;
+}
+
+static esp_err_t start_survey(void)
+{
+    /* Without a station interface, wifi_init_softap() already warned. */
+    return sta_netif ? wifi_survey_start() : ESP_OK;
+}
+
+static esp_err_t start_channel_task(void)
+{
+    if (xTaskCreate(channel_rescan_task, "channel_rescan", 4096, NULL, 3,
+                    &channel_rescan_handle) != pdPASS) {
+        channel_rescan_handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/* Called by the watchdog when channel_rescan_task stopped checking in.
+ * Stuck with the AP config mutex, it cannot be replaced; the chip resets. */
+static esp_err_t restart_channel_task(void)
+{
+    TaskHandle_t stuck = channel_rescan_handle;
+    if (ap_config_held_by(stuck)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    channel_rescan_handle = NULL;
+    if (stuck) vTaskDelete(stuck);
+    return start_channel_task();
+}
+
+static esp_err_t start_tx_power_task(void)
+{
+    return xTaskCreate(tx_power_task, "tx_power", 3072, NULL, 3,
+                       &tx_power_task_handle) == pdPASS ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static esp_err_t start_watchdog(void)
+{
+    return watchdog_start(30, 5000); // Feed every 5s with a 30s timeout
+}
+
+static const boot_init_step_t s_boot_steps[] = {
+    [STEP_SOFTAP] = {"softap", start_softap, 0, false},
+    [STEP_TRAFFIC] = {"client_traffic", client_traffic_start,
+                      BOOT_STEP(STEP_SOFTAP), true},
+    [STEP_SURVEY] = {"wifi_survey", start_survey, BOOT_STEP(STEP_SOFTAP), true},
+    [STEP_CHANNEL_TASK] = {"channel_rescan", start_channel_task,
+                           BOOT_STEP(STEP_SURVEY), false},
+    [STEP_TX_POWER_TASK] = {"tx_power", start_tx_power_task,
+                            BOOT_STEP(STEP_SOFTAP), false},
+    [STEP_JOBS] = {"jobs", jobs_start, 0, false},
+    [STEP_WEB] = {"web_server", web_server_start, BOOT_STEP(STEP_JOBS), false},
+    [STEP_MQTT] = {"mqtt", mqtt_telemetry_start, 0, false},
+    // Idle until enabled in the MQTT settings
+    [STEP_LOCAL_BROKER] = {"local_broker", local_broker_start,
+                           BOOT_STEP(STEP_MQTT), false},
+    [STEP_OLED] = {"oled", oled_start, 0, false},
+    [STEP_PPP] = {"ppp_usb", ppp_usb_start, 0, false},
+    [STEP_WATCHDOG] = {"watchdog", start_watchdog, BOOT_STEP(STEP_WEB), false},
+};
+
 void app_main(void)
 {
+    boot_init_begin();
+
+    int64_t started = esp_timer_get_time();
     esp_err_t nvs_err = nvs_flash_init();
     if (nvs_err == ESP_ERR_NVS_NO_FREE_PAGES ||
         nvs_err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -764,26 +1335,34 @@ void app_main(void)
         nvs_err = nvs_flash_init();
     }
     ESP_ERROR_CHECK(nvs_err);
+    boot_init_record("nvs", started, nvs_err);
+
+    started = esp_timer_get_time();
+    esp_err_t config_err = config_store_init();
+    if (config_err != ESP_OK) {
+        ESP_LOGW(TAG, "Migrated settings not saved yet; retrying");
+    }
+    boot_init_record("config_store", started, config_err);
+
+    started = esp_timer_get_time();
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
 
     ap_config_mutex = xSemaphoreCreateMutex();
     ESP_ERROR_CHECK(ap_config_mutex ? ESP_OK : ESP_ERR_NO_MEM);
-
-    load_ap_config_from_nvs();
-    wifi_init_softap();
-
-    BaseType_t channel_task_ok = xTaskCreate(
-        channel_rescan_task, "channel_rescan", 4096, NULL, 3, NULL);
-    ESP_ERROR_CHECK(channel_task_ok == pdPASS ? ESP_OK : ESP_ERR_NO_MEM);
-
-    /* Start modules */
-    ESP_ERROR_CHECK(client_rssi_init()); // Initialize client RSSI tracking first
-    ESP_ERROR_CHECK(web_server_start());
-    ESP_ERROR_CHECK(mqtt_telemetry_start());
-    ESP_ERROR_CHECK(oled_start());
-    ESP_ERROR_CHECK(ppp_usb_start());
-    ESP_ERROR_CHECK(watchdog_start(30, 5000)); // Feed every 5s with a 30s timeout
+    tx_power_mutex = xSemaphoreCreateMutex();
+    ESP_ERROR_CHECK(tx_power_mutex ? ESP_OK : ESP_ERR_NO_MEM);
+    tx_power_init(&g_tx_power, AP_MIN_TX_POWER_QDBM, AP_MAX_TX_POWER_QDBM,
+                  esp_timer_get_time() / 1000);
+
+    /* Station table before the AP, so no connect event is missed. */
+    ESP_ERROR_CHECK(client_rssi_init());
+    load_ap_config();
+    boot_init_record("netif", started, ESP_OK);
+
+    /* Start modules; each step starts once the steps it needs are done. */
+    ESP_ERROR_CHECK(boot_init_run(s_boot_steps,
+                                  sizeof(s_boot_steps) / sizeof(s_boot_steps[0])));
 
     /* app_main no longer needs a forever loop:
      * watchdog loop runs in its own task.
@@ -0,0 +1,134 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Recorded channel scans.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "scan_trace.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+void scan_trace_init(scan_trace_t *t)
+{
+    memset(t, 0, sizeof(*t));
+}
+
+void scan_trace_scan_init(scan_trace_scan_t *scan, uint32_t uptime_s,
+                          uint8_t ap_channel)
+{
+    memset(scan, 0, sizeof(*scan));
+    for (size_t c = 0; c < SCAN_TRACE_CHANNELS; c++) {
+        scan->airtime_permille[c] = SCAN_TRACE_NO_AIRTIME;
+    }
+    scan->uptime_s = uptime_s;
+    scan->ap_channel = ap_channel;
+}
+
+void scan_trace_scan_add(scan_trace_scan_t *scan, const scan_trace_ap_t *ap)
+{
+    if (scan->seen < UINT16_MAX) scan->seen++;
+    if (scan->count < SCAN_TRACE_APS) {
+        scan->ap[scan->count++] = *ap;
+        return;
+    }
+    size_t weakest = 0;
+    for (size_t i = 1; i < SCAN_TRACE_APS; i++) {
+        if (scan->ap[i].rssi < scan->ap[weakest].rssi) weakest = i;
+    }
+    if (ap->rssi > scan->ap[weakest].rssi) scan->ap[weakest] = *ap;
+}
+
+void scan_trace_push(scan_trace_t *t, scan_trace_scan_t *scan)
+{
+    scan->seq = t->next_seq++;
+    t->scans[t->head] = *scan;
+    t->head = (uint8_t)((t->head + 1) % SCAN_TRACE_SCANS);
+    if (t->count < SCAN_TRACE_SCANS) t->count++;
+}
+
+const scan_trace_scan_t *scan_trace_get(const scan_trace_t *t, size_t i)
+{
+    if (i >= t->count) return NULL;
+    size_t oldest = (t->head + SCAN_TRACE_SCANS - t->count) % SCAN_TRACE_SCANS;
+    return &t->scans[(oldest + i) % SCAN_TRACE_SCANS];
+}
+
+int scan_trace_format_scan(char *buf, size_t len,
+                           const scan_trace_scan_t *scan)
+{
+    return snprintf(buf, len, "S,%" PRIu32 ",%" PRIu32 ",%u,%u\n", scan->seq,
+                    scan->uptime_s, scan->ap_channel, scan->seen);
+}
+
+int scan_trace_format_airtime(char *buf, size_t len,
+                              const scan_trace_scan_t *scan, uint8_t channel)
+{
+    if (channel < 1 || channel > SCAN_TRACE_CHANNELS ||
+        scan->airtime_permille[channel - 1] == SCAN_TRACE_NO_AIRTIME) {
+        return 0;
+    }
+    return snprintf(buf, len, "U,%u,%u\n", channel,
+                    scan->airtime_permille[channel - 1]);
+}
+
+int scan_trace_format_ap(char *buf, size_t len, const scan_trace_ap_t *ap)
+{
+    return snprintf(buf, len, "A,%02x:%02x:%02x:%02x:%02x:%02x,%u,%u,%d\n",
+                    ap->bssid[0], ap->bssid[1], ap->bssid[2], ap->bssid[3],
+                    ap->bssid[4], ap->bssid[5], ap->primary, ap->second,
+                    ap->rssi);
+}
+
+scan_trace_line_t scan_trace_parse_line(const char *line,
+                                        scan_trace_scan_t *scan,
+                                        scan_trace_ap_t *ap)
+{
+    while (*line == ' ' || *line == '\t') line++;
+    if (*line == '\0' || *line == '\n' || *line == '\r' || *line == '#') {
+        return SCAN_TRACE_LINE_SKIP;
+    }
+
+    if (line[0] == 'S' && line[1] == ',') {
+        unsigned long seq, uptime;
+        unsigned channel, seen;
+        if (sscanf(line + 2, "%lu,%lu,%u,%u", &seq, &uptime, &channel,
+                   &seen) != 4 || channel > UINT8_MAX || seen > UINT16_MAX) {
+            return SCAN_TRACE_LINE_ERROR;
+        }
+        scan_trace_scan_init(scan, (uint32_t)uptime, (uint8_t)channel);
+        scan->seq = (uint32_t)seq;
+        scan->seen = (uint16_t)seen;
+        return SCAN_TRACE_LINE_SCAN;
+    }
+
+    if (line[0] == 'U' && line[1] == ',') {
+        unsigned channel, permille;
+        if (sscanf(line + 2, "%u,%u", &channel, &permille) != 2 ||
+            channel < 1 || channel > SCAN_TRACE_CHANNELS || permille > 1000) {
+            return SCAN_TRACE_LINE_ERROR;
+        }
+        scan->airtime_permille[channel - 1] = (uint16_t)permille;
+        return SCAN_TRACE_LINE_AIRTIME;
+    }
+
+    if (line[0] == 'A' && line[1] == ',') {
+        unsigned b[6], primary, second;
+        int rssi;
+        if (sscanf(line + 2, "%x:%x:%x:%x:%x:%x,%u,%u,%d", &b[0], &b[1],
+                   &b[2], &b[3], &b[4], &b[5], &primary, &second,
+                   &rssi) != 9 || primary > UINT8_MAX ||
+            second > UINT8_MAX || rssi < INT8_MIN || rssi > INT8_MAX) {
+            return SCAN_TRACE_LINE_ERROR;
+        }
+        for (size_t i = 0; i < 6; i++) ap->bssid[i] = (uint8_t)b[i];
+        ap->primary = (uint8_t)primary;
+        ap->second = (uint8_t)second;
+        ap->rssi = (int8_t)rssi;
+        return SCAN_TRACE_LINE_AP;
+    }
+    return SCAN_TRACE_LINE_ERROR;
+}
@@ -0,0 +1,144 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Per-channel occupancy from the background survey.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "survey_table.h"
+
+#include <string.h>
+
+void survey_table_init(survey_table_t *t)
+{
+    memset(t, 0, sizeof(*t));
+    for (size_t c = 0; c < SURVEY_CHANNELS; c++) {
+        t->ch[c].strongest = INT8_MIN;
+        t->ch[c].airtime_permille = CHANNEL_SELECT_NO_AIRTIME;
+    }
+}
+
+static int find_ap(const survey_table_t *t, const uint8_t *bssid)
+{
+    for (int i = 0; i < t->ap_count; i++) {
+        if (memcmp(t->ap[i].bssid, bssid, 6) == 0) return i;
+    }
+    return -1;
+}
+
+static void update_channel_summary(survey_table_t *t)
+{
+    for (size_t c = 0; c < SURVEY_CHANNELS; c++) {
+        t->ch[c].aps = 0;
+        t->ch[c].strongest = INT8_MIN;
+    }
+    for (size_t i = 0; i < t->ap_count; i++) {
+        survey_channel_t *ch = &t->ch[t->ap[i].primary - 1];
+        ch->aps++;
+        if (t->ap[i].rssi > ch->strongest) ch->strongest = t->ap[i].rssi;
+    }
+}
+
+void survey_table_record(survey_table_t *t, uint8_t channel,
+                         const survey_seen_t *seen, size_t count,
+                         uint32_t now_s, uint32_t dwell_ms)
+{
+    if (channel < 1 || channel > SURVEY_CHANNELS) return;
+
+    /* Everything on this channel counts as missed unless heard below. */
+    for (size_t i = 0; i < t->ap_count; i++) {
+        if (t->ap[i].primary == channel && t->ap[i].missed < UINT8_MAX) {
+            t->ap[i].missed++;
+        }
+    }
+
+    size_t heard = 0;
+    for (size_t s = 0; s < count; s++) {
+        if (seen[s].primary < 1 || seen[s].primary > SURVEY_CHANNELS) continue;
+        if (seen[s].primary == channel) heard++;
+        int i = find_ap(t, seen[s].bssid);
+        if (i < 0) {
+            if (t->ap_count == SURVEY_MAX_APS) {
+                t->dropped_aps++;
+                continue;
+            }
+            i = t->ap_count++;
+            memcpy(t->ap[i].bssid, seen[s].bssid, 6);
+            t->ap[i].rssi = seen[s].rssi;
+        } else {
+            /* Half-weight smoothing: beacon RSSI jumps by several dB. */
+            t->ap[i].rssi = (int8_t)((t->ap[i].rssi + seen[s].rssi) / 2);
+        }
+        t->ap[i].primary = seen[s].primary;
+        t->ap[i].missed = 0;
+    }
+
+    for (size_t i = 0; i < t->ap_count;) {
+        if (t->ap[i].missed >= SURVEY_AP_TTL_DWELLS) {
+            t->ap[i] = t->ap[--t->ap_count];
+        } else {
+            i++;
+        }
+    }
+
+    survey_channel_t *ch = &t->ch[channel - 1];
+    uint16_t heard_q4 = (uint16_t)(heard > 255 ? 255 * 16 : heard * 16);
+    ch->aps_avg_q4 = ch->dwells == 0
+        ? heard_q4 : (uint16_t)((ch->aps_avg_q4 * 3 + heard_q4) / 4);
+    ch->dwells++;
+    ch->last_dwell_s = now_s;
+    ch->dwell_ms += dwell_ms;
+    t->dwells++;
+    update_channel_summary(t);
+
+    t->visited |= (uint16_t)(1u << (channel - 1));
+    if (t->visited == (1u << SURVEY_CHANNELS) - 1) {
+        t->sweeps++;
+        t->visited = 0;
+    }
+}
+
+void survey_table_record_airtime(survey_table_t *t, uint8_t channel,
+                                 uint32_t busy_us, uint32_t window_us,
+                                 uint32_t frames)
+{
+    if (channel < 1 || channel > SURVEY_CHANNELS || window_us == 0) return;
+    survey_channel_t *ch = &t->ch[channel - 1];
+    /* Frames overlapping the window edges can add up to more than it. */
+    uint64_t permille = (uint64_t)busy_us * 1000U / window_us;
+    if (permille > 1000) permille = 1000;
+    ch->airtime_permille = ch->airtime_windows == 0
+        ? (uint16_t)permille
+        : (uint16_t)((ch->airtime_permille * 3U + permille) / 4U);
+    ch->airtime_windows++;
+    ch->airtime_frames = frames;
+}
+
+bool survey_table_airtime(const survey_table_t *t,
+                          uint16_t out[SURVEY_CHANNELS])
+{
+    bool complete = true;
+    for (size_t c = 0; c < SURVEY_CHANNELS; c++) {
+        if (t->ch[c].airtime_windows == 0) {
+            out[c] = CHANNEL_SELECT_NO_AIRTIME;
+            complete = false;
+        } else {
+            out[c] = t->ch[c].airtime_permille;
+        }
+    }
+    return complete;
+}
+
+size_t survey_table_export(const survey_table_t *t, channel_select_ap_t *out,
+                           size_t max)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < t->ap_count && n < max; i++) {
+        out[n++] = (channel_select_ap_t) {
+            .primary = t->ap[i].primary,
+            .rssi = t->ap[i].rssi,
+        };
+    }
+    return n;
+}
@@ -0,0 +1,93 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Per-client traffic counters for the SoftAP subnet.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "traffic_table.h"
+
+#include <string.h>
+
+void traffic_table_init(traffic_table_t *t, uint32_t self, uint32_t mask)
+{
+    memset(t, 0, sizeof(*t));
+    memset(t->slot_by_octet, TRAFFIC_TABLE_NONE, sizeof(t->slot_by_octet));
+    t->net = self & mask;
+    t->mask = mask;
+    t->self_octet = (uint8_t)self;
+}
+
+/* Free slot, or the one idle the longest; its old octet is unmapped. */
+static uint8_t claim_slot(traffic_table_t *t, uint8_t octet)
+{
+    uint8_t victim = 0;
+    for (uint8_t i = 0; i < TRAFFIC_TABLE_SLOTS; i++) {
+        if (!t->slots[i].used) {
+            victim = i;
+            break;
+        }
+        if (t->clock - t->slots[i].last_seen >
+            t->clock - t->slots[victim].last_seen) {
+            victim = i;
+        }
+    }
+
+    traffic_slot_t *slot = &t->slots[victim];
+    if (slot->used) {
+        t->slot_by_octet[slot->octet] = TRAFFIC_TABLE_NONE;
+        t->evictions++;
+    }
+    memset(slot, 0, sizeof(*slot));
+    slot->used = true;
+    slot->octet = octet;
+    t->slot_by_octet[octet] = victim;
+    return victim;
+}
+
+bool traffic_table_account(traffic_table_t *t, traffic_dir_t dir,
+                           uint32_t addr, uint32_t bytes)
+{
+    uint8_t octet = (uint8_t)addr;
+    if ((addr & t->mask) != t->net || (addr & ~t->mask) == 0 ||
+        (addr | t->mask) == UINT32_MAX || octet == t->self_octet) {
+        t->other_packets++;
+        return false;
+    }
+
+    uint8_t index = t->slot_by_octet[octet];
+    if (index == TRAFFIC_TABLE_NONE) index = claim_slot(t, octet);
+
+    traffic_slot_t *slot = &t->slots[index];
+    slot->last_seen = ++t->clock;
+    slot->dir[dir].bytes += bytes;
+    slot->dir[dir].packets++;
+    return true;
+}
+
+static uint32_t read_addr(const uint8_t *a)
+{
+    return (uint32_t)a[0] << 24 | (uint32_t)a[1] << 16 |
+           (uint32_t)a[2] << 8 | a[3];
+}
+
+bool traffic_table_read_ip4(const uint8_t *data, size_t len, size_t ip_offset,
+                            uint32_t *src, uint32_t *dst)
+{
+    if (len < ip_offset + 20 || (data[ip_offset] >> 4) != 4 ||
+        (ip_offset >= 14 &&
+         (data[ip_offset - 2] != 0x08 || data[ip_offset - 1] != 0x00))) {
+        return false;
+    }
+    *src = read_addr(data + ip_offset + 12);
+    *dst = read_addr(data + ip_offset + 16);
+    return true;
+}
+
+const traffic_slot_t *traffic_table_find(const traffic_table_t *t,
+                                         uint8_t octet)
+{
+    uint8_t index = t->slot_by_octet[octet];
+    return index == TRAFFIC_TABLE_NONE ? NULL : &t->slots[index];
+}
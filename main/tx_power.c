@@ -0,0 +1,103 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Adaptive SoftAP transmit power.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "tx_power.h"
+
+#include <math.h>
+#include <string.h>
+
+static double qdbm_to_mw(int8_t qdbm)
+{
+    return pow(10.0, qdbm / 40.0);
+}
+
+/* Charge the time since the last call to the power in use. */
+static void account(tx_power_ctrl_t *c, int64_t now_ms)
+{
+    if (now_ms <= c->last_ms) return;
+    int64_t elapsed = now_ms - c->last_ms;
+    c->stats.total_ms += (uint64_t)elapsed;
+    if (c->power_qdbm < c->max_qdbm) c->stats.reduced_ms += (uint64_t)elapsed;
+    c->energy_mw_ms += qdbm_to_mw(c->power_qdbm) * (double)elapsed;
+    c->last_ms = now_ms;
+}
+
+void tx_power_init(tx_power_ctrl_t *c, int8_t min_qdbm, int8_t max_qdbm,
+                   int64_t now_ms)
+{
+    memset(c, 0, sizeof(*c));
+    c->min_qdbm = min_qdbm;
+    c->max_qdbm = max_qdbm;
+    c->power_qdbm = max_qdbm;
+    c->stats.lowest_qdbm = max_qdbm;
+    c->last_ms = now_ms;
+}
+
+tx_power_change_t tx_power_force_full(tx_power_ctrl_t *c, int64_t now_ms)
+{
+    account(c, now_ms);
+    c->hold = 0;
+    if (c->power_qdbm == c->max_qdbm) return TX_POWER_HOLD;
+    c->power_qdbm = c->max_qdbm;
+    c->stats.full_raises++;
+    return TX_POWER_FULL;
+}
+
+tx_power_change_t tx_power_update(tx_power_ctrl_t *c, int64_t now_ms,
+                                  int clients, int8_t weakest_dbm, bool poor)
+{
+    if (clients <= 0 || weakest_dbm == INT8_MIN || poor) {
+        return tx_power_force_full(c, now_ms);
+    }
+    account(c, now_ms);
+
+    /* dB at the weakest client, from its uplink RSSI at full power. */
+    int estimate = weakest_dbm - (c->max_qdbm - c->power_qdbm) / 4;
+
+    if (estimate < TX_POWER_TARGET_DBM) {
+        int needed_q = (TX_POWER_TARGET_DBM + TX_POWER_HYST_DB - estimate) * 4;
+        needed_q = (needed_q + TX_POWER_STEP_QDBM - 1) / TX_POWER_STEP_QDBM *
+                   TX_POWER_STEP_QDBM;
+        int power = c->power_qdbm + needed_q;
+        c->power_qdbm = (int8_t)(power > c->max_qdbm ? c->max_qdbm : power);
+        c->hold = 0;
+        c->stats.degraded_raises++;
+        return TX_POWER_DEGRADED;
+    }
+
+    bool spare = estimate - TX_POWER_STEP_QDBM / 4 >=
+                 TX_POWER_TARGET_DBM + TX_POWER_HYST_DB;
+    if (!spare || c->power_qdbm - TX_POWER_STEP_QDBM < c->min_qdbm) {
+        c->hold = 0;
+        return TX_POWER_HOLD;
+    }
+    if (++c->hold < TX_POWER_DOWN_HOLD) return TX_POWER_HOLD;
+
+    c->hold = 0;
+    c->power_qdbm -= TX_POWER_STEP_QDBM;
+    if (c->power_qdbm < c->stats.lowest_qdbm) {
+        c->stats.lowest_qdbm = c->power_qdbm;
+    }
+    c->stats.steps_down++;
+    return TX_POWER_DOWN;
+}
+
+void tx_power_get_stats(tx_power_ctrl_t *c, int64_t now_ms,
+                        tx_power_stats_t *out)
+{
+    account(c, now_ms);
+    *out = c->stats;
+    out->power_qdbm = c->power_qdbm;
+    out->max_qdbm = c->max_qdbm;
+    out->energy_saving_pct = 0;
+    if (c->stats.total_ms > 0) {
+        double full = qdbm_to_mw(c->max_qdbm) * (double)c->stats.total_ms;
+        double saving = 100.0 * (1.0 - c->energy_mw_ms / full);
+        out->energy_saving_pct = (uint8_t)(saving < 0 ? 0 : saving + 0.5);
+    }
+}
@@ -29,17 +29,24 @@
  *
  * Usage:
  *   - Call watchdog_start(timeout_sec, feed_period_ms) in app_main.
- *   - Watchdog task will periodically call esp_task_wdt_reset().
+ *   - Watchdog task will periodically call esp_task_wdt_reset() while every
+ *     task in the liveness registry checks in on time.
+ *   - A stalled task is restarted once through its callback; if it cannot
+ *     be, or stalls again before checking in, feeding stops.
  *   - If system deadlocks and watchdog isn't fed, ESP32-C3 will reset.
  *   - Stop using watchdog_deinit() if needed before shutdown/reset.
  */
 
 #include "watchdog.h"
 
+#include <string.h>
+
+#include "config_store.h"
 #include "web_server.h"
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_task_wdt.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -49,6 +56,82 @@ static uint32_t feed_period_ms = 5000;
 
 #define WEB_HEALTH_FAIL_LIMIT 3
 
+typedef struct {
+    const char *name;
+    uint32_t period_ms;
+    watchdog_restart_fn restart;
+    int64_t last_seen_us;
+    uint32_t checkins;
+    uint8_t restarts;
+    bool restart_pending;  /* Restarted; no check-in from the new task yet. */
+} liveness_entry_t;
+
+/* Liveness registry; entries are never removed. */
+static liveness_entry_t s_tasks[WATCHDOG_MAX_TASKS];
+static uint8_t s_task_count;
+static bool s_feeding = true;
+static uint32_t s_feeds;
+static uint32_t s_skipped_feeds;
+static uint32_t s_restarts;
+static portMUX_TYPE s_tasks_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool is_stalled(const liveness_entry_t *task, int64_t now)
+{
+    return now - task->last_seen_us >
+           (int64_t)task->period_ms * WATCHDOG_MISSED_BEATS * 1000;
+}
+
+/**
+ * @brief Check every registered task and restart stalled ones.
+ *
+ * @return true if all tasks are alive, or were just restarted.
+ */
+static bool check_tasks(void)
+{
+    bool healthy = true;
+    for (uint8_t i = 0; i < WATCHDOG_MAX_TASKS; i++) {
+        int64_t now = esp_timer_get_time();
+        portENTER_CRITICAL(&s_tasks_lock);
+        if (i >= s_task_count) {
+            portEXIT_CRITICAL(&s_tasks_lock);
+            break;
+        }
+        liveness_entry_t *task = &s_tasks[i];
+        bool stalled = is_stalled(task, now);
+        const char *name = task->name;
+        uint32_t silent_ms = (uint32_t)((now - task->last_seen_us) / 1000);
+        watchdog_restart_fn restart =
+            stalled && !task->restart_pending &&
+            task->restarts < WATCHDOG_MAX_RESTARTS ? task->restart : NULL;
+        portEXIT_CRITICAL(&s_tasks_lock);
+        if (!stalled) continue;
+
+        esp_err_t err = ESP_ERR_NOT_SUPPORTED;
+        if (restart) {
+            ESP_LOGW(TAG, "Task %s silent for %lums; restarting it", name,
+                     (unsigned long)silent_ms);
+            err = restart();
+        }
+        if (err != ESP_OK) {
+            if (s_feeding) {
+                ESP_LOGE(TAG, "Task %s silent for %lums, restart %s", name,
+                         (unsigned long)silent_ms,
+                         restart ? esp_err_to_name(err) : "not possible");
+            }
+            healthy = false;
+            continue;
+        }
+        portENTER_CRITICAL(&s_tasks_lock);
+        /* The new task gets a full stall period to check in. */
+        task->last_seen_us = esp_timer_get_time();
+        task->restart_pending = true;
+        task->restarts++;
+        s_restarts++;
+        portEXIT_CRITICAL(&s_tasks_lock);
+    }
+    return healthy;
+}
+
 /**
  * @brief Watchdog feed and web-server health-check loop.
  *
@@ -64,11 +147,27 @@ static void watchdog_task(void *arg)
     ESP_LOGI(TAG, "Watchdog task started");
 
     while (1) {
-        esp_err_t err = esp_task_wdt_reset();
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to feed task watchdog: %s",
-                     esp_err_to_name(err));
+        bool healthy = check_tasks();
+        if (healthy) {
+            esp_err_t err = esp_task_wdt_reset();
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to feed task watchdog: %s",
+                         esp_err_to_name(err));
+            }
+            if (!s_feeding) ESP_LOGW(TAG, "All tasks alive again; feeding");
+        } else if (s_feeding) {
+            ESP_LOGE(TAG, "Not feeding the task watchdog; reset follows");
+            /* A TWDT reset skips the shutdown handlers. */
+            config_store_flush();
+        }
+        portENTER_CRITICAL(&s_tasks_lock);
+        s_feeding = healthy;
+        if (healthy) {
+            s_feeds++;
+        } else {
+            s_skipped_feeds++;
         }
+        portEXIT_CRITICAL(&s_tasks_lock);
 
         if (web_server_is_ota_in_progress()) {
             web_fail_count = 0;
@@ -179,3 +278,71 @@ void watchdog_deinit(void)
 
     ESP_LOGI(TAG, "Watchdog stopped");
 }
+
+int watchdog_register(const char *name, uint32_t period_ms,
+                      watchdog_restart_fn restart)
+{
+    if (name == NULL || period_ms == 0) return -1;
+
+    int id = -1;
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_tasks_lock);
+    for (uint8_t i = 0; i < s_task_count; i++) {
+        if (strcmp(s_tasks[i].name, name) == 0) {
+            id = i;
+            break;
+        }
+    }
+    if (id < 0 && s_task_count < WATCHDOG_MAX_TASKS) {
+        id = s_task_count++;
+        s_tasks[id] = (liveness_entry_t){.name = name, .last_seen_us = now};
+    }
+    /* A restarted task registering again is not alive yet: only a check-in
+     * from its loop clears restart_pending. */
+    if (id >= 0) {
+        s_tasks[id].period_ms = period_ms;
+        s_tasks[id].restart = restart;
+    }
+    portEXIT_CRITICAL(&s_tasks_lock);
+
+    if (id < 0) {
+        ESP_LOGE(TAG, "Liveness registry full; %s not monitored", name);
+    }
+    return id;
+}
+
+void watchdog_checkin(int id)
+{
+    if (id < 0 || id >= WATCHDOG_MAX_TASKS) return;
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_tasks_lock);
+    s_tasks[id].last_seen_us = now;
+    s_tasks[id].restart_pending = false;
+    s_tasks[id].checkins++;
+    portEXIT_CRITICAL(&s_tasks_lock);
+}
+
+void watchdog_get_status(watchdog_status_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_tasks_lock);
+    out->running = watchdog_task_handle != NULL;
+    out->feeding = s_feeding;
+    out->feeds = s_feeds;
+    out->skipped_feeds = s_skipped_feeds;
+    out->restarts = s_restarts;
+    out->task_count = s_task_count;
+    for (uint8_t i = 0; i < s_task_count; i++) {
+        const liveness_entry_t *task = &s_tasks[i];
+        out->tasks[i] = (watchdog_task_status_t){
+            .name = task->name,
+            .period_ms = task->period_ms,
+            .last_seen_ms = (uint32_t)((now - task->last_seen_us) / 1000),
+            .checkins = task->checkins,
+            .restarts = task->restarts,
+            .healthy = !is_stalled(task, now),
+        };
+    }
+    portEXIT_CRITICAL(&s_tasks_lock);
+}
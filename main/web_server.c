@@ -9,9 +9,17 @@
  */
 #include "web_server.h"
 #include "ap_config.h"
+#include "boot_init.h"
+#include "client_rssi.h"
+#include "client_traffic.h"
+#include "config_store.h"
+#include "jobs.h"
+#include "local_broker.h"
 #include "mqtt_telemetry.h"
 #include "oled.h"
 #include "ppp.h"
+#include "watchdog.h"
+#include "wifi_survey.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -24,7 +32,6 @@
 #include "esp_http_server.h"
 #include "esp_http_client.h"
 #include "esp_tls_crypto.h"
-#include "esp_wifi.h"
 #include "esp_netif.h"
 #include "esp_system.h"
 #include "esp_mac.h"
@@ -38,7 +45,6 @@
 /* Default AP subnet shown in UI */
 #define AP_IP_ADDR "192.168.4.1"
 #define AJAX_REFRESH_SEC 10
-#define AP_MAX_CONN 4
 #define AP_MIN_CHANNEL 1
 #define AP_MAX_CHANNEL 11
 
@@ -194,7 +200,7 @@ static esp_err_t root_get_handler(httpd_req_t *req)
         return ESP_OK;
     }
 
-    const size_t page_len = 10240;
+    const size_t page_len = 15360;
     char *page = (char *)malloc(page_len);
     if (!page) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
@@ -218,6 +224,17 @@ static esp_err_t root_get_handler(httpd_req_t *req)
                 sizeof(escaped_mqtt_host));
     html_escape(mqtt_config.root_topic, escaped_mqtt_root,
                 sizeof(escaped_mqtt_root));
+    char escaped_power_subtopic[96];
+    char escaped_power_path[144];
+    html_escape(mqtt_config.power_subtopic, escaped_power_subtopic,
+                sizeof(escaped_power_subtopic));
+    html_escape(mqtt_config.power_json_path, escaped_power_path,
+                sizeof(escaped_power_path));
+    char escaped_bridge_filters[384];
+    html_escape(mqtt_config.bridge_filters, escaped_bridge_filters,
+                sizeof(escaped_bridge_filters));
+    oled_rotation_t rotation;
+    oled_get_rotation(&rotation);
 
     snprintf(page, page_len,
         "<!doctype html><html><head>"
@@ -245,6 +262,14 @@ static esp_err_t root_get_handler(httpd_req_t *req)
         "function schedule(ms){if(timer){clearTimeout(timer);}timer=setTimeout(tick,ms);}"
         "function setText(id,val){var el=document.getElementById(id);if(el)el.textContent=val;}"
         "function setHtml(id,val){var el=document.getElementById(id);if(el)el.innerHTML=val;}"
+        "function pollJob(id,el,done){"
+        "fetch('/jobs/'+id).then(function(r){return r.ok?r.json():null;}).then(function(j){"
+        "if(!j){el.textContent='Job '+id+' finished earlier or the device restarted.';return;}"
+        "el.textContent=j.kind+': '+j.step+' ('+j.progress+'%%)'+(j.state==='failed'?' - '+j.result:'');"
+        "if(j.state==='queued'||j.state==='running'){setTimeout(function(){pollJob(id,el,done);},500);}else if(done){done(j);}"
+        "}).catch(function(){el.textContent='Waiting for the device...';setTimeout(function(){pollJob(id,el,done);},1000);});"
+        "}"
+        "function fmtBytes(b){return b>=1048576?(b/1048576).toFixed(1)+' MB':b>=1024?(b/1024).toFixed(1)+' KB':b+' B';}"
         "window.toggleManualChannel=function(){"
         "var auto=document.getElementById('channelAuto');"
         "var row=document.getElementById('manualChannelRow');"
@@ -281,11 +306,14 @@ static esp_err_t root_get_handler(httpd_req_t *req)
         "setText('pppNm',data.ppp.nm||'0.0.0.0');"
         "var body=document.getElementById('clientTableBody');"
         "if(body){body.innerHTML='';"
-        "if(!data.clients||!data.clients.length){body.innerHTML='<tr><td colspan=\"3\">No clients connected.</td></tr>';}else{"
+        "if(!data.clients||!data.clients.length){body.innerHTML='<tr><td colspan=\"5\">No clients connected.</td></tr>';}else{"
         "data.clients.forEach(function(c,idx){"
         "var ip=c.ip||'0.0.0.0';"
         "var ipCell=ip==='0.0.0.0'?ip:'<a href=\"http://'+ip+'\" target=\"_blank\" rel=\"noopener\">'+ip+'</a>';"
-        "body.innerHTML+=('<tr><td>'+(idx+1)+'</td><td>'+c.mac+'</td><td>'+ipCell+'</td></tr>');"
+        "var t=c.traffic;"
+        "var up=t?fmtBytes(t.uplink_up.bps)+'/s &uarr; '+fmtBytes(t.uplink_down.bps)+'/s &darr;':'';"
+        "var tot=t?fmtBytes(t.wifi_up.bytes)+' &uarr; '+fmtBytes(t.wifi_down.bytes)+' &darr;':'';"
+        "body.innerHTML+=('<tr><td>'+(idx+1)+'</td><td>'+c.mac+'</td><td>'+ipCell+'</td><td>'+up+'</td><td>'+tot+'</td></tr>');"
         "});"
         "}}"
         "backoff=0;"
@@ -305,10 +333,14 @@ static esp_err_t root_get_handler(httpd_req_t *req)
         "statusEl.textContent='Uploading '+file.name+' ('+file.size+' bytes)...';"
         "fetch('/ota',{method:'POST',headers:{'Content-Type':'application/octet-stream','X-OTA-Filename':file.name},body:file})"
         ".then(function(resp){return resp.text().then(function(text){return {ok:resp.ok,text:text};});})"
-        ".then(function(result){if(result.ok){statusEl.textContent='Upload complete. Device will reboot shortly.';}else{otaInProgress=false;updateBadge();statusEl.textContent='OTA failed: '+result.text;}})"
+        ".then(function(result){if(result.ok){statusEl.textContent='Upload complete. Verifying image...';"
+        "pollJob(JSON.parse(result.text).job,statusEl,function(j){if(j.state==='failed'){otaInProgress=false;updateBadge();}});"
+        "}else{otaInProgress=false;updateBadge();statusEl.textContent='OTA failed: '+result.text;}})"
         ".catch(function(err){otaInProgress=false;updateBadge();statusEl.textContent='OTA failed: '+err;});"
         "};"
-        "document.addEventListener('DOMContentLoaded',window.toggleManualChannel);updateBadge();"
+        "document.addEventListener('DOMContentLoaded',function(){window.toggleManualChannel();"
+        "var m=location.search.match(/[?&]job=(\\d+)/);var el=document.getElementById('apJobStatus');"
+        "if(m&&el){pollJob(m[1],el);}});updateBadge();"
         "})();</script>"
         "<style>body{font-family:sans-serif;margin:20px;}table{border-collapse:collapse;}th,td{border:1px solid #ccc;padding:6px 10px;}input{padding:6px;margin:4px 0;}</style>"
         "</head><body>"
@@ -323,8 +355,11 @@ static esp_err_t root_get_handler(httpd_req_t *req)
         "<label><input type='checkbox' name='open' value='1'> Use an open network</label><br>"
         "<label><input id='channelAuto' type='checkbox' name='channel_auto' value='1' onchange='toggleManualChannel()'%s> Automatically select channel</label><br>"
         "<div id='manualChannelRow'>Channel:<br><input id='manualChannel' name='channel' type='number' min='1' max='11' step='1' value='%u'></div>"
-        "<small>Automatic selection scans after one idle minute and only rescans after the AP has been idle. Leave password blank to keep it unchanged.</small><br><br>"
-        "<input type='submit' value='Save & Restart AP'></form><hr>"
+        "Channel changes per day with clients connected (0 = only when idle):<br><input name='busy_switches' type='number' min='0' max='%u' step='1' value='%u'><br>"
+        "<label><input type='checkbox' name='airtime' value='1'%s> Measure airtime while idle and choose among all channels 1-11</label><br>"
+        "<small>Automatic selection scans after one idle minute and rescans every six hours. With clients connected, the channel is moved by announcing the switch, up to the daily limit. Leave password blank to keep it unchanged.</small><br><br>"
+        "<input type='submit' value='Save & Apply'></form>"
+        "<div id='apJobStatus' style='margin-top:8px;color:#444;'></div><hr>"
         "<h3>OLED Diagnostics</h3>"
         "<form method='POST' action='/oled/debug'><button type='submit'>Toggle Debug Page</button></form>"
         "<p><small>Use this control to test the display without pressing the GPIO9 BOOT button.</small></p><hr>"
@@ -334,8 +369,27 @@ static esp_err_t root_get_handler(httpd_req_t *req)
         "Manual broker IPv4 override:<br><input name='broker_host' maxlength='15' value='%s'><br>"
         "<small>The override is used only when automatic mode is unchecked. Port 1883 is fixed.</small><br>"
         "Grafana root topic:<br><input name='root_topic' maxlength='63' value='%s' required><br>"
-        "<small>For example OBK-681; /power/get and /connected are appended automatically.</small><br>"
-        "<label><input type='checkbox' name='display_enabled' value='1'%s> OLED enabled</label><br><br>"
+        "<small>For example OBK-681; /connected and the power subtopic are appended automatically.</small><br>"
+        "Power subtopic:<br><input name='power_subtopic' maxlength='31' value='%s' required><br>"
+        "Power JSON path:<br><input name='power_json_path' maxlength='47' value='%s' placeholder='Plain value'><br>"
+        "<small>Leave the path empty for a plain value such as OpenBeken's <code>power/get</code>. For a JSON document enter the key path, for example subtopic <code>tele/SENSOR</code> and path <code>ENERGY.Power</code>.</small><br>"
+        "Self-telemetry interval (s):<br><input name='telemetry_interval' type='number' min='0' max='%u' step='1' value='%u'><br>"
+        "Self-telemetry deadband (%%):<br><input name='telemetry_deadband' type='number' min='0' max='%u' step='1' value='%u'><br>"
+        "<small>Router health is published to <code>&lt;root&gt;/" MQTT_SELF_TELEMETRY_SUBTOPIC "</code>. 0 s disables publishing; 0 %% publishes every sample.</small><br>"
+        "<label><input type='checkbox' name='protocol_v5' value='1'%s> Use MQTT v5 (topic aliases, subscription identifiers)</label><br>"
+        "<label><input type='checkbox' name='persistent_session' value='1'%s> Persistent session (QoS 1, show last value after reconnect)</label><br>"
+        "<label><input type='checkbox' name='local_broker' value='1'%s> Local broker on 192.168.4.1:1883 (read the plug without crossing the PPP link)</label><br>"
+        "Bridge topic filters:<br><input name='bridge_filters' maxlength='127' value='%s' placeholder='Nothing bridged'><br>"
+        "<small>Comma-separated filters such as <code>OBK-681/#</code>. Matching local topics are forwarded to the FRITZ!Box broker in batches, unchanged values only once a minute.</small><br>"
+        "<label><input type='checkbox' name='display_enabled' value='1'%s> OLED enabled</label><br>"
+        "OLED page rotation: <label><input type='checkbox' name='rotate_power' value='1'%s> Power</label> "
+        "<label><input type='checkbox' name='rotate_debug' value='1'%s> Debug</label> "
+        "<label><input type='checkbox' name='rotate_history' value='1'%s> Power graph</label><br>"
+        "<label><input type='checkbox' name='rotate_clients' value='1'%s> Clients</label><br>"
+        "Seconds per page:<br><input name='rotate_s' type='number' min='0' max='%u' step='1' value='%u'><br>"
+        "<small>0 s stays on the first selected page; with none selected the power page is shown. Credentials, debug toggle and screensaver take precedence.</small><br>"
+        "Power graph span (minutes):<br><input name='history_min' type='number' min='%u' max='%u' step='1' value='%u'><br>"
+        "<small>Changing the span clears the graph.</small><br><br>"
         "<button type='submit'>Save MQTT & Display Settings</button></form><hr>"
         "<h3>OTA Firmware Update</h3>"
         "<p>Select a firmware <code>.bin</code> file built for this device. The device will reboot after upload.</p>"
@@ -358,17 +412,39 @@ static esp_err_t root_get_handler(httpd_req_t *req)
         "<b>Last automatic scan:</b> <span id='channelScan'>%s</span></p>"
         "<hr>"
         "<h3>Connected Clients</h3>"
-        "<table><thead><tr><th>#</th><th>MAC</th><th>IP (DHCP)</th></tr></thead>"
-        "<tbody id='clientTableBody'><tr><td colspan='3'>Loading...</td></tr></tbody></table><hr>",
+        "<table><thead><tr><th>#</th><th>MAC</th><th>IP (DHCP)</th><th>PPP uplink</th><th>Wi-Fi total</th></tr></thead>"
+        "<tbody id='clientTableBody'><tr><td colspan='5'>Loading...</td></tr></tbody></table><hr>",
         AJAX_REFRESH_SEC,
         IP2STR(&ppp_ip), IP2STR(&ppp_gw), IP2STR(&ppp_nm),
         escaped_ssid,
         channel_status.channel_auto ? " checked" : "",
         channel_status.manual_channel,
+        AP_MAX_BUSY_SWITCHES_PER_DAY,
+        channel_status.busy_switch_limit,
+        wifi_survey_get_airtime_enabled() ? " checked" : "",
         mqtt_config.broker_auto ? " checked" : "",
         escaped_mqtt_host,
         escaped_mqtt_root,
+        escaped_power_subtopic,
+        escaped_power_path,
+        MQTT_SELF_TELEMETRY_MAX_INTERVAL_S,
+        mqtt_config.telemetry_interval_s,
+        MQTT_SELF_TELEMETRY_MAX_DEADBAND_PCT,
+        mqtt_config.telemetry_deadband_pct,
+        mqtt_config.protocol_v5 ? " checked" : "",
+        mqtt_config.persistent_session ? " checked" : "",
+        mqtt_config.local_broker ? " checked" : "",
+        escaped_bridge_filters,
         oled_is_enabled() ? " checked" : "",
+        (rotation.pages & OLED_ROTATE_POWER) ? " checked" : "",
+        (rotation.pages & OLED_ROTATE_DEBUG) ? " checked" : "",
+        (rotation.pages & OLED_ROTATE_HISTORY) ? " checked" : "",
+        (rotation.pages & OLED_ROTATE_CLIENTS) ? " checked" : "",
+        OLED_ROTATE_MAX_S,
+        rotation.interval_s,
+        OLED_HISTORY_MIN_MINUTES,
+        OLED_HISTORY_MAX_MINUTES,
+        oled_get_history_minutes(),
         channel_status.active_channel,
         channel_status.channel_auto ? "Automatic" : "Manual",
         channel_status.last_scan_time_us == 0 ? "Never" :
@@ -384,9 +460,102 @@ static esp_err_t root_get_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+/* dBm value, or null before the first RSSI sample. */
+static void format_rssi_json(char *out, size_t out_len, int8_t rssi)
+{
+    if (rssi == INT8_MIN) {
+        strlcpy(out, "null", out_len);
+    } else {
+        snprintf(out, out_len, "%d", rssi);
+    }
+}
+
+/* Per-direction counters of the client at ip, null if nothing was counted. */
+static void format_traffic_json(char *out, size_t out_len, uint32_t ip)
+{
+    static const char *const names[TRAFFIC_DIR_COUNT] = {
+        [TRAFFIC_WIFI_UP] = "wifi_up",
+        [TRAFFIC_WIFI_DOWN] = "wifi_down",
+        [TRAFFIC_UPLINK_UP] = "uplink_up",
+        [TRAFFIC_UPLINK_DOWN] = "uplink_down",
+    };
+    client_traffic_t traffic;
+    if (!client_traffic_get(ip, &traffic)) {
+        strlcpy(out, "null", out_len);
+        return;
+    }
+
+    strlcpy(out, "{", out_len);
+    for (int d = 0; d < TRAFFIC_DIR_COUNT; d++) {
+        char dir[96];
+        snprintf(dir, sizeof(dir),
+                 "%s\"%s\":{\"bytes\":%llu,\"packets\":%lu,\"bps\":%lu}",
+                 d ? "," : "", names[d],
+                 (unsigned long long)traffic.dir[d].bytes,
+                 (unsigned long)traffic.dir[d].packets,
+                 (unsigned long)traffic.dir[d].bytes_per_s);
+        strlcat(out, dir, out_len);
+    }
+    strlcat(out, "}", out_len);
+}
+
+static void format_switch_path_json(char *out, size_t out_len,
+                                    const ap_switch_path_stats_t *path)
+{
+    snprintf(out, out_len,
+             "{\"count\":%lu,\"last_apply_ms\":%lu,\"max_apply_ms\":%lu,"
+             "\"measured\":%lu,\"last_outage_ms\":%lu,"
+             "\"avg_outage_ms\":%lu,\"max_outage_ms\":%lu,"
+             "\"clients_dropped\":%lu,\"clients_silent\":%lu}",
+             (unsigned long)path->count, (unsigned long)path->last_apply_ms,
+             (unsigned long)path->max_apply_ms, (unsigned long)path->measured,
+             (unsigned long)path->last_outage_ms,
+             (unsigned long)(path->measured
+                 ? path->total_outage_ms / path->measured : 0),
+             (unsigned long)path->max_outage_ms,
+             (unsigned long)path->clients_dropped,
+             (unsigned long)path->clients_silent);
+}
+
+/* Members of the "channel_switch" object, without the braces. */
+static void format_channel_switch_json(char *out, size_t out_len)
+{
+    ap_channel_switch_stats_t stats;
+    ap_get_channel_switch_stats(&stats);
+    char csa[224];
+    char restart[224];
+    format_switch_path_json(csa, sizeof(csa), &stats.path[AP_SWITCH_CSA]);
+    format_switch_path_json(restart, sizeof(restart),
+                            &stats.path[AP_SWITCH_RESTART]);
+    snprintf(out, out_len,
+             "\"busy_switches_24h\":%u,\"csa_fallbacks\":%lu,"
+             "\"csa\":%s,\"restart\":%s",
+             stats.busy_switches_24h, (unsigned long)stats.csa_fallbacks,
+             csa, restart);
+}
+
+/* Members of the "reconfig" object, without the braces. */
+static void format_reconfig_json(char *out, size_t out_len)
+{
+    static const char *const names[AP_RECONFIG_KINDS] = {
+        "none", "channel", "credentials", "restart",
+    };
+    ap_reconfig_stats_t stats;
+    ap_get_reconfig_stats(&stats);
+    snprintf(out, out_len, "\"fallbacks\":%lu",
+             (unsigned long)stats.fallbacks);
+    for (size_t k = 0; k < AP_RECONFIG_KINDS; k++) {
+        char kind[240];
+        char path[224];
+        format_switch_path_json(path, sizeof(path), &stats.kind[k]);
+        snprintf(kind, sizeof(kind), ",\"%s\":%s", names[k], path);
+        strlcat(out, kind, out_len);
+    }
+}
+
 static esp_err_t status_all_get_handler(httpd_req_t *req)
 {
-    const size_t page_len = 2048;
+    const size_t page_len = 11264;
     char *page = (char *)malloc(page_len);
     if (!page) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
@@ -415,12 +584,38 @@ static esp_err_t status_all_get_handler(httpd_req_t *req)
     char effective_broker_host[MQTT_BROKER_HOST_MAX_LEN + 1];
     mqtt_telemetry_get_effective_broker_host(effective_broker_host,
                                               sizeof(effective_broker_host));
-    char mqtt_power_topic[MQTT_ROOT_TOPIC_MAX_LEN + 16];
-    char mqtt_connected_topic[MQTT_ROOT_TOPIC_MAX_LEN + 16];
-    snprintf(mqtt_power_topic, sizeof(mqtt_power_topic), "%s/power/get",
-             mqtt_config.root_topic);
+    char mqtt_power_topic[MQTT_TOPIC_MAX_LEN + 1];
+    char mqtt_connected_topic[MQTT_TOPIC_MAX_LEN + 1];
+    snprintf(mqtt_power_topic, sizeof(mqtt_power_topic), "%s/%s",
+             mqtt_config.root_topic, mqtt_config.power_subtopic);
     snprintf(mqtt_connected_topic, sizeof(mqtt_connected_topic), "%s/connected",
              mqtt_config.root_topic);
+    char mqtt_self_topic[MQTT_TOPIC_MAX_LEN + 1];
+    snprintf(mqtt_self_topic, sizeof(mqtt_self_topic), "%s/%s",
+             mqtt_config.root_topic, MQTT_SELF_TELEMETRY_SUBTOPIC);
+    mqtt_self_telemetry_stats_t self_stats;
+    mqtt_telemetry_get_self_stats(&self_stats);
+    mqtt_link_stats_t link_stats;
+    mqtt_telemetry_get_link_stats(&link_stats);
+    mqtt_power_reading_t power_reading;
+    mqtt_telemetry_get_power_reading(&power_reading);
+    mqtt_first_display_stats_t first_display;
+    mqtt_telemetry_get_first_display_stats(&first_display);
+    mqtt_broker_stats_t broker_stats;
+    local_broker_get_stats(&broker_stats);
+    oled_frame_stats_t frame_stats;
+    oled_get_frame_stats(&frame_stats);
+    oled_rotation_t rotation;
+    oled_get_rotation(&rotation);
+    uint32_t frames = frame_stats.frames ? frame_stats.frames : 1;
+    int64_t uptime_us = esp_timer_get_time();
+    unsigned long wakeups_centi = uptime_us > 0
+        ? (unsigned long)((uint64_t)frame_stats.task_wakeups * 100000000ULL /
+                          (uint64_t)uptime_us)
+        : 0;
+    char bridge_filters[2 * MQTT_BRIDGE_FILTERS_MAX_LEN + 1];
+    json_escape(mqtt_config.bridge_filters, bridge_filters,
+                sizeof(bridge_filters));
 
     ap_channel_status_t channel_status;
     ap_get_config_snapshot(NULL, 0, NULL, 0, &channel_status);
@@ -434,9 +629,15 @@ static esp_err_t status_all_get_handler(httpd_req_t *req)
         snprintf(scan_age_json, sizeof(scan_age_json), "%lld",
                  (long long)scan_age_sec);
     }
+    tx_power_stats_t tx_power;
+    ap_get_tx_power_stats(&tx_power);
+    char switch_json[512];
+    format_channel_switch_json(switch_json, sizeof(switch_json));
+    char reconfig_json[960];
+    format_reconfig_json(reconfig_json, sizeof(reconfig_json));
     snprintf(page, page_len,
              "{"
-             "\"schema_version\":3,"
+             "\"schema_version\":4,"
              "\"mqtt\":{"
              "\"connected\":%s,"
              "\"auto\":%s,"
@@ -445,20 +646,92 @@ static esp_err_t status_all_get_handler(httpd_req_t *req)
              "\"port\":%d,"
              "\"root_topic\":\"%s\","
              "\"power_topic\":\"%s\","
+             "\"power_json_path\":\"%s\","
              "\"connected_topic\":\"%s\","
+             "\"telemetry_topic\":\"%s\","
+             "\"telemetry_interval_s\":%u,"
+             "\"telemetry_deadband_pct\":%u,"
+             "\"telemetry_published\":%lu,"
+             "\"telemetry_suppressed\":%lu,"
+             "\"telemetry_failed\":%lu,"
+             "\"protocol\":\"%s\","
+             "\"tx_messages\":%lu,"
+             "\"tx_bytes_per_msg\":%lu,"
+             "\"tx_alias_hits\":%lu,"
+             "\"rx_by_subscription_id\":%lu,"
+             "\"rx_by_topic\":%lu,"
+             "\"dispatch_id_cycles_avg\":%lu,"
+             "\"dispatch_topic_cycles_avg\":%lu,"
+             "\"persistent_session\":%s,"
+             "\"first_display_ms\":%lu,"
+             "\"first_display_best_ms\":%lu,"
+             "\"first_display_worst_ms\":%lu,"
+             "\"first_display_samples\":%lu,"
+             "\"first_display_retained\":%s,"
              "\"free_heap\":%lu,"
              "\"obk_power\":\"%s\","
+             "\"obk_power_stale\":%s,"
+             "\"obk_power_age_s\":%ld,"
              "\"obk_connected\":%s,"
              "\"obk_connected_state\":%d"
              "},"
+             "\"local_broker\":{"
+             "\"enabled\":%s,"
+             "\"running\":%s,"
+             "\"bridge_filters\":\"%s\","
+             "\"clients\":%lu,"
+             "\"connects\":%lu,"
+             "\"rx_publishes\":%lu,"
+             "\"tx_publishes\":%lu,"
+             "\"bridge_forwarded\":%lu,"
+             "\"bridge_batches\":%lu,"
+             "\"bridge_coalesced\":%lu,"
+             "\"bridge_deduplicated\":%lu,"
+             "\"bridge_dropped\":%lu,"
+             "\"protocol_errors\":%lu"
+             "},"
              "\"display_enabled\":%s,"
+             "\"oled\":{"
+             "\"frames\":%lu,"
+             "\"full_frames\":%lu,"
+             "\"unchanged_frames\":%lu,"
+             "\"tiles_per_frame\":%lu,"
+             "\"i2c_bytes_per_frame\":%lu,"
+             "\"i2c_us_per_frame\":%lu,"
+             "\"last_frame_bytes\":%lu,"
+             "\"last_frame_us\":%lu,"
+             "\"task_wakeups\":%lu,"
+             "\"wakeups_per_s\":%lu.%02lu,"
+             "\"page\":\"%s\","
+             "\"rotation_pages\":%lu,"
+             "\"rotation_s\":%u,"
+             "\"render_us_per_frame\":%lu,"
+             "\"over_budget_frames\":%lu,"
+             "\"skipped_renders\":%lu,"
+             "\"history_min\":%u,"
+             "\"history_columns\":%lu,"
+             "\"history_rescales\":%lu"
+             "},"
              "\"ap\":{"
              "\"channel\":%u,"
              "\"channel_auto\":%s,"
              "\"manual_channel\":%u,"
              "\"scan_in_progress\":%s,"
              "\"last_scan\":\"%s\","
-             "\"last_scan_age_sec\":%s"
+             "\"last_scan_age_sec\":%s,"
+             "\"busy_switch_limit\":%u,"
+             "\"channel_switch\":{%s},"
+             "\"reconfig\":{%s},"
+             "\"tx_power\":{"
+             "\"dbm\":%d.%02d,"
+             "\"max_dbm\":%d.%02d,"
+             "\"lowest_dbm\":%d.%02d,"
+             "\"steps_down\":%lu,"
+             "\"degraded_raises\":%lu,"
+             "\"full_raises\":%lu,"
+             "\"reduced_pct\":%u,"
+             "\"energy_saving_pct\":%u"
+             "}"
              "},"
              "\"ppp\":{"
              "\"ip\":\"" IPSTR "\","
@@ -473,12 +746,71 @@ static esp_err_t status_all_get_handler(httpd_req_t *req)
              MQTT_TELEMETRY_PORT,
              mqtt_config.root_topic,
              mqtt_power_topic,
+             mqtt_config.power_json_path,
              mqtt_connected_topic,
+             mqtt_self_topic,
+             mqtt_config.telemetry_interval_s,
+             mqtt_config.telemetry_deadband_pct,
+             (unsigned long)self_stats.published,
+             (unsigned long)self_stats.suppressed,
+             (unsigned long)self_stats.failed,
+             link_stats.protocol_v5 ? "5" : "3.1.1",
+             (unsigned long)link_stats.tx_messages,
+             (unsigned long)(link_stats.tx_messages
+                 ? link_stats.tx_wire_bytes / link_stats.tx_messages : 0),
+             (unsigned long)link_stats.tx_alias_hits,
+             (unsigned long)link_stats.dispatch_by_id,
+             (unsigned long)link_stats.dispatch_by_topic,
+             (unsigned long)(link_stats.dispatch_by_id
+                 ? link_stats.dispatch_id_cycles / link_stats.dispatch_by_id : 0),
+             (unsigned long)(link_stats.dispatch_by_topic
+                 ? link_stats.dispatch_topic_cycles / link_stats.dispatch_by_topic
+                 : 0),
+             mqtt_config.persistent_session ? "true" : "false",
+             (unsigned long)first_display.last_ms,
+             (unsigned long)first_display.best_ms,
+             (unsigned long)first_display.worst_ms,
+             (unsigned long)first_display.samples,
+             first_display.last_from_retained ? "true" : "false",
              (unsigned long)esp_get_free_heap_size(),
              obk_power,
+             power_reading.stale ? "true" : "false",
+             (long)power_reading.age_s,
              conn_bool,
              conn_state,
+             mqtt_config.local_broker ? "true" : "false",
+             local_broker_is_running() ? "true" : "false",
+             bridge_filters,
+             (unsigned long)broker_stats.clients,
+             (unsigned long)broker_stats.connects,
+             (unsigned long)broker_stats.rx_publishes,
+             (unsigned long)broker_stats.tx_publishes,
+             (unsigned long)broker_stats.bridge_forwarded,
+             (unsigned long)broker_stats.bridge_batches,
+             (unsigned long)broker_stats.bridge_coalesced,
+             (unsigned long)broker_stats.bridge_deduplicated,
+             (unsigned long)broker_stats.bridge_dropped,
+             (unsigned long)broker_stats.protocol_errors,
              oled_is_enabled() ? "true" : "false",
+             (unsigned long)frame_stats.frames,
+             (unsigned long)frame_stats.full_frames,
+             (unsigned long)frame_stats.unchanged_frames,
+             (unsigned long)(frame_stats.tiles_sent / frames),
+             (unsigned long)(frame_stats.i2c_bytes / frames),
+             (unsigned long)(frame_stats.i2c_us / frames),
+             (unsigned long)frame_stats.last_bytes,
+             (unsigned long)frame_stats.last_us,
+             (unsigned long)frame_stats.task_wakeups,
+             wakeups_centi / 100, wakeups_centi % 100,
+             frame_stats.page ? frame_stats.page : "",
+             (unsigned long)rotation.pages,
+             rotation.interval_s,
+             (unsigned long)(frame_stats.render_us / frames),
+             (unsigned long)frame_stats.over_budget_frames,
+             (unsigned long)frame_stats.skipped_renders,
+             oled_get_history_minutes(),
+             (unsigned long)frame_stats.history_columns,
+             (unsigned long)frame_stats.history_rescales,
              channel_status.active_channel,
              channel_status.channel_auto ? "true" : "false",
              channel_status.manual_channel,
@@ -486,50 +818,139 @@ static esp_err_t status_all_get_handler(httpd_req_t *req)
              channel_status.last_scan_time_us == 0 ? "Never" :
                  esp_err_to_name(channel_status.last_scan_result),
              scan_age_json,
+             channel_status.busy_switch_limit,
+             switch_json,
+             reconfig_json,
+             tx_power.power_qdbm / 4, (tx_power.power_qdbm % 4) * 25,
+             tx_power.max_qdbm / 4, (tx_power.max_qdbm % 4) * 25,
+             tx_power.lowest_qdbm / 4, (tx_power.lowest_qdbm % 4) * 25,
+             (unsigned long)tx_power.steps_down,
+             (unsigned long)tx_power.degraded_raises,
+             (unsigned long)tx_power.full_raises,
+             (unsigned)(tx_power.total_ms
+                 ? tx_power.reduced_ms * 100 / tx_power.total_ms : 0),
+             tx_power.energy_saving_pct,
              IP2STR(&ppp_ip), IP2STR(&ppp_gw), IP2STR(&ppp_nm));
 
-    wifi_sta_list_t sta_list = {0};
-    esp_wifi_ap_get_sta_list(&sta_list);
-
-    esp_netif_t *ap_netif = ap_get_netif();
-    esp_netif_pair_mac_ip_t pairs[AP_MAX_CONN];
-    int n = sta_list.num;
-    if (n > AP_MAX_CONN) n = AP_MAX_CONN;
-
-    for (int i = 0; i < n; i++) {
-        memcpy(pairs[i].mac, sta_list.sta[i].mac, 6);
-        pairs[i].ip.addr = 0;
-    }
-
-    if (ap_netif && n > 0) {
-        esp_err_t err = esp_netif_dhcps_get_clients_by_mac(ap_netif, n, pairs);
-        if (err != ESP_OK) {
-            ESP_LOGW(TAG, "esp_netif_dhcps_get_clients_by_mac failed: %s",
-                     esp_err_to_name(err));
-        }
-    }
+    /* Station list and DHCP leases come from the event-fed table. */
+    client_station_snapshot_t stations;
+    client_rssi_get_snapshot(&stations);
+    int n = stations.count;
 
     for (int i = 0; i < n; i++) {
         char mac_str[32];
         char ip_str[IP4ADDR_STRLEN_MAX];
-        snprintf(mac_str, sizeof(mac_str), MACSTR, MAC2STR(pairs[i].mac));
-        if (pairs[i].ip.addr != 0) {
-            esp_ip4addr_ntoa(&pairs[i].ip, ip_str, sizeof(ip_str));
-        } else {
-            snprintf(ip_str, sizeof(ip_str), IPSTR, IP2STR(&pairs[i].ip));
+        esp_ip4_addr_t ip = {.addr = stations.sta[i].ip};
+        snprintf(mac_str, sizeof(mac_str), MACSTR, MAC2STR(stations.sta[i].mac));
+        esp_ip4addr_ntoa(&ip, ip_str, sizeof(ip_str));
+
+        const client_station_t *sta = &stations.sta[i];
+        char rssi_json[4][8];
+        format_rssi_json(rssi_json[0], sizeof(rssi_json[0]), sta->rssi);
+        format_rssi_json(rssi_json[1], sizeof(rssi_json[1]), sta->rssi_avg);
+        format_rssi_json(rssi_json[2], sizeof(rssi_json[2]), sta->rssi_min);
+        format_rssi_json(rssi_json[3], sizeof(rssi_json[3]), sta->rssi_max);
+        int8_t history[CLIENT_RSSI_HISTORY];
+        size_t history_len = client_rssi_history(sta, history);
+        char history_json[CLIENT_RSSI_HISTORY * 5 + 1] = "";
+        for (size_t k = 0; k < history_len; k++) {
+            char sample[8];
+            snprintf(sample, sizeof(sample), k ? ",%d" : "%d", history[k]);
+            strlcat(history_json, sample, sizeof(history_json));
         }
-
-        strlcat(page, "{\"mac\":\"", page_len);
-        strlcat(page, mac_str, page_len);
-        strlcat(page, "\",\"ip\":\"", page_len);
-        strlcat(page, ip_str, page_len);
-        strlcat(page, "\"}", page_len);
+        char traffic_json[384];
+        format_traffic_json(traffic_json, sizeof(traffic_json), sta->ip);
+        char entry[768];
+        snprintf(entry, sizeof(entry),
+                 "{\"mac\":\"%s\",\"ip\":\"%s\","
+                 "\"rssi\":%s,\"rssi_avg\":%s,\"rssi_min\":%s,"
+                 "\"rssi_max\":%s,\"rssi_stddev\":%u.%u,"
+                 "\"rssi_history\":[%s],\"poor\":%s,"
+                 "\"poor_crossings\":%u,\"connected_s\":%lld,"
+                 "\"traffic\":%s}",
+                 mac_str, ip_str, rssi_json[0], rssi_json[1], rssi_json[2],
+                 rssi_json[3], sta->rssi_stddev_ddb / 10,
+                 sta->rssi_stddev_ddb % 10, history_json,
+                 sta->poor ? "true" : "false", sta->poor_crossings,
+                 (long long)((uptime_us - sta->connected_us) / 1000000),
+                 traffic_json);
+        strlcat(page, entry, page_len);
         if (i + 1 < n) {
             strlcat(page, ",", page_len);
         }
     }
 
-    strlcat(page, "]}", page_len);
+    client_traffic_stats_t traffic_stats;
+    client_traffic_get_stats(&traffic_stats);
+    char traffic_json[160];
+    snprintf(traffic_json, sizeof(traffic_json),
+             "],\"traffic\":{\"packets\":%lu,\"other_packets\":%lu,"
+             "\"evictions\":%lu,\"hook_cycles_avg\":%lu},",
+             (unsigned long)traffic_stats.packets,
+             (unsigned long)traffic_stats.other_packets,
+             (unsigned long)traffic_stats.evictions,
+             (unsigned long)traffic_stats.hook_cycles_avg);
+    strlcat(page, traffic_json, page_len);
+
+    config_store_stats_t config_stats;
+    config_store_get_stats(&config_stats);
+    char config_json[560];
+    snprintf(config_json, sizeof(config_json),
+             "\"config\":{\"source\":\"%s\",\"version\":%u,"
+             "\"blob_bytes\":%u,\"load_us\":%lu,\"blob_read_us\":%lu,"
+             "\"legacy_read_us\":%lu,\"legacy_keys_read\":%u,"
+             "\"commits\":%lu,\"saves\":%lu,\"coalesced\":%lu,"
+             "\"unchanged\":%lu,\"writes_saved\":%lu,"
+             "\"forced_flushes\":%lu,\"pending\":%s,\"pending_ms\":%lu,"
+             "\"max_save_us\":%lu,"
+             "\"legacy_key_writes\":%lu,\"last_commit_us\":%lu,"
+             "\"crc_errors\":%lu,\"write_errors\":%lu},",
+             config_store_source_name(config_stats.source),
+             config_stats.loaded_version, config_stats.blob_bytes,
+             (unsigned long)config_stats.load_us,
+             (unsigned long)config_stats.blob_read_us,
+             (unsigned long)config_stats.legacy_read_us,
+             config_stats.legacy_keys_read,
+             (unsigned long)config_stats.commits,
+             (unsigned long)config_stats.saves,
+             (unsigned long)config_stats.coalesced,
+             (unsigned long)config_stats.unchanged,
+             (unsigned long)(config_stats.coalesced + config_stats.unchanged),
+             (unsigned long)config_stats.forced_flushes,
+             config_stats.pending ? "true" : "false",
+             (unsigned long)config_stats.pending_ms,
+             (unsigned long)config_stats.max_save_us,
+             (unsigned long)config_stats.legacy_key_writes,
+             (unsigned long)config_stats.last_commit_us,
+             (unsigned long)config_stats.crc_errors,
+             (unsigned long)config_stats.write_errors);
+    strlcat(page, config_json, page_len);
+
+    watchdog_status_t watchdog;
+    watchdog_get_status(&watchdog);
+    char watchdog_json[160];
+    snprintf(watchdog_json, sizeof(watchdog_json),
+             "\"watchdog\":{\"running\":%s,\"feeding\":%s,\"feeds\":%lu,"
+             "\"skipped_feeds\":%lu,\"restarts\":%lu,\"tasks\":[",
+             watchdog.running ? "true" : "false",
+             watchdog.feeding ? "true" : "false",
+             (unsigned long)watchdog.feeds,
+             (unsigned long)watchdog.skipped_feeds,
+             (unsigned long)watchdog.restarts);
+    strlcat(page, watchdog_json, page_len);
+    for (uint8_t i = 0; i < watchdog.task_count; i++) {
+        const watchdog_task_status_t *task = &watchdog.tasks[i];
+        snprintf(watchdog_json, sizeof(watchdog_json),
+                 "%s{\"name\":\"%s\",\"period_ms\":%lu,"
+                 "\"last_seen_ms\":%lu,\"checkins\":%lu,\"restarts\":%u,"
+                 "\"healthy\":%s}",
+                 i ? "," : "", task->name, (unsigned long)task->period_ms,
+                 (unsigned long)task->last_seen_ms,
+                 (unsigned long)task->checkins, task->restarts,
+                 task->healthy ? "true" : "false");
+        strlcat(page, watchdog_json, page_len);
+    }
+    strlcat(page, "]}}", page_len);
 
     httpd_resp_set_type(req, "application/json");
     httpd_resp_set_hdr(req, "Connection", "close");
@@ -806,6 +1227,182 @@ static bool valid_wpa_password(const char *pass)
     return true;
 }
 
+/* --------------------------------------------------------------------------
+ * Jobs: slow operations run on the jobs worker, not in the httpd task
+ * -------------------------------------------------------------------------- */
+
+/* Queues fn; on failure the error response is sent and false returned. */
+static bool submit_job(httpd_req_t *req, const char *kind, job_fn_t fn,
+                       void *arg, uint32_t *id_out)
+{
+    esp_err_t err = jobs_submit(kind, fn, arg, id_out);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Cannot queue %s job: %s", kind, esp_err_to_name(err));
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "2");
+        httpd_resp_sendstr(req, "Busy, try again");
+        return false;
+    }
+    return true;
+}
+
+/* 202 with the job id, for requests made by scripts. */
+static esp_err_t send_job_accepted(httpd_req_t *req, uint32_t id)
+{
+    char body[64];
+    snprintf(body, sizeof(body), "{\"job\":%lu,\"status\":\"/jobs/%lu\"}",
+             (unsigned long)id, (unsigned long)id);
+    httpd_resp_set_status(req, "202 Accepted");
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_sendstr(req, body);
+}
+
+typedef struct {
+    char ssid[33];
+    char pass[65];
+    bool channel_auto;
+    uint8_t channel;
+    uint8_t busy_switches;
+    bool airtime;
+} ap_apply_job_t;
+
+static esp_err_t ap_apply_job(void *arg)
+{
+    ap_apply_job_t *job = (ap_apply_job_t *)arg;
+    /* Before the apply, so a scan it triggers already uses the mode. */
+    esp_err_t err = wifi_survey_set_airtime_enabled(job->airtime);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save airtime setting: %s", esp_err_to_name(err));
+    }
+    err = ap_set_credentials_and_restart(job->ssid, job->pass,
+                                         job->channel_auto, job->channel,
+                                         job->busy_switches);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to apply AP configuration: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+static esp_err_t scan_job(void *arg)
+{
+    (void)arg;
+    jobs_set_progress(10, "Scanning channels");
+    return ap_record_scan();
+}
+
+typedef struct {
+    esp_ota_handle_t handle;
+    const esp_partition_t *partition;
+} ota_finalize_job_t;
+
+static esp_err_t ota_finalize_job(void *arg)
+{
+    ota_finalize_job_t *job = (ota_finalize_job_t *)arg;
+    jobs_set_progress(10, "Verifying image");
+    esp_err_t err = esp_ota_end(job->handle);
+    if (err == ESP_OK) {
+        jobs_set_progress(80, "Setting boot partition");
+        err = esp_ota_set_boot_partition(job->partition);
+    }
+    if (err != ESP_OK) {
+        set_ota_state(false, -1);
+        return err;
+    }
+
+    jobs_set_progress(90, "Saving settings");
+    config_store_flush();
+    jobs_set_progress(100, "Rebooting");
+    /* Give the page a poll to see it. */
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    esp_restart();
+    return ESP_OK;
+}
+
+static esp_err_t jobs_get_handler(httpd_req_t *req)
+{
+    const char *id_text = req->uri + strlen("/jobs/");
+    char *end = NULL;
+    unsigned long id = strtoul(id_text, &end, 10);
+    job_status_t job;
+    if (end == id_text || (*end != '\0' && *end != '?') ||
+        !jobs_get((uint32_t)id, &job)) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "Unknown job");
+        return ESP_FAIL;
+    }
+
+    int64_t now = esp_timer_get_time();
+    int64_t run_end = job.finished_us ? job.finished_us : now;
+    char result[40] = "null";
+    if (job.state == JOB_DONE || job.state == JOB_FAILED) {
+        snprintf(result, sizeof(result), "\"%s\"", esp_err_to_name(job.result));
+    }
+    char body[256];
+    snprintf(body, sizeof(body),
+             "{\"id\":%lu,\"kind\":\"%s\",\"state\":\"%s\","
+             "\"progress\":%u,\"step\":\"%s\",\"result\":%s,"
+             "\"age_ms\":%lld,\"run_ms\":%lld}",
+             (unsigned long)job.id, job.kind, jobs_state_name(job.state),
+             job.progress_pct, job.step, result,
+             (long long)((now - job.queued_us) / 1000),
+             (long long)(job.started_us ? (run_end - job.started_us) / 1000 : 0));
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    return httpd_resp_sendstr(req, body);
+}
+
+/* Boot timeline: stage times from app_main() and the milestones. */
+static esp_err_t status_boot_handler(httpd_req_t *req)
+{
+    boot_profile_t *profile = malloc(sizeof(*profile));
+    if (!profile) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    boot_init_get_profile(profile);
+
+    int64_t init_us = profile->init_done_us ?
+        profile->init_done_us - profile->app_main_us : 0;
+    int64_t saved_us = init_us ? (int64_t)profile->stages_us - init_us : 0;
+    char line[160];
+    snprintf(line, sizeof(line),
+             "{\"parallel\":%s,\"app_main_ms\":%lld,\"init_ms\":%lld,"
+             "\"stages_ms\":%lu,\"saved_ms\":%lld,\"milestones\":{",
+             profile->parallel ? "true" : "false",
+             (long long)(profile->app_main_us / 1000),
+             (long long)(init_us / 1000),
+             (unsigned long)(profile->stages_us / 1000),
+             (long long)(saved_us > 0 ? saved_us / 1000 : 0));
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    esp_err_t err = httpd_resp_sendstr_chunk(req, line);
+    for (int m = 0; err == ESP_OK && m < BOOT_MILESTONES; m++) {
+        char value[24] = "null";
+        if (profile->milestone_us[m]) {
+            snprintf(value, sizeof(value), "%lld",
+                     (long long)(profile->milestone_us[m] / 1000));
+        }
+        snprintf(line, sizeof(line), "%s\"%s\":%s", m ? "," : "",
+                 boot_init_milestone_name((boot_milestone_t)m), value);
+        err = httpd_resp_sendstr_chunk(req, line);
+    }
+    if (err == ESP_OK) err = httpd_resp_sendstr_chunk(req, "},\"stages\":[");
+    for (size_t i = 0; err == ESP_OK && i < profile->stage_count; i++) {
+        const boot_stage_t *stage = &profile->stages[i];
+        snprintf(line, sizeof(line),
+                 "%s{\"name\":\"%s\",\"start_us\":%lld,\"us\":%lld,"
+                 "\"task\":%s,\"result\":\"%s\"}",
+                 i ? "," : "", stage->name, (long long)stage->start_us,
+                 (long long)(stage->end_us - stage->start_us),
+                 stage->on_task ? "true" : "false",
+                 esp_err_to_name(stage->result));
+        err = httpd_resp_sendstr_chunk(req, line);
+    }
+    free(profile);
+    if (err == ESP_OK) err = httpd_resp_sendstr_chunk(req, "]}");
+    if (err == ESP_OK) err = httpd_resp_sendstr_chunk(req, NULL);
+    return err;
+}
+
 static esp_err_t set_post_handler(httpd_req_t *req)
 {
     if (!web_admin_authorized(req)) {
@@ -822,6 +1419,8 @@ static esp_err_t set_post_handler(httpd_req_t *req)
     char channel_raw[4] = {0};
     char open_raw[2] = {0};
     char channel_auto_raw[2] = {0};
+    char busy_switches_raw[4] = {0};
+    char airtime_raw[2] = {0};
 
     if (!parse_form_field(buf, "ssid", ssid, sizeof(ssid)) ||
         !parse_form_field(buf, "pass", pass, sizeof(pass))) {
@@ -834,6 +1433,9 @@ static esp_err_t set_post_handler(httpd_req_t *req)
                                          channel_auto_raw,
                                          sizeof(channel_auto_raw)) &&
                         strcmp(channel_auto_raw, "1") == 0;
+    bool airtime = parse_form_field(buf, "airtime", airtime_raw,
+                                    sizeof(airtime_raw)) &&
+                   strcmp(airtime_raw, "1") == 0;
 
     if (!open_network && pass[0] == 0) {
         ap_get_config_snapshot(NULL, 0, pass, sizeof(pass), NULL);
@@ -854,6 +1456,18 @@ static esp_err_t set_post_handler(httpd_req_t *req)
         }
         channel = strtol(channel_raw, &endptr, 10);
     }
+    long busy_switches = current_channel_status.busy_switch_limit;
+    if (parse_form_field(buf, "busy_switches", busy_switches_raw,
+                         sizeof(busy_switches_raw))) {
+        char *busy_end = NULL;
+        busy_switches = strtol(busy_switches_raw, &busy_end, 10);
+        if (busy_switches_raw[0] == 0 || *busy_end != '\0' ||
+            busy_switches < 0 || busy_switches > AP_MAX_BUSY_SWITCHES_PER_DAY) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                                "Channel changes per day must be between 0 and 24");
+            return ESP_FAIL;
+        }
+    }
 
     if (strlen(ssid) == 0) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "SSID must not be empty");
@@ -875,18 +1489,31 @@ static esp_err_t set_post_handler(httpd_req_t *req)
              ssid, (int)strlen(pass), channel_auto ? "auto" : "manual",
              channel);
 
-    esp_err_t err = ap_set_credentials_and_restart(
-        ssid, pass, channel_auto, (uint8_t)channel);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to apply AP configuration: %s", esp_err_to_name(err));
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "AP configuration was not changed");
+    ap_apply_job_t *job = calloc(1, sizeof(*job));
+    if (!job) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    strlcpy(job->ssid, ssid, sizeof(job->ssid));
+    strlcpy(job->pass, pass, sizeof(job->pass));
+    job->channel_auto = channel_auto;
+    job->channel = (uint8_t)channel;
+    job->busy_switches = (uint8_t)busy_switches;
+    job->airtime = airtime;
+    uint32_t id = 0;
+    if (!submit_job(req, "ap_apply", ap_apply_job, job, &id)) {
         return ESP_FAIL;
     }
 
+    /* The page polls /jobs/<id> and shows the progress. */
+    char location[24];
+    char body[48];
+    snprintf(location, sizeof(location), "/?job=%lu", (unsigned long)id);
+    snprintf(body, sizeof(body), "{\"job\":%lu}", (unsigned long)id);
     httpd_resp_set_status(req, "303 See Other");
-    httpd_resp_set_hdr(req, "Location", "/");
-    httpd_resp_send(req, NULL, 0);
+    httpd_resp_set_hdr(req, "Location", location);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, body);
     return ESP_OK;
 }
 
@@ -896,56 +1523,171 @@ static esp_err_t mqtt_display_post_handler(httpd_req_t *req)
         return ESP_OK;
     }
 
-    char buf[256];
+    char buf[1024];
     if (receive_request_body(req, buf, sizeof(buf)) != ESP_OK) {
         return ESP_FAIL;
     }
 
-    char broker_host[MQTT_BROKER_HOST_MAX_LEN + 1] = {0};
-    char root_topic[MQTT_ROOT_TOPIC_MAX_LEN + 1] = {0};
+    mqtt_telemetry_config_t mqtt_config;
     char broker_auto_raw[2] = {0};
     char display_raw[2] = {0};
-    if (!parse_form_field(buf, "broker_host", broker_host,
-                          sizeof(broker_host)) ||
-        !parse_form_field(buf, "root_topic", root_topic,
-                          sizeof(root_topic))) {
+    char interval_raw[6] = {0};
+    char deadband_raw[4] = {0};
+    char protocol_v5_raw[2] = {0};
+    char persistent_raw[2] = {0};
+    char local_broker_raw[2] = {0};
+    char rotate_raw[2] = {0};
+    char rotate_s_raw[6] = {0};
+    char history_raw[6] = {0};
+    mqtt_telemetry_get_config(&mqtt_config);
+    if (!parse_form_field(buf, "broker_host", mqtt_config.broker_host,
+                          sizeof(mqtt_config.broker_host)) ||
+        !parse_form_field(buf, "root_topic", mqtt_config.root_topic,
+                          sizeof(mqtt_config.root_topic)) ||
+        !parse_form_field(buf, "power_subtopic", mqtt_config.power_subtopic,
+                          sizeof(mqtt_config.power_subtopic))) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
                             "MQTT configuration fields are missing or invalid");
         return ESP_FAIL;
     }
-    bool broker_auto =
+    mqtt_config.broker_auto =
         parse_form_field(buf, "broker_auto", broker_auto_raw,
                          sizeof(broker_auto_raw)) &&
         strcmp(broker_auto_raw, "1") == 0;
+    mqtt_config.protocol_v5 =
+        parse_form_field(buf, "protocol_v5", protocol_v5_raw,
+                         sizeof(protocol_v5_raw)) &&
+        strcmp(protocol_v5_raw, "1") == 0;
+    mqtt_config.persistent_session =
+        parse_form_field(buf, "persistent_session", persistent_raw,
+                         sizeof(persistent_raw)) &&
+        strcmp(persistent_raw, "1") == 0;
+    if (!parse_form_field(buf, "power_json_path", mqtt_config.power_json_path,
+                          sizeof(mqtt_config.power_json_path))) {
+        mqtt_config.power_json_path[0] = 0;
+    }
+    mqtt_config.local_broker =
+        parse_form_field(buf, "local_broker", local_broker_raw,
+                         sizeof(local_broker_raw)) &&
+        strcmp(local_broker_raw, "1") == 0;
+    if (!parse_form_field(buf, "bridge_filters", mqtt_config.bridge_filters,
+                          sizeof(mqtt_config.bridge_filters))) {
+        mqtt_config.bridge_filters[0] = 0;
+    }
+    if (parse_form_field(buf, "telemetry_interval", interval_raw,
+                         sizeof(interval_raw))) {
+        char *endptr = NULL;
+        long interval = strtol(interval_raw, &endptr, 10);
+        if (interval_raw[0] == 0 || *endptr != '\0' || interval < 0 ||
+            interval > MQTT_SELF_TELEMETRY_MAX_INTERVAL_S) {
+            interval = -1;
+        }
+        mqtt_config.telemetry_interval_s =
+            interval < 0 ? UINT16_MAX : (uint16_t)interval;
+    }
+    if (parse_form_field(buf, "telemetry_deadband", deadband_raw,
+                         sizeof(deadband_raw))) {
+        char *endptr = NULL;
+        long deadband = strtol(deadband_raw, &endptr, 10);
+        if (deadband_raw[0] == 0 || *endptr != '\0' || deadband < 0 ||
+            deadband > MQTT_SELF_TELEMETRY_MAX_DEADBAND_PCT) {
+            deadband = UINT8_MAX;
+        }
+        mqtt_config.telemetry_deadband_pct = (uint8_t)deadband;
+    }
     bool display_enabled =
         parse_form_field(buf, "display_enabled", display_raw,
                          sizeof(display_raw)) &&
         strcmp(display_raw, "1") == 0;
 
+    oled_rotation_t rotation = {0};
+    if (parse_form_field(buf, "rotate_power", rotate_raw, sizeof(rotate_raw)) &&
+        strcmp(rotate_raw, "1") == 0) {
+        rotation.pages |= OLED_ROTATE_POWER;
+    }
+    if (parse_form_field(buf, "rotate_debug", rotate_raw, sizeof(rotate_raw)) &&
+        strcmp(rotate_raw, "1") == 0) {
+        rotation.pages |= OLED_ROTATE_DEBUG;
+    }
+    if (parse_form_field(buf, "rotate_history", rotate_raw,
+                         sizeof(rotate_raw)) &&
+        strcmp(rotate_raw, "1") == 0) {
+        rotation.pages |= OLED_ROTATE_HISTORY;
+    }
+    if (parse_form_field(buf, "rotate_clients", rotate_raw,
+                         sizeof(rotate_raw)) &&
+        strcmp(rotate_raw, "1") == 0) {
+        rotation.pages |= OLED_ROTATE_CLIENTS;
+    }
+    uint16_t history_minutes = oled_get_history_minutes();
+    if (parse_form_field(buf, "history_min", history_raw, sizeof(history_raw))) {
+        char *endptr = NULL;
+        long minutes = strtol(history_raw, &endptr, 10);
+        if (history_raw[0] == 0 || *endptr != '\0' ||
+            minutes < OLED_HISTORY_MIN_MINUTES ||
+            minutes > OLED_HISTORY_MAX_MINUTES) {
+            minutes = 0;
+        }
+        history_minutes = (uint16_t)minutes;
+    }
+    if (parse_form_field(buf, "rotate_s", rotate_s_raw, sizeof(rotate_s_raw))) {
+        char *endptr = NULL;
+        long interval = strtol(rotate_s_raw, &endptr, 10);
+        if (rotate_s_raw[0] == 0 || *endptr != '\0' || interval < 0 ||
+            interval > OLED_ROTATE_MAX_S) {
+            interval = UINT16_MAX;
+        }
+        rotation.interval_s = (uint16_t)interval;
+    }
+
     bool previous_display_enabled = oled_is_enabled();
+    oled_rotation_t previous_rotation;
+    oled_get_rotation(&previous_rotation);
+    uint16_t previous_history_minutes = oled_get_history_minutes();
     esp_err_t err = oled_set_enabled(display_enabled);
     if (err == ESP_OK) {
-        err = mqtt_telemetry_set_config(broker_auto, broker_host, root_topic);
+        err = oled_set_rotation(&rotation);
+    }
+    if (err == ESP_OK) {
+        err = oled_set_history_minutes(history_minutes);
+    }
+    if (err == ESP_OK) {
+        err = mqtt_telemetry_set_config(&mqtt_config);
     }
     if (err != ESP_OK) {
         if (oled_is_enabled() != previous_display_enabled) {
             oled_set_enabled(previous_display_enabled);
         }
+        oled_get_rotation(&rotation);
+        if (rotation.pages != previous_rotation.pages ||
+            rotation.interval_s != previous_rotation.interval_s) {
+            oled_set_rotation(&previous_rotation);
+        }
+        if (oled_get_history_minutes() != previous_history_minutes) {
+            oled_set_history_minutes(previous_history_minutes);
+        }
         ESP_LOGE(TAG, "Failed to apply MQTT/display configuration: %s",
                  esp_err_to_name(err));
         httpd_resp_send_err(
             req, err == ESP_ERR_INVALID_ARG ? HTTPD_400_BAD_REQUEST
                                             : HTTPD_500_INTERNAL_SERVER_ERROR,
             err == ESP_ERR_INVALID_ARG
-                ? "Select automatic PPP-peer mode or enter a valid IPv4 override; the root may contain only letters, digits, '.', '_' or '-'"
+                ? "Select automatic PPP-peer mode or enter a valid IPv4 override; the root may contain only letters, digits, '.', '_' or '-'; the power subtopic may also contain inner '/' and the JSON path must be dot-separated keys; bridge filters must be comma-separated MQTT filters; the self-telemetry interval must be 0 or 10-3600 s and the deadband 0-100 %; the OLED rotation must be 0 or 3-3600 s per page and the graph span 10-1440 minutes"
                 : "MQTT/display configuration was not saved");
         return ESP_FAIL;
     }
 
-    ESP_LOGI(TAG, "MQTT/display config changed: broker=%s%s:%d root=%s OLED=%s",
-             broker_auto ? "PPP peer" : broker_host,
-             broker_auto ? " (automatic)" : "", MQTT_TELEMETRY_PORT, root_topic,
-             display_enabled ? "on" : "off");
+    ESP_LOGI(TAG, "MQTT/display config changed: broker=%s%s:%d root=%s "
+             "telemetry=%us/%u%% mqtt%s%s%s OLED=%s rotation=0x%lx/%us",
+             mqtt_config.broker_auto ? "PPP peer" : mqtt_config.broker_host,
+             mqtt_config.broker_auto ? " (automatic)" : "", MQTT_TELEMETRY_PORT,
+             mqtt_config.root_topic, mqtt_config.telemetry_interval_s,
+             mqtt_config.telemetry_deadband_pct,
+             mqtt_config.protocol_v5 ? "5" : "3.1.1",
+             mqtt_config.persistent_session ? " persistent" : "",
+             mqtt_config.local_broker ? " local-broker" : "",
+             display_enabled ? "on" : "off",
+             (unsigned long)rotation.pages, rotation.interval_s);
     httpd_resp_set_status(req, "303 See Other");
     httpd_resp_set_hdr(req, "Location", "/");
     httpd_resp_send(req, NULL, 0);
@@ -965,6 +1707,175 @@ static esp_err_t oled_debug_post_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+static esp_err_t wifi_survey_get_handler(httpd_req_t *req)
+{
+    survey_table_t *survey = malloc(sizeof(*survey));
+    channel_select_ap_t *aps = malloc(SURVEY_MAX_APS * sizeof(*aps));
+    const size_t page_len = 4096;
+    char *page = malloc(page_len);
+    if (!survey || !aps || !page) {
+        free(survey);
+        free(aps);
+        free(page);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    wifi_survey_get(survey);
+    wifi_survey_stats_t stats;
+    wifi_survey_get_stats(&stats);
+    uint32_t now_s = (uint32_t)(esp_timer_get_time() / 1000000);
+
+    uint32_t scores[CHANNEL_SELECT_CANDIDATES];
+    size_t ap_count = survey_table_export(survey, aps, SURVEY_MAX_APS);
+    uint8_t best = channel_select_choose(aps, ap_count, 0, 0, scores);
+    char scores_json[96] = "null";
+    if (survey_table_complete(survey)) {
+        snprintf(scores_json, sizeof(scores_json),
+                 "{\"1\":%lu,\"6\":%lu,\"11\":%lu,\"best\":%u}",
+                 (unsigned long)scores[0], (unsigned long)scores[1],
+                 (unsigned long)scores[2], best);
+    }
+
+    uint16_t airtime[SURVEY_CHANNELS];
+    char airtime_scores[256] = "null";
+    if (survey_table_airtime(survey, airtime)) {
+        uint32_t all[CHANNEL_SELECT_CHANNELS];
+        uint8_t pick = channel_select_choose_airtime(aps, ap_count, airtime,
+                                                     0, 0, all);
+        size_t used = 0;
+        for (size_t c = 0; c < CHANNEL_SELECT_CHANNELS; c++) {
+            used += (size_t)snprintf(airtime_scores + used,
+                                     sizeof(airtime_scores) - used,
+                                     "%s\"%u\":%lu", c ? "," : "{",
+                                     (unsigned)(c + 1),
+                                     (unsigned long)all[c]);
+        }
+        snprintf(airtime_scores + used, sizeof(airtime_scores) - used,
+                 ",\"best\":%u}", pick);
+    }
+
+    int len = snprintf(page, page_len,
+             "{\"complete\":%s,\"sweeps\":%lu,\"dwells\":%lu,"
+             "\"step_s\":%u,\"dwell_ms\":[%u,%u],\"last_dwell_us\":%lu,"
+             "\"dwell_failures\":%lu,\"skipped_steps\":%lu,"
+             "\"aps\":%u,\"dropped_aps\":%lu,\"scores\":%s,"
+             "\"airtime\":{\"enabled\":%s,\"window_ms\":%u,"
+             "\"windows\":%lu,\"failures\":%lu,\"busy_skips\":%lu,"
+             "\"off_channel_ms\":%llu,\"rx_frames\":%lu,"
+             "\"rx_cycles_avg\":%lu,\"scores\":%s},"
+             "\"channels\":[",
+             survey_table_complete(survey) ? "true" : "false",
+             (unsigned long)survey->sweeps, (unsigned long)survey->dwells,
+             WIFI_SURVEY_STEP_MS / 1000, WIFI_SURVEY_DWELL_MIN_MS,
+             WIFI_SURVEY_DWELL_MAX_MS, (unsigned long)stats.last_dwell_us,
+             (unsigned long)stats.dwell_failures,
+             (unsigned long)stats.skipped_steps, survey->ap_count,
+             (unsigned long)survey->dropped_aps, scores_json,
+             wifi_survey_get_airtime_enabled() ? "true" : "false",
+             WIFI_SURVEY_AIRTIME_MS, (unsigned long)stats.airtime_windows,
+             (unsigned long)stats.airtime_failures,
+             (unsigned long)stats.airtime_busy_skips,
+             (unsigned long long)stats.airtime_off_channel_ms,
+             (unsigned long)stats.rx_frames,
+             (unsigned long)stats.rx_cycles_avg, airtime_scores);
+    for (size_t c = 0; c < SURVEY_CHANNELS && len > 0 && (size_t)len < page_len; c++) {
+        const survey_channel_t *ch = &survey->ch[c];
+        char age[16] = "null";
+        char strongest[8] = "null";
+        char permille[8] = "null";
+        if (airtime[c] != CHANNEL_SELECT_NO_AIRTIME) {
+            snprintf(permille, sizeof(permille), "%u", airtime[c]);
+        }
+        if (ch->dwells > 0) {
+            snprintf(age, sizeof(age), "%lu",
+                     (unsigned long)(now_s - ch->last_dwell_s));
+        }
+        if (ch->strongest != INT8_MIN) {
+            snprintf(strongest, sizeof(strongest), "%d", ch->strongest);
+        }
+        len += snprintf(page + len, page_len - len,
+                        "%s{\"channel\":%u,\"dwells\":%lu,\"age_s\":%s,"
+                        "\"listen_ms\":%lu,\"aps\":%u,\"aps_avg\":%u.%u,"
+                        "\"strongest\":%s,\"airtime_permille\":%s,"
+                        "\"airtime_windows\":%lu,\"frames\":%lu}",
+                        c ? "," : "", (unsigned)(c + 1),
+                        (unsigned long)ch->dwells, age,
+                        (unsigned long)ch->dwell_ms, ch->aps,
+                        ch->aps_avg_q4 / 16, (ch->aps_avg_q4 % 16) * 10 / 16,
+                        strongest, permille,
+                        (unsigned long)ch->airtime_windows,
+                        (unsigned long)ch->airtime_frames);
+    }
+    if (len > 0 && (size_t)len < page_len) {
+        strlcat(page, "]}", page_len);
+    }
+    free(survey);
+    free(aps);
+
+    httpd_resp_set_type(req, "application/json");
+    esp_err_t err = httpd_resp_send(req, page, HTTPD_RESP_USE_STRLEN);
+    free(page);
+    return err;
+}
+
+/* Recorded scans as text, for tools/channel_sim.c. */
+static esp_err_t send_scan_trace(httpd_req_t *req)
+{
+    scan_trace_t *trace = malloc(sizeof(*trace));
+    if (!trace) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    ap_get_scan_trace(trace);
+
+    httpd_resp_set_type(req, "text/plain");
+    httpd_resp_sendstr_chunk(req, "# S,seq,uptime_s,ap_channel,aps_seen\n"
+                                  "# U,channel,airtime_permille\n"
+                                  "# A,bssid,primary,second,rssi\n");
+    char line[SCAN_TRACE_LINE_MAX];
+    esp_err_t err = ESP_OK;
+    for (size_t i = 0; err == ESP_OK && i < trace->count; i++) {
+        const scan_trace_scan_t *scan = scan_trace_get(trace, i);
+        scan_trace_format_scan(line, sizeof(line), scan);
+        err = httpd_resp_sendstr_chunk(req, line);
+        for (uint8_t c = 1; err == ESP_OK && c <= SCAN_TRACE_CHANNELS; c++) {
+            if (scan_trace_format_airtime(line, sizeof(line), scan, c) > 0) {
+                err = httpd_resp_sendstr_chunk(req, line);
+            }
+        }
+        for (size_t a = 0; err == ESP_OK && a < scan->count; a++) {
+            scan_trace_format_ap(line, sizeof(line), &scan->ap[a]);
+            err = httpd_resp_sendstr_chunk(req, line);
+        }
+    }
+    free(trace);
+    if (err == ESP_OK) {
+        err = httpd_resp_sendstr_chunk(req, NULL);
+    }
+    return err;
+}
+
+static esp_err_t debug_scans_get_handler(httpd_req_t *req)
+{
+    if (!web_admin_authorized(req)) {
+        return ESP_OK;
+    }
+    return send_scan_trace(req);
+}
+
+static esp_err_t debug_scans_post_handler(httpd_req_t *req)
+{
+    if (!web_admin_authorized(req)) {
+        return ESP_OK;
+    }
+
+    uint32_t id = 0;
+    if (!submit_job(req, "scan", scan_job, NULL, &id)) {
+        return ESP_FAIL;
+    }
+    return send_job_accepted(req, id);
+}
+
 static esp_err_t ota_post_handler(httpd_req_t *req)
 {
     if (!web_admin_authorized(req)) {
@@ -986,6 +1897,8 @@ static esp_err_t ota_post_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
 
+    /* Pending settings go out before the partition erase and upload. */
+    config_store_flush();
     esp_ota_handle_t ota_handle = 0;
     esp_err_t err = esp_ota_begin(update_partition, OTA_SIZE_UNKNOWN, &ota_handle);
     if (err != ESP_OK) {
@@ -1023,25 +1936,26 @@ static esp_err_t ota_post_handler(httpd_req_t *req)
         }
     }
 
-    err = esp_ota_end(ota_handle);
-    if (err != ESP_OK) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA end failed");
+    /* Verifying the image reads it back from flash; that and the reboot
+     * run on the jobs worker. */
+    set_ota_state(true, 100);
+    ota_finalize_job_t *job = malloc(sizeof(*job));
+    if (!job) {
+        esp_ota_abort(ota_handle);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
         set_ota_state(false, -1);
         return ESP_FAIL;
     }
-
-    err = esp_ota_set_boot_partition(update_partition);
-    if (err != ESP_OK) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA set boot partition failed");
+    job->handle = ota_handle;
+    job->partition = update_partition;
+    uint32_t id = 0;
+    if (jobs_submit("ota_finalize", ota_finalize_job, job, &id) != ESP_OK) {
+        esp_ota_abort(ota_handle);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "OTA finalize not queued");
         set_ota_state(false, -1);
         return ESP_FAIL;
     }
-
-    set_ota_state(true, 100);
-    httpd_resp_sendstr(req, "OK");
-    vTaskDelay(pdMS_TO_TICKS(500));
-    esp_restart();
-    return ESP_OK;
+    return send_job_accepted(req, id);
 }
 
 /* --------------------------------------------------------------------------
@@ -1072,6 +1986,8 @@ esp_err_t web_server_start(void)
     config.send_wait_timeout = 15;
     config.lru_purge_enable = true;
     config.keep_alive_enable = false;
+    config.max_uri_handlers = 12;
+    config.uri_match_fn = httpd_uri_match_wildcard;
 
     esp_err_t err = httpd_start(&s_httpd, &config);
     if (err != ESP_OK) {
@@ -1133,6 +2049,51 @@ esp_err_t web_server_start(void)
     err = httpd_register_uri_handler(s_httpd, &status_all);
     if (err != ESP_OK) goto register_failed;
 
+    httpd_uri_t wifi_survey = {
+        .uri      = "/wifi/survey",
+        .method   = HTTP_GET,
+        .handler  = wifi_survey_get_handler,
+        .user_ctx = NULL
+    };
+    err = httpd_register_uri_handler(s_httpd, &wifi_survey);
+    if (err != ESP_OK) goto register_failed;
+
+    httpd_uri_t debug_scans_get = {
+        .uri      = "/debug/scans",
+        .method   = HTTP_GET,
+        .handler  = debug_scans_get_handler,
+        .user_ctx = NULL
+    };
+    err = httpd_register_uri_handler(s_httpd, &debug_scans_get);
+    if (err != ESP_OK) goto register_failed;
+
+    httpd_uri_t debug_scans_post = {
+        .uri      = "/debug/scans",
+        .method   = HTTP_POST,
+        .handler  = debug_scans_post_handler,
+        .user_ctx = NULL
+    };
+    err = httpd_register_uri_handler(s_httpd, &debug_scans_post);
+    if (err != ESP_OK) goto register_failed;
+
+    httpd_uri_t jobs = {
+        .uri      = "/jobs/*",
+        .method   = HTTP_GET,
+        .handler  = jobs_get_handler,
+        .user_ctx = NULL
+    };
+    err = httpd_register_uri_handler(s_httpd, &jobs);
+    if (err != ESP_OK) goto register_failed;
+
+    httpd_uri_t status_boot = {
+        .uri      = "/status/boot",
+        .method   = HTTP_GET,
+        .handler  = status_boot_handler,
+        .user_ctx = NULL
+    };
+    err = httpd_register_uri_handler(s_httpd, &status_boot);
+    if (err != ESP_OK) goto register_failed;
+
     ESP_LOGI(TAG, "Webserver started on http://%s/", AP_IP_ADDR);
     xSemaphoreGive(s_server_mutex);
     return ESP_OK;
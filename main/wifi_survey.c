@@ -0,0 +1,349 @@
+/*
+ * PPP-over-USB + WiFi SoftAP Router (ESP32-C3)
+ *
+ * Incremental background channel survey.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "wifi_survey.h"
+
+#include <string.h>
+#include <stdatomic.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_event.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+
+#include "ap_config.h"
+#include "client_rssi.h"
+#include "config_store.h"
+#include "web_server.h"
+
+static const char *TAG = "wifi_survey";
+
+#define SURVEY_MAX_RECORDS 24
+#define SURVEY_SCAN_TIMEOUT_MS 1000
+
+/* Only the survey task writes s_table; publishing works as in
+ * client_rssi.c, so a reader never waits for a dwell. */
+static survey_table_t s_table;
+static survey_table_t s_published_buf[2];
+static atomic_uint s_published;
+static SemaphoreHandle_t s_scanner = NULL;
+static TaskHandle_t s_task = NULL;
+static atomic_bool s_dwell_active;
+static wifi_ap_record_t s_records[SURVEY_MAX_RECORDS];
+static wifi_survey_stats_t s_stats;
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static atomic_bool s_airtime_enabled;
+
+/* Written by the rx callback in the Wi-Fi task during a window only. */
+static atomic_uint s_rx_busy_us;
+static atomic_uint s_rx_frames;
+static uint64_t s_rx_cycles = 0;
+static uint64_t s_rx_calls = 0;
+
+static void publish_table(void)
+{
+    unsigned next = atomic_load_explicit(&s_published,
+                                         memory_order_relaxed) + 1;
+    s_published_buf[next & 1] = s_table;
+    atomic_store_explicit(&s_published, next, memory_order_release);
+}
+
+static void scan_done_handler(void *arg, esp_event_base_t base,
+                              int32_t id, void *data)
+{
+    (void)arg;
+    (void)base;
+    (void)id;
+    (void)data;
+    /* Blocking scans by other code also end here; only wake for our own. */
+    if (atomic_load(&s_dwell_active) && s_task) {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+/* Caller holds s_scanner. */
+static esp_err_t survey_dwell(uint8_t channel)
+{
+    wifi_mode_t mode;
+    esp_err_t err = esp_wifi_get_mode(&mode);
+    if (err != ESP_OK) return err;
+    /* Scanning needs the STA interface. It stays enabled (and unconnected),
+     * so later dwells do not change the mode under the running SoftAP. */
+    if (mode == WIFI_MODE_AP) {
+        err = esp_wifi_set_mode(WIFI_MODE_APSTA);
+        if (err != ESP_OK) return err;
+    }
+
+    wifi_scan_config_t config = {
+        .channel = channel,
+        .show_hidden = true,
+        .scan_type = WIFI_SCAN_TYPE_ACTIVE,
+        .scan_time.active = {
+            .min = WIFI_SURVEY_DWELL_MIN_MS,
+            .max = WIFI_SURVEY_DWELL_MAX_MS,
+        },
+    };
+    ulTaskNotifyTake(pdTRUE, 0);
+    atomic_store(&s_dwell_active, true);
+    int64_t started = esp_timer_get_time();
+    err = esp_wifi_scan_start(&config, false);
+    if (err == ESP_OK &&
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SURVEY_SCAN_TIMEOUT_MS)) == 0) {
+        esp_wifi_scan_stop();
+        err = ESP_ERR_TIMEOUT;
+    }
+    atomic_store(&s_dwell_active, false);
+    if (err != ESP_OK) return err;
+    uint32_t dwell_us = (uint32_t)(esp_timer_get_time() - started);
+
+    uint16_t count = SURVEY_MAX_RECORDS;
+    err = esp_wifi_scan_get_ap_records(&count, s_records);
+    if (err != ESP_OK) {
+        esp_wifi_clear_ap_list();
+        return err;
+    }
+
+    survey_seen_t seen[SURVEY_MAX_RECORDS];
+    for (uint16_t i = 0; i < count; i++) {
+        memcpy(seen[i].bssid, s_records[i].bssid, 6);
+        seen[i].primary = s_records[i].primary;
+        seen[i].rssi = s_records[i].rssi;
+    }
+    survey_table_record(&s_table, channel, seen, count,
+                        (uint32_t)(esp_timer_get_time() / 1000000),
+                        dwell_us / 1000);
+    publish_table();
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.last_dwell_us = dwell_us;
+    portEXIT_CRITICAL(&s_stats_lock);
+    return ESP_OK;
+}
+
+/* Runs in the Wi-Fi driver task for every frame heard: keep it short. */
+static void airtime_rx(void *buf, wifi_promiscuous_pkt_type_t type)
+{
+    uint32_t started = esp_cpu_get_cycle_count();
+    (void)type;
+    const wifi_pkt_rx_ctrl_t *rx = &((const wifi_promiscuous_pkt_t *)buf)->rx_ctrl;
+    bool ht = rx->sig_mode != 0;
+    uint32_t us = channel_select_frame_airtime_us(
+        ht, (uint8_t)(ht ? rx->mcs : rx->rate), rx->cwb, rx->sgi,
+        (uint16_t)rx->sig_len);
+    atomic_fetch_add_explicit(&s_rx_busy_us, us, memory_order_relaxed);
+    atomic_fetch_add_explicit(&s_rx_frames, 1, memory_order_relaxed);
+    uint32_t cycles = esp_cpu_get_cycle_count() - started;
+    portENTER_CRITICAL(&s_stats_lock);
+    s_rx_cycles += cycles;
+    s_rx_calls++;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+/* Caller holds s_scanner and has checked that no station is associated. */
+static esp_err_t measure_airtime(uint8_t channel)
+{
+    uint8_t home = 0;
+    wifi_second_chan_t second = WIFI_SECOND_CHAN_NONE;
+    esp_err_t err = esp_wifi_get_channel(&home, &second);
+    if (err != ESP_OK) return err;
+
+    wifi_promiscuous_filter_t filter = {
+        .filter_mask = WIFI_PROMIS_FILTER_MASK_ALL,
+    };
+    err = esp_wifi_set_promiscuous_filter(&filter);
+    if (err == ESP_OK) err = esp_wifi_set_promiscuous_rx_cb(airtime_rx);
+    if (err != ESP_OK) return err;
+
+    atomic_store(&s_rx_busy_us, 0);
+    atomic_store(&s_rx_frames, 0);
+    int64_t left = esp_timer_get_time();
+    if (channel != home) {
+        err = esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+        if (err != ESP_OK) return err;
+    }
+    int64_t started = esp_timer_get_time();
+    err = esp_wifi_set_promiscuous(true);
+    if (err == ESP_OK) {
+        vTaskDelay(pdMS_TO_TICKS(WIFI_SURVEY_AIRTIME_MS));
+        esp_wifi_set_promiscuous(false);
+    }
+    int64_t stopped = esp_timer_get_time();
+    if (channel != home) {
+        esp_err_t back = esp_wifi_set_channel(home, second);
+        if (back != ESP_OK) {
+            ESP_LOGE(TAG, "Cannot return to channel %u: %s", home,
+                     esp_err_to_name(back));
+        }
+    }
+    int64_t returned = esp_timer_get_time();
+    if (err != ESP_OK) return err;
+
+    uint32_t frames = atomic_load(&s_rx_frames);
+    survey_table_record_airtime(&s_table, channel, atomic_load(&s_rx_busy_us),
+                                (uint32_t)(stopped - started), frames);
+    publish_table();
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.airtime_windows++;
+    s_stats.rx_frames += frames;
+    if (channel != home) {
+        s_stats.airtime_off_channel_ms += (uint64_t)(returned - left) / 1000;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+    return ESP_OK;
+}
+
+/* A window on every step that finds the AP idle, on the channel just
+ * dwelled on. */
+static void maybe_measure_airtime(uint8_t channel)
+{
+    if (!atomic_load(&s_airtime_enabled)) return;
+    if (client_rssi_get_count() > 0) {
+        portENTER_CRITICAL(&s_stats_lock);
+        s_stats.airtime_busy_skips++;
+        portEXIT_CRITICAL(&s_stats_lock);
+        return;
+    }
+    esp_err_t err = measure_airtime(channel);
+    if (err != ESP_OK) {
+        portENTER_CRITICAL(&s_stats_lock);
+        s_stats.airtime_failures++;
+        portEXIT_CRITICAL(&s_stats_lock);
+        ESP_LOGW(TAG, "Airtime window on channel %u failed: %s", channel,
+                 esp_err_to_name(err));
+    }
+}
+
+static void count_skip(bool failure)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    if (failure) {
+        s_stats.dwell_failures++;
+    } else {
+        s_stats.skipped_steps++;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+static void survey_task(void *arg)
+{
+    (void)arg;
+    uint8_t channel = 1;
+    esp_err_t last_err = ESP_OK;
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(WIFI_SURVEY_STEP_MS));
+        if (!ap_is_running() || web_server_is_ota_in_progress() ||
+            !wifi_survey_take_scanner(0)) {
+            count_skip(false);
+            continue;
+        }
+        esp_err_t err = survey_dwell(channel);
+        if (err == ESP_OK) maybe_measure_airtime(channel);
+        wifi_survey_give_scanner();
+
+        if (err != ESP_OK) {
+            count_skip(true);
+            if (err != last_err) {
+                ESP_LOGW(TAG, "Dwell on channel %u failed: %s", channel,
+                         esp_err_to_name(err));
+            }
+        } else {
+            if (last_err != ESP_OK) {
+                ESP_LOGI(TAG, "Survey dwells work again");
+            }
+            channel = channel % SURVEY_CHANNELS + 1;
+        }
+        last_err = err;
+    }
+}
+
+esp_err_t wifi_survey_start(void)
+{
+    if (s_task) return ESP_OK;
+
+    s_scanner = xSemaphoreCreateMutex();
+    if (!s_scanner) return ESP_ERR_NO_MEM;
+
+    config_survey_t stored;
+    config_store_get_survey(&stored);
+    bool airtime = stored.airtime != 0;
+    atomic_store(&s_airtime_enabled, airtime);
+    survey_table_init(&s_table);
+    publish_table();
+
+    esp_err_t err = esp_event_handler_register(
+        WIFI_EVENT, WIFI_EVENT_SCAN_DONE, &scan_done_handler, NULL);
+    if (err != ESP_OK) return err;
+
+    if (xTaskCreate(survey_task, "wifi_survey", 3072, NULL, 2,
+                    &s_task) != pdPASS) {
+        esp_event_handler_unregister(WIFI_EVENT, WIFI_EVENT_SCAN_DONE,
+                                     &scan_done_handler);
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Surveying one channel every %u s%s",
+             WIFI_SURVEY_STEP_MS / 1000,
+             airtime ? ", measuring airtime when idle" : "");
+    return ESP_OK;
+}
+
+void wifi_survey_get(survey_table_t *out)
+{
+    for (;;) {
+        unsigned seq = atomic_load_explicit(&s_published,
+                                            memory_order_acquire);
+        *out = s_published_buf[seq & 1];
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&s_published, memory_order_relaxed) == seq) {
+            return;
+        }
+    }
+}
+
+void wifi_survey_get_stats(wifi_survey_stats_t *out)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    *out = s_stats;
+    out->rx_cycles_avg = s_rx_calls ? (uint32_t)(s_rx_cycles / s_rx_calls) : 0;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+bool wifi_survey_get_airtime_enabled(void)
+{
+    return atomic_load(&s_airtime_enabled);
+}
+
+esp_err_t wifi_survey_set_airtime_enabled(bool enabled)
+{
+    config_survey_t stored;
+    config_store_get_survey(&stored);
+    stored.airtime = enabled ? 1 : 0;
+    esp_err_t err = config_store_set_survey(&stored);
+    if (err != ESP_OK) return err;
+
+    if (atomic_exchange(&s_airtime_enabled, enabled) != enabled) {
+        ESP_LOGI(TAG, "Airtime measurement %s", enabled ? "on" : "off");
+    }
+    return ESP_OK;
+}
+
+bool wifi_survey_take_scanner(TickType_t wait)
+{
+    /* Before the survey starts nobody else can be scanning. */
+    return !s_scanner || xSemaphoreTake(s_scanner, wait) == pdTRUE;
+}
+
+void wifi_survey_give_scanner(void)
+{
+    if (s_scanner) xSemaphoreGive(s_scanner);
+}
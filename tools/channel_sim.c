@@ -0,0 +1,390 @@
+// channel_sim.c
+// Replays recorded channel scans through main/channel_select.c, the same
+// scoring the firmware uses for automatic channel selection.
+//
+// Record scans on the device (admin password required):
+//   curl -u admin:<ap password> http://192.168.4.1/debug/scans > trace.txt
+//   curl -u admin:<ap password> -X POST http://192.168.4.1/debug/scans
+// GET returns the last scans kept in RAM; POST queues a scan that does not
+// change the channel and returns its job id (poll /jobs/<id>, then GET
+// again). Several files are
+// replayed in the given order as one trace, so traces saved over days can
+// be combined.
+//
+// For every scan the simulator prints the scores and the channel the
+// algorithm would pick, starting on the channel the AP had in the first
+// scan. The summary reports switches, how long each channel was kept, how
+// many of the visible BSSIDs were also seen in the previous scan, and the
+// predicted interference: the score of the channel in use, averaged over the
+// scans, next to the best possible (a new choice every scan) and each fixed
+// channel. --sweep repeats the summary for hysteresis 0..50 %.
+//
+// Scans recorded with airtime measurement on carry the survey's airtime per
+// channel (U lines). --airtime replays them through the all-channel airtime
+// scoring instead, falling back to beacons for scans without airtime on
+// every channel, as the firmware does. --compare prints both side by side.
+// "load" is the airtime score of the channel in use, the measured occupancy
+// it shares with its neighbours, so the two can be judged by the same
+// yardstick; "us/pick" is the host CPU time per decision.
+//
+// Build and run from the repository root:
+//   cc -O2 -Wall -Imain/include tools/channel_sim.c main/channel_select.c main/scan_trace.c -o channel_sim
+//   ./channel_sim [--hysteresis PCT] [--sweep] [--airtime|--compare] [--quiet] trace.txt...
+
+#include "channel_select.h"
+#include "scan_trace.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_APS 256
+
+typedef struct {
+    scan_trace_scan_t header;
+    size_t count;
+    scan_trace_ap_t ap[MAX_APS];
+} sim_scan_t;
+
+typedef struct {
+    sim_scan_t *scans;
+    size_t count;
+    size_t capacity;
+} sim_trace_t;
+
+typedef struct {
+    size_t switches;
+    size_t longest_stay;   /* scans */
+    double stay_sum;
+    size_t stays;
+    double score_used;     /* summed over scans */
+    double score_best;
+    double score_fixed[CHANNEL_SELECT_CANDIDATES];
+    size_t agreements;     /* scans where the device was on the pick */
+    size_t load_scans;     /* scans with airtime on every channel */
+    double load_used;
+    double load_best;
+    double pick_seconds;
+} sim_result_t;
+
+static sim_scan_t *add_scan(sim_trace_t *trace)
+{
+    if (trace->count == trace->capacity) {
+        size_t capacity = trace->capacity ? trace->capacity * 2 : 64;
+        sim_scan_t *scans = realloc(trace->scans, capacity * sizeof(*scans));
+        if (!scans) {
+            fprintf(stderr, "out of memory\n");
+            exit(2);
+        }
+        trace->scans = scans;
+        trace->capacity = capacity;
+    }
+    sim_scan_t *scan = &trace->scans[trace->count++];
+    memset(scan, 0, sizeof(*scan));
+    return scan;
+}
+
+static bool load_trace(const char *path, sim_trace_t *trace)
+{
+    FILE *f = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return false;
+    }
+
+    char line[256];
+    unsigned line_no = 0;
+    sim_scan_t *scan = NULL;
+    scan_trace_scan_t header;
+    bool ok = true;
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        scan_trace_ap_t ap;
+        switch (scan_trace_parse_line(line, &header, &ap)) {
+        case SCAN_TRACE_LINE_SKIP:
+            break;
+        case SCAN_TRACE_LINE_SCAN:
+            scan = add_scan(trace);
+            scan->header = header;
+            break;
+        case SCAN_TRACE_LINE_AIRTIME:
+            if (!scan) {
+                fprintf(stderr, "%s:%u: airtime before the first scan\n",
+                        path, line_no);
+                ok = false;
+            } else {
+                memcpy(scan->header.airtime_permille, header.airtime_permille,
+                       sizeof(header.airtime_permille));
+            }
+            break;
+        case SCAN_TRACE_LINE_AP:
+            if (!scan) {
+                fprintf(stderr, "%s:%u: AP before the first scan\n", path,
+                        line_no);
+                ok = false;
+            } else if (scan->count < MAX_APS) {
+                scan->ap[scan->count++] = ap;
+            }
+            break;
+        case SCAN_TRACE_LINE_ERROR:
+            fprintf(stderr, "%s:%u: cannot parse: %s", path, line_no, line);
+            ok = false;
+            break;
+        }
+    }
+    if (f != stdin) fclose(f);
+    return ok;
+}
+
+static size_t candidate_index(uint8_t channel)
+{
+    for (size_t c = 0; c < CHANNEL_SELECT_CANDIDATES; c++) {
+        if (channel_select_candidates[c] == channel) return c;
+    }
+    return CHANNEL_SELECT_CANDIDATES;
+}
+
+/* Share of the BSSIDs in scan that were also in prev, in percent. */
+static unsigned bssid_overlap_pct(const sim_scan_t *prev,
+                                  const sim_scan_t *scan)
+{
+    if (scan->count == 0) return 100;
+    size_t common = 0;
+    for (size_t i = 0; i < scan->count; i++) {
+        for (size_t j = 0; j < prev->count; j++) {
+            if (memcmp(scan->ap[i].bssid, prev->ap[j].bssid, 6) == 0) {
+                common++;
+                break;
+            }
+        }
+    }
+    return (unsigned)(common * 100 / scan->count);
+}
+
+static double now_seconds(void)
+{
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+static bool has_airtime(const sim_scan_t *scan)
+{
+    for (size_t c = 0; c < SCAN_TRACE_CHANNELS; c++) {
+        if (scan->header.airtime_permille[c] == SCAN_TRACE_NO_AIRTIME) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void replay(const sim_trace_t *trace, unsigned hysteresis_pct,
+                   bool airtime, bool verbose, sim_result_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    uint8_t current = trace->scans[0].header.ap_channel;
+    size_t stay = 0;
+    channel_select_ap_t aps[MAX_APS];
+
+    if (verbose) {
+        printf("%6s %8s %4s %7s %7s %7s %7s %6s %6s %s\n", "seq",
+               "uptime_s", "aps", "ch1", "ch6", "ch11", "load", "device",
+               "pick", "seen_before");
+    }
+    for (size_t s = 0; s < trace->count; s++) {
+        const sim_scan_t *scan = &trace->scans[s];
+        for (size_t i = 0; i < scan->count; i++) {
+            aps[i] = (channel_select_ap_t) {
+                .primary = scan->ap[i].primary,
+                .rssi = scan->ap[i].rssi,
+            };
+        }
+
+        /* Like the firmware, the first scan after boot has no hysteresis. */
+        unsigned hysteresis = s == 0 ? 0 : hysteresis_pct;
+        bool measured = has_airtime(scan);
+        uint32_t scores[CHANNEL_SELECT_CANDIDATES];
+        uint32_t load[CHANNEL_SELECT_CHANNELS];
+        double started = now_seconds();
+        uint8_t pick = channel_select_choose(aps, scan->count, current,
+                                             hysteresis, scores);
+        if (airtime && measured) {
+            pick = channel_select_choose_airtime(
+                aps, scan->count, scan->header.airtime_permille, current,
+                hysteresis, load);
+        }
+        out->pick_seconds += now_seconds() - started;
+
+        uint32_t best = scores[0];
+        for (size_t c = 0; c < CHANNEL_SELECT_CANDIDATES; c++) {
+            if (scores[c] < best) best = scores[c];
+            out->score_fixed[c] += scores[c];
+        }
+        /* Airtime picks need not be 1, 6 or 11. */
+        size_t index = candidate_index(pick);
+        out->score_used += index < CHANNEL_SELECT_CANDIDATES
+            ? scores[index]
+            : channel_select_beacon_score(aps, scan->count, pick);
+        out->score_best += best;
+
+        char load_text[12] = "-";
+        if (measured) {
+            channel_select_choose_airtime(aps, scan->count,
+                                          scan->header.airtime_permille, 0,
+                                          0, load);
+            uint32_t load_best = load[0];
+            for (size_t c = 1; c < CHANNEL_SELECT_CHANNELS; c++) {
+                if (load[c] < load_best) load_best = load[c];
+            }
+            out->load_scans++;
+            out->load_used += load[pick - 1];
+            out->load_best += load_best;
+            snprintf(load_text, sizeof(load_text), "%" PRIu32, load[pick - 1]);
+        }
+        if (scan->header.ap_channel == pick) out->agreements++;
+
+        bool switched = s > 0 && pick != current;
+        if (switched) {
+            out->switches++;
+            out->stay_sum += (double)stay;
+            out->stays++;
+            stay = 0;
+        }
+        stay++;
+        if (stay > out->longest_stay) out->longest_stay = stay;
+        current = pick;
+
+        if (verbose) {
+            char seen[8] = "-";
+            if (s > 0) {
+                snprintf(seen, sizeof(seen), "%u%%",
+                         bssid_overlap_pct(&trace->scans[s - 1], scan));
+            }
+            printf("%6" PRIu32 " %8" PRIu32 " %4zu %7" PRIu32 " %7" PRIu32
+                   " %7" PRIu32 " %7s %6u %5u%s %s\n", scan->header.seq,
+                   scan->header.uptime_s, scan->count, scores[0], scores[1],
+                   scores[2], load_text, scan->header.ap_channel, pick,
+                   switched ? "*" : " ", seen);
+        }
+    }
+    out->stay_sum += (double)stay;
+    out->stays++;
+}
+
+static void print_summary_header(void)
+{
+    printf("%-7s %5s %8s %9s %8s %9s %9s %9s %7s %7s %7s %6s %7s %9s %7s\n",
+           "scoring", "hyst%", "switches", "mean_stay", "longest", "used",
+           "best", "regret%", "fix1", "fix6", "fix11", "agree%", "load",
+           "load_best", "us/pick");
+}
+
+static void print_summary(const sim_trace_t *trace, unsigned hysteresis_pct,
+                          bool airtime, const sim_result_t *r)
+{
+    double n = (double)trace->count;
+    double regret = r->score_best > 0
+        ? 100.0 * (r->score_used - r->score_best) / r->score_best : 0.0;
+    char load[16] = "-";
+    char load_best[16] = "-";
+    if (r->load_scans > 0) {
+        snprintf(load, sizeof(load), "%.0f",
+                 r->load_used / (double)r->load_scans);
+        snprintf(load_best, sizeof(load_best), "%.0f",
+                 r->load_best / (double)r->load_scans);
+    }
+    printf("%-7s %5u %8zu %9.1f %8zu %9.0f %9.0f %9.1f %7.0f %7.0f %7.0f "
+           "%6.0f %7s %9s %7.2f\n",
+           airtime ? "airtime" : "beacon", hysteresis_pct, r->switches,
+           r->stay_sum / (double)r->stays, r->longest_stay,
+           r->score_used / n, r->score_best / n, regret,
+           r->score_fixed[0] / n, r->score_fixed[1] / n,
+           r->score_fixed[2] / n, 100.0 * (double)r->agreements / n, load,
+           load_best, r->pick_seconds * 1e6 / n);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [--hysteresis PCT] [--sweep] "
+            "[--airtime|--compare] [--quiet] trace.txt... ('-' reads stdin)\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    unsigned hysteresis_pct = CHANNEL_SELECT_HYSTERESIS_PCT;
+    bool sweep = false;
+    bool quiet = false;
+    bool airtime = false;
+    bool compare = false;
+    sim_trace_t trace = {0};
+    int files = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--hysteresis") == 0 && i + 1 < argc) {
+            hysteresis_pct = (unsigned)strtoul(argv[++i], NULL, 10);
+            if (hysteresis_pct >= 100) {
+                fprintf(stderr, "hysteresis must be below 100\n");
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--sweep") == 0) {
+            sweep = true;
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "--airtime") == 0) {
+            airtime = true;
+        } else if (strcmp(argv[i], "--compare") == 0) {
+            compare = true;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            if (!load_trace(argv[i], &trace)) return 1;
+            files++;
+        }
+    }
+    if (files == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (trace.count == 0) {
+        fprintf(stderr, "no scans in the trace\n");
+        return 1;
+    }
+
+    size_t measured = 0;
+    for (size_t s = 0; s < trace.count; s++) {
+        if (has_airtime(&trace.scans[s])) measured++;
+    }
+    if ((airtime || compare) && measured == 0) {
+        fprintf(stderr, "warning: no scan has airtime on every channel; "
+                "airtime scoring falls back to beacons\n");
+    }
+
+    bool verbose = !quiet && !sweep && !compare;
+    sim_result_t result;
+    if (verbose) {
+        replay(&trace, hysteresis_pct, airtime, true, &result);
+        printf("\n");
+    }
+    printf("%zu scans, %zu with airtime; scores are predicted interference, "
+           "lower is better\n", trace.count, measured);
+    print_summary_header();
+    for (int mode = 0; mode < 2; mode++) {
+        bool use_airtime = mode == 1;
+        if (!compare && use_airtime != airtime) continue;
+        if (sweep) {
+            for (unsigned h = 0; h <= 50; h += 5) {
+                replay(&trace, h, use_airtime, false, &result);
+                print_summary(&trace, h, use_airtime, &result);
+            }
+        } else {
+            replay(&trace, hysteresis_pct, use_airtime, false, &result);
+            print_summary(&trace, hysteresis_pct, use_airtime, &result);
+        }
+    }
+    free(trace.scans);
+    return 0;
+}
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+# gen_digit_atlas.py
+# Generates digit_atlas.h, the prerendered large-digit glyphs for the OLED
+# power value. main/CMakeLists.txt runs it at build time; for host builds of
+# tools/oled_render.c run it by hand:
+#   python3 tools/gen_digit_atlas.py build/host/digit_atlas.h
+#
+# Glyphs are 7-segment style and stored in the SSD1306/u8g2 full-buffer
+# layout: column by column, DIGIT_ATLAS_PAGES bytes per column, bit 0 of the
+# first byte is the top row. oled_pages.c ORs the columns straight into the
+# u8g2 buffer, shifted to the target row.
+
+import os
+import sys
+
+HEIGHT = 20
+DIGIT_WIDTH = 11
+THICKNESS = 3
+SPACING = 2
+PAGES = (HEIGHT + 7) // 8
+MID = HEIGHT // 2
+
+# Segment rectangles as (x0, y0, x1, y1), inclusive.
+SEGMENTS = {
+    "a": (1, 0, DIGIT_WIDTH - 2, THICKNESS - 1),
+    "b": (DIGIT_WIDTH - THICKNESS, 1, DIGIT_WIDTH - 1, MID - 1),
+    "c": (DIGIT_WIDTH - THICKNESS, MID, DIGIT_WIDTH - 1, HEIGHT - 2),
+    "d": (1, HEIGHT - THICKNESS, DIGIT_WIDTH - 2, HEIGHT - 1),
+    "e": (0, MID, THICKNESS - 1, HEIGHT - 2),
+    "f": (0, 1, THICKNESS - 1, MID - 1),
+    "g": (1, MID - 1 - THICKNESS // 2, DIGIT_WIDTH - 2,
+          MID - 1 + THICKNESS - 1 - THICKNESS // 2),
+}
+
+DIGITS = {
+    "0": "abcdef", "1": "bc", "2": "abdeg", "3": "abcdg", "4": "bcfg",
+    "5": "acdfg", "6": "acdefg", "7": "abc", "8": "abcdefg", "9": "abcdfg",
+    "-": "g", " ": "",
+}
+
+
+def glyph(segments, width):
+    pixels = [[0] * width for _ in range(HEIGHT)]
+    for name in segments:
+        x0, y0, x1, y1 = SEGMENTS[name]
+        for y in range(y0, y1 + 1):
+            for x in range(x0, x1 + 1):
+                pixels[y][x] = 1
+    return pixels
+
+
+def dot():
+    pixels = [[0] * THICKNESS for _ in range(HEIGHT)]
+    for y in range(HEIGHT - THICKNESS, HEIGHT):
+        for x in range(THICKNESS):
+            pixels[y][x] = 1
+    return pixels
+
+
+def columns(pixels):
+    width = len(pixels[0])
+    out = []
+    for x in range(width):
+        for page in range(PAGES):
+            byte = 0
+            for bit in range(8):
+                y = page * 8 + bit
+                if y < HEIGHT and pixels[y][x]:
+                    byte |= 1 << bit
+            out.append(byte)
+    return out
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.stderr.write("usage: gen_digit_atlas.py OUTPUT.h\n")
+        return 2
+
+    glyphs = [(ch, glyph(DIGITS[ch], DIGIT_WIDTH)) for ch in "0123456789- "]
+    glyphs.append((".", dot()))
+
+    first = min(ord(ch) for ch, _ in glyphs)
+    last = max(ord(ch) for ch, _ in glyphs)
+    index = [0xFF] * (last - first + 1)
+    data = []
+    table = []
+    for i, (ch, pixels) in enumerate(glyphs):
+        index[ord(ch) - first] = i
+        table.append((ch, len(pixels[0]), len(data)))
+        data.extend(columns(pixels))
+
+    lines = [
+        "/* Generated by tools/gen_digit_atlas.py; do not edit. */",
+        "#pragma once",
+        "",
+        "#include <stdint.h>",
+        "",
+        "#define DIGIT_ATLAS_HEIGHT %d" % HEIGHT,
+        "#define DIGIT_ATLAS_PAGES %d" % PAGES,
+        "#define DIGIT_ATLAS_SPACING %d" % SPACING,
+        "#define DIGIT_ATLAS_FIRST %d" % first,
+        "#define DIGIT_ATLAS_LAST %d" % last,
+        "#define DIGIT_ATLAS_NONE 0xFF",
+        "",
+        "typedef struct {",
+        "    uint8_t width;",
+        "    uint16_t offset; /* into digit_atlas_bits */",
+        "} digit_atlas_glyph_t;",
+        "",
+        "/* Glyph per character from DIGIT_ATLAS_FIRST, DIGIT_ATLAS_NONE if absent. */",
+        "static const uint8_t digit_atlas_index[] = {",
+    ]
+    for start in range(0, len(index), 12):
+        lines.append("    " + ", ".join("0x%02X" % v for v in index[start:start + 12]) + ",")
+    lines += ["};", "", "static const digit_atlas_glyph_t digit_atlas_glyphs[] = {"]
+    for ch, width, offset in table:
+        lines.append("    {%d, %d}, /* '%s' */" % (width, offset, ch))
+    lines += ["};", "", "static const uint8_t digit_atlas_bits[] = {"]
+    for start in range(0, len(data), 12):
+        lines.append("    " + ", ".join("0x%02X" % v for v in data[start:start + 12]) + ",")
+    lines += ["};", ""]
+
+    directory = os.path.dirname(sys.argv[1])
+    if directory:
+        os.makedirs(directory, exist_ok=True)
+    with open(sys.argv[1], "w") as f:
+        f.write("\n".join(lines))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
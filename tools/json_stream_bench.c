@@ -0,0 +1,150 @@
+// json_stream_bench.c
+// Host benchmark for main/json_stream.c, the streaming MQTT payload extractor.
+//
+// Generates Tasmota/OpenBeken-style documents of growing size on the fly,
+// feeds them to the extractor in pseudo-random chunks of 1..1024 bytes (the
+// range ESP-MQTT uses for MQTT_EVENT_DATA fragments), and reports throughput
+// and memory. Neither the generator nor the extractor keeps the document, so
+// the extractor state and peak RSS stay flat while the payload grows.
+//
+// Build and run from the repository root:
+//   cc -O2 -Wall -Imain/include tools/json_stream_bench.c main/json_stream.c -o json_stream_bench
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "json_stream.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#define CHUNK_MAX 1024
+
+static const char HEADER[] =
+    "{\"Time\":\"2026-10-16T12:00:00\",\"ENERGY\":{\"History\":[";
+/* Decoys: same key names inside arrays and under other objects. */
+static const char ELEMENT[] =
+    "{\"Power\":999,\"Name\":\"pad \\\"quoted\\\"\",\"V\":[1,2.5,-3e2,true,null]}";
+static const char TRAILER[] =
+    "],\"Other\":{\"Power\":-1},\"Power\":1234.5,\"Voltage\":231}}";
+
+/* Streams HEADER, count comma-separated ELEMENTs, and TRAILER. */
+typedef struct {
+    uint64_t count;
+    uint64_t emitted;
+    size_t pos;
+    int part; /* 0 header, 1 elements, 2 trailer, 3 done */
+} generator_t;
+
+static size_t generate(generator_t *g, char *out, size_t cap)
+{
+    size_t n = 0;
+    while (n < cap && g->part < 3) {
+        const char *src;
+        size_t src_len;
+        if (g->part == 0) {
+            src = HEADER;
+            src_len = sizeof(HEADER) - 1;
+        } else if (g->part == 2) {
+            src = TRAILER;
+            src_len = sizeof(TRAILER) - 1;
+        } else if (g->emitted == g->count) {
+            g->part = 2;
+            g->pos = 0;
+            continue;
+        } else if (g->pos == 0 && g->emitted > 0) {
+            out[n++] = ',';
+            g->pos = SIZE_MAX; /* separator written */
+            continue;
+        } else {
+            src = ELEMENT;
+            src_len = sizeof(ELEMENT) - 1;
+        }
+        size_t from = g->pos == SIZE_MAX ? 0 : g->pos;
+        size_t copy = src_len - from;
+        if (copy > cap - n) copy = cap - n;
+        memcpy(out + n, src + from, copy);
+        n += copy;
+        from += copy;
+        if (from < src_len) {
+            g->pos = from;
+        } else {
+            g->pos = 0;
+            if (g->part == 1) {
+                g->emitted++;
+            } else {
+                g->part++;
+            }
+        }
+    }
+    return n;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static long peak_rss_kb(void)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+int main(void)
+{
+    static const char *const paths[] = {"ENERGY.Power", "ENERGY.Voltage"};
+    static const uint64_t element_counts[] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000,
+    };
+    char chunk[CHUNK_MAX];
+    json_stream_t js;
+    int failures = 0;
+
+    if (!json_stream_init(&js, paths, 2)) {
+        fprintf(stderr, "invalid paths\n");
+        return 1;
+    }
+    printf("extractor state: %zu bytes\n", sizeof(js));
+    printf("%12s %8s %9s %9s %9s %8s %s\n", "bytes", "chunks", "ms",
+           "MB/s", "rss KB", "ok", "ENERGY.Power / Voltage");
+
+    for (size_t i = 0; i < sizeof(element_counts) / sizeof(element_counts[0]); i++) {
+        generator_t gen = {.count = element_counts[i]};
+        uint32_t seed = 12345;
+        uint64_t bytes = 0;
+        uint64_t chunks = 0;
+        json_stream_reset(&js);
+
+        double start = now_seconds();
+        for (;;) {
+            seed = seed * 1103515245u + 12345u;
+            size_t want = 1 + (seed >> 16) % CHUNK_MAX;
+            size_t n = generate(&gen, chunk, want);
+            if (n == 0) break;
+            json_stream_feed(&js, chunk, n);
+            bytes += n;
+            chunks++;
+        }
+        double elapsed = now_seconds() - start;
+
+        const char *power = json_stream_value(&js, 0);
+        const char *voltage = json_stream_value(&js, 1);
+        bool ok = json_stream_complete(&js) && power && voltage &&
+                  strcmp(power, "1234.5") == 0 && strcmp(voltage, "231") == 0;
+        if (!ok) failures++;
+        printf("%12llu %8llu %9.2f %9.1f %9ld %8s %s / %s\n",
+               (unsigned long long)bytes, (unsigned long long)chunks,
+               elapsed * 1000.0,
+               elapsed > 0 ? (double)bytes / elapsed / 1e6 : 0.0,
+               peak_rss_kb(), ok ? "yes" : "NO",
+               power ? power : "-", voltage ? voltage : "-");
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,108 @@
+// mqtt_broker_host.c
+// Runs the SoftAP broker and bridge from main/mqtt_broker.c on the host so it
+// can be exercised with ordinary MQTT clients such as mosquitto_pub/_sub.
+//
+// Local deliveries (what the firmware feeds to its display) are printed as
+// "local", and bridge output (what would cross the PPP link) as "upstream".
+// Ctrl-C flushes the bridge and prints the counters.
+//
+// Build and run from the repository root:
+//   cc -O2 -Wall -Imain/include tools/mqtt_broker_host.c main/mqtt_broker.c -o mqtt_broker_host
+//   ./mqtt_broker_host [-p port] [-f 'filter,filter'] [-b batch_ms]
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "mqtt_broker.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <arpa/inet.h>
+
+static volatile sig_atomic_t g_should_stop = 0;
+
+static void handle_signal(int sig)
+{
+    (void)sig;
+    g_should_stop = 1;
+}
+
+static int64_t clock_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void print_message(const char *kind, const char *topic,
+                          const uint8_t *payload, size_t len, bool retain)
+{
+    printf("%8lld %-8s %s%s %.*s\n", (long long)clock_ms(), kind, topic,
+           retain ? " (retained)" : "", (int)len, (const char *)payload);
+    fflush(stdout);
+}
+
+static void deliver_local(void *ctx, const char *topic, const uint8_t *payload,
+                          size_t len, bool retain)
+{
+    (void)ctx;
+    print_message("local", topic, payload, len, retain);
+}
+
+static bool forward(void *ctx, const char *topic, const uint8_t *payload,
+                    size_t len, bool retain)
+{
+    (void)ctx;
+    print_message("upstream", topic, payload, len, retain);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    mqtt_broker_config_t config = {
+        .bind_addr = htonl(INADDR_LOOPBACK),
+        .port = 1884,
+        .bridge_filters = MQTT_BRIDGE_DEFAULT_FILTERS,
+        .batch_ms = MQTT_BRIDGE_DEFAULT_BATCH_MS,
+        .deliver_local = deliver_local,
+        .forward = forward,
+        .clock_ms = clock_ms,
+    };
+    int opt;
+    while ((opt = getopt(argc, argv, "p:f:b:")) != -1) {
+        switch (opt) {
+            case 'p': config.port = (uint16_t)atoi(optarg); break;
+            case 'f': config.bridge_filters = optarg; break;
+            case 'b': config.batch_ms = (uint32_t)atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-p port] [-f filters] [-b batch_ms]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+    if (!mqtt_broker_valid_filters(config.bridge_filters)) {
+        fprintf(stderr, "invalid bridge filters: %s\n", config.bridge_filters);
+        return 2;
+    }
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+    signal(SIGPIPE, SIG_IGN);
+    if (!mqtt_broker_start(&config)) return 1;
+    while (!g_should_stop) mqtt_broker_poll(500);
+    mqtt_broker_stop();
+
+    mqtt_broker_stats_t stats;
+    mqtt_broker_get_stats(&stats);
+    printf("connects=%u publishes=%u delivered=%u forwarded=%u batches=%u "
+           "coalesced=%u deduplicated=%u dropped=%u protocol_errors=%u\n",
+           stats.connects, stats.rx_publishes, stats.tx_publishes,
+           stats.bridge_forwarded, stats.bridge_batches, stats.bridge_coalesced,
+           stats.bridge_deduplicated, stats.bridge_dropped,
+           stats.protocol_errors);
+    return 0;
+}
@@ -0,0 +1,438 @@
+// oled_render.c
+// Renders every OLED page from main/oled_pages.c with the real u8g2 library
+// into its in-memory SSD1306 framebuffer, compares each frame to a golden
+// snapshot in tools/oled_golden/ and measures the render time per page.
+//
+// Snapshots are binary PBM (P4) files, 128x64, one per fixture. A missing
+// golden is reported but does not fail the run until the goldens have been
+// recorded against the pinned u8g2 and committed. --record (-r) writes the
+// missing ones, and --update (-u) rewrites all of them after an intended
+// layout change. -o DIR also writes the current frames to DIR, e.g. for
+// viewing a failing fixture next to its golden.
+//
+// The value_font and value_atlas fixtures draw the same power value with the
+// u8g2 9x15 font and with the prerendered digit atlas, to compare their cost.
+//
+// Needs the u8g2 submodule (git submodule update --init) and the generated
+// digit atlas. Build and run from the repository root:
+//   python3 tools/gen_digit_atlas.py build/host/digit_atlas.h
+//   cc -O2 -Wall -Imain/include -Ibuild/host -Icomponents/u8g2/csrc tools/oled_render.c main/oled_pages.c main/power_history.c components/u8g2/csrc/*.c -o oled_render
+//   ./oled_render [-r|--record] [-u|--update] [-o dir] [-g golden_dir] [-n iterations]
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "oled_pages.h"
+#include "power_history.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <getopt.h>
+
+#include <sys/stat.h>
+
+#define FRAME_BYTES (OLED_WIDTH * OLED_HEIGHT / 8)
+#define PBM_ROW_BYTES (OLED_WIDTH / 8)
+#define DEFAULT_GOLDEN_DIR "tools/oled_golden"
+#define DEFAULT_ITERATIONS 2000
+#define SCREENSAVER_STEPS 150
+
+typedef struct {
+    const char *name;
+    void (*render)(u8g2_t *u8g2);
+} fixture_t;
+
+static void power_page(u8g2_t *u8g2, const char *label, const char *value,
+                       int clients, int8_t rssi, char marker, int jitter_x)
+{
+    oled_power_page_t page = {
+        .label = label,
+        .value = value,
+        .clients = clients,
+        .rssi = rssi,
+        .marker = marker,
+        .jitter_x = jitter_x,
+    };
+    oled_pages_draw_power(u8g2, &page);
+}
+
+static void render_power(u8g2_t *u8g2)
+{
+    power_page(u8g2, "Power (W)", "1234.5", 1, -62, 0, 0);
+}
+
+static void render_power_jitter_left(u8g2_t *u8g2)
+{
+    power_page(u8g2, "Power (W)", "87", 2, -80, 0, -1);
+}
+
+static void render_power_jitter_right(u8g2_t *u8g2)
+{
+    power_page(u8g2, "Power (W)", "0", 1, -45, 0, 1);
+}
+
+static void render_power_stale(u8g2_t *u8g2)
+{
+    char label[16];
+    oled_pages_format_power_label(label, sizeof(label), true, 7260);
+    power_page(u8g2, label, "412", 1, INT8_MIN, 0, 0);
+}
+
+static void render_power_marker(u8g2_t *u8g2)
+{
+    char label[16];
+    oled_pages_format_power_label(label, sizeof(label), true, -1);
+    power_page(u8g2, label, "-", 0, INT8_MIN, 'X', 0);
+}
+
+static void render_power_negative(u8g2_t *u8g2)
+{
+    power_page(u8g2, "Power (W)", "-87.5", 1, -70, 0, 0);
+}
+
+/* Seven characters are wider than the visible area in the atlas digits:
+ * falls back to the 9x15 font. */
+static void render_power_wide(u8g2_t *u8g2)
+{
+    power_page(u8g2, "Power (W)", "-1234.5", 1, -58, 0, 1);
+}
+
+/* Not in the atlas: falls back to the 9x15 font. */
+static void render_power_unknown(u8g2_t *u8g2)
+{
+    power_page(u8g2, "Power (W)", "N/A", 0, INT8_MIN, '-', 0);
+}
+
+static void render_value_font(u8g2_t *u8g2)
+{
+    u8g2_ClearBuffer(u8g2);
+    u8g2_SetFont(u8g2, u8g2_font_9x15_tr);
+    u8g2_DrawStr(u8g2, OLED_CONTENT_X_OFFSET, OLED_CONTENT_Y_OFFSET + 32,
+                 "1234.5");
+}
+
+static void render_value_atlas(u8g2_t *u8g2)
+{
+    u8g2_ClearBuffer(u8g2);
+    oled_pages_draw_big_value(u8g2, OLED_CONTENT_X_OFFSET,
+                              OLED_CONTENT_Y_OFFSET + 16, "1234.5");
+}
+
+static void render_debug(u8g2_t *u8g2)
+{
+    const char lines[OLED_DEBUG_LINE_COUNT][OLED_DEBUG_LINE_LEN + 1] = {
+        "W:R H:200", "E:OK", "AP:R C:1 M:R", "FD:3s R",
+    };
+    oled_pages_draw_debug(u8g2, lines);
+}
+
+static void render_debug_ota(u8g2_t *u8g2)
+{
+    const char lines[OLED_DEBUG_LINE_COUNT][OLED_DEBUG_LINE_LEN + 1] = {
+        "W:R H:NA", "OTA:57%", "AP:W C:0 M:S", "FD:--",
+    };
+    oled_pages_draw_debug(u8g2, lines);
+}
+
+static void draw_client(u8g2_t *u8g2, const oled_client_page_t *client)
+{
+    char lines[OLED_DEBUG_LINE_COUNT][OLED_DEBUG_LINE_LEN + 1];
+    oled_pages_format_client(lines, client);
+    oled_pages_draw_debug(u8g2, (const char (*)[OLED_DEBUG_LINE_LEN + 1])lines);
+}
+
+static void render_client(u8g2_t *u8g2)
+{
+    const oled_client_page_t client = {
+        .index = 1, .count = 2, .mac_tail = {0x9F, 0xA3}, .rssi_avg = -68,
+        .rssi_min = -81, .rssi_max = -60, .stddev_ddb = 64,
+        .poor_crossings = 3, .connected_s = 2 * 3600 + 5 * 60,
+    };
+    draw_client(u8g2, &client);
+}
+
+static void render_client_none(u8g2_t *u8g2)
+{
+    const oled_client_page_t client = {0};
+    draw_client(u8g2, &client);
+}
+
+static void render_credentials(u8g2_t *u8g2)
+{
+    oled_pages_draw_credentials(u8g2, "ppp-router", "correct horse battery");
+}
+
+static void render_credentials_wrapped(u8g2_t *u8g2)
+{
+    oled_pages_draw_credentials(
+        u8g2, "a-rather-long-ssid-for-wrapping",
+        "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ!");
+}
+
+static void render_credentials_open(u8g2_t *u8g2)
+{
+    oled_pages_draw_credentials(u8g2, "ppp-router", "");
+}
+
+/* Position after a fixed number of steps, so the bounce logic is covered. */
+static void render_screensaver(u8g2_t *u8g2)
+{
+    oled_screensaver_t ss;
+    oled_pages_screensaver_reset(&ss);
+    for (int i = 0; i < SCREENSAVER_STEPS; i++) {
+        oled_pages_draw_screensaver(u8g2, &ss, "3+");
+    }
+}
+
+static void draw_history(u8g2_t *u8g2, const power_history_t *history,
+                         int jitter_x)
+{
+    uint8_t heights[POWER_HISTORY_COLUMNS];
+    power_history_summary_t summary;
+    char label[24];
+    size_t count = power_history_heights(history, heights);
+    power_history_get_summary(history, &summary);
+    oled_pages_format_history_label(label, sizeof(label), summary.valid,
+                                    summary.min_dw, summary.max_dw,
+                                    summary.avg_dw);
+    oled_history_page_t page = {
+        .label = label,
+        .heights = heights,
+        .count = count,
+        .max_height = POWER_HISTORY_HEIGHT,
+        .jitter_x = jitter_x,
+    };
+    oled_pages_draw_history(u8g2, &page);
+}
+
+/* A sunny hour at one-minute columns: a ramp with a cloud gap and a few
+ * seconds without data, then the last half minute still open. */
+static void render_history(u8g2_t *u8g2)
+{
+    static power_history_t history;
+    static int ready = 0;
+    if (!ready) {
+        power_history_init(&history, 60000, 0);
+        for (int64_t t = 0; t < 70 * 60000 + 30000; t += 5000) {
+            int minute = (int)(t / 60000);
+            int32_t dw = 1500 + minute * 120;
+            if (minute >= 30 && minute < 36) dw /= 5;
+            bool valid = !(minute == 50 || minute == 51);
+            power_history_set(&history, t, valid, dw);
+        }
+        ready = 1;
+    }
+    draw_history(u8g2, &history, 1);
+}
+
+static void render_history_empty(u8g2_t *u8g2)
+{
+    power_history_t history;
+    power_history_init(&history, 60000, 0);
+    power_history_advance(&history, 5 * 60000);
+    draw_history(u8g2, &history, 0);
+}
+
+static void render_signal_bars(u8g2_t *u8g2)
+{
+    static const int8_t rssi[] = {INT8_MIN, -110, -100, -85, -70, -55, -45, -20};
+    u8g2_ClearBuffer(u8g2);
+    for (size_t i = 0; i < sizeof(rssi) / sizeof(rssi[0]); i++) {
+        oled_pages_draw_signal_bar(u8g2, 2 + (int)(i % 2) * 64,
+                                   2 + (int)(i / 2) * 8, rssi[i]);
+    }
+}
+
+static const fixture_t k_fixtures[] = {
+    {"power", render_power},
+    {"power_jitter_left", render_power_jitter_left},
+    {"power_jitter_right", render_power_jitter_right},
+    {"power_stale", render_power_stale},
+    {"power_marker", render_power_marker},
+    {"power_negative", render_power_negative},
+    {"power_wide", render_power_wide},
+    {"power_unknown", render_power_unknown},
+    {"value_font", render_value_font},
+    {"value_atlas", render_value_atlas},
+    {"debug", render_debug},
+    {"debug_ota", render_debug_ota},
+    {"client", render_client},
+    {"client_none", render_client_none},
+    {"credentials", render_credentials},
+    {"credentials_wrapped", render_credentials_wrapped},
+    {"credentials_open", render_credentials_open},
+    {"history", render_history},
+    {"history_empty", render_history_empty},
+    {"screensaver", render_screensaver},
+    {"signal_bars", render_signal_bars},
+};
+
+static double clock_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+/* u8g2 full buffers are page-major: byte (y / 8) * width + x, bit y % 8. */
+static void frame_to_pbm(const uint8_t *frame, uint8_t *pbm)
+{
+    memset(pbm, 0, FRAME_BYTES);
+    for (int y = 0; y < OLED_HEIGHT; y++) {
+        for (int x = 0; x < OLED_WIDTH; x++) {
+            if (frame[(y / 8) * OLED_WIDTH + x] & (1u << (y % 8))) {
+                pbm[y * PBM_ROW_BYTES + x / 8] |= (uint8_t)(0x80u >> (x % 8));
+            }
+        }
+    }
+}
+
+static int write_pbm(const char *path, const uint8_t *pbm)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    fprintf(f, "P4\n%d %d\n", OLED_WIDTH, OLED_HEIGHT);
+    size_t written = fwrite(pbm, 1, FRAME_BYTES, f);
+    if (fclose(f) != 0 || written != FRAME_BYTES) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+/* Returns 1 if read, 0 if the file does not exist, -1 if it is malformed. */
+static int read_pbm(const char *path, uint8_t *pbm)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    int w = 0;
+    int h = 0;
+    int ok = fscanf(f, "P4 %d %d", &w, &h) == 2 && fgetc(f) != EOF &&
+             w == OLED_WIDTH && h == OLED_HEIGHT &&
+             fread(pbm, 1, FRAME_BYTES, f) == FRAME_BYTES;
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "%s: not a %dx%d binary PBM\n", path, OLED_WIDTH,
+                OLED_HEIGHT);
+        return -1;
+    }
+    return 1;
+}
+
+static int count_pixels(const uint8_t *a, const uint8_t *b)
+{
+    int n = 0;
+    for (size_t i = 0; i < FRAME_BYTES; i++) {
+        uint8_t bits = b ? (uint8_t)(a[i] ^ b[i]) : a[i];
+        for (; bits; bits &= (uint8_t)(bits - 1)) n++;
+    }
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    const char *golden_dir = DEFAULT_GOLDEN_DIR;
+    const char *out_dir = NULL;
+    int iterations = DEFAULT_ITERATIONS;
+    int update = 0;
+    int record = 0;
+    static const struct option long_options[] = {
+        {"record", no_argument, NULL, 'r'},
+        {"update", no_argument, NULL, 'u'},
+        {NULL, 0, NULL, 0},
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "ruo:g:n:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'r': record = 1; break;
+            case 'u': update = 1; break;
+            case 'o': out_dir = optarg; break;
+            case 'g': golden_dir = optarg; break;
+            case 'n': iterations = atoi(optarg); break;
+            default:
+                fprintf(stderr,
+                        "usage: %s [-r|--record] [-u|--update] [-o dir] "
+                        "[-g golden_dir] [-n iterations]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+    if (iterations < 1) iterations = 1;
+
+    u8g2_t u8g2;
+    u8g2_Setup_ssd1306_128x64_noname_f(&u8g2, U8G2_R0, u8x8_byte_empty,
+                                       u8x8_dummy_cb);
+    const uint8_t *frame = u8g2_GetBufferPtr(&u8g2);
+
+    int failures = 0;
+    int recorded = 0;
+    int missing = 0;
+    if (record || update) mkdir(golden_dir, 0755);
+    printf("%-20s %10s %8s %s\n", "fixture", "us/frame", "pixels", "result");
+    for (size_t i = 0; i < sizeof(k_fixtures) / sizeof(k_fixtures[0]); i++) {
+        const fixture_t *fx = &k_fixtures[i];
+        uint8_t actual[FRAME_BYTES];
+        uint8_t golden[FRAME_BYTES];
+        char path[512];
+
+        double start = clock_us();
+        for (int n = 0; n < iterations; n++) fx->render(&u8g2);
+        double per_frame = (clock_us() - start) / iterations;
+
+        /* Timed renders leave the last frame in the buffer; render once more
+         * from scratch so stateful pages start from the same point. */
+        fx->render(&u8g2);
+        frame_to_pbm(frame, actual);
+        int lit = count_pixels(actual, NULL);
+
+        if (out_dir) {
+            snprintf(path, sizeof(path), "%s/%s.pbm", out_dir, fx->name);
+            if (write_pbm(path, actual) != 0) failures++;
+        }
+
+        snprintf(path, sizeof(path), "%s/%s.pbm", golden_dir, fx->name);
+        const char *result;
+        int have = update ? 0 : read_pbm(path, golden);
+        if (have < 0) {
+            result = "BAD GOLDEN";
+            failures++;
+        } else if (have == 0 && !record && !update) {
+            result = "no golden";
+            missing++;
+        } else if (have == 0) {
+            if (write_pbm(path, actual) != 0) {
+                result = "WRITE FAILED";
+                failures++;
+            } else {
+                result = "recorded";
+                recorded++;
+            }
+        } else if (memcmp(actual, golden, FRAME_BYTES) != 0) {
+            static char diff[32];
+            snprintf(diff, sizeof(diff), "DIFF (%d px)",
+                     count_pixels(actual, golden));
+            result = diff;
+            failures++;
+        } else {
+            result = "ok";
+        }
+        printf("%-20s %10.2f %8d %s\n", fx->name, per_frame, lit, result);
+    }
+
+    if (recorded) {
+        printf("%d golden(s) recorded in %s; review and commit them\n",
+               recorded, golden_dir);
+    }
+    if (missing) {
+        printf("%d fixture(s) without a golden in %s, not compared; "
+               "run with --record to create them\n", missing, golden_dir);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,201 @@
+// oled_tiles_check.c
+// Host check for main/oled_tiles.c, the dirty-tile diff behind the OLED's
+// incremental updates.
+//
+// Renders frames similar to the firmware pages into a 128x64 buffer in the
+// u8g2 SSD1306 layout and pushes each one to two emulated panels: one updated
+// only with the runs oled_tiles_flush() reports, the other with the whole
+// frame as u8g2_SendBuffer() would. After every frame both panels must be
+// pixel-identical to the frame. The incremental path also does the firmware's
+// periodic full refresh.
+//
+// Byte counts use the SSD1306 fast-I2C framing of u8x8: per run, one command
+// transfer (address, control, column and page commands) and one data
+// transfer (address, control, tile bytes). The firmware counts real bus
+// bytes in /status/all.
+//
+// Build and run from the repository root:
+//   cc -O2 -Wall -Imain/include tools/oled_tiles_check.c main/oled_tiles.c -o oled_tiles_check
+//   ./oled_tiles_check
+
+#include "oled_tiles.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WIDTH 128
+#define HEIGHT 64
+#define TILE_COLS (WIDTH / 8)
+#define TILE_ROWS (HEIGHT / 8)
+#define FRAME_BYTES (WIDTH * HEIGHT / 8)
+#define FRAMES_PER_SCENARIO 3600
+#define FULL_REFRESH_FRAMES 300 /* OLED_FULL_REFRESH_FRAMES in oled.c */
+#define RUN_OVERHEAD_BYTES 7    /* 2 x (address + control) + 3 commands */
+
+typedef struct {
+    const uint8_t *frame;
+    uint8_t *panel;
+    unsigned long bytes;
+} panel_t;
+
+static uint8_t g_frame[FRAME_BYTES];
+static uint32_t g_seed = 1;
+
+static uint32_t next_random(void)
+{
+    g_seed = g_seed * 1103515245u + 12345u;
+    return g_seed >> 16;
+}
+
+static void set_pixel(int x, int y)
+{
+    if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) return;
+    g_frame[(y / 8) * WIDTH + x] |= (uint8_t)(1u << (y % 8));
+}
+
+static void draw_box(int x, int y, int w, int h)
+{
+    for (int dy = 0; dy < h; dy++) {
+        for (int dx = 0; dx < w; dx++) set_pixel(x + dx, y + dy);
+    }
+}
+
+/* Stand-in glyphs: a fixed w x h bit pattern per character, baseline at y. */
+static void draw_text(int x, int y, const char *s, int w, int h)
+{
+    for (; *s; s++, x += w + 1) {
+        uint32_t bits = (uint32_t)(unsigned char)*s * 2654435761u;
+        for (int col = 0; col < w; col++) {
+            for (int row = 0; row < h; row++) {
+                if ((bits >> ((col * h + row) % 31)) & 1u) {
+                    set_pixel(x + col, y - h + 1 + row);
+                }
+            }
+        }
+    }
+}
+
+/* The normal page: label, power digits, client count and RSSI bar, with the
+ * one-pixel jitter of handle_oled(). */
+static void render_power(int frame)
+{
+    static int power = 230;
+    static int rssi_fill = 30;
+    int phase = frame % 60;
+    int xoff = 28 + (phase == 0 ? 1 : phase == 30 ? -1 : 0);
+    char value[16];
+    power += (int)(next_random() % 21) - 10;
+    if (power < 0) power = 0;
+    if (next_random() % 5 == 0) rssi_fill = 20 + (int)(next_random() % 30);
+    snprintf(value, sizeof(value), "%d", power);
+    draw_text(xoff, 18 + 14, "Power (W)", 5, 7);
+    draw_text(xoff, 18 + 32, value, 8, 12);
+    draw_text(xoff, 18 + 44, "1", 5, 7);
+    draw_box(xoff + 12, 18 + 38, rssi_fill, 6);
+}
+
+/* Bouncing client count, one pixel per frame like draw_screensaver(). */
+static void render_screensaver(int frame)
+{
+    int x = 1 + frame % (2 * (WIDTH - 14));
+    int y = 11 + frame % (2 * (HEIGHT - 11));
+    if (x > WIDTH - 14) x = 2 * (WIDTH - 14) - x;
+    if (y > HEIGHT - 1) y = 2 * (HEIGHT - 1) - y;
+    draw_text(x, y, "1+", 5, 7);
+}
+
+/* Debug page: four lines, uptime-like counters change every frame. */
+static void render_debug(int frame)
+{
+    char line[24];
+    draw_text(28, 27, "W:R H:200", 5, 7);
+    snprintf(line, sizeof(line), "OTA:-- %d", frame / 10);
+    draw_text(28, 37, line, 5, 7);
+    draw_text(28, 47, "M:R AP:R", 5, 7);
+    snprintf(line, sizeof(line), "FD:%d", 100 + frame % 7);
+    draw_text(28, 57, line, 5, 7);
+}
+
+/* Worst case: every pixel random. */
+static void render_noise(int frame)
+{
+    (void)frame;
+    for (size_t i = 0; i < FRAME_BYTES; i++) g_frame[i] = (uint8_t)next_random();
+}
+
+static void send_tiles(void *ctx, uint8_t tx, uint8_t ty, uint8_t tw)
+{
+    panel_t *panel = ctx;
+    size_t offset = (size_t)ty * WIDTH + (size_t)tx * OLED_TILE_BYTES;
+    memcpy(panel->panel + offset, panel->frame + offset,
+           (size_t)tw * OLED_TILE_BYTES);
+    panel->bytes += RUN_OVERHEAD_BYTES + (unsigned long)tw * OLED_TILE_BYTES;
+}
+
+static int run_scenario(const char *name, void (*render)(int))
+{
+    static uint8_t shadow[FRAME_BYTES];
+    static uint8_t full_shadow[FRAME_BYTES];
+    static uint8_t incremental[FRAME_BYTES];
+    static uint8_t full[FRAME_BYTES];
+    panel_t inc_panel = {.frame = g_frame, .panel = incremental};
+    panel_t full_panel = {.frame = g_frame, .panel = full};
+    unsigned long tiles = 0;
+    unsigned long runs = 0;
+    unsigned unchanged = 0;
+    int mismatches = 0;
+
+    /* Panel RAM is undefined at power-up. */
+    memset(incremental, 0xA5, sizeof(incremental));
+    memset(full, 0x5A, sizeof(full));
+    memset(shadow, 0, sizeof(shadow));
+
+    for (int frame = 0; frame < FRAMES_PER_SCENARIO; frame++) {
+        memset(g_frame, 0, sizeof(g_frame));
+        render(frame);
+
+        bool force_full = frame % FULL_REFRESH_FRAMES == 0;
+        oled_tiles_result_t sent = oled_tiles_flush(
+            g_frame, shadow, TILE_COLS, TILE_ROWS, force_full, send_tiles,
+            &inc_panel);
+        oled_tiles_flush(g_frame, full_shadow, TILE_COLS, TILE_ROWS, true,
+                         send_tiles, &full_panel);
+        tiles += sent.tiles;
+        runs += sent.runs;
+        if (sent.tiles == 0) unchanged++;
+
+        if (memcmp(incremental, g_frame, FRAME_BYTES) != 0 ||
+            memcmp(full, g_frame, FRAME_BYTES) != 0 ||
+            memcmp(incremental, full, FRAME_BYTES) != 0) {
+            if (mismatches == 0) {
+                fprintf(stderr, "%s: frame %d differs between paths\n", name,
+                        frame);
+            }
+            mismatches++;
+        }
+    }
+
+    double frames = FRAMES_PER_SCENARIO;
+    double inc_bytes = (double)inc_panel.bytes / frames;
+    double full_bytes = (double)full_panel.bytes / frames;
+    printf("%-12s %6d %7.1f %6.2f %9.0f %9.0f %7.1f%% %9u %s\n", name,
+           FRAMES_PER_SCENARIO, (double)tiles / frames, (double)runs / frames,
+           inc_bytes, full_bytes, 100.0 * (1.0 - inc_bytes / full_bytes),
+           unchanged, mismatches ? "NO" : "yes");
+    return mismatches;
+}
+
+int main(void)
+{
+    int failures = 0;
+    printf("%-12s %6s %7s %6s %9s %9s %8s %9s %s\n", "scenario", "frames",
+           "tiles", "runs", "B/frame", "full B", "saved", "unchanged",
+           "identical");
+    failures += run_scenario("power", render_power);
+    failures += run_scenario("screensaver", render_screensaver);
+    failures += run_scenario("debug", render_debug);
+    failures += run_scenario("noise", render_noise);
+    return failures ? 1 : 0;
+}
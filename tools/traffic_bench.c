@@ -0,0 +1,208 @@
+// traffic_bench.c
+// Forwarding benchmark for main/traffic_table.c, the per-client counters
+// behind the SoftAP and PPP netif hooks.
+//
+// Replays the packets a forwarded TCP flow produces: each upload is seen as
+// an Ethernet frame on SoftAP input and again as an IP packet on PPP output,
+// and each download as an IP packet on SoftAP output with a source outside
+// the subnet. ARP frames, broadcasts and traffic to the router itself are
+// mixed in. Every packet goes through the same header decode and table
+// update as client_traffic.c (without its critical section), and the totals
+// are checked against counts kept by the generator.
+//
+// The "churn" scenario uses more addresses than the table has slots, so it
+// also covers eviction.
+//
+// Build and run from the repository root:
+//   cc -O2 -Wall -Imain/include tools/traffic_bench.c main/traffic_table.c -o traffic_bench
+//   ./traffic_bench
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "traffic_table.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define ETH_HEADER_LEN 14
+#define PACKETS_PER_SCENARIO 20000000
+#define SUBNET 0xC0A80400u /* 192.168.4.0/24, AP_IP_ADDR 192.168.4.1 */
+#define MASK 0xFFFFFF00u
+#define REMOTE 0xC0A8B201u /* a host behind the PPP link */
+
+typedef enum { HOOK_AP_INPUT, HOOK_AP_OUTPUT, HOOK_PPP_OUTPUT } hook_t;
+
+typedef struct {
+    uint64_t bytes[256][TRAFFIC_DIR_COUNT];
+} expected_t;
+
+static uint32_t g_seed = 1;
+static uint8_t g_frame[ETH_HEADER_LEN + 1500];
+static expected_t g_expected;
+
+static uint32_t next_random(void)
+{
+    g_seed = g_seed * 1103515245u + 12345u;
+    return g_seed >> 16;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void put_addr(uint8_t *p, uint32_t addr)
+{
+    p[0] = (uint8_t)(addr >> 24);
+    p[1] = (uint8_t)(addr >> 16);
+    p[2] = (uint8_t)(addr >> 8);
+    p[3] = (uint8_t)addr;
+}
+
+/* Writes the headers into g_frame; returns the offset of the IP header. */
+static size_t build_packet(hook_t hook, uint32_t src, uint32_t dst, bool arp)
+{
+    size_t ip = hook == HOOK_AP_INPUT ? ETH_HEADER_LEN : 0;
+    if (hook == HOOK_AP_INPUT) {
+        g_frame[12] = 0x08;
+        g_frame[13] = arp ? 0x06 : 0x00;
+    }
+    g_frame[ip] = 0x45;
+    put_addr(g_frame + ip + 12, src);
+    put_addr(g_frame + ip + 16, dst);
+    return ip;
+}
+
+/* What client_traffic.c does per hooked packet, minus the lock. */
+static void hook_packet(traffic_table_t *t, hook_t hook, size_t len)
+{
+    uint32_t src;
+    uint32_t dst;
+    switch (hook) {
+    case HOOK_AP_INPUT:
+        if (traffic_table_read_ip4(g_frame, len, ETH_HEADER_LEN, &src, &dst)) {
+            traffic_table_account(t, TRAFFIC_WIFI_UP, src,
+                                  (uint32_t)(len - ETH_HEADER_LEN));
+        } else {
+            t->other_packets++;
+        }
+        break;
+    case HOOK_AP_OUTPUT:
+        if (traffic_table_read_ip4(g_frame, len, 0, &src, &dst)) {
+            traffic_table_account(t, TRAFFIC_WIFI_DOWN, dst, (uint32_t)len);
+            if ((src & t->mask) != t->net) {
+                traffic_table_account(t, TRAFFIC_UPLINK_DOWN, dst,
+                                      (uint32_t)len);
+            }
+        } else {
+            t->other_packets++;
+        }
+        break;
+    case HOOK_PPP_OUTPUT:
+        if (traffic_table_read_ip4(g_frame, len, 0, &src, &dst)) {
+            traffic_table_account(t, TRAFFIC_UPLINK_UP, src, (uint32_t)len);
+        } else {
+            t->other_packets++;
+        }
+        break;
+    }
+}
+
+static void expect(uint32_t addr, traffic_dir_t dir, size_t bytes)
+{
+    g_expected.bytes[addr & 0xFF][dir] += bytes;
+}
+
+/* One step of the traffic mix for the client at addr; returns hooks run. */
+static int run_step(traffic_table_t *t, uint32_t addr)
+{
+    uint32_t kind = next_random() % 100;
+    size_t payload = 40 + next_random() % 1460;
+
+    if (kind < 40) { /* download from the PPP side */
+        size_t ip = build_packet(HOOK_AP_OUTPUT, REMOTE, addr, false);
+        hook_packet(t, HOOK_AP_OUTPUT, ip + payload);
+        expect(addr, TRAFFIC_WIFI_DOWN, payload);
+        expect(addr, TRAFFIC_UPLINK_DOWN, payload);
+        return 1;
+    }
+    if (kind < 80) { /* upload, seen on SoftAP input and PPP output */
+        size_t ip = build_packet(HOOK_AP_INPUT, addr, REMOTE, false);
+        hook_packet(t, HOOK_AP_INPUT, ip + payload);
+        ip = build_packet(HOOK_PPP_OUTPUT, addr, REMOTE, false);
+        hook_packet(t, HOOK_PPP_OUTPUT, ip + payload);
+        expect(addr, TRAFFIC_WIFI_UP, payload);
+        expect(addr, TRAFFIC_UPLINK_UP, payload);
+        return 2;
+    }
+    if (kind < 90) { /* web UI or local broker on the router */
+        size_t ip = build_packet(HOOK_AP_INPUT, addr, SUBNET | 1, false);
+        hook_packet(t, HOOK_AP_INPUT, ip + payload);
+        ip = build_packet(HOOK_AP_OUTPUT, SUBNET | 1, addr, false);
+        hook_packet(t, HOOK_AP_OUTPUT, ip + payload);
+        expect(addr, TRAFFIC_WIFI_UP, payload);
+        expect(addr, TRAFFIC_WIFI_DOWN, payload);
+        return 2;
+    }
+    if (kind < 95) { /* ARP */
+        size_t ip = build_packet(HOOK_AP_INPUT, addr, SUBNET | 1, true);
+        hook_packet(t, HOOK_AP_INPUT, ip + 28);
+        return 1;
+    }
+    /* Broadcast from the router, e.g. DHCP or mDNS */
+    size_t ip = build_packet(HOOK_AP_OUTPUT, SUBNET | 1, SUBNET | 255, false);
+    hook_packet(t, HOOK_AP_OUTPUT, ip + payload);
+    return 1;
+}
+
+static int run_scenario(const char *name, int addresses)
+{
+    static traffic_table_t table;
+    traffic_table_init(&table, SUBNET | 1, MASK);
+    memset(&g_expected, 0, sizeof(g_expected));
+    memset(g_frame, 0, sizeof(g_frame));
+
+    long hooks = 0;
+    double start = now_seconds();
+    for (int i = 0; i < PACKETS_PER_SCENARIO; i++) {
+        /* Clients take turns in bursts, like real flows. */
+        uint32_t addr = SUBNET | (uint32_t)(2 + (i / 16) % addresses);
+        hooks += run_step(&table, addr);
+    }
+    double elapsed = now_seconds() - start;
+
+    /* Without eviction every byte must be accounted for. */
+    int mismatches = 0;
+    if (addresses <= TRAFFIC_TABLE_SLOTS) {
+        for (int a = 0; a < addresses; a++) {
+            const traffic_slot_t *slot = traffic_table_find(&table,
+                                                            (uint8_t)(2 + a));
+            for (int d = 0; d < TRAFFIC_DIR_COUNT; d++) {
+                uint64_t got = slot ? slot->dir[d].bytes : 0;
+                if (got != g_expected.bytes[2 + a][d]) mismatches++;
+            }
+        }
+    }
+
+    printf("%-8s %9d %9ld %9.1f %9.2f %9lu %9lu %s\n", name, addresses,
+           hooks, elapsed * 1e9 / (double)hooks, (double)hooks / elapsed / 1e6,
+           (unsigned long)table.other_packets,
+           (unsigned long)table.evictions,
+           addresses > TRAFFIC_TABLE_SLOTS ? "n/a" : mismatches ? "NO" : "yes");
+    return mismatches;
+}
+
+int main(void)
+{
+    int failures = 0;
+    printf("%-8s %9s %9s %9s %9s %9s %9s %s\n", "scenario", "clients",
+           "hooks", "ns/hook", "Mhook/s", "other", "evicted", "exact");
+    failures += run_scenario("single", 1);
+    failures += run_scenario("full", 4);
+    failures += run_scenario("churn", 40);
+    return failures ? 1 : 0;
+}